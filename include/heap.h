@@ -109,6 +109,12 @@ typedef struct st_heap_block
 
 struct st_heap_info;			/* For referense */
 
+typedef struct st_hp_blobdef		/* BLOB column of a record */
+{
+  uint offset;				/* Offset of the column in the record */
+  uint packlength;			/* Bytes used to store the length */
+} HP_BLOBDEF;
+
 typedef struct st_hp_keydef		/* Key definition with open */
 {
   uint flag;				/* HA_NOSAME | HA_NULL_PART_KEY */
@@ -134,6 +140,7 @@ typedef struct st_heap_share
 {
   HP_BLOCK block;
   HP_KEYDEF  *keydef;
+  HP_BLOBDEF *blobdef;
   ulong min_records,max_records;	/* Params to open */
   ulonglong data_length,index_length,max_table_size;
   uint key_stat_version;                /* version to indicate insert/delete */
@@ -143,6 +150,7 @@ typedef struct st_heap_share
   uint reclength;			/* Length of one record */
   uint changed;
   uint keys,max_key_length;
+  uint blobs;				/* Number of BLOB columns */
   uint currently_disabled_keys;    /* saved value from "keys" when disabled */
   uint open_count;
   uchar *del_link;			/* Link to next block with del. rec */
@@ -182,11 +190,13 @@ typedef struct st_heap_info
 typedef struct st_heap_create_info
 {
   HP_KEYDEF *keydef;
+  HP_BLOBDEF *blobdef;
   ulong max_records;
   ulong min_records;
   uint auto_key;                        /* keynr [1 - maxkey] for auto key */
   uint auto_key_type;
   uint keys;
+  uint blobs;
   uint reclength;
   ulonglong max_table_size;
   ulonglong auto_increment;
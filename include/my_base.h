@@ -194,7 +194,12 @@ enum ha_extra_function {
   */
   HA_EXTRA_EXPORT,
   /** Do secondary sort by handler::ref (rowid) after key sort. */
-  HA_EXTRA_SECONDARY_SORT_ROWID
+  HA_EXTRA_SECONDARY_SORT_ROWID,
+  /**
+    The following index lookups, or rnd_pos() calls, are made in key
+    order, until index_end() or rnd_end().
+  */
+  HA_EXTRA_KEY_ORDERED_READS
 };
 
 /* Compatible option, to be deleted in 6.0 */
@@ -247,6 +247,17 @@ INSERT IGNORE INTO engine_cost(engine_name, device_type, cost_name) VALUES
   ("default", 0, "memory_block_read_cost"),
   ("default", 0, "io_block_read_cost");
 
+-- Column histograms, maintained by ANALYZE TABLE ... UPDATE HISTOGRAM
+
+CREATE TABLE IF NOT EXISTS histograms (
+  database_name VARCHAR(64) NOT NULL,
+  table_name    VARCHAR(64) NOT NULL,
+  column_name   VARCHAR(64) NOT NULL,
+  last_update   TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
+  histogram     JSON NOT NULL,
+  PRIMARY KEY (database_name, table_name, column_name)
+) ENGINE=MyISAM CHARACTER SET=utf8 COLLATE=utf8_bin comment='Column histograms';
+
 --
 -- PERFORMANCE SCHEMA INSTALLATION
 -- Note that this script is also reused by mysql_upgrade,
@@ -308,6 +308,7 @@ bool filesort(THD *thd, Filesort *filesort, bool sort_positions,
                           table,
                           thd->variables.max_length_for_sort_data,
                           max_rows, sort_positions);
+  param.sort_threads= thd->variables.sort_threads;
 
   table_sort.addon_fields= param.addon_fields;
 
@@ -2015,7 +2016,7 @@ struct Merge_chunk_less
     uchar *key1= a->current_key();
     uchar *key2= b->current_key();
     if (m_len)
-      return memcmp(key1, key2, m_len) > 0;
+      return cmp_sort_keys(key1, key2, m_len) > 0;
 
     if (m_fun)
       return (*m_fun)(m_arg, key1, key2) > 0;
@@ -18,12 +18,14 @@
 #include "sql_const.h"
 #include "sql_sort.h"
 #include "table.h"
+#include "mysql/psi/mysql_thread.h"
 
 #include <algorithm>
 #include <functional>
 #include <vector>
 
 PSI_memory_key key_memory_Filesort_buffer_sort_keys;
+PSI_thread_key key_thread_filesort_sort;
 
 namespace {
 /**
@@ -215,8 +217,262 @@ size_t try_reserve(std::pair<type*, ptrdiff_t> *buf, ptrdiff_t size)
   return buf->second;
 }
 
+/** Upper limit for Sort_param::sort_threads */
+const uint MAX_SORT_THREADS= 64;
+
+/** Smallest number of keys that is worth sorting in a thread of its own */
+const uint MIN_KEYS_PER_SORT_THREAD= 16 * 1024;
+
+/**
+  Smallest number of keys that msd_radix_sort() is used for, when
+  radixsort_for_str_ptr() cannot be used.
+*/
+const uint MIN_KEYS_FOR_MSD_RADIX_SORT= 1000;
+
+/** Buckets of at most this many keys are sorted with insertion sort */
+const size_t MSD_RADIX_SORT_CUTOFF= 32;
+
+/** Stable insertion sort of keys that are equal in their first 'depth' bytes */
+void insertion_sort_keys(uchar **keys, size_t count, size_t depth,
+                         size_t sort_length)
+{
+  for (size_t i= 1; i < count; i++)
+  {
+    uchar *const key= keys[i];
+    size_t j= i;
+    for (; j > 0 && cmp_sort_keys(key + depth, keys[j - 1] + depth,
+                                  sort_length - depth) < 0; j--)
+      keys[j]= keys[j - 1];
+    keys[j]= key;
+  }
+}
+
+/** A bucket of keys that are equal in their first 'depth' bytes */
+struct Radix_bucket
+{
+  uchar **keys;
+  uchar **buffer;
+  size_t count;
+  size_t depth;
+};
+
+/**
+  Sort keys that are equal in their first 'depth' bytes, see
+  msd_radix_sort(). The buckets that are left to sort are kept on a stack
+  of their own rather than by recursion, as keys with long common
+  prefixes, e.g. 'b', 'ab', 'aab', ..., are split at every byte.
+*/
+void msd_radix_sort_from(uchar **keys, uchar **buffer, size_t count,
+                         size_t depth, size_t sort_length)
+{
+  std::vector<Radix_bucket> stack;
+  Radix_bucket bucket= { keys, buffer, count, depth };
+  stack.push_back(bucket);
+  size_t counts[256];
+  size_t offsets[256];
+  while (!stack.empty())
+  {
+    bucket= stack.back();
+    stack.pop_back();
+    for (; bucket.depth < sort_length; bucket.depth++)
+    {
+      if (bucket.count <= MSD_RADIX_SORT_CUTOFF)
+      {
+        insertion_sort_keys(bucket.keys, bucket.count, bucket.depth,
+                            sort_length);
+        break;
+      }
+      memset(counts, 0, sizeof(counts));
+      for (size_t i= 0; i < bucket.count; i++)
+        counts[bucket.keys[i][bucket.depth]]++;
+      // Skip bytes that all keys have in common
+      if (counts[bucket.keys[0][bucket.depth]] == bucket.count)
+        continue;
+
+      size_t offset= 0;
+      for (uint b= 0; b < 256; b++)
+      {
+        offsets[b]= offset;
+        offset+= counts[b];
+      }
+      for (size_t i= 0; i < bucket.count; i++)
+        bucket.buffer[offsets[bucket.keys[i][bucket.depth]]++]=
+          bucket.keys[i];
+      memcpy(bucket.keys, bucket.buffer, bucket.count * sizeof(uchar*));
+
+      size_t start= 0;
+      for (uint b= 0; b < 256; start+= counts[b], b++)
+      {
+        if (counts[b] > 1)
+        {
+          const Radix_bucket next= { bucket.keys + start,
+                                     bucket.buffer + start, counts[b],
+                                     bucket.depth + 1 };
+          stack.push_back(next);
+        }
+      }
+      break;
+    }
+  }
+}
+
+/**
+  A part of the sort keys to sort, or two adjacent sorted parts to merge
+  into another array.
+*/
+struct Sort_task
+{
+  void (*run)(Sort_task *task);
+  uchar **from;
+  uchar **middle;
+  uchar **end;
+  uchar **to;
+  size_t sort_length;
+  my_thread_handle thread;
+  bool started;
+};
+
+template <class Compare>
+void sort_task(Sort_task *task)
+{
+  const size_t count= task->end - task->from;
+  if (count >= MIN_KEYS_FOR_MSD_RADIX_SORT)
+    msd_radix_sort(task->from, count, task->sort_length, task->to);
+  else
+    std::stable_sort(task->from, task->end, Compare(task->sort_length));
+}
+
+template <class Compare>
+void merge_task(Sort_task *task)
+{
+  // Ties are taken from the first part, which keeps the sort stable
+  std::merge(task->from, task->middle, task->middle, task->end, task->to,
+             Compare(task->sort_length));
+}
+
+void copy_task(Sort_task *task)
+{
+  std::copy(task->from, task->end, task->to);
+}
+
 } // namespace
 
+
+void msd_radix_sort(uchar **keys, size_t count, size_t sort_length,
+                    uchar **buffer)
+{
+  msd_radix_sort_from(keys, buffer, count, 0, sort_length);
+}
+
+
+extern "C" void *run_sort_task(void *arg)
+{
+  Sort_task *const task= static_cast<Sort_task*>(arg);
+  my_thread_init();
+  task->run(task);
+  my_thread_end();
+  return NULL;
+}
+
+
+/**
+  Run sort tasks in threads of their own, the first one in the calling
+  thread. A task whose thread cannot be started is run by the calling
+  thread too.
+*/
+static void run_sort_tasks(Sort_task *tasks, uint count)
+{
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  for (uint i= 1; i < count; i++)
+    tasks[i].started= !mysql_thread_create(key_thread_filesort_sort,
+                                           &tasks[i].thread, &attr,
+                                           run_sort_task, &tasks[i]);
+  my_thread_attr_destroy(&attr);
+
+  tasks[0].run(&tasks[0]);
+  for (uint i= 1; i < count; i++)
+  {
+    if (tasks[i].started)
+      my_thread_join(&tasks[i].thread, NULL);
+    else
+      tasks[i].run(&tasks[i]);
+  }
+}
+
+
+/**
+  Sort the keys with several threads: each thread sorts a part of the
+  keys, and the sorted parts are then merged pairwise, with the merges of
+  each round running in parallel. The result is the same as that of
+  std::stable_sort().
+
+  @retval false  The keys are sorted
+  @retval true   Out of memory, nothing was done
+*/
+template <class Compare>
+static bool sort_in_parallel(uchar **keys, uint count, size_t sort_length,
+                             uint threads)
+{
+  std::pair<uchar**, ptrdiff_t> buffer;
+  if (!try_reserve(&buffer, count))
+    return true;
+
+  Sort_task tasks[MAX_SORT_THREADS];
+  uint bounds[MAX_SORT_THREADS + 1];
+  uint merged_bounds[MAX_SORT_THREADS + 1];
+  for (uint i= 0; i <= threads; i++)
+    bounds[i]= static_cast<uint>(static_cast<ulonglong>(count) * i / threads);
+
+  for (uint i= 0; i < threads; i++)
+  {
+    tasks[i].run= sort_task<Compare>;
+    tasks[i].from= keys + bounds[i];
+    tasks[i].end= keys + bounds[i + 1];
+    tasks[i].to= buffer.first + bounds[i];
+    tasks[i].sort_length= sort_length;
+  }
+  run_sort_tasks(tasks, threads);
+
+  uchar **from= keys;
+  uchar **to= buffer.first;
+  uint parts= threads;
+  while (parts > 1)
+  {
+    uint task_count= 0;
+    merged_bounds[0]= 0;
+    for (uint i= 0; i < parts; i+= 2)
+    {
+      Sort_task *const task= &tasks[task_count++];
+      task->from= from + bounds[i];
+      task->to= to + bounds[i];
+      task->sort_length= sort_length;
+      if (i + 1 < parts)
+      {
+        task->run= merge_task<Compare>;
+        task->middle= from + bounds[i + 1];
+        task->end= from + bounds[i + 2];
+        merged_bounds[task_count]= bounds[i + 2];
+      }
+      else
+      {
+        task->run= copy_task;
+        task->end= from + bounds[i + 1];
+        merged_bounds[task_count]= bounds[i + 1];
+      }
+    }
+    run_sort_tasks(tasks, task_count);
+    std::copy(merged_bounds, merged_bounds + task_count + 1, bounds);
+    parts= task_count;
+    std::swap(from, to);
+  }
+  if (from != keys)
+    std::copy(from, from + count, keys);
+  std::return_temporary_buffer(buffer.first);
+  return false;
+}
+
 void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
 {
   m_sort_keys= get_sort_keys();
@@ -239,6 +495,25 @@ void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
     std::return_temporary_buffer(buffer.first);
     return;
   }
+  const uint threads=
+    std::min(std::min(param->sort_threads, MAX_SORT_THREADS),
+             count / MIN_KEYS_PER_SORT_THREAD);
+  if (threads > 1)
+  {
+    const bool failed= param->sort_length < 10 ?
+      sort_in_parallel<Mem_compare>(m_sort_keys, count, param->sort_length,
+                                    threads) :
+      sort_in_parallel<Mem_compare_longkey>(m_sort_keys, count,
+                                            param->sort_length, threads);
+    if (!failed)
+      return;
+  }
+  if (count >= MIN_KEYS_FOR_MSD_RADIX_SORT && try_reserve(&buffer, count))
+  {
+    msd_radix_sort(m_sort_keys, count, param->sort_length, buffer.first);
+    std::return_temporary_buffer(buffer.first);
+    return;
+  }
   /*
     std::stable_sort has some extra overhead in allocating the temp buffer,
     which takes some time. The cutover point where it starts to get faster
@@ -52,6 +52,49 @@ double get_merge_many_buffs_cost_fast(ha_rows num_rows,
                                       const Cost_model_table *cost_model);
 
 
+/**
+  Compare two sort keys of filesort(), which compare byte by byte, eight
+  bytes at a time.
+
+  @return Less than, equal to or greater than zero, like memcmp()
+*/
+
+inline int cmp_sort_keys(const uchar *s1, const uchar *s2, size_t len)
+{
+#if defined(__GNUC__) && !defined(WORDS_BIGENDIAN)
+  for (; len >= 8; s1+= 8, s2+= 8, len-= 8)
+  {
+    ulonglong word1, word2;
+    memcpy(&word1, s1, 8);
+    memcpy(&word2, s2, 8);
+    if (word1 != word2)
+    {
+      // The first differing byte decides, make it the most significant
+      word1= __builtin_bswap64(word1);
+      word2= __builtin_bswap64(word2);
+      return word1 < word2 ? -1 : 1;
+    }
+  }
+#endif
+  return len ? memcmp(s1, s2, len) : 0;
+}
+
+
+/**
+  Stable most significant digit first radix sort of filesort() keys.
+  Unlike radixsort_for_str_ptr(), it only looks at the bytes that are
+  needed to tell the keys apart, and is suited for long keys.
+
+  @param keys         Pointers to the keys to sort
+  @param count        Number of keys
+  @param sort_length  Length of each key
+  @param buffer       Space for 'count' pointers, used while sorting
+*/
+
+void msd_radix_sort(uchar **keys, size_t count, size_t sort_length,
+                    uchar **buffer);
+
+
 /**
   A wrapper class around the buffer used by filesort().
   The sort buffer is a contiguous chunk of memory,
@@ -28,11 +28,13 @@
 #include "binlog.h"                   // mysql_bin_log
 #include "debug_sync.h"               // DEBUG_SYNC
 #include "discover.h"                 // writefrm
+#include "histogram.h"                // Histogram
 #include "log.h"                      // sql_print_error
 #include "log_event.h"                // Write_rows_log_event
 #include "my_bitmap.h"                // MY_BITMAP
 #include "probes_mysql.h"             // MYSQL_HANDLER_WRLOCK_START
 #include "opt_costconstantcache.h"    // reload_optimizer_cost_constants
+#include "opt_range_cache.h"          // Range_estimate_cache
 #include "rpl_handler.h"              // RUN_HOOK
 #include "sql_base.h"                 // free_io_cache
 #include "sql_parse.h"                // check_stack_overrun
@@ -6080,6 +6082,48 @@ bool key_uses_partial_cols(TABLE *table, uint keyno)
  * Default MRR implementation (MRR to non-MRR converter)
  ***************************************************************************/
 
+/**
+  Estimate the number of rows in an equality range on the first key part
+  from the histogram of its column.
+
+  A singleton histogram holds the frequency of each value, and is used
+  instead of an index dive. An equi-height histogram only knows the
+  average frequency of the values of a bucket, and is used where index
+  statistics would be.
+
+  @param table  The table
+  @param keyno  The index
+  @param range  The range
+
+  @return Number of rows, or HA_POS_ERROR if there is no estimate
+*/
+
+static ha_rows histogram_eq_range_rows(TABLE *table, uint keyno,
+                                       const KEY_MULTI_RANGE *range)
+{
+  if (!(range->range_flag & EQ_RANGE) || (range->range_flag & NULL_RANGE) ||
+      range->start_key.keypart_map != 1)
+    return HA_POS_ERROR;
+
+  const KEY_PART_INFO *key_part= table->key_info[keyno].key_part;
+  const Histogram *histogram=
+    table->s->find_histogram(key_part->field->field_index);
+  if (histogram == NULL ||
+      (histogram->type() != Histogram::SINGLETON &&
+       !(range->range_flag & USE_INDEX_STATISTICS)))
+    return HA_POS_ERROR;
+
+  Histogram::Value value;
+  String buf;
+  if (histogram->get_key_value(key_part, range->start_key.key, &value, &buf))
+    return HA_POS_ERROR;
+  const double rows=
+    histogram->get_selectivity(Histogram::EQUAL, &value, 1) *
+    table->file->stats.records;
+  return std::max(static_cast<ha_rows>(rows), static_cast<ha_rows>(1));
+}
+
+
 /**
   Get cost and other information about MRR scan over a known list of ranges
 
@@ -6165,11 +6209,22 @@ handler::multi_range_read_info_const(uint keyno, RANGE_SEQ_IF *seq,
            Ranges of the form "x IS NULL" will not use index statistics 
            because the number of rows with this value are likely to be 
            very different than the values in the index statistics.
+        3) The range is an equality range on the first key part, and its
+           column has a histogram, see histogram_eq_range_rows(). This
+           is checked before 2) since a singleton histogram knows the
+           frequency of the value itself.
+      The result of records_in_range() may come from an earlier statement,
+      see Range_estimate_cache.
     */
     int keyparts_used= 0;
     if ((range.range_flag & UNIQUE_RANGE) &&                        // 1)
         !(range.range_flag & NULL_RANGE))
       rows= 1; /* there can be at most one row */
+    else if ((rows= histogram_eq_range_rows(table, keyno, &range)) !=
+             HA_POS_ERROR)                                          // 3)
+    {
+      /* rows has been estimated from the histogram */
+    }
     else if ((range.range_flag & EQ_RANGE) &&                       // 2a)
              (range.range_flag & USE_INDEX_STATISTICS) &&           // 2b)
              (keyparts_used= my_count_bits(range.start_key.keypart_map)) &&
@@ -6184,8 +6239,9 @@ handler::multi_range_read_info_const(uint keyno, RANGE_SEQ_IF *seq,
     {
       DBUG_EXECUTE_IF("crash_records_in_range", DBUG_SUICIDE(););
       DBUG_ASSERT(min_endp || max_endp);
-      if (HA_POS_ERROR == (rows= this->records_in_range(keyno, min_endp, 
-                                                        max_endp)))
+      if (HA_POS_ERROR ==
+          (rows= Range_estimate_cache::records_in_range(table, this, keyno,
+                                                        min_endp, max_endp)))
       {
         /* Can't scan one range => can't do MRR scan at all */
         total_rows= HA_POS_ERROR;
@@ -6404,6 +6460,265 @@ scan_it_again:
  * DS-MRR implementation 
  ***************************************************************************/
 
+/*
+  DS-MRR: key-ordered lookups (HA_MRR_KEY_LOOKUPS)
+
+  When all ranges are single key lookups in no particular order, like the
+  ones of Batched Key Access, the ranges are read into a buffer and sorted
+  by key before they are given to h2, or to h itself for a clustered
+  primary key. The index lookups then go through the index in key order,
+  and find the pages they need in the buffer pool more often. The range
+  sequence functions below are given to the index handler instead of the
+  ones of the MRR user, and serve the sorted ranges.
+*/
+
+static range_seq_t key_ordered_seq_init(void *init_param, uint n_ranges,
+                                        uint flags)
+{
+  return init_param;
+}
+
+
+static uint key_ordered_seq_next(range_seq_t seq, KEY_MULTI_RANGE *range)
+{
+  return static_cast<DsMrr_impl*>(seq)->key_seq_next(range);
+}
+
+
+static bool key_ordered_seq_skip_record(range_seq_t seq, char *range_info,
+                                        uchar *rowid)
+{
+  return static_cast<DsMrr_impl*>(seq)->key_seq_skip_record(range_info,
+                                                            rowid);
+}
+
+
+static bool key_ordered_seq_skip_index_tuple(range_seq_t seq,
+                                             char *range_info)
+{
+  return static_cast<DsMrr_impl*>(seq)->key_seq_skip_index_tuple(range_info);
+}
+
+
+/**
+  Compare two start keys, in the order of the index.
+
+  Ranges without a start key go first. Key parts that are prefixes of
+  their column are not compared, nor any key part after them, as the
+  order only needs to be approximately the one of the index.
+*/
+
+static int start_key_cmp(const KEY *key_info, const key_range *r1,
+                         const key_range *r2)
+{
+  if (!r1->keypart_map || !r2->keypart_map)
+    return MY_TEST(r1->keypart_map) - MY_TEST(r2->keypart_map);
+
+  const uchar *k1= r1->key;
+  const uchar *k2= r2->key;
+  const uchar *const k1_end= k1 + min(r1->length, r2->length);
+  const KEY_PART_INFO *part= key_info->key_part;
+  const KEY_PART_INFO *const part_end= part + key_info->actual_key_parts;
+  for (; k1 < k1_end && part < part_end; part++)
+  {
+    if (part->key_part_flag & HA_PART_KEY_SEG)
+      return 0;
+    if (part->null_bit)
+    {
+      // NULL sorts first
+      if (*k1 != *k2)
+        return *k1 ? -1 : 1;
+      if (*k1)
+      {
+        k1+= part->store_length;
+        k2+= part->store_length;
+        continue;
+      }
+    }
+    const uint null_length= part->null_bit ? 1 : 0;
+    const int res= part->field->key_cmp(k1 + null_length, k2 + null_length);
+    if (res)
+      return res;
+    k1+= part->store_length;
+    k2+= part->store_length;
+  }
+  return 0;
+}
+
+
+/**
+  Compare two ranges of keys_buf by their start keys.
+
+  Ranges with equal start keys keep the order of the MRR user, which is
+  the order of their entries in keys_buf. my_qsort2() is not stable.
+*/
+
+static int key_range_cmp(const void *arg, const void *a, const void *b)
+{
+  const KEY_MULTI_RANGE *r1= *static_cast<KEY_MULTI_RANGE* const*>(a);
+  const KEY_MULTI_RANGE *r2= *static_cast<KEY_MULTI_RANGE* const*>(b);
+  const int res= start_key_cmp(static_cast<const KEY*>(arg),
+                               &r1->start_key, &r2->start_key);
+  if (res)
+    return res;
+  return r1 < r2 ? -1 : (r1 > r2 ? 1 : 0);
+}
+
+
+/**
+  DS-MRR: Prepare to give the ranges of the MRR user to the index in key order
+
+  @param keyno           Index of the lookups
+  @param seq_funcs       Range sequence of the MRR user
+  @param seq_init_param  Range sequence parameter of the MRR user
+  @param n_ranges        Number of ranges in the sequence
+  @param mode            HA_MRR_* modes
+  @param buffer_size     Size of the buffer to sort the ranges in
+  @param[out] key_seq    Range sequence to give to the index handler
+
+  @retval false  OK
+  @retval true   Out of memory, the ranges must be read unsorted
+*/
+
+bool DsMrr_impl::key_seq_setup(uint keyno, RANGE_SEQ_IF *seq_funcs,
+                               void *seq_init_param, uint n_ranges, uint mode,
+                               size_t buffer_size, RANGE_SEQ_IF *key_seq)
+{
+  DBUG_ENTER("DsMrr_impl::key_seq_setup");
+
+  // A range with a start and an end key of the index, and its pointer
+  const KEY *key_info= &table->key_info[keyno];
+  uint key_length= 0;
+  for (uint i= 0; i < key_info->actual_key_parts; i++)
+    key_length+= key_info->key_part[i].store_length;
+  key_seq_entry_size= ALIGN_SIZE(sizeof(KEY_MULTI_RANGE)) +
+                      2 * ALIGN_SIZE(key_length) + sizeof(uchar*);
+
+  // Room for a few ranges at least, or sorting them is of little use
+  buffer_size= ALIGN_SIZE(max(buffer_size, 16 * key_seq_entry_size));
+  if (keys_buf == NULL || static_cast<size_t>(keys_buf_end - keys_buf) <
+                          buffer_size)
+  {
+    if (!(keys_buf= static_cast<uchar*>(table->in_use->alloc(buffer_size))))
+    {
+      keys_buf_end= NULL;
+      DBUG_RETURN(true);
+    }
+    keys_buf_end= keys_buf + buffer_size;
+  }
+
+  key_seq_keyno= keyno;
+  key_seq_funcs= *seq_funcs;
+  key_seq_iter= seq_funcs->init(seq_init_param, n_ranges, mode);
+  key_seq_eof= false;
+  key_ptrs_cur= key_ptrs_end= NULL;
+
+  key_seq->init= key_ordered_seq_init;
+  key_seq->next= key_ordered_seq_next;
+  key_seq->skip_record=
+    seq_funcs->skip_record ? key_ordered_seq_skip_record : NULL;
+  key_seq->skip_index_tuple=
+    seq_funcs->skip_index_tuple ? key_ordered_seq_skip_index_tuple : NULL;
+  DBUG_RETURN(false);
+}
+
+
+/**
+  DS-MRR: Read the next ranges of the MRR user into keys_buf, and sort them
+
+  The keys are copied, as the MRR user may keep them in a buffer that is
+  reused for the next range.
+*/
+
+void DsMrr_impl::key_seq_fill_buffer()
+{
+  DBUG_ENTER("DsMrr_impl::key_seq_fill_buffer");
+  uchar *entry= keys_buf;
+  uchar **const ptrs_end= reinterpret_cast<uchar**>(keys_buf_end);
+  uchar **ptrs= ptrs_end;
+  KEY_MULTI_RANGE range;
+
+  while (entry + key_seq_entry_size <= reinterpret_cast<uchar*>(ptrs))
+  {
+    if (key_seq_funcs.next(key_seq_iter, &range))
+    {
+      key_seq_eof= true;
+      break;
+    }
+    DBUG_ASSERT(ALIGN_SIZE(sizeof(KEY_MULTI_RANGE)) +
+                ALIGN_SIZE(range.start_key.length) +
+                ALIGN_SIZE(range.end_key.length) + sizeof(uchar*) <=
+                key_seq_entry_size);
+
+    KEY_MULTI_RANGE *const copy= reinterpret_cast<KEY_MULTI_RANGE*>(entry);
+    *copy= range;
+    uchar *key= entry + ALIGN_SIZE(sizeof(KEY_MULTI_RANGE));
+    if (range.start_key.keypart_map)
+    {
+      memcpy(key, range.start_key.key, range.start_key.length);
+      copy->start_key.key= key;
+      key+= ALIGN_SIZE(range.start_key.length);
+    }
+    if (range.end_key.keypart_map)
+    {
+      if (range.end_key.key == range.start_key.key &&
+          range.end_key.length <= range.start_key.length)
+        copy->end_key.key= copy->start_key.key;
+      else
+      {
+        memcpy(key, range.end_key.key, range.end_key.length);
+        copy->end_key.key= key;
+        key+= ALIGN_SIZE(range.end_key.length);
+      }
+    }
+    *--ptrs= entry;
+    entry= key;
+  }
+
+  my_qsort2(ptrs, ptrs_end - ptrs, sizeof(uchar*), key_range_cmp,
+            &table->key_info[key_seq_keyno]);
+  key_ptrs_cur= ptrs;
+  key_ptrs_end= ptrs_end;
+  DBUG_PRINT("info", ("sorted %u ranges",
+                       (uint) (key_ptrs_end - key_ptrs_cur)));
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  DS-MRR: Get the next range for h2 in key order
+
+  @retval 0  OK, the range is in *range
+  @retval 1  No more ranges
+*/
+
+uint DsMrr_impl::key_seq_next(KEY_MULTI_RANGE *range)
+{
+  if (key_ptrs_cur == key_ptrs_end)
+  {
+    if (key_seq_eof)
+      return 1;
+    key_seq_fill_buffer();
+    if (key_ptrs_cur == key_ptrs_end)
+      return 1;
+  }
+  *range= *reinterpret_cast<KEY_MULTI_RANGE*>(*key_ptrs_cur++);
+  return 0;
+}
+
+
+bool DsMrr_impl::key_seq_skip_record(char *range_info, uchar *rowid)
+{
+  return key_seq_funcs.skip_record(key_seq_iter, range_info, rowid);
+}
+
+
+bool DsMrr_impl::key_seq_skip_index_tuple(char *range_info)
+{
+  return key_seq_funcs.skip_index_tuple(key_seq_iter, range_info);
+}
+
+
 /**
   DS-MRR: Initialize and start MRR scan
 
@@ -6466,6 +6781,34 @@ int DsMrr_impl::dsmrr_init(handler *h_arg, RANGE_SEQ_IF *seq_funcs,
     DBUG_RETURN(retval);
   }
 
+  /*
+    Lookups on a clustered primary key read the rows themselves, there are
+    no rowids to sort. The lookup keys are sorted in the MRR buffer, and
+    the rows are read with the default implementation, see
+    choose_mrr_impl(). When a DS-MRR scan is restarted, h is not open on
+    an index but reads the rows of h2 with rnd_pos().
+  */
+  if (h->inited == handler::INDEX &&
+      h->active_index == table->s->primary_key &&
+      h->primary_key_is_clustered())
+  {
+    RANGE_SEQ_IF key_seq;
+    use_default_impl= TRUE;
+    if ((mode & HA_MRR_KEY_LOOKUPS) &&
+        !key_seq_setup(h->active_index, seq_funcs, seq_init_param, n_ranges,
+                       mode, buf->buffer_end - buf->buffer, &key_seq))
+    {
+      if ((retval= h->extra(HA_EXTRA_KEY_ORDERED_READS)))
+        DBUG_RETURN(retval);
+      retval= h->handler::multi_range_read_init(&key_seq, this, n_ranges,
+                                                mode, buf);
+    }
+    else
+      retval= h->handler::multi_range_read_init(seq_funcs, seq_init_param,
+                                                n_ranges, mode, buf);
+    DBUG_RETURN(retval);
+  }
+
   /* 
     This assert will hit if we have pushed an index condition to the
     primary key index and then "change our mind" and use a different
@@ -6596,8 +6939,23 @@ int DsMrr_impl::dsmrr_init(handler *h_arg, RANGE_SEQ_IF *seq_funcs,
   DBUG_ASSERT(h2->active_index != MAX_KEY);
   DBUG_ASSERT(h->m_lock_type == h2->m_lock_type);
 
-  if ((retval= h2->handler::multi_range_read_init(seq_funcs, seq_init_param, 
-                                                  n_ranges, mode, buf)))
+  /*
+    Sort single key lookups by key, in a buffer of the same size as the
+    rowid buffer. If that fails, the lookups are made in the given order.
+  */
+  RANGE_SEQ_IF key_seq;
+  if ((mode & HA_MRR_KEY_LOOKUPS) &&
+      !key_seq_setup(h2->active_index, seq_funcs, seq_init_param, n_ranges,
+                     mode, rowids_buf_end - rowids_buf, &key_seq))
+  {
+    if ((retval= h2->extra(HA_EXTRA_KEY_ORDERED_READS)) ||
+        (retval= h2->handler::multi_range_read_init(&key_seq, this,
+                                                    n_ranges, mode, buf)))
+      goto error;
+  }
+  else if ((retval= h2->handler::multi_range_read_init(seq_funcs,
+                                                       seq_init_param,
+                                                       n_ranges, mode, buf)))
     goto error;
 
   if ((retval= dsmrr_fill_buffer()))
@@ -6621,6 +6979,9 @@ int DsMrr_impl::dsmrr_init(handler *h_arg, RANGE_SEQ_IF *seq_funcs,
     retval= 1;
     goto error;
   }
+  // The rowids are read in sorted order
+  if ((retval= h->extra(HA_EXTRA_KEY_ORDERED_READS)))
+    goto error;
 
   use_default_impl= FALSE;
   h->mrr_funcs= *seq_funcs;
@@ -6666,6 +7027,8 @@ void DsMrr_impl::reset()
     delete h2;
     h2= NULL;
   }
+  // The buffer is on the MEM_ROOT of the statement
+  keys_buf= keys_buf_end= NULL;
   DBUG_VOID_RETURN;
 }
 
@@ -6922,15 +7285,33 @@ bool DsMrr_impl::choose_mrr_impl(uint keyno, ha_rows rows, uint *flags,
     hint_table_state(thd, table, BKA_HINT_ENUM, 0);
 
   if (!(mrr_on || force_dsmrr_by_hints) ||
-      *flags & (HA_MRR_INDEX_ONLY | HA_MRR_SORTED) || // Unsupported by DS-MRR
-      (keyno == table->s->primary_key && h->primary_key_is_clustered()) ||
-       key_uses_partial_cols(table, keyno) ||
-       table->s->tmp_table != NO_TMP_TABLE)
+      *flags & HA_MRR_SORTED ||                        // Unsupported by DS-MRR
+      table->s->tmp_table != NO_TMP_TABLE)
   {
     /* Use the default implementation, don't modify args: See comments  */
     return TRUE;
   }
 
+  /*
+    A clustered primary key has no rowids to sort. Only single key lookups
+    in no particular order are worth sorting by key, see dsmrr_init(). As
+    that costs next to nothing and the rows are read with the default
+    implementation, its cost is kept, and the heuristics below, which are
+    about sorting rowids, do not apply.
+  */
+  if (keyno == table->s->primary_key && h->primary_key_is_clustered())
+  {
+    if (!(*flags & HA_MRR_KEY_LOOKUPS))
+      return TRUE;
+    *flags &= ~HA_MRR_USE_DEFAULT_IMPL;  /* Use the DS-MRR implementation */
+    *flags &= ~HA_MRR_SUPPORT_SORTED;    /* We can't provide ordered output */
+    return FALSE;
+  }
+
+  if (*flags & HA_MRR_INDEX_ONLY ||                    // Unsupported by DS-MRR
+      key_uses_partial_cols(table, keyno))
+    return TRUE;
+
   /*
     If @@optimizer_switch has "mrr_cost_based" on, we should avoid
     using DS-MRR for queries where it is likely that the records are
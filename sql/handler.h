@@ -1888,6 +1888,12 @@ void get_sweep_read_cost(TABLE *table, ha_rows nrows, bool interrupted,
 */
 #define HA_MRR_SUPPORT_SORTED 256
 
+/*
+  The MRR user provides ranges that are single key lookups (EQ_RANGE), in
+  no particular order. The MRR implementation may read them in key order.
+*/
+#define HA_MRR_KEY_LOOKUPS 512
+
 
 class ha_statistics
 {
@@ -2878,6 +2884,21 @@ public:
   virtual int read_first_row(uchar *buf, uint primary_key);
   virtual ha_rows records_in_range(uint inx, key_range *min_key, key_range *max_key)
     { return (ha_rows) 10; }
+  /**
+    Number of rows that all sessions have inserted, updated or deleted in
+    the table since the engine last recalculated its statistics. Tells
+    when cached results of records_in_range() are stale, see
+    Range_estimate_cache.
+
+    @retval HA_POS_ERROR  The engine does not count the changes
+  */
+  virtual ha_rows stat_modified_rows() { return HA_POS_ERROR; }
+  /**
+    A number that the engine changes each time it recalculates the
+    statistics of the table, which restarts the count of
+    stat_modified_rows().
+  */
+  virtual ulonglong stat_generation() { return 0; }
   /*
     If HA_PRIMARY_KEY_REQUIRED_FOR_POSITION is set, then it sets ref
     (reference to the row, aka position, with the primary key given in
@@ -3854,7 +3875,7 @@ class DsMrr_impl
 public:
   typedef void (handler::*range_check_toggle_func_t)(bool on);
 
-  DsMrr_impl() : h2(NULL) {}
+  DsMrr_impl() : h2(NULL), keys_buf(NULL), keys_buf_end(NULL) {}
 
   ~DsMrr_impl()
   {
@@ -3890,6 +3911,23 @@ private:
   bool is_mrr_assoc;
 
   bool use_default_impl; /* TRUE <=> shortcut all calls to default MRR impl */
+
+  /*
+    Key-ordered lookups (HA_MRR_KEY_LOOKUPS): the ranges of the MRR user
+    are copied to keys_buf, a buffer at a time, sorted by key, and given
+    from there to h2, or to h for a clustered primary key. The buffer
+    holds the ranges with their keys from the start, and the array of
+    pointers to them, to be sorted, from the end.
+  */
+  uint key_seq_keyno;           /* Index of the lookups */
+  RANGE_SEQ_IF key_seq_funcs;   /* Range sequence of the MRR user */
+  range_seq_t key_seq_iter;
+  bool key_seq_eof;
+  uchar *keys_buf;
+  uchar *keys_buf_end;
+  size_t key_seq_entry_size;    /* Max. size of a range with its keys */
+  uchar **key_ptrs_cur;         /* Next range to give to the index */
+  uchar **key_ptrs_end;         /* End of the pointers in use */
 public:
   /**
     Initialize the DsMrr_impl object.
@@ -3927,6 +3965,9 @@ public:
   void reset();
   int dsmrr_fill_buffer();
   int dsmrr_next(char **range_info);
+  uint key_seq_next(KEY_MULTI_RANGE *range);
+  bool key_seq_skip_record(char *range_info, uchar *rowid);
+  bool key_seq_skip_index_tuple(char *range_info);
 
   ha_rows dsmrr_info(uint keyno, uint n_ranges, uint keys, uint *bufsz,
                      uint *flags, Cost_estimate *cost);
@@ -3939,6 +3980,10 @@ private:
                        Cost_estimate *cost);
   bool get_disk_sweep_mrr_cost(uint keynr, ha_rows rows, uint flags, 
                                uint *buffer_size, Cost_estimate *cost);
+  bool key_seq_setup(uint keyno, RANGE_SEQ_IF *seq_funcs,
+                     void *seq_init_param, uint n_ranges, uint mode,
+                     size_t buffer_size, RANGE_SEQ_IF *key_seq);
+  void key_seq_fill_buffer();
 };
 	/* Some extern variables used with handlers */
 
@@ -0,0 +1,1848 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Column histograms, see Histogram.
+*/
+
+#include "histogram.h"
+
+#include "field.h"                              // Field
+#include "hash.h"                               // HASH
+#include "item.h"                               // Item
+#include "json_dom.h"                           // Json_object
+#include "key.h"                                // key_copy
+#include "log.h"                                // sql_print_warning
+#include "mysqld.h"                             // key_memory_histograms
+#include "records.h"                            // READ_RECORD
+#include "rpl_table_access.h"                   // System_table_access
+#include "sql_base.h"                           // MYSQL_OPEN_IGNORE_FLUSH
+#include "sql_class.h"                          // THD
+#include "sql_lex.h"                            // lex_start
+#include "table.h"                              // TABLE
+#include "template_utils.h"                     // down_cast
+
+#include <algorithm>
+#include <string>
+
+/*
+  The columns of mysql.histograms:
+
+  database_name VARCHAR(64) NOT NULL,
+  table_name    VARCHAR(64) NOT NULL,
+  column_name   VARCHAR(64) NOT NULL,
+  last_update   TIMESTAMP NOT NULL,
+  histogram     JSON NOT NULL,
+  PRIMARY KEY (database_name, table_name, column_name)
+*/
+enum enum_histograms_field
+{
+  HISTOGRAMS_FIELD_DB= 0,
+  HISTOGRAMS_FIELD_TABLE,
+  HISTOGRAMS_FIELD_COLUMN,
+  HISTOGRAMS_FIELD_LAST_UPDATE,
+  HISTOGRAMS_FIELD_HISTOGRAM,
+  HISTOGRAMS_FIELD_COUNT
+};
+
+static const char *histogram_type_names[]= { "singleton", "equi-height" };
+
+static const char *value_type_names[]=
+{ "int", "uint", "double", "date", "datetime", "time", "string" };
+
+
+/**
+  Compare two values of a column.
+
+  Numbers are compared as doubles, so that comparisons with constants
+  that are not integers work as they do in the server. Temporal values
+  are compared as their packed integers.
+*/
+
+static int compare_values(Histogram::enum_value_type type,
+                          const CHARSET_INFO *charset,
+                          const Histogram::Value &a,
+                          const Histogram::Value &b)
+{
+  switch (type)
+  {
+  case Histogram::INT_VALUE:
+  case Histogram::UINT_VALUE:
+  case Histogram::DOUBLE_VALUE:
+    return a.number < b.number ? -1 : (a.number > b.number ? 1 : 0);
+  case Histogram::DATE_VALUE:
+  case Histogram::DATETIME_VALUE:
+  case Histogram::TIME_VALUE:
+    return a.integer < b.integer ? -1 : (a.integer > b.integer ? 1 : 0);
+  case Histogram::STRING_VALUE:
+    return charset->coll->strnncollsp(charset,
+                                      pointer_cast<const uchar*>(a.str),
+                                      a.length,
+                                      pointer_cast<const uchar*>(b.str),
+                                      b.length, 0);
+  }
+  DBUG_ASSERT(false);
+  return 0;
+}
+
+
+/** Orders values for std::sort() */
+
+class Value_less
+{
+public:
+  Value_less(Histogram::enum_value_type type, const CHARSET_INFO *charset)
+    : m_type(type), m_charset(charset)
+  {}
+
+  bool operator()(const Histogram::Value &a, const Histogram::Value &b) const
+  {
+    return compare_values(m_type, m_charset, a, b) < 0;
+  }
+
+private:
+  Histogram::enum_value_type m_type;
+  const CHARSET_INFO *m_charset;
+};
+
+
+/** Truncate a string to Histogram::STRING_LENGTH characters */
+
+static size_t truncated_length(const CHARSET_INFO *charset, const char *str,
+                               size_t length)
+{
+  const size_t pos= my_charpos(charset, str, str + length,
+                               Histogram::STRING_LENGTH);
+  return std::min(pos, length);
+}
+
+
+bool Histogram::get_value_type(const Field *field, enum_value_type *type)
+{
+  switch (field->real_type())
+  {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+  case MYSQL_TYPE_YEAR:
+    *type= (field->flags & UNSIGNED_FLAG) ? UINT_VALUE : INT_VALUE;
+    return false;
+  case MYSQL_TYPE_FLOAT:
+  case MYSQL_TYPE_DOUBLE:
+  case MYSQL_TYPE_DECIMAL:
+  case MYSQL_TYPE_NEWDECIMAL:
+    *type= DOUBLE_VALUE;
+    return false;
+  case MYSQL_TYPE_DATE:
+  case MYSQL_TYPE_NEWDATE:
+    *type= DATE_VALUE;
+    return false;
+  case MYSQL_TYPE_DATETIME:
+  case MYSQL_TYPE_DATETIME2:
+  case MYSQL_TYPE_TIMESTAMP:
+  case MYSQL_TYPE_TIMESTAMP2:
+    *type= DATETIME_VALUE;
+    return false;
+  case MYSQL_TYPE_TIME:
+  case MYSQL_TYPE_TIME2:
+    *type= TIME_VALUE;
+    return false;
+  case MYSQL_TYPE_STRING:
+  case MYSQL_TYPE_VARCHAR:
+  case MYSQL_TYPE_VAR_STRING:
+  case MYSQL_TYPE_BLOB:
+    // Binary strings can not be stored in the JSON form
+    if (field->charset() == &my_charset_bin)
+      return true;
+    *type= STRING_VALUE;
+    return false;
+  default:
+    // ENUM, SET, BIT, GEOMETRY and JSON
+    return true;
+  }
+}
+
+
+size_t Histogram::max_string_length(const Field *field)
+{
+  return STRING_LENGTH * field->charset()->mbmaxlen;
+}
+
+
+void Histogram::read_field(Field *field, enum_value_type type, Value *value,
+                           char *buf)
+{
+  value->number= 0.0;
+  value->integer= 0;
+  value->str= NULL;
+  value->length= 0;
+
+  switch (type)
+  {
+  case INT_VALUE:
+    value->integer= field->val_int();
+    value->number= static_cast<double>(value->integer);
+    break;
+  case UINT_VALUE:
+    value->integer= field->val_int();
+    value->number= ulonglong2double(static_cast<ulonglong>(value->integer));
+    break;
+  case DOUBLE_VALUE:
+    value->number= field->val_real();
+    break;
+  case DATE_VALUE:
+  case DATETIME_VALUE:
+    value->integer= field->val_date_temporal();
+    value->number= static_cast<double>(value->integer);
+    break;
+  case TIME_VALUE:
+    value->integer= field->val_time_temporal();
+    value->number= static_cast<double>(value->integer);
+    break;
+  case STRING_VALUE:
+  {
+    String tmp;
+    const String *res= field->val_str(&tmp);
+    value->length= truncated_length(field->charset(), res->ptr(),
+                                    res->length());
+    memcpy(buf, res->ptr(), value->length);
+    value->str= buf;
+    break;
+  }
+  }
+}
+
+
+Histogram *Histogram::build(MEM_ROOT *mem_root, enum_value_type type,
+                            const CHARSET_INFO *charset, Value *values,
+                            size_t value_count, size_t row_count,
+                            double sampling_rate, uint buckets)
+{
+  DBUG_ENTER("Histogram::build");
+  DBUG_ASSERT(value_count <= row_count);
+  DBUG_ASSERT(buckets > 0);
+
+  std::sort(values, values + value_count, Value_less(type, charset));
+
+  size_t distinct= 0;
+  for (size_t i= 0; i < value_count; i++)
+  {
+    if (i == 0 || compare_values(type, charset, values[i - 1], values[i]))
+      distinct++;
+  }
+
+  Histogram *histogram= new (mem_root) Histogram;
+  if (histogram == NULL)
+    DBUG_RETURN(NULL);
+  histogram->m_type= distinct <= buckets ? SINGLETON : EQUI_HEIGHT;
+  histogram->m_value_type= type;
+  histogram->m_charset= charset;
+  histogram->m_null_fraction=
+    row_count ? static_cast<double>(row_count - value_count) / row_count : 0.0;
+  histogram->m_sampling_rate= std::min(sampling_rate, 1.0);
+  histogram->m_buckets_specified= buckets;
+
+  const size_t max_buckets= std::min<size_t>(distinct, buckets);
+  histogram->m_buckets=
+    static_cast<Bucket*>(alloc_root(mem_root,
+                                    std::max<size_t>(max_buckets, 1) *
+                                    sizeof(Bucket)));
+  if (histogram->m_buckets == NULL)
+    DBUG_RETURN(NULL);
+
+  /*
+    Each bucket of a singleton histogram gets the values of one distinct
+    value. The buckets of an equi-height histogram get distinct values
+    until the bucket holds its share of the values.
+  */
+  size_t i= 0;
+  uint count= 0;
+  while (i < value_count)
+  {
+    Bucket *const bucket= &histogram->m_buckets[count];
+    const size_t target= (count + 1 == max_buckets) ? value_count :
+      static_cast<size_t>(static_cast<double>(count + 1) * value_count /
+                          max_buckets);
+    bucket->lower= values[i];
+    bucket->distinct= 0;
+    do
+    {
+      bucket->upper= values[i];
+      bucket->distinct++;
+      for (i++; i < value_count &&
+             !compare_values(type, charset, values[i - 1], values[i]); i++)
+      {}
+    } while (histogram->m_type == EQUI_HEIGHT && i < target);
+    bucket->cumulative= static_cast<double>(i) / row_count;
+    count++;
+  }
+  histogram->m_bucket_count= count;
+
+  // Strings point into the sample, copy them
+  if (type == STRING_VALUE)
+  {
+    for (uint b= 0; b < count; b++)
+    {
+      Bucket *const bucket= &histogram->m_buckets[b];
+      if (!(bucket->lower.str= strmake_root(mem_root, bucket->lower.str,
+                                            bucket->lower.length)) ||
+          !(bucket->upper.str= strmake_root(mem_root, bucket->upper.str,
+                                            bucket->upper.length)))
+        DBUG_RETURN(NULL);
+    }
+  }
+  DBUG_PRINT("info", ("%s histogram with %u buckets of %lu values",
+                      histogram_type_names[histogram->m_type], count,
+                      static_cast<ulong>(value_count)));
+  DBUG_RETURN(histogram);
+}
+
+
+Histogram *Histogram::clone(MEM_ROOT *mem_root) const
+{
+  Histogram *histogram= new (mem_root) Histogram(*this);
+  if (histogram == NULL)
+    return NULL;
+  histogram->m_buckets=
+    static_cast<Bucket*>(memdup_root(mem_root, m_buckets,
+                                     std::max(m_bucket_count, 1U) *
+                                     sizeof(Bucket)));
+  if (histogram->m_buckets == NULL)
+    return NULL;
+  if (m_value_type == STRING_VALUE)
+  {
+    for (uint i= 0; i < m_bucket_count; i++)
+    {
+      Bucket *const bucket= &histogram->m_buckets[i];
+      if (!(bucket->lower.str= strmake_root(mem_root, bucket->lower.str,
+                                            bucket->lower.length)) ||
+          !(bucket->upper.str= strmake_root(mem_root, bucket->upper.str,
+                                            bucket->upper.length)))
+        return NULL;
+    }
+  }
+  return histogram;
+}
+
+
+bool Histogram::is_compatible(const Field *field) const
+{
+  enum_value_type type;
+  if (get_value_type(field, &type) || type != m_value_type)
+    return false;
+  return type != STRING_VALUE || field->charset() == m_charset;
+}
+
+
+/*
+  The JSON form of a histogram is
+
+  {
+    "histogram-type": "singleton" | "equi-height",
+    "data-type": "int" | "uint" | "double" | "date" | "datetime" | "time" |
+                 "string",
+    "collation-id": <number>,
+    "null-values": <fraction>,
+    "sampling-rate": <fraction>,
+    "number-of-buckets-specified": <number>,
+    "buckets": [ <bucket>, ... ]
+  }
+
+  where a bucket of a singleton histogram is [<value>, <cumulative>], and
+  a bucket of an equi-height histogram is
+  [<lower>, <upper>, <cumulative>, <distinct values>].
+*/
+
+/** The JSON form of a value, or NULL if out of memory */
+
+static Json_dom *value_to_json(Histogram::enum_value_type type,
+                               const CHARSET_INFO *charset,
+                               const Histogram::Value &value)
+{
+  MYSQL_TIME ltime;
+  switch (type)
+  {
+  case Histogram::INT_VALUE:
+    return new (std::nothrow) Json_int(value.integer);
+  case Histogram::UINT_VALUE:
+    return new (std::nothrow)
+      Json_uint(static_cast<ulonglong>(value.integer));
+  case Histogram::DOUBLE_VALUE:
+    return new (std::nothrow) Json_double(value.number);
+  case Histogram::DATE_VALUE:
+    TIME_from_longlong_date_packed(&ltime, value.integer);
+    return new (std::nothrow) Json_datetime(ltime, MYSQL_TYPE_DATE);
+  case Histogram::DATETIME_VALUE:
+    TIME_from_longlong_datetime_packed(&ltime, value.integer);
+    return new (std::nothrow) Json_datetime(ltime, MYSQL_TYPE_DATETIME);
+  case Histogram::TIME_VALUE:
+    TIME_from_longlong_time_packed(&ltime, value.integer);
+    return new (std::nothrow) Json_datetime(ltime, MYSQL_TYPE_TIME);
+  case Histogram::STRING_VALUE:
+  {
+    String utf8;
+    uint errors;
+    if (utf8.copy(value.str, value.length, charset, &my_charset_utf8mb4_bin,
+                  &errors))
+      return NULL;
+    return new (std::nothrow)
+      Json_string(std::string(utf8.ptr(), utf8.length()));
+  }
+  }
+  DBUG_ASSERT(false);
+  return NULL;
+}
+
+
+Json_object *Histogram::to_json() const
+{
+  Json_object *object= new (std::nothrow) Json_object();
+  Json_array *buckets= new (std::nothrow) Json_array();
+  if (object == NULL || buckets == NULL)
+  {
+    delete object;
+    delete buckets;
+    return NULL;
+  }
+
+  bool error=
+    object->add_alias("histogram-type",
+                      new (std::nothrow)
+                      Json_string(histogram_type_names[m_type])) ||
+    object->add_alias("data-type",
+                      new (std::nothrow)
+                      Json_string(value_type_names[m_value_type])) ||
+    object->add_alias("collation-id",
+                      new (std::nothrow) Json_uint(m_charset->number)) ||
+    object->add_alias("null-values",
+                      new (std::nothrow) Json_double(m_null_fraction)) ||
+    object->add_alias("sampling-rate",
+                      new (std::nothrow) Json_double(m_sampling_rate)) ||
+    object->add_alias("number-of-buckets-specified",
+                      new (std::nothrow) Json_uint(m_buckets_specified));
+
+  for (uint i= 0; i < m_bucket_count && !error; i++)
+  {
+    const Bucket &bucket= m_buckets[i];
+    Json_array *json_bucket= new (std::nothrow) Json_array();
+    if (json_bucket == NULL || buckets->append_alias(json_bucket))
+    {
+      delete json_bucket;
+      error= true;
+      break;
+    }
+    error= json_bucket->append_alias(value_to_json(m_value_type, m_charset,
+                                                   bucket.lower));
+    if (m_type == EQUI_HEIGHT && !error)
+      error= json_bucket->append_alias(value_to_json(m_value_type,
+                                                     m_charset,
+                                                     bucket.upper));
+    if (!error)
+      error= json_bucket->append_alias(new (std::nothrow)
+                                       Json_double(bucket.cumulative));
+    if (m_type == EQUI_HEIGHT && !error)
+      error= json_bucket->append_alias(new (std::nothrow)
+                                       Json_uint(static_cast<ulonglong>
+                                                 (bucket.distinct)));
+  }
+  if (error || object->add_alias("buckets", buckets))
+  {
+    if (error)
+      delete buckets;
+    delete object;
+    return NULL;
+  }
+  return object;
+}
+
+
+/** Look up a member of a JSON object, with a given type */
+
+static bool get_member(const Json_wrapper &object, const char *key,
+                       Json_dom::enum_json_type type, Json_wrapper *member)
+{
+  *member= object.lookup(key, strlen(key));
+  return member->empty() || member->type() != type;
+}
+
+
+/** Get a JSON number as a double */
+
+static bool get_number(const Json_wrapper &json, double *number)
+{
+  if (json.empty())
+    return true;
+  switch (json.type())
+  {
+  case Json_dom::J_INT:
+    *number= static_cast<double>(json.get_int());
+    return false;
+  case Json_dom::J_UINT:
+    *number= ulonglong2double(json.get_uint());
+    return false;
+  case Json_dom::J_DOUBLE:
+    *number= json.get_double();
+    return false;
+  default:
+    return true;
+  }
+}
+
+
+/** Get the member of a JSON object that is a number */
+
+static bool get_number_member(const Json_wrapper &object, const char *key,
+                              double *number)
+{
+  return get_number(object.lookup(key, strlen(key)), number);
+}
+
+
+/** Find the name in a list of names, as given in a JSON string */
+
+static bool get_name(const Json_wrapper &json, const char **names,
+                     uint count, uint *index)
+{
+  for (uint i= 0; i < count; i++)
+  {
+    if (json.get_data_length() == strlen(names[i]) &&
+        !memcmp(json.get_data(), names[i], json.get_data_length()))
+    {
+      *index= i;
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/** Get a value of a bucket from its JSON form */
+
+static bool json_to_value(MEM_ROOT *mem_root,
+                          Histogram::enum_value_type type,
+                          const CHARSET_INFO *charset,
+                          const Json_wrapper &json, Histogram::Value *value)
+{
+  value->number= 0.0;
+  value->integer= 0;
+  value->str= NULL;
+  value->length= 0;
+  if (json.empty())
+    return true;
+
+  switch (type)
+  {
+  case Histogram::INT_VALUE:
+  case Histogram::UINT_VALUE:
+    if (json.type() == Json_dom::J_INT)
+      value->integer= json.get_int();
+    else if (json.type() == Json_dom::J_UINT)
+      value->integer= static_cast<longlong>(json.get_uint());
+    else
+      return true;
+    value->number= type == Histogram::INT_VALUE ?
+      static_cast<double>(value->integer) :
+      ulonglong2double(static_cast<ulonglong>(value->integer));
+    return false;
+  case Histogram::DOUBLE_VALUE:
+    return get_number(json, &value->number);
+  case Histogram::DATE_VALUE:
+  case Histogram::DATETIME_VALUE:
+  case Histogram::TIME_VALUE:
+  {
+    if (json.type() != Json_dom::J_DATE &&
+        json.type() != Json_dom::J_DATETIME &&
+        json.type() != Json_dom::J_TIMESTAMP &&
+        json.type() != Json_dom::J_TIME)
+      return true;
+    MYSQL_TIME ltime;
+    json.get_datetime(&ltime);
+    value->integer= type == Histogram::TIME_VALUE ?
+      TIME_to_longlong_time_packed(&ltime) :
+      TIME_to_longlong_datetime_packed(&ltime);
+    value->number= static_cast<double>(value->integer);
+    return false;
+  }
+  case Histogram::STRING_VALUE:
+  {
+    if (json.type() != Json_dom::J_STRING)
+      return true;
+    String str;
+    uint errors;
+    if (str.copy(json.get_data(), json.get_data_length(),
+                 &my_charset_utf8mb4_bin, charset, &errors))
+      return true;
+    value->length= str.length();
+    return !(value->str= strmake_root(mem_root, str.ptr(), str.length()));
+  }
+  }
+  return true;
+}
+
+
+Histogram *Histogram::from_json(MEM_ROOT *mem_root, const Json_wrapper &json)
+{
+  Json_wrapper member;
+  uint type;
+  uint value_type;
+  double collation_id;
+  double buckets_specified;
+  Histogram histogram;
+
+  if (json.empty() || json.type() != Json_dom::J_OBJECT ||
+      get_member(json, "histogram-type", Json_dom::J_STRING, &member) ||
+      get_name(member, histogram_type_names,
+               array_elements(histogram_type_names), &type) ||
+      get_member(json, "data-type", Json_dom::J_STRING, &member) ||
+      get_name(member, value_type_names, array_elements(value_type_names),
+               &value_type) ||
+      get_number_member(json, "collation-id", &collation_id) ||
+      get_number_member(json, "null-values", &histogram.m_null_fraction) ||
+      get_number_member(json, "sampling-rate", &histogram.m_sampling_rate) ||
+      get_number_member(json, "number-of-buckets-specified",
+                        &buckets_specified) ||
+      get_member(json, "buckets", Json_dom::J_ARRAY, &member) ||
+      member.length() > HISTOGRAM_MAX_BUCKETS)
+    return NULL;
+  histogram.m_type= static_cast<enum_type>(type);
+  histogram.m_value_type= static_cast<enum_value_type>(value_type);
+  histogram.m_buckets_specified= static_cast<uint>(buckets_specified);
+  if (!(histogram.m_charset=
+        get_charset(static_cast<uint>(collation_id), MYF(0))))
+    return NULL;
+
+  histogram.m_bucket_count= static_cast<uint>(member.length());
+  histogram.m_buckets=
+    static_cast<Bucket*>(alloc_root(mem_root,
+                                    std::max(histogram.m_bucket_count, 1U) *
+                                    sizeof(Bucket)));
+  if (histogram.m_buckets == NULL)
+    return NULL;
+
+  const size_t bucket_length= histogram.m_type == SINGLETON ? 2 : 4;
+  double previous= 0.0;
+  for (uint i= 0; i < histogram.m_bucket_count; i++)
+  {
+    const Json_wrapper json_bucket= member[i];
+    Bucket *const bucket= &histogram.m_buckets[i];
+    if (json_bucket.type() != Json_dom::J_ARRAY ||
+        json_bucket.length() != bucket_length ||
+        json_to_value(mem_root, histogram.m_value_type, histogram.m_charset,
+                      json_bucket[0], &bucket->lower))
+      return NULL;
+    if (histogram.m_type == SINGLETON)
+    {
+      bucket->upper= bucket->lower;
+      bucket->distinct= 1.0;
+      if (get_number(json_bucket[1], &bucket->cumulative))
+        return NULL;
+    }
+    else if (json_to_value(mem_root, histogram.m_value_type,
+                           histogram.m_charset, json_bucket[1],
+                           &bucket->upper) ||
+             get_number(json_bucket[2], &bucket->cumulative) ||
+             get_number(json_bucket[3], &bucket->distinct))
+      return NULL;
+    // The buckets must be in order
+    if (bucket->cumulative < previous || bucket->cumulative > 1.0 ||
+        (i > 0 && histogram.compare(histogram.m_buckets[i - 1].upper,
+                                    bucket->lower) >= 0) ||
+        histogram.compare(bucket->lower, bucket->upper) > 0)
+      return NULL;
+    previous= bucket->cumulative;
+  }
+  return new (mem_root) Histogram(histogram);
+}
+
+
+int Histogram::compare(const Value &a, const Value &b) const
+{
+  return compare_values(m_value_type, m_charset, a, b);
+}
+
+
+uint Histogram::find_bucket(const Value &value) const
+{
+  uint low= 0;
+  uint high= m_bucket_count;
+  while (low < high)
+  {
+    const uint middle= low + (high - low) / 2;
+    if (compare(m_buckets[middle].upper, value) < 0)
+      low= middle + 1;
+    else
+      high= middle;
+  }
+  return low;
+}
+
+
+double Histogram::equal(const Value &value) const
+{
+  const uint i= find_bucket(value);
+  if (i == m_bucket_count || compare(value, m_buckets[i].lower) < 0)
+    return 0.0;
+  const double previous= i ? m_buckets[i - 1].cumulative : 0.0;
+  return (m_buckets[i].cumulative - previous) /
+    std::max(m_buckets[i].distinct, 1.0);
+}
+
+
+double Histogram::less(const Value &value, bool inclusive) const
+{
+  const uint i= find_bucket(value);
+  if (i == m_bucket_count)
+    return m_bucket_count ? m_buckets[m_bucket_count - 1].cumulative : 0.0;
+
+  const Bucket &bucket= m_buckets[i];
+  const double previous= i ? m_buckets[i - 1].cumulative : 0.0;
+  const int cmp_lower= compare(value, bucket.lower);
+  if (cmp_lower < 0)
+    return previous;
+  if (m_type == SINGLETON)
+    return inclusive ? bucket.cumulative : previous;
+
+  const double frequency= bucket.cumulative - previous;
+  const double equal= frequency / std::max(bucket.distinct, 1.0);
+  if (compare(value, bucket.upper) == 0)
+    return inclusive ? bucket.cumulative : bucket.cumulative - equal;
+  if (cmp_lower == 0)
+    return inclusive ? previous + equal : previous;
+
+  // Assume that the values are evenly spread over the bucket
+  double position= 0.5;
+  if (m_value_type != STRING_VALUE &&
+      bucket.upper.number > bucket.lower.number)
+    position= (value.number - bucket.lower.number) /
+      (bucket.upper.number - bucket.lower.number);
+  double result= previous + frequency * position;
+  if (inclusive)
+    result+= equal;
+  return std::min(result, bucket.cumulative);
+}
+
+
+double Histogram::get_selectivity(enum_operator op, const Value *values,
+                                  uint count) const
+{
+  double selectivity= 0.0;
+  switch (op)
+  {
+  case EQUAL:
+    selectivity= equal(values[0]);
+    break;
+  case NOT_EQUAL:
+    selectivity= non_null_fraction() - equal(values[0]);
+    break;
+  case LESS:
+    selectivity= less(values[0], false);
+    break;
+  case LESS_EQUAL:
+    selectivity= less(values[0], true);
+    break;
+  case GREATER:
+    selectivity= non_null_fraction() - less(values[0], true);
+    break;
+  case GREATER_EQUAL:
+    selectivity= non_null_fraction() - less(values[0], false);
+    break;
+  case BETWEEN:
+  case NOT_BETWEEN:
+    selectivity= std::max(less(values[1], true) - less(values[0], false),
+                          0.0);
+    if (op == NOT_BETWEEN)
+      selectivity= non_null_fraction() - selectivity;
+    break;
+  case IN_LIST:
+  case NOT_IN_LIST:
+    for (uint i= 0; i < count; i++)
+      selectivity+= equal(values[i]);
+    selectivity= std::min(selectivity, non_null_fraction());
+    if (op == NOT_IN_LIST)
+      selectivity= non_null_fraction() - selectivity;
+    break;
+  case IS_NULL:
+    selectivity= m_null_fraction;
+    break;
+  case IS_NOT_NULL:
+    selectivity= non_null_fraction();
+    break;
+  }
+  return std::min(std::max(selectivity, 0.0), 1.0);
+}
+
+
+Histogram::enum_operator Histogram::commute(enum_operator op)
+{
+  switch (op)
+  {
+  case LESS:
+    return GREATER;
+  case LESS_EQUAL:
+    return GREATER_EQUAL;
+  case GREATER:
+    return LESS;
+  case GREATER_EQUAL:
+    return LESS_EQUAL;
+  default:
+    return op;
+  }
+}
+
+
+bool Histogram::get_item_value(Item *item, Value *value, String *buf) const
+{
+  value->number= 0.0;
+  value->integer= 0;
+  value->str= NULL;
+  value->length= 0;
+
+  switch (m_value_type)
+  {
+  case INT_VALUE:
+  case UINT_VALUE:
+  case DOUBLE_VALUE:
+    value->number= item->val_real();
+    return false;
+  case DATE_VALUE:
+  case DATETIME_VALUE:
+    value->integer= item->val_date_temporal();
+    value->number= static_cast<double>(value->integer);
+    return false;
+  case TIME_VALUE:
+    value->integer= item->val_time_temporal();
+    value->number= static_cast<double>(value->integer);
+    return false;
+  case STRING_VALUE:
+  {
+    // Strings are compared with numbers and temporals as those
+    if (item->result_type() != STRING_RESULT || item->is_temporal())
+      return true;
+    String tmp;
+    const String *res= item->val_str(&tmp);
+    if (res == NULL)
+      return false;
+    uint errors;
+    if (buf->copy(res->ptr(), res->length(), res->charset(), m_charset,
+                  &errors))
+      return true;
+    value->str= buf->ptr();
+    value->length= truncated_length(m_charset, buf->ptr(), buf->length());
+    return false;
+  }
+  }
+  return true;
+}
+
+
+bool Histogram::get_key_value(const KEY_PART_INFO *key_part,
+                              const uchar *key, Value *value,
+                              String *buf) const
+{
+  if (key_part->key_part_flag & (HA_PART_KEY_SEG | HA_BLOB_PART))
+    return true;
+  if (key_part->null_bit && *key++)
+    return true;
+
+  Field *const field= key_part->field;
+  if (m_value_type == STRING_VALUE)
+  {
+    const char *str= pointer_cast<const char*>(key);
+    size_t length= key_part->length;
+    if (key_part->key_part_flag & HA_VAR_LENGTH_PART)
+    {
+      length= uint2korr(key);
+      str+= HA_KEY_BLOB_LENGTH;
+    }
+    else
+      length= m_charset->cset->lengthsp(m_charset, str, length);
+    if (buf->copy(str, truncated_length(m_charset, str, length), m_charset))
+      return true;
+    value->number= 0.0;
+    value->integer= 0;
+    value->str= buf->ptr();
+    value->length= buf->length();
+    return false;
+  }
+
+  /*
+    Other key images are the same as the field in the record, read the
+    value with the field moved to the key.
+  */
+  const my_ptrdiff_t diff= key - field->ptr;
+  my_bitmap_map *old_map= dbug_tmp_use_all_columns(field->table,
+                                                   field->table->read_set);
+  field->move_field_offset(diff);
+  read_field(field, m_value_type, value, NULL);
+  field->move_field_offset(-diff);
+  dbug_tmp_restore_column_map(field->table->read_set, old_map);
+  return false;
+}
+
+
+bool get_histogram_selectivity(const Field *field,
+                               Histogram::enum_operator op,
+                               Item **values, uint count,
+                               float *selectivity)
+{
+  if (field->table == NULL)
+    return true;
+  const Histogram *const histogram=
+    field->table->s->find_histogram(field->field_index);
+  if (histogram == NULL)
+    return true;
+
+  for (uint i= 0; i < count; i++)
+  {
+    if (!values[i]->const_item() || values[i]->is_expensive() ||
+        values[i]->has_subquery())
+      return true;
+  }
+
+  THD *const thd= current_thd;
+  // Conversion warnings are given when the condition is evaluated
+  Dummy_error_handler error_handler;
+  thd->push_internal_handler(&error_handler);
+
+  bool error= false;
+  double result= 0.0;
+  Histogram::Value value[2];
+  String buf[2];
+  if (op == Histogram::IN_LIST || op == Histogram::NOT_IN_LIST)
+  {
+    // One value at a time, the list may be long
+    bool has_null= false;
+    for (uint i= 0; i < count && !error; i++)
+    {
+      if (!(error= histogram->get_item_value(values[i], &value[0], &buf[0])))
+      {
+        if (values[i]->null_value)
+          has_null= true;
+        else
+          result+= histogram->get_selectivity(Histogram::EQUAL, value, 1);
+      }
+    }
+    result= std::min(result, 1.0 - histogram->null_fraction());
+    if (op == Histogram::NOT_IN_LIST)
+      result= has_null ? 0.0 : 1.0 - histogram->null_fraction() - result;
+  }
+  else
+  {
+    DBUG_ASSERT(count <= 2);
+    bool has_null= false;
+    for (uint i= 0; i < count && !error; i++)
+    {
+      if (!(error= histogram->get_item_value(values[i], &value[i], &buf[i])))
+        has_null|= values[i]->null_value;
+    }
+    // Comparisons with NULL are never true
+    if (!error && !has_null)
+      result= histogram->get_selectivity(op, value, count);
+  }
+
+  thd->pop_internal_handler();
+  if (error)
+    return true;
+  *selectivity= static_cast<float>(std::min(std::max(result, 0.0), 1.0));
+  return false;
+}
+
+
+/*
+  The histogram cache.
+
+  It holds the histograms of all columns, each with a MEM_ROOT of its own,
+  in a hash on "db\0table\0column\0". The column name is in lower case.
+*/
+
+struct Histogram_cache_entry
+{
+  MEM_ROOT mem_root;
+  char *key;
+  size_t key_length;
+  /** The name of the column as in mysql.histograms */
+  const char *column_name;
+  const Histogram *histogram;
+};
+
+static HASH histogram_cache;
+static mysql_mutex_t LOCK_histograms;
+static bool histogram_cache_inited= false;
+
+/** Length of a key of the cache */
+static const size_t HISTOGRAM_KEY_LENGTH= 3 * (NAME_LEN + 1);
+
+
+static uchar *histogram_cache_get_key(const uchar *record, size_t *length,
+                                      my_bool not_used MY_ATTRIBUTE((unused)))
+{
+  const Histogram_cache_entry *entry=
+    pointer_cast<const Histogram_cache_entry*>(record);
+  *length= entry->key_length;
+  return pointer_cast<uchar*>(entry->key);
+}
+
+
+static void histogram_cache_free_entry(void *record)
+{
+  Histogram_cache_entry *entry= static_cast<Histogram_cache_entry*>(record);
+  free_root(&entry->mem_root, MYF(0));
+  my_free(entry);
+}
+
+
+/**
+  Make the key of a column in the cache.
+
+  @param column  The column, or NULL for the prefix of the keys of all
+                 columns of the table
+
+  @return The length of the key
+*/
+
+static size_t make_histogram_key(char *key, const char *db,
+                                 const char *table_name, const char *column)
+{
+  char *pos= strmake(key, db, NAME_LEN) + 1;
+  pos= strmake(pos, table_name, NAME_LEN) + 1;
+  if (column != NULL)
+  {
+    char *const name= pos;
+    pos= strmake(pos, column, NAME_LEN) + 1;
+    my_casedn_str(system_charset_info, name);
+  }
+  return pos - key;
+}
+
+
+/**
+  Put a histogram in the cache, replacing the one of the column if there
+  is one. Called with LOCK_histograms.
+
+  @retval false  OK
+  @retval true   Out of memory
+*/
+
+static bool histogram_cache_put(const char *db, const char *table_name,
+                                const char *column,
+                                const Histogram *histogram)
+{
+  mysql_mutex_assert_owner(&LOCK_histograms);
+  char key[HISTOGRAM_KEY_LENGTH];
+  const size_t key_length= make_histogram_key(key, db, table_name, column);
+
+  Histogram_cache_entry *entry=
+    static_cast<Histogram_cache_entry*>(my_malloc(key_memory_histograms,
+                                                  sizeof(*entry),
+                                                  MYF(MY_WME)));
+  if (entry == NULL)
+    return true;
+  init_alloc_root(key_memory_histograms, &entry->mem_root, 1024, 0);
+  entry->key_length= key_length;
+  if (!(entry->key= static_cast<char*>(memdup_root(&entry->mem_root, key,
+                                                   key_length))) ||
+      !(entry->column_name= strdup_root(&entry->mem_root, column)) ||
+      !(entry->histogram= histogram->clone(&entry->mem_root)))
+  {
+    histogram_cache_free_entry(entry);
+    return true;
+  }
+
+  uchar *old= my_hash_search(&histogram_cache,
+                             pointer_cast<uchar*>(key), key_length);
+  if (old != NULL)
+    my_hash_delete(&histogram_cache, old);
+  if (my_hash_insert(&histogram_cache, pointer_cast<uchar*>(entry)))
+  {
+    histogram_cache_free_entry(entry);
+    return true;
+  }
+  return false;
+}
+
+
+void histogram_cache_init()
+{
+  DBUG_ASSERT(!histogram_cache_inited);
+  mysql_mutex_init(key_LOCK_histograms, &LOCK_histograms, MY_MUTEX_INIT_FAST);
+  (void) my_hash_init(&histogram_cache, &my_charset_bin, 64, 0, 0,
+                      histogram_cache_get_key, histogram_cache_free_entry, 0,
+                      key_memory_histograms);
+  histogram_cache_inited= true;
+}
+
+
+void histogram_cache_free()
+{
+  if (!histogram_cache_inited)
+    return;
+  my_hash_free(&histogram_cache);
+  mysql_mutex_destroy(&LOCK_histograms);
+  histogram_cache_inited= false;
+}
+
+
+void attach_histograms(TABLE_SHARE *share)
+{
+  DBUG_ENTER("attach_histograms");
+  if (!histogram_cache_inited)
+    DBUG_VOID_RETURN;
+
+  mysql_mutex_lock(&LOCK_histograms);
+  if (histogram_cache.records > 0)
+  {
+    for (uint i= 0; i < share->fields; i++)
+    {
+      Field *const field= share->field[i];
+      char key[HISTOGRAM_KEY_LENGTH];
+      const size_t key_length= make_histogram_key(key, share->db.str,
+                                                  share->table_name.str,
+                                                  field->field_name);
+      const Histogram_cache_entry *entry=
+        pointer_cast<const Histogram_cache_entry*>(
+          my_hash_search(&histogram_cache, pointer_cast<uchar*>(key),
+                         key_length));
+      // The column may have been changed since the histogram was built
+      if (entry == NULL || !entry->histogram->is_compatible(field))
+        continue;
+
+      if (share->histograms == NULL)
+      {
+        if (!(share->histograms= static_cast<const Histogram**>(
+                alloc_root(&share->mem_root,
+                           share->fields * sizeof(Histogram*)))))
+          break;
+        memset(share->histograms, 0, share->fields * sizeof(Histogram*));
+      }
+      share->histograms[i]= entry->histogram->clone(&share->mem_root);
+    }
+  }
+  mysql_mutex_unlock(&LOCK_histograms);
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Catches the errors of the changes of mysql.histograms. Those made for
+  DROP TABLE or RENAME TABLE are not reported to the statement, which
+  has already done its work; they are written to the error log.
+*/
+
+class Histogram_error_handler : public Internal_error_handler
+{
+public:
+  explicit Histogram_error_handler(bool report)
+    : m_report(report), m_sql_errno(0)
+  { m_message[0]= '\0'; }
+
+  virtual bool handle_condition(THD *thd,
+                                uint sql_errno,
+                                const char *sqlstate,
+                                Sql_condition::enum_severity_level *level,
+                                const char *msg)
+  {
+    if (*level != Sql_condition::SL_ERROR)
+      return false;
+    if (m_sql_errno == 0)
+    {
+      m_sql_errno= sql_errno;
+      strmake(m_message, msg, sizeof(m_message) - 1);
+    }
+    return !m_report;
+  }
+
+  bool failed() const { return m_sql_errno != 0; }
+  const char *message() const { return m_message; }
+  void reset() { m_sql_errno= 0; m_message[0]= '\0'; }
+
+private:
+  const bool m_report;
+  uint m_sql_errno;
+  char m_message[MYSQL_ERRMSG_SIZE];
+};
+
+
+/**
+  Access to mysql.histograms.
+
+  The statement that changes histograms makes the changes with its own
+  THD, in an attachable transaction like the one that changes
+  mysql.gtid_executed. The attachable transaction has its own state of
+  open tables, so the statement may have other tables open and locked,
+  or be in LOCK TABLES mode. It shares the metadata locks of the
+  statement: DROP TABLE and RENAME TABLE already hold the global
+  intention exclusive lock, they must not ask for it again behind a
+  pending FLUSH TABLES WITH READ LOCK that waits for them. The changes
+  are not written to the binary log, the statement that makes them is.
+
+  At server start there is no statement, a THD is created to read the
+  table.
+*/
+
+class Histogram_table_access : public System_table_access
+{
+public:
+  /**
+    @param report  Whether errors are reported to the statement. If not,
+                   they are written to the error log by close().
+  */
+  explicit Histogram_table_access(bool report)
+    : m_thd(current_thd), m_created_thd(NULL), m_table(NULL),
+      m_error_handler(report), m_report(report)
+  {
+    if (m_thd == NULL)
+    {
+      m_thd= m_created_thd= new THD;
+      m_thd->thread_stack= pointer_cast<char*>(&m_thd);
+      m_thd->store_globals();
+      lex_start(m_thd);
+      m_thd->set_time();
+    }
+    else
+      m_thd->begin_attachable_rw_transaction();
+    m_saved_option_bits= m_thd->variables.option_bits;
+    m_thd->variables.option_bits&= ~OPTION_BIN_LOG;
+    m_thd->is_operating_substatement_implicitly= true;
+    m_thd->push_internal_handler(&m_error_handler);
+  }
+
+  virtual void before_open(THD*)
+  {
+    m_flags= MYSQL_OPEN_IGNORE_GLOBAL_READ_LOCK | MYSQL_OPEN_IGNORE_FLUSH;
+  }
+
+  /**
+    Open mysql.histograms.
+
+    @retval false  OK
+    @retval true   Error, it is reported by close()
+  */
+  bool open(thr_lock_type lock_type)
+  {
+    static const LEX_STRING db= { C_STRING_WITH_LEN("mysql") };
+    static const LEX_STRING name= { C_STRING_WITH_LEN("histograms") };
+    if (open_table(m_thd, db, name, HISTOGRAMS_FIELD_COUNT, lock_type,
+                   &m_table, &m_backup))
+      return true;
+    if (m_table->s->fields != HISTOGRAMS_FIELD_COUNT ||
+        m_table->s->keys == 0 ||
+        m_table->field[HISTOGRAMS_FIELD_HISTOGRAM]->type() != MYSQL_TYPE_JSON)
+    {
+      my_error(ER_COL_COUNT_DOESNT_MATCH_CORRUPTED_V2, MYF(0), "mysql",
+               "histograms", HISTOGRAMS_FIELD_COUNT, m_table->s->fields);
+      return true;
+    }
+    return false;
+  }
+
+  /** Forget an error, that is not reported by close() then */
+  void clear_error()
+  {
+    m_error_handler.reset();
+    m_thd->clear_error();
+  }
+
+  TABLE *table() const { return m_table; }
+  THD *thd() const { return m_thd; }
+
+  /**
+    Store the histogram of a column, replacing the one it has.
+
+    @retval false  OK
+    @retval true   Error
+  */
+  bool store(const char *db, const char *table_name, const char *column,
+             const Histogram *histogram)
+  {
+    bool found;
+    if (find_row(db, table_name, column, &found))
+      return true;
+
+    const timeval now= m_thd->query_start_timeval();
+    m_table->field[HISTOGRAMS_FIELD_LAST_UPDATE]->store_timestamp(&now);
+    Json_object *const json= histogram->to_json();
+    if (json == NULL)
+    {
+      my_error(ER_OUTOFMEMORY, MYF(ME_FATALERROR), sizeof(Json_object));
+      return true;
+    }
+    Json_wrapper wrapper(json);
+    if (down_cast<Field_json*>(m_table->field[HISTOGRAMS_FIELD_HISTOGRAM])->
+        store_json(&wrapper) != TYPE_OK)
+      return true;
+
+    int error;
+    if (found)
+    {
+      error= m_table->file->ha_update_row(m_table->record[1],
+                                          m_table->record[0]);
+      if (error == HA_ERR_RECORD_IS_THE_SAME)
+        error= 0;
+    }
+    else
+      error= m_table->file->ha_write_row(m_table->record[0]);
+    if (error)
+    {
+      m_table->file->print_error(error, MYF(0));
+      return true;
+    }
+    return false;
+  }
+
+  /**
+    Delete the histogram of a column.
+
+    @param[out] found  Whether the column had a histogram
+
+    @retval false  OK
+    @retval true   Error
+  */
+  bool remove(const char *db, const char *table_name, const char *column,
+              bool *found)
+  {
+    if (find_row(db, table_name, column, found))
+      return true;
+    if (!*found)
+      return false;
+    const int error= m_table->file->ha_delete_row(m_table->record[1]);
+    if (error)
+    {
+      m_table->file->print_error(error, MYF(0));
+      return true;
+    }
+    return false;
+  }
+
+  /**
+    Move the histogram of a column to another table name.
+
+    @retval false  OK
+    @retval true   Error
+  */
+  bool rename(const char *db, const char *table_name, const char *column,
+              const char *new_db, const char *new_table_name)
+  {
+    bool found;
+    if (remove(new_db, new_table_name, column, &found) ||
+        find_row(db, table_name, column, &found))
+      return true;
+    if (!found)
+      return false;
+    restore_record(m_table, record[1]);
+    store_names(new_db, new_table_name, column);
+    const int error= m_table->file->ha_update_row(m_table->record[1],
+                                                  m_table->record[0]);
+    if (error && error != HA_ERR_RECORD_IS_THE_SAME)
+    {
+      m_table->file->print_error(error, MYF(0));
+      return true;
+    }
+    return false;
+  }
+
+  /**
+    Commit or roll back the changes, close the table and end the
+    transaction.
+
+    @param error  Whether the changes failed
+
+    @return Whether there was an error
+  */
+  bool close(bool error)
+  {
+    error|= m_error_handler.failed();
+    error|= close_table(m_thd, m_table, &m_backup, error, true);
+    m_table= NULL;
+    error|= m_error_handler.failed();
+    m_thd->pop_internal_handler();
+    m_thd->is_operating_substatement_implicitly= false;
+    m_thd->variables.option_bits= m_saved_option_bits;
+    if (m_created_thd != NULL)
+    {
+      drop_thd(m_created_thd);
+      m_created_thd= NULL;
+    }
+    else
+      m_thd->end_attachable_transaction();
+
+    if (m_error_handler.failed())
+    {
+      if (!m_report)
+        sql_print_warning("Failed to update mysql.histograms: %s",
+                          m_error_handler.message());
+    }
+    else if (error && m_report)
+      my_error(ER_UNKNOWN_ERROR, MYF(0));
+    return error;
+  }
+
+private:
+  void store_names(const char *db, const char *table_name, const char *column)
+  {
+    m_table->field[HISTOGRAMS_FIELD_DB]->store(db, strlen(db),
+                                               system_charset_info);
+    m_table->field[HISTOGRAMS_FIELD_TABLE]->store(table_name,
+                                                  strlen(table_name),
+                                                  system_charset_info);
+    m_table->field[HISTOGRAMS_FIELD_COLUMN]->store(column, strlen(column),
+                                                   system_charset_info);
+  }
+
+  /** Read the row of a column into record[1], prepare record[0] for it */
+  bool find_row(const char *db, const char *table_name, const char *column,
+                bool *found)
+  {
+    restore_record(m_table, s->default_values);
+    store_names(db, table_name, column);
+    key_copy(m_key, m_table->record[0], m_table->key_info,
+             m_table->key_info->key_length);
+    const int error=
+      m_table->file->ha_index_read_idx_map(m_table->record[1], 0, m_key,
+                                           HA_WHOLE_KEY, HA_READ_KEY_EXACT);
+    *found= !error;
+    if (error && error != HA_ERR_KEY_NOT_FOUND && error != HA_ERR_END_OF_FILE)
+    {
+      m_table->file->print_error(error, MYF(0));
+      return true;
+    }
+    return false;
+  }
+
+  THD *m_thd;
+  /** The THD created when there is no statement */
+  THD *m_created_thd;
+  TABLE *m_table;
+  Open_tables_backup m_backup;
+  Histogram_error_handler m_error_handler;
+  const bool m_report;
+  ulonglong m_saved_option_bits;
+  uchar m_key[MAX_KEY_LENGTH];
+};
+
+
+/** Read a name from mysql.histograms */
+
+static void read_name(Field *field, char *name)
+{
+  String tmp;
+  const String *res= field->val_str(&tmp);
+  strmake(name, res->ptr(), std::min<size_t>(res->length(), NAME_LEN));
+}
+
+
+void load_histograms()
+{
+  DBUG_ENTER("load_histograms");
+  Histogram_table_access access(false);
+  if (!access.open(TL_READ))
+  {
+    THD *const thd= access.thd();
+    TABLE *const table= access.table();
+    READ_RECORD read_record_info;
+    if (!init_read_record(&read_record_info, thd, table, NULL, true, true,
+                          false))
+    {
+      MEM_ROOT mem_root;
+      init_alloc_root(key_memory_histograms, &mem_root, 1024, 0);
+      mysql_mutex_lock(&LOCK_histograms);
+      while (!read_record_info.read_record(&read_record_info))
+      {
+        char db[NAME_LEN + 1];
+        char table_name[NAME_LEN + 1];
+        char column[NAME_LEN + 1];
+        read_name(table->field[HISTOGRAMS_FIELD_DB], db);
+        read_name(table->field[HISTOGRAMS_FIELD_TABLE], table_name);
+        read_name(table->field[HISTOGRAMS_FIELD_COLUMN], column);
+
+        Json_wrapper json;
+        const Histogram *histogram= NULL;
+        if (!down_cast<Field_json*>(table->field[HISTOGRAMS_FIELD_HISTOGRAM])->
+            val_json(&json))
+          histogram= Histogram::from_json(&mem_root, json);
+        if (histogram == NULL)
+          sql_print_warning("Invalid histogram of column %s.%s.%s in "
+                            "mysql.histograms", db, table_name, column);
+        else if (histogram_cache_put(db, table_name, column, histogram))
+          break;
+        free_root(&mem_root, MYF(MY_MARK_BLOCKS_FREE));
+      }
+      mysql_mutex_unlock(&LOCK_histograms);
+      free_root(&mem_root, MYF(0));
+      end_read_record(&read_record_info);
+    }
+  }
+  /*
+    A missing table is not an error, mysql_upgrade has not been run yet.
+    Nothing has been changed, so there is nothing to report.
+  */
+  access.clear_error();
+  access.close(false);
+  DBUG_VOID_RETURN;
+}
+
+
+/** The values of a column in the sample of build_histograms() */
+
+struct Column_sample
+{
+  Histogram::enum_value_type type;
+  /** Size of the buffer of a string value, 0 for other types */
+  size_t string_length;
+  Histogram::Value *values;
+  uchar *nulls;
+  char *strings;
+};
+
+
+/** Make room for a sample of the given number of rows */
+
+static bool grow_sample(Column_sample *columns, uint count, size_t rows)
+{
+  for (uint i= 0; i < count; i++)
+  {
+    Column_sample *const column= &columns[i];
+    void *values= my_realloc(key_memory_histograms, column->values,
+                             rows * sizeof(Histogram::Value),
+                             MYF(MY_WME | MY_ALLOW_ZERO_PTR));
+    if (values == NULL)
+      return true;
+    column->values= static_cast<Histogram::Value*>(values);
+    void *nulls= my_realloc(key_memory_histograms, column->nulls, rows,
+                            MYF(MY_WME | MY_ALLOW_ZERO_PTR));
+    if (nulls == NULL)
+      return true;
+    column->nulls= static_cast<uchar*>(nulls);
+    if (column->string_length > 0)
+    {
+      void *strings= my_realloc(key_memory_histograms, column->strings,
+                                rows * column->string_length,
+                                MYF(MY_WME | MY_ALLOW_ZERO_PTR));
+      if (strings == NULL)
+        return true;
+      column->strings= static_cast<char*>(strings);
+    }
+  }
+  return false;
+}
+
+
+bool build_histograms(THD *thd, TABLE *table, Field **fields, uint count,
+                      uint buckets, MEM_ROOT *mem_root,
+                      Histogram **histograms)
+{
+  DBUG_ENTER("build_histograms");
+  Column_sample *columns=
+    static_cast<Column_sample*>(thd->alloc(count * sizeof(Column_sample)));
+  if (columns == NULL)
+    DBUG_RETURN(true);
+
+  size_t row_size= 0;
+  bitmap_clear_all(table->read_set);
+  for (uint i= 0; i < count; i++)
+  {
+    Column_sample *const column= &columns[i];
+    if (Histogram::get_value_type(fields[i], &column->type))
+    {
+      DBUG_ASSERT(false);                       // Checked by the caller
+      DBUG_RETURN(true);
+    }
+    column->string_length= column->type == Histogram::STRING_VALUE ?
+      Histogram::max_string_length(fields[i]) : 0;
+    column->values= NULL;
+    column->nulls= NULL;
+    column->strings= NULL;
+    row_size+= sizeof(Histogram::Value) + 1 + column->string_length;
+    bitmap_set_bit(table->read_set, fields[i]->field_index);
+  }
+  table->file->column_bitmaps_signal();
+
+  /*
+    Keep a random sample of the rows that fits in the memory limit, with
+    reservoir sampling: the first rows fill the sample, after that row n
+    replaces a random row of the sample with probability capacity / n.
+  */
+  const size_t capacity=
+    std::max<size_t>(thd->variables.histogram_generation_max_mem_size /
+                     row_size, 1);
+  size_t allocated= 0;
+  ha_rows rows= 0;
+  bool error= false;
+  int read_error;
+  if ((read_error= table->file->ha_rnd_init(true)))
+  {
+    table->file->print_error(read_error, MYF(0));
+    error= true;
+  }
+  else
+  {
+    while (!(read_error= table->file->ha_rnd_next(table->record[0])) ||
+           read_error == HA_ERR_RECORD_DELETED)
+    {
+      if (read_error)
+        continue;
+      if (thd->killed)
+      {
+        thd->send_kill_message();
+        error= true;
+        break;
+      }
+
+      size_t slot;
+      if (rows < capacity)
+      {
+        slot= static_cast<size_t>(rows);
+        if (slot == allocated)
+        {
+          allocated= std::min(std::max<size_t>(allocated * 2, 1024),
+                              capacity);
+          if ((error= grow_sample(columns, count, allocated)))
+            break;
+        }
+      }
+      else
+      {
+        slot= static_cast<size_t>(my_rnd(&thd->rand) * (rows + 1));
+        if (slot >= capacity)
+        {
+          rows++;
+          continue;
+        }
+      }
+      rows++;
+
+      for (uint i= 0; i < count; i++)
+      {
+        Column_sample *const column= &columns[i];
+        column->nulls[slot]= fields[i]->is_null();
+        if (!column->nulls[slot])
+          Histogram::read_field(fields[i], column->type,
+                                &column->values[slot],
+                                column->strings +
+                                slot * column->string_length);
+      }
+    }
+    if (!error && read_error != HA_ERR_END_OF_FILE)
+    {
+      table->file->print_error(read_error, MYF(0));
+      error= true;
+    }
+    table->file->ha_rnd_end();
+  }
+
+  const size_t sample_rows= std::min<size_t>(rows, capacity);
+  const double sampling_rate= rows ? static_cast<double>(sample_rows) / rows :
+    1.0;
+  for (uint i= 0; i < count && !error; i++)
+  {
+    // Put the values that are not NULL first
+    Column_sample *const column= &columns[i];
+    size_t values= 0;
+    for (size_t row= 0; row < sample_rows; row++)
+    {
+      if (column->nulls[row])
+        continue;
+      column->values[values]= column->values[row];
+      if (column->string_length > 0)
+        column->values[values].str=
+          column->strings + row * column->string_length;
+      values++;
+    }
+    if (!(histograms[i]= Histogram::build(mem_root, column->type,
+                                          fields[i]->charset(),
+                                          column->values, values,
+                                          sample_rows, sampling_rate,
+                                          buckets)))
+      error= true;
+  }
+
+  for (uint i= 0; i < count; i++)
+  {
+    my_free(columns[i].values);
+    my_free(columns[i].nulls);
+    my_free(columns[i].strings);
+  }
+  DBUG_RETURN(error);
+}
+
+
+bool store_histograms(THD *thd, const char *db, const char *table_name,
+                      const char **columns, Histogram **histograms,
+                      uint count)
+{
+  DBUG_ENTER("store_histograms");
+  Histogram_table_access access(true);
+  bool error= access.open(TL_WRITE);
+  for (uint i= 0; i < count && !error; i++)
+    error= access.store(db, table_name, columns[i], histograms[i]);
+  if (access.close(error))
+    DBUG_RETURN(true);
+
+  mysql_mutex_lock(&LOCK_histograms);
+  for (uint i= 0; i < count && !error; i++)
+    error= histogram_cache_put(db, table_name, columns[i], histograms[i]);
+  mysql_mutex_unlock(&LOCK_histograms);
+  if (error)
+  {
+    my_error(ER_OUTOFMEMORY, MYF(ME_FATALERROR), sizeof(Histogram));
+    DBUG_RETURN(true);
+  }
+
+  // The next open of the table gets a share with the new histograms
+  tdc_remove_table(thd, TDC_RT_REMOVE_UNUSED, db, table_name, false);
+  DBUG_RETURN(false);
+}
+
+
+/** Remove the histogram of a column from the cache */
+
+static void histogram_cache_remove(const char *db, const char *table_name,
+                                   const char *column)
+{
+  mysql_mutex_assert_owner(&LOCK_histograms);
+  char key[HISTOGRAM_KEY_LENGTH];
+  const size_t key_length= make_histogram_key(key, db, table_name, column);
+  uchar *entry= my_hash_search(&histogram_cache,
+                               pointer_cast<uchar*>(key), key_length);
+  if (entry != NULL)
+    my_hash_delete(&histogram_cache, entry);
+}
+
+
+bool drop_histograms(THD *thd, const char *db, const char *table_name,
+                     const char **columns, uint count, bool *dropped)
+{
+  DBUG_ENTER("drop_histograms");
+  Histogram_table_access access(true);
+  bool error= access.open(TL_WRITE);
+  for (uint i= 0; i < count && !error; i++)
+    error= access.remove(db, table_name, columns[i], &dropped[i]);
+  if (access.close(error))
+    DBUG_RETURN(true);
+
+  mysql_mutex_lock(&LOCK_histograms);
+  for (uint i= 0; i < count; i++)
+    histogram_cache_remove(db, table_name, columns[i]);
+  mysql_mutex_unlock(&LOCK_histograms);
+
+  tdc_remove_table(thd, TDC_RT_REMOVE_UNUSED, db, table_name, false);
+  DBUG_RETURN(false);
+}
+
+
+/**
+  Get the names of the columns of a table that have histograms.
+
+  @return The number of columns
+*/
+
+static uint get_histogram_columns(THD *thd, const char *db,
+                                  const char *table_name,
+                                  const char ***columns)
+{
+  char prefix[HISTOGRAM_KEY_LENGTH];
+  const size_t prefix_length= make_histogram_key(prefix, db, table_name,
+                                                 NULL);
+  uint count= 0;
+  *columns= NULL;
+  if (!histogram_cache_inited)
+    return 0;
+
+  mysql_mutex_lock(&LOCK_histograms);
+  for (ulong i= 0; i < histogram_cache.records; i++)
+  {
+    const Histogram_cache_entry *entry=
+      pointer_cast<const Histogram_cache_entry*>(
+        my_hash_element(&histogram_cache, i));
+    if (entry->key_length <= prefix_length ||
+        memcmp(entry->key, prefix, prefix_length))
+      continue;
+    if (*columns == NULL &&
+        !(*columns= static_cast<const char**>(
+            thd->alloc(histogram_cache.records * sizeof(char*)))))
+      break;
+    if (((*columns)[count]= thd->mem_strdup(entry->column_name)))
+      count++;
+  }
+  mysql_mutex_unlock(&LOCK_histograms);
+  return count;
+}
+
+
+void drop_table_histograms(THD *thd, const char *db, const char *table_name)
+{
+  DBUG_ENTER("drop_table_histograms");
+  const char **columns;
+  const uint count= get_histogram_columns(thd, db, table_name, &columns);
+  if (count == 0)
+    DBUG_VOID_RETURN;
+
+  Histogram_table_access access(false);
+  bool error= access.open(TL_WRITE);
+  for (uint i= 0; i < count && !error; i++)
+  {
+    bool found;
+    error= access.remove(db, table_name, columns[i], &found);
+  }
+  access.close(error);
+
+  mysql_mutex_lock(&LOCK_histograms);
+  for (uint i= 0; i < count; i++)
+    histogram_cache_remove(db, table_name, columns[i]);
+  mysql_mutex_unlock(&LOCK_histograms);
+  DBUG_VOID_RETURN;
+}
+
+
+void rename_table_histograms(THD *thd, const char *db,
+                             const char *table_name, const char *new_db,
+                             const char *new_table_name)
+{
+  DBUG_ENTER("rename_table_histograms");
+  const char **columns;
+  const uint count= get_histogram_columns(thd, db, table_name, &columns);
+  if (count == 0)
+    DBUG_VOID_RETURN;
+
+  Histogram_table_access access(false);
+  bool error= access.open(TL_WRITE);
+  for (uint i= 0; i < count && !error; i++)
+    error= access.rename(db, table_name, columns[i], new_db, new_table_name);
+  access.close(error);
+
+  mysql_mutex_lock(&LOCK_histograms);
+  for (uint i= 0; i < count; i++)
+  {
+    char key[HISTOGRAM_KEY_LENGTH];
+    const size_t key_length= make_histogram_key(key, db, table_name,
+                                                columns[i]);
+    const Histogram_cache_entry *entry=
+      pointer_cast<const Histogram_cache_entry*>(
+        my_hash_search(&histogram_cache, pointer_cast<uchar*>(key),
+                       key_length));
+    if (entry != NULL)
+    {
+      (void) histogram_cache_put(new_db, new_table_name, columns[i],
+                                 entry->histogram);
+      histogram_cache_remove(db, table_name, columns[i]);
+    }
+  }
+  mysql_mutex_unlock(&LOCK_histograms);
+  DBUG_VOID_RETURN;
+}
@@ -0,0 +1,351 @@
+#ifndef HISTOGRAM_INCLUDED
+#define HISTOGRAM_INCLUDED
+
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+  Column histograms.
+
+  ANALYZE TABLE ... UPDATE HISTOGRAM samples the values of columns and
+  builds a histogram of each of them. The histograms are stored as JSON
+  documents in the mysql.histograms table, and kept in a server wide
+  cache that is loaded at startup. When a table share is opened, the
+  histograms of its columns are copied from the cache to the share, where
+  the optimizer uses them to estimate the selectivity of conditions on
+  the columns.
+*/
+
+#include "my_global.h"
+#include "my_alloc.h"                           // MEM_ROOT
+#include "sql_alloc.h"                          // Sql_alloc
+#include "sql_string.h"                         // String
+
+class Field;
+class Item;
+class Json_object;
+class Json_wrapper;
+class KEY_PART_INFO;
+class THD;
+struct TABLE;
+struct TABLE_SHARE;
+
+/** Default number of buckets of ANALYZE TABLE ... UPDATE HISTOGRAM */
+static const uint HISTOGRAM_DEFAULT_BUCKETS= 100;
+/** Maximum number of buckets of a histogram */
+static const uint HISTOGRAM_MAX_BUCKETS= 1024;
+
+/**
+  A histogram of the values of a column.
+
+  A singleton histogram has a bucket for each distinct value of the
+  column. An equi-height histogram has buckets that hold ranges of values
+  with about the same number of rows each, and is built when the column
+  has more distinct values than buckets were asked for.
+
+  Each bucket holds the cumulative fraction of the rows of the table
+  that have a value up to the upper bound of the bucket. The fractions
+  do not include NULL values, which have a fraction of their own.
+
+  Integers and floating point values are held as doubles, and temporal
+  values as the packed integers of Field::val_date_temporal() and
+  Field::val_time_temporal(). Strings are truncated to STRING_LENGTH
+  characters, and compared with the collation of the column.
+*/
+
+class Histogram : public Sql_alloc
+{
+public:
+  enum enum_type
+  {
+    SINGLETON,
+    EQUI_HEIGHT
+  };
+
+  /** Type of the values, determined by the type of the column */
+  enum enum_value_type
+  {
+    INT_VALUE,
+    UINT_VALUE,
+    DOUBLE_VALUE,
+    DATE_VALUE,
+    DATETIME_VALUE,
+    TIME_VALUE,
+    STRING_VALUE
+  };
+
+  /** Conditions the selectivity can be estimated for */
+  enum enum_operator
+  {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    BETWEEN,
+    NOT_BETWEEN,
+    IN_LIST,
+    NOT_IN_LIST,
+    IS_NULL,
+    IS_NOT_NULL
+  };
+
+  /** A value of the column */
+  struct Value
+  {
+    /** Numeric values, and temporal values converted to double */
+    double number;
+    /** Integer and packed temporal values */
+    longlong integer;
+    /** String values, in the character set of the column */
+    const char *str;
+    size_t length;
+  };
+
+  struct Bucket
+  {
+    Value lower;
+    Value upper;
+    /** Fraction of the rows with values up to and including upper */
+    double cumulative;
+    /** Number of distinct values in the bucket */
+    double distinct;
+  };
+
+  /** Number of characters strings are truncated to */
+  static const uint STRING_LENGTH= 42;
+
+  /**
+    Get the type of the values of a histogram of a column.
+
+    @retval false  OK
+    @retval true   Histograms are not supported for the type of the column
+  */
+  static bool get_value_type(const Field *field, enum_value_type *type);
+
+  /**
+    Read the value of a column for sampling. The value must not be NULL.
+
+    @param field  The column
+    @param type   Type of the values, from get_value_type()
+    @param value  Out: the value. A string value points into buf.
+    @param buf    Buffer for strings, at least max_string_length(field)
+                  bytes
+  */
+  static void read_field(Field *field, enum_value_type type, Value *value,
+                         char *buf);
+
+  /** Number of bytes read_field() needs for a string of the column */
+  static size_t max_string_length(const Field *field);
+
+  /**
+    Build a histogram from a sample of the values of a column.
+
+    @param mem_root       Where the histogram is allocated
+    @param type           Type of the values
+    @param charset        Collation of the column
+    @param values         The non-NULL values of the sample. They are
+                          sorted by this function.
+    @param value_count    Number of values
+    @param row_count      Number of rows in the sample, NULL or not
+    @param sampling_rate  Fraction of the rows of the table in the sample
+    @param buckets        Maximum number of buckets
+
+    @return The histogram, or NULL if out of memory
+  */
+  static Histogram *build(MEM_ROOT *mem_root, enum_value_type type,
+                          const CHARSET_INFO *charset, Value *values,
+                          size_t value_count, size_t row_count,
+                          double sampling_rate, uint buckets);
+
+  /**
+    Create a histogram from its JSON form.
+
+    @return The histogram, or NULL if the document is not a valid
+            histogram or out of memory
+  */
+  static Histogram *from_json(MEM_ROOT *mem_root, const Json_wrapper &json);
+
+  /**
+    The JSON form of the histogram.
+
+    @return A new object that the caller owns, or NULL if out of memory
+  */
+  Json_object *to_json() const;
+
+  /** Copy the histogram to another MEM_ROOT */
+  Histogram *clone(MEM_ROOT *mem_root) const;
+
+  /** Whether the histogram was built for a column of the type of field */
+  bool is_compatible(const Field *field) const;
+
+  enum_type type() const { return m_type; }
+  uint bucket_count() const { return m_bucket_count; }
+  double null_fraction() const { return m_null_fraction; }
+
+  /**
+    Get the value an item compares with the column as.
+
+    @param item   A constant item
+    @param value  Out: the value. A string value points into buf.
+    @param buf    Buffer for string values
+
+    @retval false  OK, or the item is NULL, see item->null_value
+    @retval true   The comparison of the item with the column is not done
+                   in the domain of the histogram
+  */
+  bool get_item_value(Item *item, Value *value, String *buf) const;
+
+  /**
+    Get the value of a key part in a key image, for the range optimizer.
+
+    @param key_part  The key part, on the column of the histogram
+    @param key       The key image of the key part, with its NULL byte
+    @param value     Out: the value
+    @param buf       Buffer for string values
+
+    @retval false  OK
+    @retval true   The value is NULL, or the key part is not supported
+  */
+  bool get_key_value(const KEY_PART_INFO *key_part, const uchar *key,
+                     Value *value, String *buf) const;
+
+  /**
+    Estimate the fraction of the rows of the table that satisfy
+    "column OP values".
+
+    @param op      The condition
+    @param values  The values. One for comparisons, two for BETWEEN, any
+                   number for IN. None for IS [NOT] NULL.
+    @param count   Number of values
+  */
+  double get_selectivity(enum_operator op, const Value *values,
+                         uint count) const;
+
+  /** The operator that gives the same result with the operands swapped */
+  static enum_operator commute(enum_operator op);
+
+private:
+  Histogram()
+    : m_type(SINGLETON), m_value_type(INT_VALUE), m_charset(NULL),
+      m_null_fraction(0.0), m_sampling_rate(1.0), m_buckets_specified(0),
+      m_bucket_count(0), m_buckets(NULL)
+  {}
+
+  int compare(const Value &a, const Value &b) const;
+  double equal(const Value &value) const;
+  double less(const Value &value, bool inclusive) const;
+  /** Index of the first bucket with an upper bound >= value */
+  uint find_bucket(const Value &value) const;
+  double non_null_fraction() const { return 1.0 - m_null_fraction; }
+
+  enum_type m_type;
+  enum_value_type m_value_type;
+  const CHARSET_INFO *m_charset;
+  double m_null_fraction;
+  double m_sampling_rate;
+  uint m_buckets_specified;
+  uint m_bucket_count;
+  Bucket *m_buckets;
+};
+
+
+/**
+  Estimate the selectivity of "field OP values" from the histogram of the
+  field.
+
+  @param field        The column
+  @param op           The condition
+  @param values       Items that the column is compared with. They must
+                      be constants, or no estimate is made.
+  @param count        Number of values
+  @param selectivity  Out: the fraction of the rows that satisfy the
+                      condition
+
+  @retval false  OK
+  @retval true   There is no histogram for the field, or it can not be
+                 used for the condition
+*/
+bool get_histogram_selectivity(const Field *field,
+                               Histogram::enum_operator op,
+                               Item **values, uint count,
+                               float *selectivity);
+
+/** Initialize the histogram cache */
+void histogram_cache_init();
+/** Load the cache from mysql.histograms */
+void load_histograms();
+/** Free the histogram cache */
+void histogram_cache_free();
+
+/**
+  Copy the histograms of the columns of a table from the cache to the
+  TABLE_SHARE, called when the share is opened.
+*/
+void attach_histograms(TABLE_SHARE *share);
+
+/**
+  Build histograms of columns of a table, by a full scan of the table
+  that keeps a sample of at most histogram_generation_max_mem_size bytes.
+
+  @param thd         Thread
+  @param table       The table, opened and locked for reading
+  @param fields      The columns
+  @param count       Number of columns
+  @param buckets     Maximum number of buckets
+  @param mem_root    Where the histograms are allocated
+  @param histograms  Out: a histogram for each column
+
+  @retval false  OK
+  @retval true   Error, it has been reported
+*/
+bool build_histograms(THD *thd, TABLE *table, Field **fields, uint count,
+                      uint buckets, MEM_ROOT *mem_root,
+                      Histogram **histograms);
+
+/**
+  Store histograms of columns of a table in mysql.histograms and in the
+  cache.
+
+  @retval false  OK
+  @retval true   Error, it has been reported
+*/
+bool store_histograms(THD *thd, const char *db, const char *table_name,
+                      const char **columns, Histogram **histograms,
+                      uint count);
+
+/**
+  Remove histograms of columns of a table from mysql.histograms and from
+  the cache.
+
+  @param[out] dropped  Whether a histogram existed, for each column
+
+  @retval false  OK
+  @retval true   Error, it has been reported
+*/
+bool drop_histograms(THD *thd, const char *db, const char *table_name,
+                     const char **columns, uint count, bool *dropped);
+
+/** Remove the histograms of all columns of a dropped table */
+void drop_table_histograms(THD *thd, const char *db, const char *table_name);
+
+/** Move the histograms of a renamed table to its new name */
+void rename_table_histograms(THD *thd, const char *db,
+                             const char *table_name, const char *new_db,
+                             const char *new_table_name);
+
+#endif /* HISTOGRAM_INCLUDED */
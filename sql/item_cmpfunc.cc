@@ -30,6 +30,7 @@
 #include "parse_tree_helpers.h"
 #include "template_utils.h"
 #include "item_json_func.h"            // json_value, get_json_atom_wrapper
+#include "histogram.h"                 // get_histogram_selectivity
 
 #include <algorithm>
 using std::min;
@@ -2523,6 +2524,32 @@ longlong Item_func_equal::val_int()
   return cmp.compare();
 }
 
+/**
+  Estimate the filtering effect of a comparison of a field with a value
+  from the histogram of the field.
+
+  @param fld     The field, one of the arguments
+  @param args    The two arguments of the comparison
+  @param op      The comparison, with the field as the first argument
+  @param filter  Out: the filtering effect
+
+  @retval false  OK
+  @retval true   The histogram can not be used, use the default estimate
+*/
+
+static bool histogram_filter_effect(const Item_field *fld, Item **args,
+                                    Histogram::enum_operator op,
+                                    float *filter)
+{
+  Item **value= args + 1;
+  if (args[0]->real_item() != fld)
+  {
+    value= args;
+    op= Histogram::commute(op);
+  }
+  return get_histogram_selectivity(fld->field, op, value, 1, filter);
+}
+
 float Item_func_ne::get_filtering_effect(table_map filter_for_table,
                                          table_map read_tables,
                                          const MY_BITMAP *fields_to_ignore,
@@ -2533,6 +2560,10 @@ float Item_func_ne::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!histogram_filter_effect(fld, args, Histogram::NOT_EQUAL, &filter))
+    return filter;
+
   return 1.0f - fld->get_cond_filter_default_probability(rows_in_table,
                                                          COND_FILTER_EQUALITY);
 }
@@ -2568,6 +2599,10 @@ float Item_func_ge::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!histogram_filter_effect(fld, args, Histogram::GREATER_EQUAL, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -2582,6 +2617,10 @@ float Item_func_lt::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!histogram_filter_effect(fld, args, Histogram::LESS, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -2596,6 +2635,10 @@ float Item_func_le::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!histogram_filter_effect(fld, args, Histogram::LESS_EQUAL, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -2610,6 +2653,10 @@ float Item_func_gt::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!histogram_filter_effect(fld, args, Histogram::GREATER, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_INEQUALITY);
 }
@@ -3097,6 +3144,14 @@ Item_func_between::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float selectivity;
+  if (args[0]->real_item() == fld &&
+      !get_histogram_selectivity(fld->field,
+                                 negated ? Histogram::NOT_BETWEEN :
+                                 Histogram::BETWEEN,
+                                 args + 1, 2, &selectivity))
+    return selectivity;
+
   const float filter=
     fld->get_cond_filter_default_probability(rows_in_table,
                                              COND_FILTER_BETWEEN);
@@ -5163,6 +5218,20 @@ float Item_func_in::get_filtering_effect(table_map filter_for_table,
     DBUG_ASSERT(args[0]->type() == FIELD_ITEM || args[0]->type() == REF_ITEM);
     Item_ident *fieldref= static_cast<Item_ident*>(args[0]);
 
+    /*
+      A histogram of the column gives the selectivity of the values
+      themselves, without the in_max_filter cap.
+    */
+    const Item_field *fld= static_cast<Item_field*>(fieldref->real_item());
+    float selectivity;
+    if (fieldref->used_tables() == filter_for_table &&
+        !bitmap_is_set(fields_to_ignore, fld->field->field_index) &&
+        !get_histogram_selectivity(fld->field,
+                                   negated ? Histogram::NOT_IN_LIST :
+                                   Histogram::IN_LIST,
+                                   args + 1, arg_count - 1, &selectivity))
+      return selectivity;
+
     const float tmp_filt= get_single_col_filtering_effect(fieldref,
                                                           filter_for_table,
                                                           fields_to_ignore,
@@ -6267,6 +6336,11 @@ float Item_func_isnull::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float selectivity;
+  if (!get_histogram_selectivity(fld->field, Histogram::IS_NULL, NULL, 0,
+                                 &selectivity))
+    return selectivity;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_EQUALITY);
 }
@@ -6341,6 +6415,11 @@ Item_func_isnotnull::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float selectivity;
+  if (!get_histogram_selectivity(fld->field, Histogram::IS_NOT_NULL, NULL, 0,
+                                 &selectivity))
+    return selectivity;
+
   return 1.0f - fld->get_cond_filter_default_probability(rows_in_table,
                                                          COND_FILTER_EQUALITY);
 }
@@ -7530,6 +7609,13 @@ float Item_equal::get_filtering_effect(table_map filter_for_table,
             cur_filter= 1.0f;
         }
 
+        // A histogram gives the selectivity of the constant itself
+        float selectivity;
+        if (const_item &&
+            !get_histogram_selectivity(cur_field->field, Histogram::EQUAL,
+                                       &const_item, 1, &selectivity))
+          cur_filter= selectivity;
+
         filter*= cur_filter;
       }
     }
@@ -7917,6 +8003,10 @@ float Item_func_eq::get_filtering_effect(table_map filter_for_table,
   if (!fld)
     return COND_FILTER_ALLPASS;
 
+  float filter;
+  if (!histogram_filter_effect(fld, args, Histogram::EQUAL, &filter))
+    return filter;
+
   return fld->get_cond_filter_default_probability(rows_in_table,
                                                   COND_FILTER_EQUALITY);
 }
@@ -361,6 +361,20 @@ protected:
 };
 
 
+class Create_func_approx_count_distinct : public Create_native_func
+{
+public:
+  virtual Item *create_native(THD *thd, LEX_STRING name,
+                              PT_item_list *item_list);
+
+  static Create_func_approx_count_distinct s_singleton;
+
+protected:
+  Create_func_approx_count_distinct() {}
+  virtual ~Create_func_approx_count_distinct() {}
+};
+
+
 class Create_func_area : public Create_func_arg1
 {
 public:
@@ -4299,6 +4313,29 @@ Create_func_random_bytes Create_func_random_bytes::s_singleton;
 
 Create_func_any_value Create_func_any_value::s_singleton;
 
+
+Create_func_approx_count_distinct
+Create_func_approx_count_distinct::s_singleton;
+
+Item*
+Create_func_approx_count_distinct::create_native(THD *thd, LEX_STRING name,
+                                                 PT_item_list *item_list)
+{
+  int arg_count= 0;
+
+  if (item_list != NULL)
+    arg_count= item_list->elements();
+
+  if (arg_count < 1)
+  {
+    my_error(ER_WRONG_PARAMCOUNT_TO_NATIVE_FCT, MYF(0), name.str);
+    return NULL;
+  }
+
+  return new (thd->mem_root) Item_sum_approx_count_distinct(POS(), item_list);
+}
+
+
 Create_func_area Create_func_area::s_singleton;
 
 Item*
@@ -7429,6 +7466,7 @@ static Native_func_registry func_array[] =
   { { C_STRING_WITH_LEN("AES_DECRYPT") }, BUILDER(Create_func_aes_decrypt)},
   { { C_STRING_WITH_LEN("AES_ENCRYPT") }, BUILDER(Create_func_aes_encrypt)},
   { { C_STRING_WITH_LEN("ANY_VALUE") }, BUILDER(Create_func_any_value)},
+  { { C_STRING_WITH_LEN("APPROX_COUNT_DISTINCT") }, BUILDER(Create_func_approx_count_distinct)},
   { { C_STRING_WITH_LEN("AREA") }, GEOM_BUILDER(Create_func_area_deprecated)},
   { { C_STRING_WITH_LEN("ASBINARY") }, GEOM_BUILDER(Create_func_as_binary_deprecated)},
   { { C_STRING_WITH_LEN("ASIN") }, BUILDER(Create_func_asin)},
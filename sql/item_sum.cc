@@ -810,7 +810,7 @@ bool Aggregator_distinct::setup(THD *thd)
     Setup can be called twice for ROLLUP items. This is a bug.
     Please add DBUG_ASSERT(tree == 0) here when it's fixed.
   */
-  if (tree || table || tmp_table_param)
+  if (tree || unique_hash || table || tmp_table_param)
     return FALSE;
 
   if (item_sum->setup(thd))
@@ -885,10 +885,10 @@ bool Aggregator_distinct::setup(THD *thd)
     if (table->hash_field)
       table->file->ha_index_init(0, 0);
 
-    if (table->s->db_type() == heap_hton)
+    if (table->s->db_type() == heap_hton && !table->s->blob_fields)
     {
       /*
-        No blobs, otherwise it would have been MyISAM: set up a compare
+        No blobs, the records have a fixed length: set up a compare
         function and its arguments to use with Unique.
       */
       qsort_cmp2 compare_key;
@@ -912,8 +912,11 @@ bool Aggregator_distinct::setup(THD *thd)
       }
       if (all_binary)
       {
-        cmp_arg= (void*) &tree_key_length;
-        compare_key= (qsort_cmp2) simple_raw_key_cmp;
+        /* Keys are compared with memcmp(), a hash finds duplicates */
+        DBUG_ASSERT(unique_hash == 0);
+        unique_hash= new Unique_hash(tree_key_length,
+                                     item_sum->ram_limitation(thd));
+        return unique_hash == NULL;
       }
       else
       {
@@ -964,7 +967,7 @@ bool Aggregator_distinct::setup(THD *thd)
     Item *arg;
     DBUG_ENTER("Aggregator_distinct::setup");
     /* It's legal to call setup() more than once when in a subquery */
-    if (tree)
+    if (tree || unique_hash)
       DBUG_RETURN(FALSE);
 
     /*
@@ -1009,11 +1012,21 @@ bool Aggregator_distinct::setup(THD *thd)
     tree_key_length= table->s->reclength - table->s->null_bytes;
 
     /*
+      The table contains numbers only, decimals are converted to binary
+      representation as well, so values can be compared with memcmp().
+      Exact numbers are found in a hash. Floating point numbers are kept
+      in the tree, which feeds them to the sum in sorted order, so that
+      the rounding of the result does not depend on the order of the rows.
+
       Unique handles all unique elements in a tree until they can't fit
-      in.  Then the tree is dumped to the temporary file. We can use
-      simple_raw_key_cmp because the table contains numbers only; decimals
-      are converted to binary representation as well.
+      in.  Then the tree is dumped to the temporary file.
     */
+    if (field_type != MYSQL_TYPE_DOUBLE && field_type != MYSQL_TYPE_FLOAT)
+    {
+      unique_hash= new Unique_hash(tree_key_length,
+                                   item_sum->ram_limitation(thd));
+      DBUG_RETURN(unique_hash == NULL);
+    }
     tree= new Unique(simple_raw_key_cmp, &tree_key_length, tree_key_length,
                      item_sum->ram_limitation(thd));
 
@@ -1035,11 +1048,13 @@ void Aggregator_distinct::clear()
   item_sum->clear();
   if (tree)
     tree->reset();
+  if (unique_hash)
+    unique_hash->reset();
   /* tree and table can be both null only if const_distinct is enabled*/
   if (item_sum->sum_func() == Item_sum::COUNT_FUNC || 
       item_sum->sum_func() == Item_sum::COUNT_DISTINCT_FUNC)
   {
-    if (!tree && table)
+    if (!tree && !unique_hash && table)
     {
       table->file->extra(HA_EXTRA_NO_CACHE);
       table->file->ha_index_or_rnd_end();
@@ -1108,12 +1123,24 @@ bool Aggregator_distinct::add()
       */
       return tree->unique_add(table->record[0] + table->s->null_bytes);
     }
+    if (unique_hash)
+      return unique_hash->unique_add(table->record[0] + table->s->null_bytes);
 
     if (!check_unique_constraint(table))
       return false;
     if ((error= table->file->ha_write_row(table->record[0])) &&
         !table->file->is_ignorable_error(error))
-      return TRUE;
+    {
+      // create_ondisk_from_heap will generate error if needed
+      if (create_ondisk_from_heap(table->in_use, table,
+                                  tmp_table_param->start_recinfo,
+                                  &tmp_table_param->recinfo, error, true,
+                                  NULL))
+        return TRUE;
+      // Table's engine changed, index is not initialized anymore
+      if (table->hash_field)
+        table->file->ha_index_init(0, false);
+    }
     return FALSE;
   }
   else
@@ -1121,12 +1148,14 @@ bool Aggregator_distinct::add()
     item_sum->get_arg(0)->save_in_field(table->field[0], false);
     if (table->field[0]->is_null())
       return 0;
-    DBUG_ASSERT(tree);
+    DBUG_ASSERT(tree || unique_hash);
     item_sum->null_value= 0;
     /*
       '0' values are also stored in the tree. This doesn't matter
       for SUM(DISTINCT), but is important for AVG(DISTINCT)
     */
+    if (unique_hash)
+      return unique_hash->unique_add(table->field[0]->ptr);
     return tree->unique_add(table->field[0]->ptr);
   }
 }
@@ -1174,7 +1203,13 @@ void Aggregator_distinct::endup()
       sum->count= (longlong) tree->elements_in_tree();
       endup_done= TRUE;
     }
-    if (!tree)
+    if (unique_hash && unique_hash->is_in_memory())
+    {
+      /* everything fits in memory, and there are no duplicates in it */
+      sum->count= (longlong) unique_hash->elements_in_memory();
+      endup_done= TRUE;
+    }
+    if (!tree && !unique_hash)
     {
       /* there were blobs */
       table->file->info(HA_STATUS_VARIABLE | HA_STATUS_NO_LOCK);
@@ -1213,6 +1248,14 @@ void Aggregator_distinct::endup()
     tree->walk(item_sum_distinct_walk, (void*) this);
     use_distinct_values= FALSE;
   }
+  if (unique_hash && !endup_done)
+  {
+    table->field[0]->set_notnull();
+    use_distinct_values= TRUE;
+    /* Errors are reported by Unique_hash */
+    (void) unique_hash->walk(item_sum_distinct_walk, (void*) this);
+    use_distinct_values= FALSE;
+  }
   /* prevent consecutive recalculations */
   endup_done= TRUE;
 }
@@ -1582,6 +1625,11 @@ Aggregator_distinct::~Aggregator_distinct()
     delete tree;
     tree= NULL;
   }
+  if (unique_hash)
+  {
+    delete unique_hash;
+    unique_hash= NULL;
+  }
   if (table)
   {
     if (table->file)
@@ -1699,6 +1747,176 @@ void Item_sum_count::cleanup()
 }
 
 
+/*
+  Approximate count of distinct values
+*/
+
+/** Number of bits of the hash that select a register */
+static const uint APPROX_COUNT_DISTINCT_BITS= 14;
+static const uint APPROX_COUNT_DISTINCT_REGISTERS=
+  1U << APPROX_COUNT_DISTINCT_BITS;
+
+
+/** Finalization step of MurmurHash3, mixes all bits of k into each bit */
+
+static inline ulonglong fmix64(ulonglong k)
+{
+  k^= k >> 33;
+  k*= 0xff51afd7ed558ccdULL;
+  k^= k >> 33;
+  k*= 0xc4ceb9fe1a85ec53ULL;
+  k^= k >> 33;
+  return k;
+}
+
+
+static inline ulonglong hash_bytes(const CHARSET_INFO *cs, const uchar *ptr,
+                                   size_t length)
+{
+  ulong nr1= 1, nr2= 4;
+  cs->coll->hash_sort(cs, ptr, length, &nr1, &nr2);
+  return static_cast<ulonglong>(nr1) ^ (static_cast<ulonglong>(nr2) << 32);
+}
+
+
+Item *Item_sum_approx_count_distinct::copy_or_same(THD* thd)
+{
+  return new (thd->mem_root) Item_sum_approx_count_distinct(thd, this);
+}
+
+
+bool Item_sum_approx_count_distinct::setup(THD *thd)
+{
+  if (registers)
+    return false;
+  registers=
+    static_cast<uchar *>(thd->alloc(APPROX_COUNT_DISTINCT_REGISTERS));
+  if (registers == NULL)
+    return true;
+  clear();
+  return false;
+}
+
+
+void Item_sum_approx_count_distinct::clear()
+{
+  if (registers)
+    memset(registers, 0, APPROX_COUNT_DISTINCT_REGISTERS);
+}
+
+
+ulonglong Item_sum_approx_count_distinct::hash_arg(Item *arg)
+{
+  if (arg->is_temporal())
+    return static_cast<ulonglong>(arg->val_temporal_by_field_type());
+
+  switch (arg->result_type())
+  {
+  case INT_RESULT:
+    return static_cast<ulonglong>(arg->val_int());
+  case REAL_RESULT:
+  {
+    double nr= arg->val_real();
+    if (nr == 0.0)
+      nr= 0.0;                                  // -0.0 is equal to 0.0
+    ulonglong bits;
+    memcpy(&bits, &nr, sizeof(bits));
+    return bits;
+  }
+  case DECIMAL_RESULT:
+  {
+    my_decimal buff;
+    const my_decimal *dec= arg->val_decimal(&buff);
+    if (arg->null_value)
+      return 0;
+    uchar bin[DECIMAL_MAX_FIELD_SIZE];
+    const uint precision= std::min<uint>(arg->decimal_precision(),
+                                         DECIMAL_MAX_PRECISION);
+    const uint scale= std::min<uint>(arg->decimals, precision);
+    my_decimal2binary(E_DEC_FATAL_ERROR & ~E_DEC_OVERFLOW, dec, bin,
+                      precision, scale);
+    return hash_bytes(&my_charset_bin, bin,
+                      my_decimal_get_binary_size(precision, scale));
+  }
+  case STRING_RESULT:
+  {
+    char buff[MAX_FIELD_WIDTH];
+    String tmp(buff, sizeof(buff), arg->collation.collation);
+    const String *str= arg->val_str(&tmp);
+    if (arg->null_value)
+      return 0;
+    return hash_bytes(str->charset(),
+                      pointer_cast<const uchar *>(str->ptr()), str->length());
+  }
+  case ROW_RESULT:
+  default:
+    DBUG_ASSERT(0);
+    return 0;
+  }
+}
+
+
+bool Item_sum_approx_count_distinct::add()
+{
+  ulonglong hash= 0;
+  for (uint i= 0; i < arg_count; i++)
+  {
+    const ulonglong nr= hash_arg(args[i]);
+    if (args[i]->null_value)
+      return false;                             // NULLs are not counted
+    hash= fmix64(hash ^ (nr + 0x9e3779b97f4a7c15ULL + (hash << 6)));
+  }
+  if (current_thd->is_error())
+    return true;
+
+  const uint index= static_cast<uint>(hash >> (64 - APPROX_COUNT_DISTINCT_BITS));
+  /* Leading zeros of the other bits, the guard bit stops at the last one */
+  ulonglong rest= (hash << APPROX_COUNT_DISTINCT_BITS) |
+    (1ULL << (APPROX_COUNT_DISTINCT_BITS - 1));
+  uchar rank= 1;
+  while (!(rest & (1ULL << 63)))
+  {
+    rank++;
+    rest<<= 1;
+  }
+  if (registers[index] < rank)
+    registers[index]= rank;
+  return false;
+}
+
+
+longlong Item_sum_approx_count_distinct::val_int()
+{
+  DBUG_ASSERT(fixed == 1);
+  if (registers == NULL)
+    return 0;
+
+  const double m= APPROX_COUNT_DISTINCT_REGISTERS;
+  double sum= 0.0;
+  uint zeros= 0;
+  for (uint i= 0; i < APPROX_COUNT_DISTINCT_REGISTERS; i++)
+  {
+    sum+= ldexp(1.0, -static_cast<int>(registers[i]));
+    if (registers[i] == 0)
+      zeros++;
+  }
+  double estimate= 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+  /* Small cardinalities are estimated better by the empty registers */
+  if (estimate <= 2.5 * m && zeros != 0)
+    estimate= m * log(m / zeros);
+  return static_cast<longlong>(rint(estimate));
+}
+
+
+void Item_sum_approx_count_distinct::cleanup()
+{
+  DBUG_ENTER("Item_sum_approx_count_distinct::cleanup");
+  registers= NULL;
+  Item_sum_int::cleanup();
+  DBUG_VOID_RETURN;
+}
+
+
 /*
   Avgerage
 */
@@ -2614,6 +2832,59 @@ void Item_sum_hybrid::update_field()
 }
 
 
+void Item_sum_sum::store_partial_result(longlong count, const my_decimal *sum,
+                                        longlong value MY_ATTRIBUTE((unused)))
+{
+  DBUG_ASSERT(hybrid_type == DECIMAL_RESULT);
+  result_field->store_decimal(count ? sum : &decimal_zero);
+  if (count)
+    result_field->set_notnull();
+  else
+    result_field->set_null();
+}
+
+
+void Item_sum_count::store_partial_result(longlong count,
+                                          const my_decimal *sum
+                                          MY_ATTRIBUTE((unused)),
+                                          longlong value
+                                          MY_ATTRIBUTE((unused)))
+{
+  int8store(result_field->ptr, count);
+}
+
+
+void Item_sum_avg::store_partial_result(longlong count, const my_decimal *sum,
+                                        longlong value MY_ATTRIBUTE((unused)))
+{
+  uchar *res= result_field->ptr;
+  DBUG_ASSERT(hybrid_type == DECIMAL_RESULT);
+  my_decimal2binary(E_DEC_FATAL_ERROR, count ? sum : &decimal_zero,
+                    res, f_precision, f_scale);
+  int8store(res + dec_bin_size, count);
+}
+
+
+void Item_sum_hybrid::store_partial_result(longlong count,
+                                           const my_decimal *sum
+                                           MY_ATTRIBUTE((unused)),
+                                           longlong value)
+{
+  DBUG_ASSERT(hybrid_type == INT_RESULT);
+  if (maybe_null)
+  {
+    if (count == 0)
+    {
+      value= 0;
+      result_field->set_null();
+    }
+    else
+      result_field->set_notnull();
+  }
+  result_field->store(value, unsigned_flag);
+}
+
+
 void Item_sum_hybrid::min_max_update_temporal_field()
 {
   longlong nr, old_nr;
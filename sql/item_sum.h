@@ -344,7 +344,8 @@ public:
   enum Sumfunctype
   { COUNT_FUNC, COUNT_DISTINCT_FUNC, SUM_FUNC, SUM_DISTINCT_FUNC, AVG_FUNC,
     AVG_DISTINCT_FUNC, MIN_FUNC, MAX_FUNC, STD_FUNC,
-    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC
+    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC,
+    APPROX_COUNT_DISTINCT_FUNC
   };
 
   Item **ref_by; /* pointer to a ref to the object used to register it */
@@ -425,6 +426,19 @@ public:
     Updated value is then saved in the field.
   */
   virtual void update_field()=0;
+  /**
+    Store the aggregate of a group in result_field when the rows of the
+    group were aggregated without this item, e.g. by the threads of a
+    parallel scan. The field is left as reset_field() and update_field()
+    would have left it after the rows of the group.
+
+    @param count  Number of rows in the group with a non-NULL argument
+    @param sum    Sum of the argument over those rows (SUM, AVG)
+    @param value  Smallest or largest argument value (MIN, MAX)
+  */
+  virtual void store_partial_result(longlong count, const my_decimal *sum,
+                                    longlong value)
+  { DBUG_ASSERT(false); }
   virtual bool keep_field_type(void) const { return 0; }
   virtual void fix_length_and_dec();
   virtual Item *result_item(Field *field)
@@ -527,6 +541,7 @@ public:
 
 
 class Unique;
+class Unique_hash;
 
 
 /**
@@ -580,11 +595,20 @@ class Aggregator_distinct : public Aggregator
     If there are no blobs in the COUNT(DISTINCT) arguments, we can use a tree,
     which is faster than heap table. In that case, we still use the table
     to help get things set up, but we insert nothing in it. 
-    For AVG/SUM(DISTINCT) we always use this tree (as it takes a single 
-    argument) to get the distinct rows.
+    For AVG/SUM(DISTINCT) of floating point numbers we always use this tree
+    (as it takes a single argument) to get the distinct rows.
   */
   Unique *tree;
 
+  /*
+    Used instead of the tree when the distinct values can be compared
+    with memcmp() and their order does not matter: for COUNT(DISTINCT)
+    with binary arguments, and for AVG/SUM(DISTINCT) of exact numbers.
+    Duplicates are found through a hash, so there is no sorting and, as
+    long as the values fit in memory, no merge.
+  */
+  Unique_hash *unique_hash;
+
   /* 
     The length of the temp table row. Must be a member of the class as it
     gets passed down to simple_raw_key_cmp () as a compare function argument
@@ -625,7 +649,7 @@ class Aggregator_distinct : public Aggregator
 public:
   Aggregator_distinct (Item_sum *sum) :
     Aggregator(sum), table(NULL), tmp_table_param(NULL), tree(NULL),
-    const_distinct(NOT_CONST), use_distinct_values(false) {}
+    unique_hash(NULL), const_distinct(NOT_CONST), use_distinct_values(false) {}
   virtual ~Aggregator_distinct ();
   Aggregator_type Aggrtype() { return DISTINCT_AGGREGATOR; }
 
@@ -760,6 +784,8 @@ public:
   enum Item_result result_type () const { return hybrid_type; }
   void reset_field();
   void update_field();
+  void store_partial_result(longlong count, const my_decimal *sum,
+                            longlong value);
   void no_rows_in_result() {}
   const char *func_name() const 
   { 
@@ -813,6 +839,8 @@ class Item_sum_count :public Item_sum_int
   longlong val_int();
   void reset_field();
   void update_field();
+  void store_partial_result(longlong count, const my_decimal *sum,
+                            longlong value);
   const char *func_name() const 
   { 
     return has_with_distinct() ? "count(distinct " : "count(";
@@ -821,6 +849,55 @@ class Item_sum_count :public Item_sum_int
 };
 
 
+/**
+  APPROX_COUNT_DISTINCT(expr, ...) estimates the number of distinct rows
+  of its arguments that are not NULL, with the HyperLogLog algorithm.
+
+  Each row is hashed to 64 bits. The first APPROX_COUNT_DISTINCT_BITS
+  bits select a register, which keeps the largest number of leading zero
+  bits + 1 seen in the rest of the hash. The estimate is computed from
+  the registers only, so the memory used does not depend on the number
+  of rows or of distinct values, and no row is sorted or written to disk.
+  The standard error of the estimate is about 1.04 / sqrt(number of
+  registers), i.e. 0.8%.
+
+  Values are hashed according to their type, strings according to their
+  collation, so the values that COUNT(DISTINCT) counts once are hashed
+  alike.
+*/
+
+class Item_sum_approx_count_distinct :public Item_sum_int
+{
+  /** Registers, allocated by setup() */
+  uchar *registers;
+
+  void clear();
+  bool add();
+  void cleanup();
+
+  /** Hash of the value of an argument, for add() */
+  static ulonglong hash_arg(Item *arg);
+
+public:
+  Item_sum_approx_count_distinct(const POS &pos, PT_item_list *list)
+    :Item_sum_int(pos, list), registers(NULL)
+  {
+    quick_group= false;
+  }
+  Item_sum_approx_count_distinct(THD *thd, Item_sum_approx_count_distinct *item)
+    :Item_sum_int(thd, item), registers(NULL)
+  {}
+  enum Sumfunctype sum_func () const { return APPROX_COUNT_DISTINCT_FUNC; }
+  bool setup(THD *thd);
+  void no_rows_in_result() { clear(); }
+  longlong val_int();
+  void reset_field() { DBUG_ASSERT(0); }        // not used
+  void update_field() { DBUG_ASSERT(0); }       // not used
+  const char *func_name() const { return "approx_count_distinct("; }
+  Item *copy_or_same(THD* thd);
+};
+
+
 /* Item to get the value of a stored sum function */
 
 class Item_sum_avg;
@@ -911,6 +988,8 @@ public:
   String *val_str(String *str);
   void reset_field();
   void update_field();
+  void store_partial_result(longlong count, const my_decimal *sum,
+                            longlong value);
   Item *result_item(Field *field)
   { return new Item_avg_field(hybrid_type, this); }
   void no_rows_in_result() {}
@@ -1098,6 +1177,8 @@ protected:
   enum Item_result result_type () const { return hybrid_type; }
   enum enum_field_types field_type() const { return hybrid_field_type; }
   void update_field();
+  void store_partial_result(longlong count, const my_decimal *sum,
+                            longlong value);
   void min_max_update_str_field();
   void min_max_update_temporal_field();
   void min_max_update_real_field();
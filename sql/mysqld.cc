@@ -56,6 +56,7 @@
 #include "sql_time.h"     // known_date_time_formats,
                           // get_date_time_format_str
 #include "tztime.h"       // my_tz_free, my_tz_init, my_tz_SYSTEM
+#include "histogram.h"    // histogram_cache_init, load_histograms
 #include "hostname.h"     // hostname_cache_free, hostname_cache_init
 #include "auth_common.h"  // set_default_auth_plugin
                           // acl_free, acl_init
@@ -129,6 +130,7 @@
 #include "sp_rcontext.h"
 #include "sql_reload.h"  // reload_acl_and_cache
 #include "sp_head.h"  // init_sp_psi_keys
+#include "sp_cache.h" // sp_cache_init
 #include "event_data_objects.h" //init_scheduler_psi_keys
 #include "my_timer.h"    // my_timer_init, my_timer_deinit
 #include "table_cache.h"                // table_cache_manager
@@ -521,6 +523,11 @@ ulong expire_logs_days = 0;
   in the sp_cache for one connection.
 */
 ulong stored_program_cache_size= 0;
+/**
+  Upper limit for number of sp_head objects that are kept in the cache
+  shared between connections.
+*/
+ulong stored_program_shared_cache_size= 0;
 /**
   Compatibility option to prevent auto upgrade of old temporals
   during certain ALTER TABLE operations.
@@ -1308,6 +1315,7 @@ void clean_up(bool print_message)
   grant_free();
 #endif
   query_cache.destroy();
+  sp_cache_end();
   hostname_cache_free();
   item_func_sleep_free();
   lex_free();       /* Free some memory */
@@ -1321,6 +1329,7 @@ void clean_up(bool print_message)
   table_def_start_shutdown();
   plugin_shutdown();
   delete_optimizer_cost_module();
+  histogram_cache_free();
   ha_end();
   if (tc_log)
   {
@@ -4302,6 +4311,8 @@ a file name for --log-bin-index option", opt_binlog_index_name);
 
   /* Initialize the optimizer cost module */
   init_optimizer_cost_module(true);
+  histogram_cache_init();
+  sp_cache_init();
   ft_init_stopwords();
 
   init_max_user_conn();
@@ -4947,6 +4958,10 @@ int mysqld_main(int argc, char **argv)
   if (!opt_bootstrap)
     reload_optimizer_cost_constants();
 
+  /* Read the column histograms */
+  if (!opt_bootstrap)
+    load_histograms();
+
   if (mysql_rm_tmp_tables() || acl_init(opt_noacl) ||
       my_tz_init((THD *)0, default_tz_name, opt_bootstrap) ||
       grant_init(opt_noacl))
@@ -6863,7 +6878,7 @@ SHOW_VAR status_vars[]= {
   {"Prepared_stmt_count",      (char*) &show_prepared_stmt_count,                     SHOW_FUNC,               SHOW_SCOPE_GLOBAL},
   {"Qcache_free_blocks",       (char*) &query_cache.free_memory_blocks,               SHOW_LONG_NOFLUSH,       SHOW_SCOPE_GLOBAL},
   {"Qcache_free_memory",       (char*) &query_cache.free_memory,                      SHOW_LONG_NOFLUSH,       SHOW_SCOPE_GLOBAL},
-  {"Qcache_hits",              (char*) &query_cache.hits,                             SHOW_LONG,               SHOW_SCOPE_GLOBAL},
+  {"Qcache_hits",              (char*) &query_cache.hits,                             SHOW_LONGLONG,           SHOW_SCOPE_GLOBAL},
   {"Qcache_inserts",           (char*) &query_cache.inserts,                          SHOW_LONG,               SHOW_SCOPE_GLOBAL},
   {"Qcache_lowmem_prunes",     (char*) &query_cache.lowmem_prunes,                    SHOW_LONG,               SHOW_SCOPE_GLOBAL},
   {"Qcache_not_cached",        (char*) &query_cache.refused,                          SHOW_LONG,               SHOW_SCOPE_GLOBAL},
@@ -6927,6 +6942,9 @@ SHOW_VAR status_vars[]= {
 #endif
 #endif
 #endif /* HAVE_OPENSSL */
+  {"Statement_template_cache_hits", (char*) offsetof(STATUS_VAR, stmt_template_cache_hits), SHOW_LONGLONG_STATUS, SHOW_SCOPE_ALL},
+  {"Statement_template_cache_invalidations", (char*) offsetof(STATUS_VAR, stmt_template_cache_invalidations), SHOW_LONGLONG_STATUS, SHOW_SCOPE_ALL},
+  {"Statement_template_cache_misses", (char*) offsetof(STATUS_VAR, stmt_template_cache_misses), SHOW_LONGLONG_STATUS, SHOW_SCOPE_ALL},
   {"Table_locks_immediate",    (char*) &locks_immediate,                               SHOW_LONG,              SHOW_SCOPE_GLOBAL},
   {"Table_locks_waited",       (char*) &locks_waited,                                  SHOW_LONG,              SHOW_SCOPE_GLOBAL},
   {"Table_open_cache_hits",    (char*) offsetof(STATUS_VAR, table_open_cache_hits),    SHOW_LONGLONG_STATUS,   SHOW_SCOPE_ALL},
@@ -8570,6 +8588,8 @@ void refresh_status(THD *thd)
 
   /* Reset the counters of all key caches (default and named). */
   process_key_caches(reset_key_cache_counters);
+  /* Qcache_hits is counted atomically, it is not a SHOW_LONG. */
+  my_atomic_store64(&query_cache.hits, 0);
   flush_status_time= time((time_t*) 0);
   mysql_mutex_unlock(&LOCK_status);
 
@@ -8651,6 +8671,9 @@ PSI_mutex_key key_thd_timer_mutex;
 PSI_mutex_key key_LOCK_offline_mode;
 PSI_mutex_key key_LOCK_default_password_lifetime;
 PSI_mutex_key key_LOCK_group_replication_handler;
+PSI_mutex_key key_LOCK_parallel_group_scan;
+PSI_mutex_key key_LOCK_histograms;
+PSI_mutex_key key_LOCK_sp_shared_cache;
 
 #ifdef HAVE_REPLICATION
 PSI_mutex_key key_commit_order_manager_mutex;
@@ -8741,6 +8764,9 @@ static PSI_mutex_info all_server_mutexes[]=
   { &key_LOCK_compress_gtid_table, "LOCK_compress_gtid_table", PSI_FLAG_GLOBAL},
   { &key_mts_gaq_LOCK, "key_mts_gaq_LOCK", 0},
   { &key_thd_timer_mutex, "thd_timer_mutex", 0},
+  { &key_LOCK_parallel_group_scan, "Parallel_group_scan::m_lock", 0},
+  { &key_LOCK_histograms, "LOCK_histograms", PSI_FLAG_GLOBAL},
+  { &key_LOCK_sp_shared_cache, "LOCK_sp_shared_cache", PSI_FLAG_GLOBAL},
 #ifdef HAVE_REPLICATION
   { &key_commit_order_manager_mutex, "Commit_order_manager::m_mutex", 0},
   { &key_mutex_slave_worker_hash, "Relay_log_info::slave_worker_hash_lock", 0},
@@ -8753,6 +8779,7 @@ static PSI_mutex_info all_server_mutexes[]=
 PSI_rwlock_key key_rwlock_LOCK_grant, key_rwlock_LOCK_logger,
   key_rwlock_LOCK_sys_init_connect, key_rwlock_LOCK_sys_init_slave,
   key_rwlock_LOCK_system_variables_hash, key_rwlock_query_cache_query_lock,
+  key_rwlock_query_cache_queries_lock,
   key_rwlock_global_sid_lock, key_rwlock_gtid_mode_lock,
   key_rwlock_channel_map_lock, key_rwlock_channel_lock;
 
@@ -8776,6 +8803,7 @@ static PSI_rwlock_info all_server_rwlocks[]=
   { &key_rwlock_LOCK_sys_init_slave, "LOCK_sys_init_slave", PSI_FLAG_GLOBAL},
   { &key_rwlock_LOCK_system_variables_hash, "LOCK_system_variables_hash", PSI_FLAG_GLOBAL},
   { &key_rwlock_query_cache_query_lock, "Query_cache_query::lock", 0},
+  { &key_rwlock_query_cache_queries_lock, "Query_cache::queries_lock", 0},
   { &key_rwlock_global_sid_lock, "gtid_commit_rollback", PSI_FLAG_GLOBAL},
   { &key_rwlock_gtid_mode_lock, "gtid_mode_lock", PSI_FLAG_GLOBAL},
   { &key_rwlock_channel_map_lock, "channel_map_lock", 0},
@@ -8806,6 +8834,7 @@ PSI_cond_key key_RELAYLOG_prep_xids_cond;
 PSI_cond_key key_gtid_ensure_index_cond;
 PSI_cond_key key_COND_compress_gtid_table;
 PSI_cond_key key_COND_thr_lock;
+PSI_cond_key key_COND_parallel_group_scan;
 #ifdef HAVE_REPLICATION
 PSI_cond_key key_commit_order_manager_cond;
 PSI_cond_key key_cond_slave_worker_hash;
@@ -8833,6 +8862,7 @@ static PSI_cond_info all_server_conds[]=
   { &key_COND_start_signal_handler, "COND_start_signal_handler", PSI_FLAG_GLOBAL},
 #endif
   { &key_COND_thr_lock, "COND_thr_lock", 0 },
+  { &key_COND_parallel_group_scan, "Parallel_group_scan::m_cond", 0},
   { &key_item_func_sleep_cond, "Item_func_sleep::cond", 0},
   { &key_master_info_data_cond, "Master_info::data_cond", 0},
   { &key_master_info_start_cond, "Master_info::start_cond", 0},
@@ -8861,6 +8891,7 @@ PSI_thread_key key_thread_bootstrap, key_thread_handle_manager, key_thread_main,
   key_thread_one_connection, key_thread_signal_hand,
   key_thread_compress_gtid_table, key_thread_parser_service;
 PSI_thread_key key_thread_timer_notifier;
+PSI_thread_key key_thread_parallel_group_scan;
 
 static PSI_thread_info all_server_threads[]=
 {
@@ -8878,6 +8909,8 @@ static PSI_thread_info all_server_threads[]=
   { &key_thread_signal_hand, "signal_handler", PSI_FLAG_GLOBAL},
   { &key_thread_compress_gtid_table, "compress_gtid_table", PSI_FLAG_GLOBAL},
   { &key_thread_parser_service, "parser_service", PSI_FLAG_GLOBAL},
+  { &key_thread_parallel_group_scan, "parallel_group_scan", 0},
+  { &key_thread_filesort_sort, "filesort_sort", 0},
 };
 
 PSI_file_key key_file_map;
@@ -9244,10 +9277,14 @@ PSI_memory_key key_memory_binlog_statement_buffer;
 PSI_memory_key key_memory_partition_syntax_buffer;
 PSI_memory_key key_memory_READ_INFO;
 PSI_memory_key key_memory_JOIN_CACHE;
+PSI_memory_key key_memory_Parallel_group_scan;
+PSI_memory_key key_memory_Group_hash;
+PSI_memory_key key_memory_histograms;
 PSI_memory_key key_memory_TABLE_sort_io_cache;
 PSI_memory_key key_memory_frm;
 PSI_memory_key key_memory_Unique_sort_buffer;
 PSI_memory_key key_memory_Unique_merge_buffer;
+PSI_memory_key key_memory_Unique_hash;
 PSI_memory_key key_memory_TABLE;
 PSI_memory_key key_memory_frm_extra_segment_buff;
 PSI_memory_key key_memory_frm_form_pos;
@@ -9390,10 +9427,14 @@ static PSI_memory_info all_server_memory[]=
   { &key_memory_partition_syntax_buffer, "partition_syntax_buffer", 0},
   { &key_memory_READ_INFO, "READ_INFO", 0},
   { &key_memory_JOIN_CACHE, "JOIN_CACHE", 0},
+  { &key_memory_Parallel_group_scan, "Parallel_group_scan", 0},
+  { &key_memory_Group_hash, "Group_hash", 0},
+  { &key_memory_histograms, "histograms", PSI_FLAG_GLOBAL},
   { &key_memory_TABLE_sort_io_cache, "TABLE::sort_io_cache", 0},
   { &key_memory_frm, "frm", 0},
   { &key_memory_Unique_sort_buffer, "Unique::sort_buffer", 0},
   { &key_memory_Unique_merge_buffer, "Unique::merge_buffer", 0},
+  { &key_memory_Unique_hash, "Unique_hash", 0},
   { &key_memory_TABLE, "TABLE", PSI_FLAG_GLOBAL}, /* Table cache */
   { &key_memory_frm_extra_segment_buff, "frm::extra_segment_buff", 0},
   { &key_memory_frm_form_pos, "frm::form_pos", 0},
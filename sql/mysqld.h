@@ -269,6 +269,7 @@ enum enum_binlog_error_action
 extern const char *binlog_error_action_list[];
 
 extern ulong stored_program_cache_size;
+extern ulong stored_program_shared_cache_size;
 extern ulong back_log;
 extern char language[FN_REFLEN];
 extern "C" MYSQL_PLUGIN_IMPORT ulong server_id;
@@ -448,6 +449,9 @@ extern PSI_mutex_key key_thd_timer_mutex;
 extern PSI_mutex_key key_LOCK_offline_mode;
 extern PSI_mutex_key key_LOCK_default_password_lifetime;
 extern PSI_mutex_key key_LOCK_group_replication_handler;
+extern PSI_mutex_key key_LOCK_parallel_group_scan;
+extern PSI_mutex_key key_LOCK_histograms;
+extern PSI_mutex_key key_LOCK_sp_shared_cache;
 
 #ifdef HAVE_REPLICATION
 extern PSI_mutex_key key_commit_order_manager_mutex;
@@ -457,6 +461,7 @@ extern PSI_mutex_key key_mutex_slave_worker_hash;
 extern PSI_rwlock_key key_rwlock_LOCK_grant, key_rwlock_LOCK_logger,
   key_rwlock_LOCK_sys_init_connect, key_rwlock_LOCK_sys_init_slave,
   key_rwlock_LOCK_system_variables_hash, key_rwlock_query_cache_query_lock,
+  key_rwlock_query_cache_queries_lock,
   key_rwlock_global_sid_lock, key_rwlock_gtid_mode_lock,
   key_rwlock_channel_map_lock, key_rwlock_channel_lock;
 
@@ -480,6 +485,7 @@ extern PSI_cond_key key_RELAYLOG_prep_xids_cond;
 extern PSI_cond_key key_gtid_ensure_index_cond;
 extern PSI_cond_key key_COND_compress_gtid_table;
 extern PSI_cond_key key_COND_thr_lock;
+extern PSI_cond_key key_COND_parallel_group_scan;
 
 #ifdef HAVE_REPLICATION
 extern PSI_cond_key key_cond_slave_worker_hash;
@@ -490,6 +496,8 @@ extern PSI_thread_key key_thread_bootstrap,
   key_thread_one_connection, key_thread_signal_hand,
   key_thread_compress_gtid_table, key_thread_parser_service;
 extern PSI_thread_key key_thread_timer_notifier;
+extern PSI_thread_key key_thread_parallel_group_scan;
+extern PSI_thread_key key_thread_filesort_sort;
 
 extern PSI_file_key key_file_map;
 extern PSI_file_key key_file_binlog, key_file_binlog_cache,
@@ -611,6 +619,9 @@ extern PSI_memory_key key_memory_dboptions_hash;
 extern PSI_memory_key key_memory_hash_index_key_buffer;
 extern PSI_memory_key key_memory_THD_handler_tables_hash;
 extern PSI_memory_key key_memory_JOIN_CACHE;
+extern PSI_memory_key key_memory_Parallel_group_scan;
+extern PSI_memory_key key_memory_Group_hash;
+extern PSI_memory_key key_memory_histograms;
 extern PSI_memory_key key_memory_READ_INFO;
 extern PSI_memory_key key_memory_partition_syntax_buffer;
 extern PSI_memory_key key_memory_global_system_variables;
@@ -623,6 +634,7 @@ extern PSI_memory_key key_memory_frm_form_pos;
 extern PSI_memory_key key_memory_frm_string;
 extern PSI_memory_key key_memory_Unique_sort_buffer;
 extern PSI_memory_key key_memory_Unique_merge_buffer;
+extern PSI_memory_key key_memory_Unique_hash;
 extern PSI_memory_key key_memory_shared_memory_name;
 extern PSI_memory_key key_memory_opt_bin_logname;
 extern PSI_memory_key key_memory_Query_cache;
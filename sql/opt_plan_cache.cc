@@ -0,0 +1,204 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+  Join orders cached between executions of a prepared statement, see
+  Cached_join_order.
+*/
+
+#include "opt_plan_cache.h"
+
+#include "item.h"                               // Item_param
+#include "sql_class.h"                          // THD
+#include "sql_lex.h"                            // SELECT_LEX
+#include "sql_optimizer.h"                      // JOIN
+#include "sql_select.h"                         // JOIN_TAB
+#include "table.h"                              // TABLE_LIST
+
+#include <algorithm>
+
+
+/**
+  Version of the share of a table, or 0 for tables that are created for
+  each execution, and so have a new share each time.
+*/
+
+static ulonglong table_version(const JOIN_TAB *tab)
+{
+  const TABLE_LIST *const tl= tab->table_ref;
+  if (tl->uses_materialization() || tl->schema_table)
+    return 0;
+  return tab->table()->s->get_table_ref_version();
+}
+
+
+/**
+  Type of a parameter as kept in Cached_join_order::m_param_types. The
+  field type is set by the binary protocol, and the result type by
+  EXECUTE ... USING.
+*/
+
+static uint32 param_type(const Item_param *param)
+{
+  uint32 type= static_cast<uint32>(param->field_type()) |
+               static_cast<uint32>(param->result_type()) << 8;
+  if (param->state == Item_param::NULL_VALUE)
+    type|= 1U << 16;
+  return type;
+}
+
+
+/** Whether two estimates of the number of rows of a table are close */
+
+static bool rows_are_close(ha_rows cached, ha_rows current)
+{
+  const double ratio= (current + 1.0) / (cached + 1.0);
+  return ratio <= PLAN_CACHE_MAX_ROWS_CHANGE &&
+         ratio >= 1.0 / PLAN_CACHE_MAX_ROWS_CHANGE;
+}
+
+
+bool Cached_join_order::is_applicable(const JOIN *join)
+{
+  THD *const thd= join->thd;
+  const SELECT_LEX *const select_lex= join->select_lex;
+
+  return thd->variables.prepared_statement_plan_cache &&
+         !thd->stmt_arena->is_conventional() &&
+         !thd->stmt_arena->is_stmt_prepare() &&
+         thd->sp_runtime_ctx == NULL &&
+         !(select_lex->active_options() & SELECT_STRAIGHT_JOIN) &&
+         select_lex->sj_nests.is_empty() &&
+         join->tables - join->const_tables >= 2 &&
+         join->tables <= MAX_TABLES;
+}
+
+
+const Cached_join_order *Cached_join_order::get(const JOIN *join)
+{
+  const Cached_join_order *const order= join->select_lex->cached_join_order;
+  if (order == NULL || !order->is_valid(join))
+    return NULL;
+  return order;
+}
+
+
+bool Cached_join_order::is_valid(const JOIN *join) const
+{
+  const THD *const thd= join->thd;
+  DBUG_ENTER("Cached_join_order::is_valid");
+
+  if (m_tables != join->tables ||
+      m_const_table_map != join->const_table_map ||
+      m_optimizer_switch != thd->variables.optimizer_switch ||
+      m_search_depth != thd->variables.optimizer_search_depth ||
+      m_prune_level != thd->variables.optimizer_prune_level ||
+      m_dp_max_plans != thd->variables.optimizer_dp_max_plans ||
+      m_param_count != thd->lex->param_list.elements)
+    DBUG_RETURN(false);
+
+  List_iterator_fast<Item_param> it(thd->lex->param_list);
+  const Item_param *param;
+  for (uint i= 0; (param= it++); i++)
+  {
+    if (m_param_types[i] != param_type(param))
+    {
+      DBUG_PRINT("info", ("type of parameter %u changed", i));
+      DBUG_RETURN(false);
+    }
+  }
+
+  for (uint i= join->const_tables; i < join->tables; i++)
+  {
+    const JOIN_TAB *const tab= join->best_ref[i];
+    const uint tableno= tab->table_ref->tableno();
+    if (m_versions[tableno] != table_version(tab))
+    {
+      DBUG_PRINT("info", ("table %s was reopened", tab->table()->alias));
+      DBUG_RETURN(false);
+    }
+    if (!rows_are_close(m_rows[tableno], tab->found_records))
+    {
+      DBUG_PRINT("info", ("rows of table %s changed from %lu to %lu",
+                          tab->table()->alias, (ulong) m_rows[tableno],
+                          (ulong) tab->found_records));
+      DBUG_RETURN(false);
+    }
+  }
+  DBUG_RETURN(true);
+}
+
+
+void Cached_join_order::save(JOIN *join)
+{
+  THD *const thd= join->thd;
+  SELECT_LEX *const select_lex= join->select_lex;
+  MEM_ROOT *const mem_root= thd->stmt_arena->mem_root;
+  const uint param_count= thd->lex->param_list.elements;
+  DBUG_ENTER("Cached_join_order::save");
+
+  Cached_join_order *order= select_lex->cached_join_order;
+  if (order == NULL)
+  {
+    if (!(order= new (mem_root) Cached_join_order()))
+      DBUG_VOID_RETURN;
+    select_lex->cached_join_order= order;
+  }
+  // The number of parameters is the same for all executions
+  if (order->m_param_types == NULL &&
+      !(order->m_param_types=
+        static_cast<uint32 *>(alloc_root(mem_root, sizeof(uint32) *
+                                         (param_count + 1)))))
+    DBUG_VOID_RETURN;
+
+  order->m_tables= join->tables;
+  order->m_const_table_map= join->const_table_map;
+  order->m_optimizer_switch= thd->variables.optimizer_switch;
+  order->m_search_depth= thd->variables.optimizer_search_depth;
+  order->m_prune_level= thd->variables.optimizer_prune_level;
+  order->m_dp_max_plans= thd->variables.optimizer_dp_max_plans;
+  order->m_param_count= param_count;
+
+  List_iterator_fast<Item_param> it(thd->lex->param_list);
+  const Item_param *param;
+  for (uint i= 0; (param= it++); i++)
+    order->m_param_types[i]= param_type(param);
+
+  for (uint i= join->const_tables; i < join->tables; i++)
+  {
+    const JOIN_TAB *const tab= join->best_positions[i].table;
+    const uint tableno= tab->table_ref->tableno();
+    order->m_order[i - join->const_tables]= tableno;
+    order->m_versions[tableno]= table_version(tab);
+    order->m_rows[tableno]= tab->found_records;
+  }
+  DBUG_VOID_RETURN;
+}
+
+
+void Cached_join_order::apply(JOIN *join) const
+{
+  JOIN_TAB **const first= join->best_ref + join->const_tables;
+  JOIN_TAB **const last= join->best_ref + join->tables;
+
+  for (uint i= 0; first + i < last; i++)
+  {
+    JOIN_TAB **tab= first + i;
+    while ((*tab)->table_ref->tableno() != m_order[i])
+      tab++;
+    std::swap(first[i], *tab);
+  }
+}
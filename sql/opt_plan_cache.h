@@ -0,0 +1,117 @@
+#ifndef OPT_PLAN_CACHE_INCLUDED
+#define OPT_PLAN_CACHE_INCLUDED
+
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+  Join orders cached between executions of a prepared statement.
+
+  The query blocks of a prepared statement live as long as the statement,
+  but every execution optimizes them from scratch. With
+  prepared_statement_plan_cache enabled, the join order that the greedy
+  search chose for a query block is kept in the query block, together
+  with what it was based on. The next execution that finds the same
+  inputs puts the tables in that order and only computes the access
+  methods for it, like for a STRAIGHT_JOIN, skipping the search.
+
+  The cached order is used only if
+  - the optimizer settings are the same,
+  - the parameters have the same types and NULL-ness,
+  - the same tables were found to be constant,
+  - no table share has been reopened, which happens on DDL and ANALYZE
+    TABLE, so that new statistics are taken into account, and
+  - the estimated number of rows of each table, which the range optimizer
+    computes from the parameter values, has not changed by more than a
+    factor of PLAN_CACHE_MAX_ROWS_CHANGE.
+  Otherwise the search is done, and its result replaces the cached order.
+*/
+
+#include "my_global.h"
+#include "my_base.h"                            // ha_rows
+#include "sql_alloc.h"                          // Sql_alloc
+#include "sql_const.h"                          // MAX_TABLES
+
+class JOIN;
+
+/**
+  A change of the estimated number of rows of a table by more than this
+  factor makes the cached join order invalid.
+*/
+static const double PLAN_CACHE_MAX_ROWS_CHANGE= 2.0;
+
+class Cached_join_order : public Sql_alloc
+{
+public:
+  /**
+    Whether join orders of the query block of a join may be cached: the
+    statement is an execution of a prepared statement, the cache is
+    enabled, and the join order is searched for, which is not the case
+    with STRAIGHT_JOIN, semi-join nests or fewer than two non-constant
+    tables.
+  */
+  static bool is_applicable(const JOIN *join);
+
+  /**
+    Get the cached join order of the query block of a join.
+
+    @return The join order, or NULL if there is none or it does not hold
+            for the current execution
+  */
+  static const Cached_join_order *get(const JOIN *join);
+
+  /**
+    Cache the join order of join->best_positions in the query block,
+    replacing an earlier one. The order is allocated on the MEM_ROOT of
+    the prepared statement, and an earlier one is reused when possible.
+    Nothing is cached if out of memory.
+  */
+  static void save(JOIN *join);
+
+  /**
+    Put the non-constant tables of join->best_ref in the cached order.
+  */
+  void apply(JOIN *join) const;
+
+private:
+  Cached_join_order()
+    : m_tables(0), m_const_table_map(0), m_optimizer_switch(0),
+      m_search_depth(0), m_prune_level(0), m_dp_max_plans(0),
+      m_param_count(0),
+      m_param_types(NULL)
+  {}
+
+  bool is_valid(const JOIN *join) const;
+
+  /** Number of tables of the join */
+  uint m_tables;
+  table_map m_const_table_map;
+  ulonglong m_optimizer_switch;
+  ulong m_search_depth;
+  ulong m_prune_level;
+  uint m_dp_max_plans;
+  uint m_param_count;
+  /** Field and result type of each parameter, and whether it was NULL */
+  uint32 *m_param_types;
+  /** Table numbers of the non-constant tables, in join order */
+  uint m_order[MAX_TABLES];
+  /** Version of the share of each table, by table number */
+  ulonglong m_versions[MAX_TABLES];
+  /** Estimated number of rows of each table, by table number */
+  ha_rows m_rows[MAX_TABLES];
+};
+
+#endif /* OPT_PLAN_CACHE_INCLUDED */
@@ -126,6 +126,8 @@
 #include "opt_hints.h"           // hint_key_state
 #include "mysys_err.h"           // EE_CAPACITY_EXCEEDED
 
+#include <algorithm>             // std::sort
+
 using std::min;
 using std::max;
 
@@ -1091,6 +1093,10 @@ static SEL_TREE * get_mm_parts(RANGE_OPT_PARAM *param,
 static SEL_ARG *get_mm_leaf(RANGE_OPT_PARAM *param,Item *cond_func,Field *field,
 			    KEY_PART *key_part,
 			    Item_func::Functype type,Item *value);
+static bool comparable_in_index(Item *cond_func, const Field *field,
+                                const Field::imagetype itype,
+                                Item_func::Functype comp_type,
+                                const Item *value);
 static SEL_TREE *get_mm_tree(RANGE_OPT_PARAM *param,Item *cond);
 
 static bool is_key_scan_ror(PARAM *param, uint keynr, uint nparts);
@@ -6086,6 +6092,205 @@ static SEL_TREE *get_ne_mm_tree(RANGE_OPT_PARAM *param, Item_func *cond_func,
 }
 
 
+/** Order of single-point SEL_ARGs by their value */
+
+static bool sel_arg_point_less(const SEL_ARG *a, const SEL_ARG *b)
+{
+  return a->cmp_min_to_min(b) < 0;
+}
+
+
+/**
+  Link sorted SEL_ARGs into a balanced R-B tree.
+
+  The middle element is the root of each subtree, so that the depths of
+  the leaves differ by at most one. Coloring the elements of the deepest
+  level red, and all others black, gives the same number of black
+  elements on every path.
+
+  @param args       The SEL_ARGs, in order
+  @param count      Number of SEL_ARGs
+  @param depth      Depth of the root of this subtree
+  @param red_depth  Depth of the elements to color red
+  @param parent     Parent of the root of this subtree
+
+  @return The root of the subtree, or &null_element if count is 0
+*/
+
+static SEL_ARG *build_sel_arg_tree(SEL_ARG **args, uint count, uint depth,
+                                   uint red_depth, SEL_ARG *parent)
+{
+  if (count == 0)
+    return &null_element;
+  const uint middle= count / 2;
+  SEL_ARG *const root= args[middle];
+  root->parent= parent;
+  root->color= depth == red_depth ? SEL_ARG::RED : SEL_ARG::BLACK;
+  root->left= build_sel_arg_tree(args, middle, depth + 1, red_depth, root);
+  root->right= build_sel_arg_tree(args + middle + 1, count - middle - 1,
+                                  depth + 1, red_depth, root);
+  return root;
+}
+
+
+/**
+  Build the SEL_TREE of "field IN (c1, ..., cN)" in one pass.
+
+  OR-ing the trees of "field = c_i" one at a time allocates a SEL_TREE
+  for each value and inserts its range into the R-B tree of every index
+  with key_or(), which for lists of many thousand values takes longer
+  than executing the query, and makes the range optimizer run out of
+  range_optimizer_max_mem_size. Instead, the ranges of all values are
+  created by get_mm_leaf() like get_mm_parts() does, then sorted and
+  deduplicated, and linked into a balanced R-B tree for each index.
+
+  This is done only if all values are constants and every range is a
+  single point. The caller builds the tree with get_mm_parts() and
+  tree_or() otherwise.
+
+  @param      param  PARAM from test_quick_select
+  @param      op     The IN predicate
+  @param      field  The left-hand side of the IN predicate
+  @param[out] tree   The tree, or NULL if no range can be built
+
+  @retval false  The tree was built
+  @retval true   The tree must be built value by value
+*/
+
+static bool get_in_list_mm_tree(RANGE_OPT_PARAM *param, Item_func_in *op,
+                                Field *field, SEL_TREE **tree)
+{
+  Item **const values= op->arguments() + 1;
+  const uint value_count= op->argument_count() - 1;
+  DBUG_ENTER("get_in_list_mm_tree");
+
+  *tree= NULL;
+  if (field->table != param->table)
+    DBUG_RETURN(true);
+  for (uint i= 0; i < value_count; i++)
+  {
+    if (values[i]->used_tables() & ~param->read_tables)
+      DBUG_RETURN(true);
+  }
+
+  uint part_count= 0;
+  for (KEY_PART *key_part= param->key_parts; key_part != param->key_parts_end;
+       key_part++)
+  {
+    if (field->eq(key_part->field))
+      part_count++;
+  }
+  if (part_count == 0)
+    DBUG_RETURN(true);
+
+  KEY_PART **const parts= static_cast<KEY_PART **>
+    (alloc_root(param->mem_root, sizeof(KEY_PART *) * part_count));
+  // The range of value i in key part j is ranges[j * value_count + i]
+  SEL_ARG **const ranges= static_cast<SEL_ARG **>
+    (alloc_root(param->mem_root,
+                sizeof(SEL_ARG *) * part_count * value_count));
+  if (parts == NULL || ranges == NULL)
+    DBUG_RETURN(false);                         // OOM
+
+  part_count= 0;
+  for (KEY_PART *key_part= param->key_parts; key_part != param->key_parts_end;
+       key_part++)
+  {
+    if (field->eq(key_part->field))
+    {
+      // get_mm_parts() would chain two ranges of the same index
+      if (part_count > 0 && parts[part_count - 1]->key == key_part->key)
+        DBUG_RETURN(true);
+      parts[part_count++]= key_part;
+    }
+  }
+
+  uint range_count= 0;
+  for (uint i= 0; i < value_count; i++)
+  {
+    bool impossible= false;
+    for (uint j= 0; j < part_count && !impossible; j++)
+    {
+      // Leave the EXPLAIN warning of get_mm_leaf() to the caller
+      if (!comparable_in_index(op, parts[j]->field, parts[j]->image_type,
+                               Item_func::EQ_FUNC, values[i]))
+        DBUG_RETURN(true);
+      SEL_ARG *const range= get_mm_leaf(param, op, parts[j]->field, parts[j],
+                                        Item_func::EQ_FUNC, values[i]);
+      if (param->has_errors())
+        DBUG_RETURN(false);
+      if (range == NULL)
+        DBUG_RETURN(true);
+      if (range->type == SEL_ARG::IMPOSSIBLE)
+      {
+        // The value can never be equal to the field, so it adds no range
+        impossible= true;
+        continue;
+      }
+      if (range->type != SEL_ARG::KEY_RANGE || range->maybe_flag ||
+          range->next_key_part != NULL || !range->is_singlepoint())
+        DBUG_RETURN(true);
+      range->part= parts[j]->part;
+      ranges[j * value_count + range_count]= range;
+    }
+    if (!impossible)
+      range_count++;
+  }
+
+  if (range_count == 0)
+  {
+    *tree= new (param->mem_root) SEL_TREE(SEL_TREE::IMPOSSIBLE,
+                                          param->mem_root, param->keys);
+    DBUG_RETURN(false);
+  }
+  if (!(*tree= new (param->mem_root) SEL_TREE(param->mem_root, param->keys)))
+    DBUG_RETURN(false);                         // OOM
+
+  for (uint j= 0; j < part_count; j++)
+  {
+    SEL_ARG **const first= ranges + j * value_count;
+    std::sort(first, first + range_count, sel_arg_point_less);
+
+    uint distinct= 1;
+    for (uint i= 1; i < range_count; i++)
+    {
+      if (first[i]->cmp_min_to_min(first[distinct - 1]) != 0)
+        first[distinct++]= first[i];
+    }
+    // SEL_ARG::elements cannot count more points
+    if (distinct > UINT_MAX16)
+    {
+      *tree= NULL;
+      DBUG_RETURN(true);
+    }
+    for (uint i= 0; i < distinct; i++)
+    {
+      first[i]->prev= i > 0 ? first[i - 1] : NULL;
+      first[i]->next= i + 1 < distinct ? first[i + 1] : NULL;
+    }
+
+    /*
+      Depth of the deepest level of the tree, whose elements are red. The
+      root is black, also when it is the only element.
+    */
+    uint red_depth= 1;
+    while ((2U << red_depth) - 1 < distinct)
+      red_depth++;
+    SEL_ARG *const root= build_sel_arg_tree(first, distinct, 0, red_depth,
+                                            NULL);
+    root->elements= static_cast<uint16>(distinct);
+    root->use_count= 1;
+#ifndef DBUG_OFF
+    test_rb_tree(root, root->parent);
+#endif
+
+    (*tree)->keys[parts[j]->key]= root;
+    (*tree)->keys_map.set_bit(parts[j]->key);
+  }
+  DBUG_RETURN(false);
+}
+
+
 /**
   Factory function to build a SEL_TREE from an <in predicate>
 
@@ -6287,8 +6492,11 @@ static SEL_TREE *get_func_mm_tree_from_in_predicate(RANGE_OPT_PARAM *param,
   {
     // The expression is (<column>) IN (...)
     Field *field= static_cast<Item_field*>(predicand)->field;
-    SEL_TREE *tree= get_mm_parts(param, op, field, Item_func::EQ_FUNC,
-                                 op->arguments()[1], cmp_type);
+    SEL_TREE *tree;
+    if (!get_in_list_mm_tree(param, op, field, &tree))
+      return tree;
+    tree= get_mm_parts(param, op, field, Item_func::EQ_FUNC,
+                       op->arguments()[1], cmp_type);
     if (tree)
     {
       Item **arg, **end;
@@ -0,0 +1,161 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+  Estimates of records_in_range() kept in a TABLE, see
+  Range_estimate_cache.
+*/
+
+#include "opt_range_cache.h"
+
+#include "handler.h"                            // handler
+#include "mysqld.h"                             // key_memory_TABLE
+#include "sql_class.h"                          // THD
+#include "table.h"                              // TABLE
+
+#include <new>
+
+
+/** Size of the bytes of a key_range in a key of the cache */
+
+static const size_t KEY_RANGE_HEADER_LENGTH= 1 + 1 + 8 + 4;
+
+
+/**
+  Write the index number and the bounds of a range into a buffer, as the
+  key of the cache.
+
+  @return Length of the key, or 0 if it does not fit in the buffer
+*/
+
+uint Range_estimate_cache::make_key(uchar *buff, size_t buff_length,
+                                    uint keyno, const key_range *min_key,
+                                    const key_range *max_key)
+{
+  const key_range *const bounds[2]= { min_key, max_key };
+  size_t length= 4;
+  for (uint i= 0; i < 2; i++)
+    length+= bounds[i] ? KEY_RANGE_HEADER_LENGTH + bounds[i]->length : 1;
+  if (length > buff_length)
+    return 0;
+
+  uchar *pos= buff;
+  int4store(pos, keyno);
+  pos+= 4;
+  for (uint i= 0; i < 2; i++)
+  {
+    if (bounds[i] == NULL)
+    {
+      *pos++= 0;
+      continue;
+    }
+    *pos++= 1;
+    *pos++= static_cast<uchar>(bounds[i]->flag);
+    int8store(pos, static_cast<ulonglong>(bounds[i]->keypart_map));
+    pos+= 8;
+    int4store(pos, bounds[i]->length);
+    pos+= 4;
+    memcpy(pos, bounds[i]->key, bounds[i]->length);
+    pos+= bounds[i]->length;
+  }
+  DBUG_ASSERT(static_cast<size_t>(pos - buff) == length);
+  return static_cast<uint>(length);
+}
+
+
+ha_rows Range_estimate_cache::records_in_range(TABLE *table, handler *file,
+                                               uint keyno,
+                                               key_range *min_key,
+                                               key_range *max_key)
+{
+  const uint size= table->in_use->variables.range_estimate_cache_size;
+  Range_estimate_cache *cache= table->range_estimate_cache;
+  uchar key[4 + 2 * (KEY_RANGE_HEADER_LENGTH + MAX_KEY_LENGTH)];
+  uint key_length;
+  ha_rows modified_rows;
+  ulonglong stat_generation;
+  DBUG_ENTER("Range_estimate_cache::records_in_range");
+
+  if (cache != NULL && cache->m_size != size)
+  {
+    delete cache;
+    table->range_estimate_cache= cache= NULL;
+  }
+
+  if (size == 0 || table->s->tmp_table != NO_TMP_TABLE ||
+      (modified_rows= file->stat_modified_rows()) == HA_POS_ERROR ||
+      !(key_length= make_key(key, sizeof(key), keyno, min_key, max_key)))
+    DBUG_RETURN(file->records_in_range(keyno, min_key, max_key));
+  stat_generation= file->stat_generation();
+
+  if (cache == NULL)
+  {
+    Entry *const entries= static_cast<Entry *>
+      (my_malloc(key_memory_TABLE, sizeof(Entry) * size,
+                 MYF(MY_ZEROFILL)));
+    if (entries == NULL ||
+        !(cache= new (std::nothrow) Range_estimate_cache(size, entries)))
+    {
+      my_free(entries);
+      DBUG_RETURN(file->records_in_range(keyno, min_key, max_key));
+    }
+    table->range_estimate_cache= cache;
+  }
+
+  ulong nr1= 1, nr2= 4;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, key, key_length,
+                                 &nr1, &nr2);
+  Entry *const entry= &cache->m_entries[nr1 % size];
+
+  if (entry->key_length == key_length &&
+      memcmp(entry->key, key, key_length) == 0 &&
+      stat_generation == entry->stat_generation &&
+      modified_rows >= entry->modified_rows &&
+      modified_rows - entry->modified_rows <=
+      file->stats.records / RANGE_ESTIMATE_MAX_CHANGE)
+  {
+    DBUG_PRINT("info", ("cached estimate: %lu rows", (ulong) entry->rows));
+    DBUG_RETURN(entry->rows);
+  }
+
+  const ha_rows rows= file->records_in_range(keyno, min_key, max_key);
+  if (rows == HA_POS_ERROR)
+    DBUG_RETURN(rows);
+
+  if (entry->buffer_length < key_length)
+  {
+    my_free(entry->key);
+    entry->key_length= entry->buffer_length= 0;
+    if (!(entry->key= static_cast<uchar *>
+          (my_malloc(key_memory_TABLE, key_length, MYF(0)))))
+      DBUG_RETURN(rows);
+    entry->buffer_length= key_length;
+  }
+  memcpy(entry->key, key, key_length);
+  entry->key_length= key_length;
+  entry->rows= rows;
+  entry->modified_rows= modified_rows;
+  entry->stat_generation= stat_generation;
+  DBUG_RETURN(rows);
+}
+
+
+Range_estimate_cache::~Range_estimate_cache()
+{
+  for (uint i= 0; i < m_size; i++)
+    my_free(m_entries[i].key);
+  my_free(m_entries);
+}
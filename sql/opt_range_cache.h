@@ -0,0 +1,100 @@
+#ifndef OPT_RANGE_CACHE_INCLUDED
+#define OPT_RANGE_CACHE_INCLUDED
+
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+  Estimates of records_in_range() kept in a TABLE between statements.
+
+  The range optimizer estimates the number of rows of each range with a
+  dive into the index, which reads pages from disk if the index is not
+  cached, and does so again for every execution of a statement. With
+  range_estimate_cache_size > 0, the estimates are kept in the TABLE,
+  keyed on the index and the bounds of the range, and reused by the later
+  statements that get the same TABLE from the table cache.
+
+  An estimate is stale, and taken again, once more than
+  1/RANGE_ESTIMATE_MAX_CHANGE of the rows of the table have been changed
+  since, as counted by handler::stat_modified_rows(), or once the engine
+  has recalculated its statistics, which restarts the count and changes
+  handler::stat_generation(). Engines that do not count changes do not
+  use the cache.
+
+  The cache is direct-mapped: an estimate replaces the one in its slot.
+*/
+
+#include "my_global.h"
+#include "my_base.h"                            // ha_rows, key_range
+
+class handler;
+struct TABLE;
+
+/**
+  An estimate is stale once more than the number of rows of the table
+  divided by this has been changed.
+*/
+static const uint RANGE_ESTIMATE_MAX_CHANGE= 16;
+
+class Range_estimate_cache
+{
+public:
+  /**
+    Estimate the number of rows in a range of an index with
+    handler::records_in_range(), or take the estimate from the cache of
+    the table.
+
+    @param table    The table
+    @param file     The handler of the table to estimate with
+    @param keyno    The index
+    @param min_key  The start of the range, or NULL
+    @param max_key  The end of the range, or NULL
+
+    @return The estimate, or HA_POS_ERROR if the range can not be scanned
+  */
+  static ha_rows records_in_range(TABLE *table, handler *file, uint keyno,
+                                  key_range *min_key, key_range *max_key);
+
+  ~Range_estimate_cache();
+
+private:
+  struct Entry
+  {
+    /** The index number and the bounds, see make_key(), or NULL */
+    uchar *key;
+    uint key_length;
+    /** Size of the buffer of key */
+    uint buffer_length;
+    ha_rows rows;
+    /** handler::stat_modified_rows() when the estimate was taken */
+    ha_rows modified_rows;
+    /** handler::stat_generation() when the estimate was taken */
+    ulonglong stat_generation;
+  };
+
+  Range_estimate_cache(uint size, Entry *entries)
+    : m_size(size), m_entries(entries)
+  {}
+
+  static uint make_key(uchar *buff, size_t buff_length, uint keyno,
+                       const key_range *min_key, const key_range *max_key);
+
+  /** Number of entries */
+  const uint m_size;
+  Entry *const m_entries;
+};
+
+#endif /* OPT_RANGE_CACHE_INCLUDED */
@@ -25,6 +25,7 @@
 #include "filesort.h"            // filesort_free_buffers
 #include "sql_class.h"                          // THD
 #include "sql_select.h"          // JOIN_TAB
+#include "sql_batch_filter.h"    // Batch_filter
 
 
 static int rr_quick(READ_RECORD *info);
@@ -523,6 +524,19 @@ int rr_sequential(READ_RECORD *info)
 }
 
 
+/**
+  Read the next row of a table scan that passes info->batch_filter.
+
+  The filter reads rows ahead of the caller with rr_sequential(), see
+  Batch_filter::read().
+*/
+
+int rr_batch_filter(READ_RECORD *info)
+{
+  return info->batch_filter->read(info);
+}
+
+
 static int rr_from_tempfile(READ_RECORD *info)
 {
   int tmp;
@@ -18,6 +18,7 @@
 #include <my_global.h>                /* for uint typedefs */
 #include "my_base.h"
 
+class Batch_filter;
 class QEP_TAB;
 class handler;
 struct TABLE;
@@ -69,6 +70,7 @@ struct READ_RECORD
   uchar	*cache,*cache_pos,*cache_end,*read_positions;
   struct st_io_cache *io_cache;
   bool print_error, ignore_not_found_rows;
+  Batch_filter *batch_filter;                   /* see rr_batch_filter() */
 
 public:
   READ_RECORD() {}
@@ -84,5 +86,6 @@ void end_read_record(READ_RECORD *info);
 
 void rr_unlock_row(QEP_TAB *tab);
 int rr_sequential(READ_RECORD *info);
+int rr_batch_filter(READ_RECORD *info);
 
 #endif /* SQL_RECORDS_H */
@@ -1750,6 +1750,69 @@ bool sp_show_create_routine(THD *thd, enum_sp_type type, sp_name *name)
 }
 
 
+/**
+  Take the functions that a routine uses, directly or through other
+  functions, from the shared cache into the cache of the session, unless
+  they are there already.
+
+  @param thd  Thread context
+  @param sp   Routine taken from the shared cache
+
+  @retval false  All functions are in the cache of the session
+  @retval true   A function is neither there nor in the shared cache
+*/
+
+static bool sp_take_shared_functions(THD *thd, sp_head *sp)
+{
+  for (ulong i= 0; i < sp->m_sroutines.records; i++)
+  {
+    Sroutine_hash_entry *rt=
+      (Sroutine_hash_entry *) my_hash_element(&sp->m_sroutines, i);
+    if (rt->mdl_request.key.mdl_namespace() != MDL_key::FUNCTION)
+      continue;
+    char qname_buff[NAME_LEN*2+1+1];
+    sp_name name(&rt->mdl_request.key, qname_buff);
+    if (sp_cache_lookup(&thd->sp_func_cache, &name))
+      continue;
+    sp_head *used= sp_cache_lookup_shared(SP_TYPE_FUNCTION, &name);
+    if (used == NULL)
+      return true;
+    sp_cache_insert(&thd->sp_func_cache, used);
+    if (sp_take_shared_functions(thd, used))
+      return true;
+  }
+  return false;
+}
+
+
+/**
+  Take a routine from the shared cache, see sp_cache_lookup_shared().
+
+  The statements of a routine keep their prelocking lists between
+  executions, and later executions only look up the functions of these
+  lists in the cache of the session, see open_and_process_routine(). So
+  a routine is only taken if the functions it uses can be taken with it.
+
+  @param thd   Thread context
+  @param type  Type of the routine
+  @param name  Name of the routine
+
+  @return The routine, or NULL if it must be loaded from mysql.proc
+*/
+
+static sp_head *sp_take_shared_routine(THD *thd, enum_sp_type type,
+                                       sp_name *name)
+{
+  sp_head *sp= sp_cache_lookup_shared(type, name);
+  if (sp != NULL && sp_take_shared_functions(thd, sp))
+  {
+    delete sp;
+    return NULL;
+  }
+  return sp;
+}
+
+
 /**
   Obtain object representing stored procedure/function by its name from
   stored procedures cache and looking into mysql.proc if needed.
@@ -1848,7 +1911,8 @@ sp_head *sp_find_routine(THD *thd, enum_sp_type type, sp_name *name,
   }
   if (!cache_only)
   {
-    if (db_find_routine(thd, type, name, &sp) == SP_OK)
+    if ((sp= sp_take_shared_routine(thd, type, name)) != NULL ||
+        db_find_routine(thd, type, name, &sp) == SP_OK)
     {
       sp_cache_insert(cp, sp);
       DBUG_PRINT("info", ("added new: 0x%lx, level: %lu, flags %x",
@@ -2158,6 +2222,12 @@ int sp_cache_routine(THD *thd, enum_sp_type type, sp_name *name,
       DBUG_RETURN(SP_OK);
   }
 
+  if ((*sp= sp_take_shared_routine(thd, type, name)))
+  {
+    sp_cache_insert(spc, *sp);
+    DBUG_RETURN(SP_OK);
+  }
+
   switch ((ret= db_find_routine(thd, type, name, sp)))
   {
     case SP_OK:
@@ -17,6 +17,7 @@
 #include "sp_cache.h"
 
 #include "my_atomic.h"
+#include "mysqld.h"                         // stored_program_shared_cache_size
 #include "sp_head.h"
 
 
@@ -24,6 +25,8 @@
   Cache of stored routines.
 */
 
+static void sp_cache_release(sp_head *sp);
+
 extern "C"
 {
   static uchar *hash_get_key_for_sp_head(const uchar *ptr, size_t *plen,
@@ -38,7 +41,7 @@ extern "C"
   static void hash_free_sp_head(void *p)
   {
     sp_head *sp= (sp_head *)p;
-    delete sp;
+    sp_cache_release(sp);
   }
 }
 
@@ -103,6 +106,108 @@ private:
 static int64 volatile Cversion= 0;
 
 
+/*
+  Stored routines shared between sessions.
+
+  A session keeps the routines it has used in its own cache, and loads a
+  routine from mysql.proc and parses it when it is not there, as happens
+  in every new connection. With stored_program_shared_cache > 0, a routine
+  that leaves the cache of a session, because the session ends or its
+  cache exceeds stored_program_cache, is put in a server wide cache
+  instead of being deleted, and a session that does not have a routine
+  takes it from there rather than parsing it again.
+
+  A routine is used by one session at a time: it is either in the cache of
+  a session or in the shared cache. As for the routines of triggers, which
+  the sessions that open a table use one after another, the instructions
+  are kept between executions, and the runtime context (sp_rcontext) is
+  created for each call. Routines of an older version of the caches, see
+  sp_cache_invalidate(), which is called on CREATE, ALTER and DROP of
+  routines, are not put in the shared cache and are deleted when found
+  there.
+*/
+
+static HASH sp_shared_cache;
+static mysql_mutex_t LOCK_sp_shared_cache;
+static bool sp_shared_cache_inited= false;
+
+
+/**
+  Delete the routines of an older version of the caches from the shared
+  cache. Called with LOCK_sp_shared_cache.
+*/
+
+static void sp_shared_cache_purge_obsolete()
+{
+  mysql_mutex_assert_owner(&LOCK_sp_shared_cache);
+  const int64 version= sp_cache_version();
+  for (ulong i= 0; i < sp_shared_cache.records; )
+  {
+    sp_head *sp= (sp_head *) my_hash_element(&sp_shared_cache, i);
+    if (sp->sp_cache_version() < version)
+    {
+      my_hash_delete(&sp_shared_cache, (uchar *) sp);
+      delete sp;
+    }
+    else
+      i++;
+  }
+}
+
+
+/**
+  Dispose of a routine that is removed from the cache of a session: put it
+  in the shared cache if it is up to date and there is room, otherwise
+  delete it.
+*/
+
+static void sp_cache_release(sp_head *sp)
+{
+  if (sp_shared_cache_inited && stored_program_shared_cache_size > 0 &&
+      sp->sp_cache_version() == sp_cache_version() && !sp->is_invoked())
+  {
+    mysql_mutex_lock(&LOCK_sp_shared_cache);
+    if (sp_shared_cache.records >= stored_program_shared_cache_size)
+      sp_shared_cache_purge_obsolete();
+    const bool shared=
+      sp_shared_cache.records < stored_program_shared_cache_size &&
+      !my_hash_insert(&sp_shared_cache, (uchar *) sp);
+    mysql_mutex_unlock(&LOCK_sp_shared_cache);
+    if (shared)
+      return;
+  }
+  delete sp;
+}
+
+
+void sp_cache_init()
+{
+  DBUG_ASSERT(!sp_shared_cache_inited);
+  mysql_mutex_init(key_LOCK_sp_shared_cache, &LOCK_sp_shared_cache,
+                   MY_MUTEX_INIT_FAST);
+  /*
+    The same routine may be in the cache more than once. The routines are
+    deleted explicitly, as they are also taken out of the cache to be used.
+  */
+  (void) my_hash_init(&sp_shared_cache, system_charset_info, 0, 0, 0,
+                      hash_get_key_for_sp_head, NULL, 0,
+                      key_memory_sp_cache);
+  sp_shared_cache_inited= true;
+}
+
+
+void sp_cache_end()
+{
+  if (!sp_shared_cache_inited)
+    return;
+  for (ulong i= 0; i < sp_shared_cache.records; i++)
+    delete (sp_head *) my_hash_element(&sp_shared_cache, i);
+  my_hash_free(&sp_shared_cache);
+  mysql_mutex_destroy(&LOCK_sp_shared_cache);
+  sp_shared_cache_inited= false;
+}
+
+
 /*
   Clear the cache *cp and set *cp to NULL.
 
@@ -182,6 +287,49 @@ sp_head *sp_cache_lookup(sp_cache **cp, sp_name *name)
 }
 
 
+/**
+  Take a routine out of the shared cache, to be put in the cache of the
+  session.
+
+  @param type  Type of the routine
+  @param name  Name of the routine
+
+  @return The routine, or NULL if there is no up to date one
+*/
+
+sp_head *sp_cache_lookup_shared(enum_sp_type type, sp_name *name)
+{
+  if (!sp_shared_cache_inited || stored_program_shared_cache_size == 0)
+    return NULL;
+
+  const int64 version= sp_cache_version();
+  sp_head *found= NULL;
+  HASH_SEARCH_STATE state;
+  mysql_mutex_lock(&LOCK_sp_shared_cache);
+  for (sp_head *sp= (sp_head *) my_hash_first(&sp_shared_cache,
+                                              (uchar *) name->m_qname.str,
+                                              name->m_qname.length, &state);
+       sp != NULL;
+       sp= (sp_head *) my_hash_next(&sp_shared_cache,
+                                    (uchar *) name->m_qname.str,
+                                    name->m_qname.length, &state))
+  {
+    if (sp->m_type == type && sp->sp_cache_version() == version)
+    {
+      found= sp;
+      break;
+    }
+  }
+  if (found != NULL)
+    my_hash_delete(&sp_shared_cache, (uchar *) found);
+  mysql_mutex_unlock(&LOCK_sp_shared_cache);
+  DBUG_PRINT("info", ("sp_cache: %s in shared cache: %.*s",
+                      found ? "found" : "not", (int) name->m_qname.length,
+                      name->m_qname.str));
+  return found;
+}
+
+
 /*
   Invalidate all routines in all caches.
 
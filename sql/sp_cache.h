@@ -18,12 +18,16 @@
 #define _SP_CACHE_H_
 
 #include "my_global.h"                          /* ulong */
+#include "sql_lex.h"                            // enum_sp_type
 
 /*
   Stored procedures/functions cache. This is used as follows:
    * Each thread has its own cache.
    * Each sp_head object is put into its thread cache before it is used, and
      then remains in the cache until deleted.
+   * With stored_program_shared_cache > 0, an up to date sp_head object
+     that is removed from a thread cache is kept in a shared cache, from
+     which another thread can take it instead of loading the routine.
 */
 
 class sp_head;
@@ -38,6 +42,9 @@ class sp_name;
     // look up a routine in the cache (no checks if it is up to date or not)
     sp_cache_lookup();
 
+    // if not found, take an up to date one from the shared cache
+    sp_cache_lookup_shared();
+
     sp_cache_insert();
     sp_cache_invalidate();
 
@@ -48,9 +55,12 @@ class sp_name;
     sp_cache_clear();
 */
 
+void sp_cache_init();
+void sp_cache_end();
 void sp_cache_clear(sp_cache **cp);
 void sp_cache_insert(sp_cache **cp, sp_head *sp);
 sp_head *sp_cache_lookup(sp_cache **cp, sp_name *name);
+sp_head *sp_cache_lookup_shared(enum_sp_type type, sp_name *name);
 void sp_cache_invalidate();
 void sp_cache_flush_obsolete(sp_cache **cp, sp_head **sp);
 int64 sp_cache_version();
@@ -25,6 +25,7 @@
 #include "sql_view.h"                        // view_checksum
 #include "sql_table.h"                       // mysql_recreate_table
 #include "debug_sync.h"                      // DEBUG_SYNC
+#include "histogram.h"                       // build_histograms
 #include "auth_common.h"                     // *_ACL
 #include "sp.h"                              // Sroutine_hash_entry
 #include "sp_rcontext.h"                     // sp_rcontext
@@ -1198,6 +1199,249 @@ bool mysql_preload_keys(THD* thd, TABLE_LIST* tables)
 }
 
 
+/**
+  Send a row of the result of ANALYZE TABLE ... HISTOGRAM.
+*/
+
+static bool send_histogram_row(Protocol *protocol, const char *table_name,
+                               const char *msg_type, const char *msg_text)
+{
+  protocol->start_row();
+  protocol->store(table_name, system_charset_info);
+  protocol->store(STRING_WITH_LEN("histogram"), system_charset_info);
+  protocol->store(msg_type, system_charset_info);
+  protocol->store(msg_text, system_charset_info);
+  return protocol->end_row();
+}
+
+
+/**
+  Send the error of the diagnostics area as a row of the result of
+  ANALYZE TABLE ... HISTOGRAM, and clear it. The error is not repeated
+  as a warning, as with the other ANALYZE TABLE errors.
+*/
+
+static bool send_histogram_error(THD *thd, const char *table_name)
+{
+  const bool res=
+    send_histogram_row(thd->get_protocol(), table_name, "error",
+                       thd->get_stmt_da()->message_text());
+  thd->clear_error();
+  thd->get_stmt_da()->reset_condition_info(thd);
+  return res;
+}
+
+
+/**
+  Execute ANALYZE TABLE ... UPDATE HISTOGRAM and DROP HISTOGRAM.
+
+  The histograms are built while the table is open for reading, and are
+  stored after it has been closed, so that the table is not locked while
+  mysql.histograms is written.
+
+  @param thd    Thread
+  @param table  The table list of the statement
+
+  @retval false  OK, the result has been sent
+  @retval true   Error
+*/
+
+bool Sql_cmd_analyze_table::handle_histograms(THD *thd, TABLE_LIST *table)
+{
+  Protocol *protocol= thd->get_protocol();
+  List<Item> field_list;
+  Item *item;
+  char table_name[NAME_LEN*2+2];
+  char buf[MYSQL_ERRMSG_SIZE];
+  DBUG_ENTER("Sql_cmd_analyze_table::handle_histograms");
+
+  if (m_histogram_command == UPDATE_HISTOGRAM &&
+      (m_histogram_buckets < 1 || m_histogram_buckets > HISTOGRAM_MAX_BUCKETS))
+  {
+    my_error(ER_DATA_OUT_OF_RANGE, MYF(0), "Number of buckets",
+             "ANALYZE TABLE");
+    DBUG_RETURN(true);
+  }
+
+  field_list.push_back(item = new Item_empty_string("Table", NAME_CHAR_LEN*2));
+  item->maybe_null = 1;
+  field_list.push_back(item = new Item_empty_string("Op", 10));
+  item->maybe_null = 1;
+  field_list.push_back(item = new Item_empty_string("Msg_type", 10));
+  item->maybe_null = 1;
+  field_list.push_back(item = new Item_empty_string("Msg_text",
+                                                    SQL_ADMIN_MSG_TEXT_SIZE));
+  item->maybe_null = 1;
+  if (thd->send_result_metadata(&field_list,
+                                Protocol::SEND_NUM_ROWS | Protocol::SEND_EOF))
+    DBUG_RETURN(true);
+
+  /* Close the temporary tables that were pre-opened for privilege checks */
+  close_thread_tables(thd);
+  for (TABLE_LIST *tl= table; tl; tl= tl->next_local)
+    tl->table= NULL;
+
+  if (table->next_local != NULL)
+  {
+    for (; table; table= table->next_local)
+    {
+      strxmov(table_name, table->db, ".", table->table_name, NullS);
+      if (send_histogram_row(protocol, table_name, "error",
+                             "Only one table can be specified while "
+                             "modifying histogram statistics."))
+        DBUG_RETURN(true);
+    }
+    my_eof(thd);
+    DBUG_RETURN(false);
+  }
+
+  strxmov(table_name, table->db, ".", table->table_name, NullS);
+  table->lock_type= TL_READ;
+  table->mdl_request.set_type(MDL_SHARED_READ);
+  table->required_type= FRMTYPE_TABLE;
+
+  if (open_temporary_tables(thd, table) ||
+      open_and_lock_tables(thd, table, 0))
+  {
+    trans_rollback_stmt(thd);
+    close_thread_tables(thd);
+    thd->mdl_context.release_transactional_locks();
+    if (send_histogram_error(thd, table_name))
+      DBUG_RETURN(true);
+    my_eof(thd);
+    DBUG_RETURN(false);
+  }
+
+  TABLE *const tab= table->table;
+  const char *message= NULL;
+  if (tab->s->tmp_table != NO_TMP_TABLE)
+    message= "Cannot modify histogram statistics of a temporary table.";
+  else if (tab->s->table_category != TABLE_CATEGORY_USER)
+    message= "Cannot modify histogram statistics of a system table.";
+
+  const uint count= m_histogram_columns->elements;
+  const char **columns=
+    static_cast<const char**>(thd->alloc(count * sizeof(char*)));
+  Field **fields= static_cast<Field**>(thd->alloc(count * sizeof(Field*)));
+  Histogram **histograms=
+    static_cast<Histogram**>(thd->alloc(count * sizeof(Histogram*)));
+  bool *dropped= static_cast<bool*>(thd->alloc(count * sizeof(bool)));
+  if (!columns || !fields || !histograms || !dropped)
+    message= ER(ER_OUTOFMEMORY);
+
+  /* Resolve the columns, and report the ones that can not be handled */
+  uint n= 0;
+  bool res= false;
+  List_iterator<String> it(*m_histogram_columns);
+  String *name;
+  while (message == NULL && !res && (name= it++))
+  {
+    const char *column= thd->strmake(name->ptr(), name->length());
+    bool duplicate= false;
+    for (uint i= 0; i < n && !duplicate; i++)
+      duplicate= !my_strcasecmp(system_charset_info, columns[i], column);
+    if (duplicate)
+      continue;
+
+    if (m_histogram_command == DROP_HISTOGRAM)
+    {
+      // Histograms of columns that were dropped can be removed, too
+      columns[n++]= column;
+      continue;
+    }
+
+    Field *field= NULL;
+    for (Field **f= tab->field; *f && field == NULL; f++)
+    {
+      if (!my_strcasecmp(system_charset_info, (*f)->field_name, column))
+        field= *f;
+    }
+    Histogram::enum_value_type value_type;
+    if (field == NULL)
+      my_snprintf(buf, sizeof(buf), "The column '%s' does not exist.",
+                  column);
+    else if (Histogram::get_value_type(field, &value_type))
+      my_snprintf(buf, sizeof(buf),
+                  "The column '%s' has an unsupported data type.", column);
+    else
+    {
+      fields[n]= field;
+      columns[n++]= field->field_name;
+      continue;
+    }
+    res= send_histogram_row(protocol, table_name, "error", buf);
+  }
+
+  bool build_error= false;
+  if (message == NULL && !res && m_histogram_command == UPDATE_HISTOGRAM &&
+      n > 0)
+    build_error= build_histograms(thd, tab, fields, n,
+                                  static_cast<uint>(m_histogram_buckets),
+                                  thd->mem_root, histograms);
+
+  if (thd->is_error())
+  {
+    trans_rollback_stmt(thd);
+    if (!res && !message)
+      res= send_histogram_error(thd, table_name);
+  }
+  else if (trans_commit_stmt(thd))
+    res= true;
+  close_thread_tables(thd);
+  thd->mdl_context.release_transactional_locks();
+
+  if (res)
+    DBUG_RETURN(true);
+  if (message != NULL)
+  {
+    if (send_histogram_row(protocol, table_name, "error", message))
+      DBUG_RETURN(true);
+    my_eof(thd);
+    DBUG_RETURN(false);
+  }
+  if (build_error || n == 0)
+  {
+    my_eof(thd);
+    DBUG_RETURN(false);
+  }
+
+  /* The histograms are written through a separate table access */
+  if (m_histogram_command == UPDATE_HISTOGRAM ?
+      store_histograms(thd, table->db, table->table_name, columns,
+                       histograms, n) :
+      drop_histograms(thd, table->db, table->table_name, columns, n,
+                      dropped))
+  {
+    if (send_histogram_error(thd, table_name))
+      DBUG_RETURN(true);
+    my_eof(thd);
+    DBUG_RETURN(false);
+  }
+
+  for (uint i= 0; i < n; i++)
+  {
+    if (m_histogram_command == UPDATE_HISTOGRAM)
+      my_snprintf(buf, sizeof(buf),
+                  "Histogram statistics created for column '%s'.",
+                  columns[i]);
+    else if (dropped[i])
+      my_snprintf(buf, sizeof(buf),
+                  "Histogram statistics removed for column '%s'.",
+                  columns[i]);
+    else
+      my_snprintf(buf, sizeof(buf),
+                  "No histogram statistics found for column '%s'.",
+                  columns[i]);
+    if (send_histogram_row(protocol, table_name,
+                           m_histogram_command == DROP_HISTOGRAM && !dropped[i] ?
+                           "note" : "status", buf))
+      DBUG_RETURN(true);
+  }
+  my_eof(thd);
+  DBUG_RETURN(false);
+}
+
+
 bool Sql_cmd_analyze_table::execute(THD *thd)
 {
   TABLE_LIST *first_table= thd->lex->select_lex->get_table_list();
@@ -1209,9 +1453,12 @@ bool Sql_cmd_analyze_table::execute(THD *thd)
                          FALSE, UINT_MAX, FALSE))
     goto error;
   thd->enable_slow_log= opt_log_slow_admin_statements;
-  res= mysql_admin_table(thd, first_table, &thd->lex->check_opt,
-                         "analyze", lock_type, 1, 0, 0, 0,
-                         &handler::ha_analyze, 0);
+  if (m_histogram_command != NONE)
+    res= handle_histograms(thd, first_table);
+  else
+    res= mysql_admin_table(thd, first_table, &thd->lex->check_opt,
+                           "analyze", lock_type, 1, 0, 0, 0,
+                           &handler::ha_analyze, 0);
   /* ! we write after unlocking the table */
   if (!res && !thd->lex->no_write_to_binlog)
   {
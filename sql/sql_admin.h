@@ -18,7 +18,9 @@
 
 #include "my_global.h"
 #include "sql_cmd.h"       // Sql_cmd
+#include "sql_list.h"      // List
 
+class String;
 class THD;
 struct TABLE_LIST;
 typedef struct st_key_cache KEY_CACHE;
@@ -43,6 +45,8 @@ public:
     Constructor, used to represent a ANALYZE TABLE statement.
   */
   Sql_cmd_analyze_table()
+    : m_histogram_command(NONE), m_histogram_columns(NULL),
+      m_histogram_buckets(0)
   {}
 
   ~Sql_cmd_analyze_table()
@@ -54,6 +58,36 @@ public:
   {
     return SQLCOM_ANALYZE;
   }
+
+  /** What ANALYZE TABLE does with histograms */
+  enum enum_histogram_command
+  {
+    NONE,               ///< Update the index statistics
+    UPDATE_HISTOGRAM,   ///< UPDATE HISTOGRAM ON columns
+    DROP_HISTOGRAM      ///< DROP HISTOGRAM ON columns
+  };
+
+  /**
+    Set the histogram clause of the statement.
+
+    @param command  UPDATE_HISTOGRAM or DROP_HISTOGRAM
+    @param columns  Names of the columns
+    @param buckets  Number of buckets, for UPDATE_HISTOGRAM
+  */
+  void set_histogram_command(enum_histogram_command command,
+                             List<String> *columns, ulong buckets)
+  {
+    m_histogram_command= command;
+    m_histogram_columns= columns;
+    m_histogram_buckets= buckets;
+  }
+
+private:
+  bool handle_histograms(THD *thd, TABLE_LIST *table);
+
+  enum_histogram_command m_histogram_command;
+  List<String> *m_histogram_columns;
+  ulong m_histogram_buckets;
 };
 
 
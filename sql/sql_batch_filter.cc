@@ -0,0 +1,691 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Batched pre-filtering of rows read by a table scan, see Batch_filter.
+*/
+
+#include "sql_batch_filter.h"
+
+#include "field.h"                              // Field
+#include "item_cmpfunc.h"                       // Item_func_opt_neg
+#include "records.h"                            // READ_RECORD
+#include "sql_class.h"                          // THD
+#include "table.h"                              // TABLE
+
+#include <algorithm>
+
+
+Batch_filter::Batch_filter(THD *thd, TABLE *table, uint capacity,
+                           bool exact)
+  : m_table(table), m_capacity(capacity), m_exact(exact),
+    m_operands(thd->mem_root), m_predicates(thd->mem_root),
+    m_root(NONE), m_values(thd->mem_root),
+    m_rows(NULL), m_row_count(0), m_next_row(0),
+    m_const_rows(0), m_pending_error(0), m_examined_rows(NULL)
+{}
+
+
+Batch_filter *Batch_filter::create(THD *thd, TABLE *table, Item *cond,
+                                   uint capacity)
+{
+  DBUG_ENTER("Batch_filter::create");
+
+#ifdef WORDS_BIGENDIAN
+  // Column values are decoded in the little-endian record format
+  if (!table->s->db_low_byte_first)
+    DBUG_RETURN(NULL);
+#endif
+
+  Batch_filter *filter=
+    new (thd->mem_root) Batch_filter(thd, table, capacity, false);
+  if (filter == NULL)
+    DBUG_RETURN(NULL);
+
+  filter->m_root= filter->add_predicate(cond);
+  if (filter->m_root == NONE || filter->alloc_buffers(thd))
+    DBUG_RETURN(NULL);
+
+  DBUG_PRINT("info", ("batch filter for %s: %u predicates, %u operands",
+                      table->alias, (uint) filter->m_predicates.size(),
+                      (uint) filter->m_operands.size()));
+  DBUG_RETURN(filter);
+}
+
+
+Batch_filter *Batch_filter::create_exact(THD *thd, TABLE *table, Item *cond,
+                                         Item **values, uint value_count,
+                                         uint capacity)
+{
+  DBUG_ENTER("Batch_filter::create_exact");
+
+#ifdef WORDS_BIGENDIAN
+  if (!table->s->db_low_byte_first)
+    DBUG_RETURN(NULL);
+#endif
+
+  Batch_filter *filter=
+    new (thd->mem_root) Batch_filter(thd, table, capacity, true);
+  if (filter == NULL)
+    DBUG_RETURN(NULL);
+
+  if (cond != NULL &&
+      (filter->m_root= filter->add_predicate(cond)) == NONE)
+    DBUG_RETURN(NULL);
+  for (uint i= 0; i < value_count; i++)
+  {
+    const uint op_no= filter->add_operand(values[i]);
+    if (op_no == NONE || filter->m_values.push_back(op_no))
+      DBUG_RETURN(NULL);
+  }
+  if (filter->alloc_buffers(thd))
+    DBUG_RETURN(NULL);
+  DBUG_RETURN(filter);
+}
+
+
+/**
+  Add a predicate for a condition.
+
+  @param cond  Condition to evaluate in batches
+
+  @return The predicate number, or NONE if the condition is not supported.
+          Children are always added before their parent.
+*/
+
+uint Batch_filter::add_predicate(Item *cond)
+{
+  // Drop what was added for a condition that turns out to be unsupported
+  const size_t predicate_count= m_predicates.size();
+  const size_t operand_count= m_operands.size();
+  const uint pred_no= build_predicate(cond);
+  if (pred_no == NONE)
+  {
+    m_predicates.chop(predicate_count);
+    m_operands.chop(operand_count);
+  }
+  return pred_no;
+}
+
+
+uint Batch_filter::build_predicate(Item *cond)
+{
+  Predicate pred;
+  memset(&pred, 0, sizeof(pred));
+  pred.first_child= NONE;
+  pred.next_sibling= NONE;
+
+  if (cond->type() == Item::COND_ITEM)
+  {
+    Item_cond *const item_cond= static_cast<Item_cond *>(cond);
+    const bool is_and= item_cond->functype() == Item_func::COND_AND_FUNC;
+    if (!is_and && item_cond->functype() != Item_func::COND_OR_FUNC)
+      return NONE;
+    pred.type= is_and ? Predicate::AND : Predicate::OR;
+
+    /*
+      Leaving out an argument of AND can only let more rows through, so
+      the unsupported ones are just skipped unless the filter must be
+      exact. An OR with an unsupported argument cannot reject any row.
+    */
+    uint last_child= NONE;
+    List_iterator<Item> it(*item_cond->argument_list());
+    Item *arg;
+    while ((arg= it++))
+    {
+      const uint child= add_predicate(arg);
+      if (child == NONE)
+      {
+        if (is_and && !m_exact)
+          continue;
+        return NONE;
+      }
+      if (last_child == NONE)
+        pred.first_child= child;
+      else
+        m_predicates[last_child].next_sibling= child;
+      last_child= child;
+    }
+    if (last_child == NONE)
+      return NONE;
+    // An AND or OR of a single predicate is that predicate
+    if (m_predicates[pred.first_child].next_sibling == NONE)
+      return pred.first_child;
+  }
+  else if (cond->type() == Item::FUNC_ITEM)
+  {
+    Item_func *const func= static_cast<Item_func *>(cond);
+    switch (func->functype())
+    {
+    case Item_func::EQ_FUNC:
+    case Item_func::NE_FUNC:
+    case Item_func::LT_FUNC:
+    case Item_func::LE_FUNC:
+    case Item_func::GT_FUNC:
+    case Item_func::GE_FUNC:
+      pred.type= Predicate::COMPARE;
+      pred.cmp= func->functype();
+      if ((pred.args[0]= add_operand(func->arguments()[0])) == NONE ||
+          (pred.args[1]= add_operand(func->arguments()[1])) == NONE)
+        return NONE;
+      break;
+    case Item_func::BETWEEN:
+      if (static_cast<Item_func_opt_neg *>(func)->negated)
+        return NONE;
+      pred.type= Predicate::BETWEEN;
+      for (uint i= 0; i < 3; i++)
+        if ((pred.args[i]= add_operand(func->arguments()[i])) == NONE)
+          return NONE;
+      break;
+    case Item_func::IN_FUNC:
+    {
+      if (static_cast<Item_func_opt_neg *>(func)->negated)
+        return NONE;
+      pred.type= Predicate::IN;
+      if ((pred.args[0]= add_operand(func->arguments()[0])) == NONE)
+        return NONE;
+      pred.in_items= func->arguments() + 1;
+      pred.in_item_count= func->argument_count() - 1;
+      for (uint i= 0; i < pred.in_item_count; i++)
+      {
+        Item *const item= pred.in_items[i];
+        if (!item->const_item() || item->is_expensive() ||
+            item->result_type() != INT_RESULT)
+          return NONE;
+      }
+      pred.in_values= static_cast<longlong *>(
+        sql_alloc(sizeof(longlong) * pred.in_item_count));
+      if (pred.in_values == NULL)
+        return NONE;
+      break;
+    }
+    default:
+      return NONE;
+    }
+  }
+  else
+    return NONE;
+
+  if (m_predicates.push_back(pred))
+    return NONE;
+  return m_predicates.size() - 1;
+}
+
+
+/**
+  Add an operand for an integer expression.
+
+  @param item  Expression to evaluate in batches
+
+  @return The operand number, or NONE if the expression is not supported.
+          Arguments are always added before the operators using them.
+*/
+
+uint Batch_filter::add_operand(Item *item)
+{
+  if (item->result_type() != INT_RESULT)
+    return NONE;
+
+  if (item->const_item())
+    return add_constant(item);
+
+  Operand op;
+  memset(&op, 0, sizeof(op));
+
+  Item *const real_item= item->real_item();
+  if (real_item->type() == Item::FIELD_ITEM)
+  {
+    Field *const field= static_cast<Item_field *>(real_item)->field;
+    if (field->table != m_table)
+      return NONE;
+    op.type= Operand::COLUMN;
+    op.field_type= field->real_type();
+    op.is_unsigned= (field->flags & UNSIGNED_FLAG) != 0;
+    switch (op.field_type)
+    {
+    case MYSQL_TYPE_TINY:     op.bits= 8; break;
+    case MYSQL_TYPE_SHORT:    op.bits= 16; break;
+    case MYSQL_TYPE_INT24:    op.bits= 24; break;
+    case MYSQL_TYPE_LONG:     op.bits= 32; break;
+    case MYSQL_TYPE_LONGLONG:
+      // Values above LLONG_MAX do not fit the longlong vectors
+      if (op.is_unsigned)
+        return NONE;
+      op.bits= 64;
+      break;
+    default:
+      return NONE;
+    }
+    op.offset= field->ptr - m_table->record[0];
+    if (field->real_maybe_null())
+    {
+      op.null_offset= field->null_offset();
+      op.null_bit= field->null_bit;
+    }
+  }
+  else if (real_item->type() == Item::FUNC_ITEM)
+  {
+    Item_func *const func= static_cast<Item_func *>(real_item);
+    if (func->argument_count() != 2 || func->unsigned_flag)
+      return NONE;
+    // Item_func_plus and friends have no Functype of their own
+    const char *const name= func->func_name();
+    if (!strcmp(name, "+"))
+      op.type= Operand::PLUS;
+    else if (!strcmp(name, "-"))
+      op.type= Operand::MINUS;
+    else if (!strcmp(name, "*"))
+      op.type= Operand::MUL;
+    else
+      return NONE;
+    if ((op.left= add_operand(func->arguments()[0])) == NONE ||
+        (op.right= add_operand(func->arguments()[1])) == NONE)
+      return NONE;
+  }
+  else
+    return NONE;
+
+  if (m_operands.push_back(op))
+    return NONE;
+  return m_operands.size() - 1;
+}
+
+
+/**
+  Add an operand for a constant expression. The value is computed by
+  init_scan() for each scan.
+*/
+
+uint Batch_filter::add_constant(Item *item)
+{
+  if (item->is_expensive())
+    return NONE;
+
+  Operand op;
+  memset(&op, 0, sizeof(op));
+  op.type= Operand::CONSTANT;
+  op.item= item;
+  if (m_operands.push_back(op))
+    return NONE;
+  return m_operands.size() - 1;
+}
+
+
+bool Batch_filter::alloc_buffers(THD *thd)
+{
+  // An exact filter evaluates rows read by the caller
+  if (!m_exact)
+  {
+    m_rows= static_cast<uchar *>(
+      thd->alloc(static_cast<size_t>(m_capacity) * m_table->s->reclength));
+    if (m_rows == NULL)
+      return true;
+  }
+  for (size_t i= 0; i < m_operands.size(); i++)
+  {
+    Operand &op= m_operands[i];
+    op.values= static_cast<longlong *>(
+      thd->alloc(sizeof(longlong) * m_capacity));
+    op.nulls= static_cast<uchar *>(thd->alloc(m_capacity));
+    if (op.values == NULL || op.nulls == NULL)
+      return true;
+  }
+  for (size_t i= 0; i < m_predicates.size(); i++)
+  {
+    Predicate &pred= m_predicates[i];
+    if ((pred.selected= static_cast<uchar *>(thd->alloc(m_capacity))) == NULL)
+      return true;
+  }
+  return false;
+}
+
+
+/** Number of bits needed for the magnitude of a value */
+
+static uint magnitude_bits(longlong value)
+{
+  if (value == LLONG_MIN)
+    return 64;
+  ulonglong magnitude= value < 0 ? -value : value;
+  uint bits= 0;
+  for (; magnitude; magnitude>>= 1)
+    bits++;
+  return bits;
+}
+
+
+/**
+  Evaluate a constant, and check that it can be represented as a longlong.
+
+  @retval false  OK, the value is in *value (unless *null_value is set)
+  @retval true   The value is out of range, or an error was raised
+*/
+
+static bool eval_constant(THD *thd, Item *item, longlong *value,
+                          bool *null_value)
+{
+  *value= item->val_int();
+  *null_value= item->null_value;
+  if (thd->is_error())
+    return true;
+  return !*null_value && item->unsigned_flag && *value < 0;
+}
+
+
+bool Batch_filter::init_scan(ha_rows *examined_rows)
+{
+  THD *const thd= m_table->in_use;
+
+  m_examined_rows= examined_rows;
+  m_row_count= m_next_row= m_const_rows= 0;
+  m_pending_error= 0;
+
+  for (size_t i= 0; i < m_operands.size(); i++)
+  {
+    Operand &op= m_operands[i];
+    switch (op.type)
+    {
+    case Operand::COLUMN:
+      break;
+    case Operand::CONSTANT:
+      if (eval_constant(thd, op.item, &op.const_value, &op.const_null))
+        return true;
+      op.bits= op.const_null ? 0 : magnitude_bits(op.const_value);
+      break;
+    case Operand::PLUS:
+    case Operand::MINUS:
+      op.bits= std::max(m_operands[op.left].bits,
+                        m_operands[op.right].bits) + 1;
+      break;
+    case Operand::MUL:
+      op.bits= m_operands[op.left].bits + m_operands[op.right].bits;
+      break;
+    }
+    // The result of arithmetic must not overflow
+    if (op.type >= Operand::PLUS && op.bits > 63)
+      return true;
+  }
+
+  for (size_t i= 0; i < m_predicates.size(); i++)
+  {
+    Predicate &pred= m_predicates[i];
+    if (pred.type != Predicate::IN)
+      continue;
+    // NULL in the list cannot make the predicate true
+    pred.in_value_count= 0;
+    for (uint j= 0; j < pred.in_item_count; j++)
+    {
+      longlong value;
+      bool null_value;
+      if (eval_constant(thd, pred.in_items[j], &value, &null_value))
+        return true;
+      if (!null_value)
+        pred.in_values[pred.in_value_count++]= value;
+    }
+    std::sort(pred.in_values, pred.in_values + pred.in_value_count);
+  }
+  return false;
+}
+
+
+int Batch_filter::read(READ_RECORD *info)
+{
+  const size_t reclength= m_table->s->reclength;
+  for (;;)
+  {
+    const uchar *const selected= m_predicates[m_root].selected;
+    while (m_next_row < m_row_count)
+    {
+      const uint row= m_next_row++;
+      if (selected[row])
+      {
+        memcpy(info->record, m_rows + row * reclength, reclength);
+        m_table->status= 0;
+        return 0;
+      }
+      (*m_examined_rows)++;
+    }
+    if (m_pending_error)
+      return m_pending_error;
+    fill_batch(info);
+  }
+}
+
+
+/**
+  Read the next batch of rows from the scan and evaluate the filter for
+  them. The error that ended the batch, if any, is kept until the rows
+  read before it have been handed out.
+*/
+
+void Batch_filter::fill_batch(READ_RECORD *info)
+{
+  const size_t reclength= m_table->s->reclength;
+  m_row_count= m_next_row= 0;
+  while (m_row_count < m_capacity)
+  {
+    const int error= rr_sequential(info);
+    if (error)
+    {
+      m_pending_error= error;
+      break;
+    }
+    memcpy(m_rows + m_row_count * reclength, info->record, reclength);
+    m_row_count++;
+  }
+  if (m_row_count > 0)
+    evaluate(m_rows, m_row_count);
+}
+
+
+const uchar *Batch_filter::evaluate(const uchar *rows, uint row_count)
+{
+  DBUG_ASSERT(row_count <= m_capacity);
+  evaluate_operands(rows, row_count);
+  if (m_root == NONE)
+    return NULL;
+  evaluate_predicate(m_root, row_count);
+  return m_predicates[m_root].selected;
+}
+
+
+/**
+  Fill in the values of all operands for the rows of the batch. The type
+  of each column is switched on once per batch, not once per row.
+*/
+
+void Batch_filter::evaluate_operands(const uchar *row_buffer, uint rows)
+{
+  const size_t reclength= m_table->s->reclength;
+  for (size_t i= 0; i < m_operands.size(); i++)
+  {
+    Operand &op= m_operands[i];
+    longlong *const values= op.values;
+    uchar *const nulls= op.nulls;
+    switch (op.type)
+    {
+    case Operand::COLUMN:
+    {
+      const uchar *ptr= row_buffer + op.offset;
+      switch (op.field_type)
+      {
+      case MYSQL_TYPE_TINY:
+        for (uint row= 0; row < rows; row++, ptr+= reclength)
+          values[row]= op.is_unsigned ? (longlong) *ptr :
+                                        (longlong) (signed char) *ptr;
+        break;
+      case MYSQL_TYPE_SHORT:
+        for (uint row= 0; row < rows; row++, ptr+= reclength)
+          values[row]= op.is_unsigned ? (longlong) uint2korr(ptr) :
+                                        (longlong) sint2korr(ptr);
+        break;
+      case MYSQL_TYPE_INT24:
+        for (uint row= 0; row < rows; row++, ptr+= reclength)
+          values[row]= op.is_unsigned ? (longlong) uint3korr(ptr) :
+                                        (longlong) sint3korr(ptr);
+        break;
+      case MYSQL_TYPE_LONG:
+        for (uint row= 0; row < rows; row++, ptr+= reclength)
+          values[row]= op.is_unsigned ? (longlong) uint4korr(ptr) :
+                                        (longlong) sint4korr(ptr);
+        break;
+      case MYSQL_TYPE_LONGLONG:
+        for (uint row= 0; row < rows; row++, ptr+= reclength)
+          values[row]= sint8korr(ptr);
+        break;
+      default:
+        DBUG_ASSERT(false);
+      }
+      if (op.null_bit)
+      {
+        const uchar *null_ptr= row_buffer + op.null_offset;
+        for (uint row= 0; row < rows; row++, null_ptr+= reclength)
+          nulls[row]= (*null_ptr & op.null_bit) != 0;
+      }
+      else
+        memset(nulls, 0, rows);
+      break;
+    }
+    case Operand::CONSTANT:
+      // Constants keep their values for the whole scan
+      for (uint row= m_const_rows; row < rows; row++)
+      {
+        values[row]= op.const_value;
+        nulls[row]= op.const_null;
+      }
+      break;
+    case Operand::PLUS:
+    case Operand::MINUS:
+    case Operand::MUL:
+    {
+      const Operand &left= m_operands[op.left];
+      const Operand &right= m_operands[op.right];
+      if (op.type == Operand::PLUS)
+        for (uint row= 0; row < rows; row++)
+          values[row]= left.values[row] + right.values[row];
+      else if (op.type == Operand::MINUS)
+        for (uint row= 0; row < rows; row++)
+          values[row]= left.values[row] - right.values[row];
+      else
+        for (uint row= 0; row < rows; row++)
+          values[row]= left.values[row] * right.values[row];
+      for (uint row= 0; row < rows; row++)
+        nulls[row]= left.nulls[row] | right.nulls[row];
+      break;
+    }
+    }
+  }
+  m_const_rows= std::max(m_const_rows, rows);
+}
+
+
+/**
+  Compute the selection vector of a predicate, and of its arguments, for
+  the rows of the batch.
+*/
+
+void Batch_filter::evaluate_predicate(uint pred_no, uint rows)
+{
+  Predicate &pred= m_predicates[pred_no];
+  uchar *const selected= pred.selected;
+
+  switch (pred.type)
+  {
+  case Predicate::AND:
+  case Predicate::OR:
+  {
+    const bool is_and= pred.type == Predicate::AND;
+    for (uint child= pred.first_child; child != NONE;
+         child= m_predicates[child].next_sibling)
+    {
+      evaluate_predicate(child, rows);
+      const uchar *const child_selected= m_predicates[child].selected;
+      if (child == pred.first_child)
+        memcpy(selected, child_selected, rows);
+      else if (is_and)
+        for (uint row= 0; row < rows; row++)
+          selected[row]&= child_selected[row];
+      else
+        for (uint row= 0; row < rows; row++)
+          selected[row]|= child_selected[row];
+    }
+    break;
+  }
+  case Predicate::COMPARE:
+  {
+    const longlong *const a= m_operands[pred.args[0]].values;
+    const longlong *const b= m_operands[pred.args[1]].values;
+    const uchar *const a_null= m_operands[pred.args[0]].nulls;
+    const uchar *const b_null= m_operands[pred.args[1]].nulls;
+    switch (pred.cmp)
+    {
+    case Item_func::EQ_FUNC:
+      for (uint row= 0; row < rows; row++)
+        selected[row]= a[row] == b[row];
+      break;
+    case Item_func::NE_FUNC:
+      for (uint row= 0; row < rows; row++)
+        selected[row]= a[row] != b[row];
+      break;
+    case Item_func::LT_FUNC:
+      for (uint row= 0; row < rows; row++)
+        selected[row]= a[row] < b[row];
+      break;
+    case Item_func::LE_FUNC:
+      for (uint row= 0; row < rows; row++)
+        selected[row]= a[row] <= b[row];
+      break;
+    case Item_func::GT_FUNC:
+      for (uint row= 0; row < rows; row++)
+        selected[row]= a[row] > b[row];
+      break;
+    case Item_func::GE_FUNC:
+      for (uint row= 0; row < rows; row++)
+        selected[row]= a[row] >= b[row];
+      break;
+    default:
+      DBUG_ASSERT(false);
+    }
+    // A comparison with NULL is never true
+    for (uint row= 0; row < rows; row++)
+      selected[row]&= !(a_null[row] | b_null[row]);
+    break;
+  }
+  case Predicate::BETWEEN:
+  {
+    const Operand &a= m_operands[pred.args[0]];
+    const Operand &low= m_operands[pred.args[1]];
+    const Operand &high= m_operands[pred.args[2]];
+    for (uint row= 0; row < rows; row++)
+      selected[row]= !(a.nulls[row] | low.nulls[row] | high.nulls[row]) &&
+                     a.values[row] >= low.values[row] &&
+                     a.values[row] <= high.values[row];
+    break;
+  }
+  case Predicate::IN:
+  {
+    const Operand &a= m_operands[pred.args[0]];
+    const longlong *const first= pred.in_values;
+    const longlong *const last= pred.in_values + pred.in_value_count;
+    for (uint row= 0; row < rows; row++)
+      selected[row]= !a.nulls[row] &&
+                     std::binary_search(first, last, a.values[row]);
+    break;
+  }
+  }
+}
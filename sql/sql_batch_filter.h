@@ -0,0 +1,219 @@
+#ifndef SQL_BATCH_FILTER_INCLUDED
+#define SQL_BATCH_FILTER_INCLUDED
+
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/** @file Batched pre-filtering of rows read by a table scan */
+
+#include "my_global.h"
+#include "my_base.h"                            // ha_rows
+#include "sql_alloc.h"                          // Sql_alloc
+#include "mem_root_array.h"                     // Mem_root_array
+#include "item_func.h"                          // Item_func::Functype
+
+class Field;
+class Item;
+class THD;
+struct TABLE;
+struct READ_RECORD;
+
+/**
+  Evaluates the simple parts of a table scan condition for a batch of rows
+  at a time.
+
+  The filter reads up to 'capacity' rows from the table scan into its own
+  buffer, evaluates the supported conjuncts of the condition column by
+  column over the whole batch, and then hands out only the rows that
+  passed, one by one, through the READ_RECORD interface.
+
+  Supported are comparisons (=, <>, <, <=, >, >=), BETWEEN and IN between
+  integer columns of the scanned table, integer constants and the
+  arithmetic operators +, - and * over those. Conjuncts that are anything
+  else are left out, and an OR is only used if all its arguments are
+  supported. The set of rows that pass the filter is thus always a
+  superset of the rows that satisfy the condition, and the caller still
+  evaluates the full condition for each row it gets back.
+
+  Since rows are read ahead of the caller, the filter must not be used
+  when the caller needs the row position of the current row, or when rows
+  are locked or modified while they are read.
+
+  A filter made with create_exact() instead evaluates the whole condition,
+  along with a list of integer expressions, for rows that the caller has
+  read into a buffer of its own. Such a filter does not touch the Item
+  tree after init_scan(), so different threads can evaluate their own
+  filters for the same scan concurrently.
+*/
+
+class Batch_filter : public Sql_alloc
+{
+public:
+  /**
+    Build a filter for the condition of a table scan.
+
+    @param thd       Thread handle, its mem_root is used for all allocations
+    @param table     Table that is scanned
+    @param cond      Condition that is evaluated for every row of the scan
+    @param capacity  Number of rows in each batch
+
+    @return The filter, or NULL if no part of the condition can be
+            evaluated in batches.
+  */
+  static Batch_filter *create(THD *thd, TABLE *table, Item *cond,
+                              uint capacity);
+
+  /**
+    Build a filter that evaluates all of a condition, and the values of
+    some integer expressions, for rows in a buffer of the caller.
+
+    @param thd          Thread handle, its mem_root is used for all
+                        allocations
+    @param table        Table that the rows are read from
+    @param cond         Condition to evaluate, or NULL
+    @param values       Expressions to evaluate
+    @param value_count  Number of expressions in 'values'
+    @param capacity     Maximum number of rows passed to evaluate()
+
+    @return The filter, or NULL if the condition or one of the expressions
+            cannot be evaluated in batches.
+  */
+  static Batch_filter *create_exact(THD *thd, TABLE *table, Item *cond,
+                                    Item **values, uint value_count,
+                                    uint capacity);
+
+  /**
+    Prepare the filter for a new scan of the table. The constants of the
+    condition are evaluated here.
+
+    @param examined_rows  Counter to increment for each row that is
+                          filtered out
+
+    @retval false  The filter can be used for this scan
+    @retval true   The filter cannot be used for this scan, e.g. because a
+                   constant is out of range. The caller reads the rows one
+                   by one instead.
+  */
+  bool init_scan(ha_rows *examined_rows);
+
+  /**
+    Read the next row that passes the filter into info->record.
+
+    @return 0 on success, otherwise the result of rr_sequential() for the
+            first row that could not be read.
+  */
+  int read(READ_RECORD *info);
+
+  /**
+    Evaluate the filter for rows read by the caller.
+
+    @param rows       Records of the table, each TABLE_SHARE::reclength long
+    @param row_count  Number of records, at most the capacity of the filter
+
+    @return 1 for each row that satisfies the condition and 0 for the
+            others, or NULL if there is no condition.
+  */
+  const uchar *evaluate(const uchar *rows, uint row_count);
+
+  /** Values of expression 'i' of create_exact() for the evaluated rows */
+  const longlong *values(uint i) const
+  { return m_operands[m_values[i]].values; }
+  /** Whether expression 'i' of create_exact() is NULL for the rows */
+  const uchar *nulls(uint i) const
+  { return m_operands[m_values[i]].nulls; }
+  /** Values of expression 'i' are within (-2^bits, 2^bits) for the scan */
+  uint value_bits(uint i) const
+  { return m_operands[m_values[i]].bits; }
+
+private:
+  /** A value computed for each row of the batch */
+  struct Operand
+  {
+    enum Type { COLUMN, CONSTANT, PLUS, MINUS, MUL };
+    Type type;
+    /** COLUMN: type, offset of the value and of the NULL bit in the record */
+    enum_field_types field_type;
+    bool is_unsigned;
+    uint offset;
+    uint null_offset;
+    uchar null_bit;
+    /** CONSTANT: the expression and its value for the current scan */
+    Item *item;
+    longlong const_value;
+    bool const_null;
+    /** PLUS, MINUS, MUL: operand numbers of the arguments */
+    uint left, right;
+    /** Values are known to be within (-2^bits, 2^bits) */
+    uint bits;
+    longlong *values;
+    uchar *nulls;
+  };
+
+  /** A boolean computed for each row of the batch */
+  struct Predicate
+  {
+    enum Type { AND, OR, COMPARE, BETWEEN, IN };
+    Type type;
+    /** COMPARE: EQ_FUNC, NE_FUNC, LT_FUNC, LE_FUNC, GT_FUNC or GE_FUNC */
+    Item_func::Functype cmp;
+    /** COMPARE, BETWEEN, IN: operand numbers of the arguments */
+    uint args[3];
+    /** IN: the list items, and their sorted non-NULL values for the scan */
+    Item **in_items;
+    uint in_item_count;
+    longlong *in_values;
+    uint in_value_count;
+    /** AND, OR: predicate numbers of the first and next argument */
+    uint first_child, next_sibling;
+    /** 1 for each row that may satisfy the predicate, 0 otherwise */
+    uchar *selected;
+  };
+
+  static const uint NONE= UINT_MAX;
+
+  Batch_filter(THD *thd, TABLE *table, uint capacity, bool exact);
+
+  uint add_predicate(Item *cond);
+  uint build_predicate(Item *cond);
+  uint add_operand(Item *item);
+  uint add_constant(Item *item);
+  bool alloc_buffers(THD *thd);
+
+  void fill_batch(READ_RECORD *info);
+  void evaluate_operands(const uchar *row_buffer, uint rows);
+  void evaluate_predicate(uint pred_no, uint rows);
+
+  TABLE *const m_table;
+  const uint m_capacity;
+  /** All of the condition must be evaluated, see create_exact() */
+  const bool m_exact;
+  Mem_root_array<Operand, true> m_operands;
+  Mem_root_array<Predicate, true> m_predicates;
+  uint m_root;
+  /** Operand numbers of the expressions given to create_exact() */
+  Mem_root_array<uint, true> m_values;
+
+  /** Rows of the current batch, each of length TABLE_SHARE::reclength */
+  uchar *m_rows;
+  /** Number of rows in the batch, and the next row to hand out */
+  uint m_row_count, m_next_row;
+  /** Number of rows that constant operands are filled in for */
+  uint m_const_rows;
+  /** Result of rr_sequential() that ended the batch, 0 if none */
+  int m_pending_error;
+  ha_rows *m_examined_rows;
+};
+
+#endif /* SQL_BATCH_FILTER_INCLUDED */
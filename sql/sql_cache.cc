@@ -339,6 +339,7 @@ TODO list:
 #include <m_ctype.h>
 #include <my_dir.h>
 #include <hash.h>
+#include "my_atomic.h"
 #include "../storage/myisammrg/ha_myisammrg.h"
 #include "../storage/myisammrg/myrg_def.h"
 #include "probes_mysql.h"
@@ -831,6 +832,45 @@ inline void Query_cache_query::lock_reading()
 }
 
 
+/*
+  Needed for serving queries without structure_guard_mutex. A block that
+  is locked for writing is being stored, moved or freed, and the writer
+  may be waiting for the shard lock that the reader holds.
+*/
+
+my_bool Query_cache_query::try_lock_reading()
+{
+  DBUG_ENTER("Query_cache_block::try_lock_reading");
+  if (mysql_rwlock_tryrdlock(&lock) != 0)
+  {
+    DBUG_PRINT("info", ("can't lock rwlock"));
+    DBUG_RETURN(0);
+  }
+  DBUG_PRINT("info", ("rwlock 0x%lx locked", (ulong) &lock));
+  DBUG_RETURN(1);
+}
+
+
+/*
+  Hits don't move the query to the end of the query list, as that needs
+  structure_guard_mutex. They only mark the query, and free_old_query()
+  moves marked queries to the end of the list when it gets to them.
+*/
+
+inline void Query_cache_query::mark_hit()
+{
+  // Don't dirty the cache line of a hot query on every hit
+  if (my_atomic_load32(&hit) == 0)
+    my_atomic_store32(&hit, 1);
+}
+
+
+inline my_bool Query_cache_query::clear_hit()
+{
+  return my_atomic_fas32(&hit, 0) != 0;
+}
+
+
 inline void Query_cache_query::unlock_writing()
 {
   RW_UNLOCK(&lock);
@@ -846,7 +886,7 @@ inline void Query_cache_query::unlock_reading()
 void Query_cache_query::init_n_lock()
 {
   DBUG_ENTER("Query_cache_query::init_n_lock");
-  res=0; wri = 0; len = 0;
+  res=0; wri = 0; len = 0; hit= 0;
   mysql_rwlock_init(key_rwlock_query_cache_query_lock, &lock);
   lock_writing();
   DBUG_PRINT("qcache", ("inited & locked query for block 0x%lx",
@@ -1173,8 +1213,8 @@ Query_cache::Query_cache(ulong query_cache_limit_arg,
 			 uint def_table_hash_size_arg)
   :query_cache_size(0),
    query_cache_limit(query_cache_limit_arg),
-   queries_in_cache(0), hits(0), inserts(0), refused(0),
-   total_blocks(0), lowmem_prunes(0), m_query_cache_is_disabled(FALSE),
+   queries_in_cache(0), inserts(0), refused(0),
+   total_blocks(0), lowmem_prunes(0), hits(0), m_query_cache_is_disabled(FALSE),
    min_allocation_unit(ALIGN_SIZE(min_allocation_unit_arg)),
    min_result_data_size(ALIGN_SIZE(min_result_data_size_arg)),
    def_query_hash_size(ALIGN_SIZE(def_query_hash_size_arg)),
@@ -1200,6 +1240,16 @@ ulong Query_cache::resize(ulong query_cache_size_arg)
 
   lock_and_suspend();
 
+  /*
+    Hits look up queries without structure_guard_mutex, so take all
+    queries out of the query hash first, as flush_cache() does. After
+    that no hit can find a block whose lock is destroyed below.
+  */
+  lock_all_query_shards();
+  for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
+    my_hash_reset(&queries[i]);
+  unlock_all_query_shards();
+
   /*
     Wait for all readers and writers to exit. When the list of all queries
     is iterated over with a block level lock, we are done.
@@ -1398,8 +1448,7 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
     }
 
     /* Check if another thread is processing the same query? */
-    Query_cache_block *competitor = (Query_cache_block *)
-      my_hash_search(&queries, (uchar*) cache_key, tot_length);
+    Query_cache_block *competitor= find_query((uchar*) cache_key, tot_length);
     DBUG_PRINT("qcache", ("competitor 0x%lx", (ulong) competitor));
     if (competitor == 0)
     {
@@ -1415,7 +1464,7 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 
 	Query_cache_query *header = query_block->query();
 	header->init_n_lock();
-	if (my_hash_insert(&queries, (uchar*) query_block))
+	if (insert_query(query_block))
 	{
 	  refused++;
 	  DBUG_PRINT("qcache", ("insertion in query hash"));
@@ -1428,7 +1477,7 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 	{
 	  refused++;
 	  DBUG_PRINT("warning", ("tables list including failed"));
-	  my_hash_delete(&queries, (uchar *) query_block);
+	  delete_query(query_block);
 	  header->unlock_n_destroy();
 	  free_memory_block(query_block);
 
@@ -1539,6 +1588,20 @@ send_data_in_chunks(NET *net, const uchar *packet, ulong len)
   tot_length= query_length + thd->db_length + 1 + QUERY_CACHE_FLAGS_SIZE;
 */
 
+/**
+  Copy of what send_result_to_client() needs of a table of a cached query.
+*/
+
+struct Query_cache_table_ref
+{
+  char *key;                                    // db + '\0' + table + '\0'
+  const char *table_name;
+  uint32 key_length;
+  qc_engine_callback callback;
+  ulonglong engine_data;
+};
+
+
 int Query_cache::send_result_to_client(THD *thd, const LEX_CSTRING &sql)
 {
   ulonglong engine_data;
@@ -1547,7 +1610,10 @@ int Query_cache::send_result_to_client(THD *thd, const LEX_CSTRING &sql)
   Query_cache_block *first_result_block;
 #endif
   Query_cache_block *result_block;
-  Query_cache_block_table *block_table, *block_table_end;
+  Query_cache_block *query_block;
+  Query_cache_table_ref *tables;
+  TABLE_COUNTER_TYPE n_tables;
+  uint shard;
   char *cache_key= NULL;
   size_t tot_length;
   Query_cache_query_flags flags;
@@ -1630,21 +1696,6 @@ int Query_cache::send_result_to_client(THD *thd, const LEX_CSTRING &sql)
       goto err;
     }
   }
-  /*
-    Try to obtain an exclusive lock on the query cache. If the cache is
-    disabled or if a full cache flush is in progress, the attempt to
-    get the lock is aborted.
-
-    The 'TRUE' parameter indicate that the lock is allowed to timeout
-  */
-  if (try_lock(TRUE))
-    goto err;
-
-  if (query_cache_size == 0)
-    goto err_unlock;
-
-  Query_cache_block *query_block;
-
   THD_STAGE_INFO(thd, stage_checking_query_cache_for_query);
 
   // fill all gaps between fields with 0 to get repeatable key
@@ -1698,21 +1749,72 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 
   cache_key= make_cache_key(thd, thd->query(), &flags, &tot_length);
   if (cache_key == NULL)
-    goto err_unlock;
+    goto err;
 
-  query_block = (Query_cache_block *)  my_hash_search(&queries,
+  /*
+    The query is looked up without structure_guard_mutex, which would
+    serialize all hits on the cache. Only the shard of the query hash is
+    locked, for reading, until the query block is locked for reading and
+    the tables of the query are copied. After that the block and its
+    results cannot be changed, moved or freed until it is unlocked.
+  */
+  shard= query_shard((uchar*) cache_key, tot_length);
+  mysql_rwlock_rdlock(&queries_lock[shard]);
+  query_block= NULL;
+  if (my_hash_inited(&queries[shard]))
+    query_block= (Query_cache_block *) my_hash_search(&queries[shard],
                                                       (uchar*) cache_key,
                                                       tot_length);
-  /* Quick abort on unlocked data */
-  if (query_block == 0 ||
-      query_block->query()->result() == 0 ||
-      query_block->query()->result()->type != Query_cache_block::RESULT)
+  if (query_block == 0 || !query_block->query()->try_lock_reading())
   {
-    DBUG_PRINT("qcache", ("No query in query hash or no results"));
-    goto err_unlock;
+    mysql_rwlock_unlock(&queries_lock[shard]);
+    DBUG_PRINT("qcache", ("No query in query hash or query is locked"));
+    goto err;
   }
   DBUG_PRINT("qcache", ("Query in query hash 0x%lx", (ulong)query_block));
 
+  query = query_block->query();
+  result_block= query->result();
+#ifndef EMBEDDED_LIBRARY
+  first_result_block= result_block;
+#endif
+
+  if (result_block == 0 || result_block->type != Query_cache_block::RESULT)
+  {
+    /* The query is probably yet processed */
+    DBUG_PRINT("qcache", ("query found, but no data or data incomplete"));
+    BLOCK_UNLOCK_RD(query_block);
+    mysql_rwlock_unlock(&queries_lock[shard]);
+    goto err;
+  }
+
+  /*
+    The table blocks may be moved by pack_cache() once the shard is
+    unlocked, even if the query block is locked.
+  */
+  n_tables= query_block->n_tables;
+  tables= static_cast<Query_cache_table_ref*>(
+    thd->alloc(n_tables * sizeof(Query_cache_table_ref)));
+  for (TABLE_COUNTER_TYPE i= 0; tables != NULL && i < n_tables; i++)
+  {
+    Query_cache_table *table= query_block->table(i)->parent;
+    tables[i].key_length= table->key_length();
+    tables[i].callback= table->callback();
+    tables[i].engine_data= table->engine_data();
+    if (!(tables[i].key= static_cast<char*>(thd->memdup(table->db(),
+                                                        table->key_length()))))
+      tables= NULL;
+    else
+      tables[i].table_name= tables[i].key + (table->table() - table->db());
+  }
+  mysql_rwlock_unlock(&queries_lock[shard]);
+  if (tables == NULL)
+  {
+    BLOCK_UNLOCK_RD(query_block);
+    goto err;
+  }
+  DBUG_PRINT("qcache", ("Query have result 0x%lx", (ulong) query));
+
   /*
     We only need to clear the diagnostics area when we actually
     find the query, as in all other cases, we'll go through
@@ -1736,42 +1838,22 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
   thd->get_stmt_da()->reset_diagnostics_area();
   thd->get_stmt_da()->reset_condition_info(thd);
 
-  /* Now lock and test that nothing changed while blocks was unlocked */
-  BLOCK_LOCK_RD(query_block);
-
-  query = query_block->query();
-  result_block= query->result();
-#ifndef EMBEDDED_LIBRARY
-  first_result_block= result_block;
-#endif
-
-  if (result_block == 0 || result_block->type != Query_cache_block::RESULT)
-  {
-    /* The query is probably yet processed */
-    DBUG_PRINT("qcache", ("query found, but no data or data incomplete"));
-    BLOCK_UNLOCK_RD(query_block);
-    goto err_unlock;
-  }
-  DBUG_PRINT("qcache", ("Query have result 0x%lx", (ulong) query));
-
   if (thd->in_multi_stmt_transaction_mode() &&
       (query->tables_type() & HA_CACHE_TBL_TRANSACT))
   {
     DBUG_PRINT("qcache",
 	       ("we are in transaction and have transaction tables in query"));
     BLOCK_UNLOCK_RD(query_block);
-    goto err_unlock;
+    goto err;
   }
       
   // Check access;
   THD_STAGE_INFO(thd, stage_checking_privileges_on_cached_query);
-  block_table= query_block->table(0);
-  block_table_end= block_table+query_block->n_tables;
-  for (; block_table != block_table_end; block_table++)
+  for (TABLE_COUNTER_TYPE i= 0; i < n_tables; i++)
   {
     TABLE_LIST table_list;
     TABLE *tmptable;
-    Query_cache_table *table = block_table->parent;
+    Query_cache_table_ref *table= &tables[i];
 
     /*
       Check that we have not temporary tables with same names of tables
@@ -1782,14 +1864,13 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
     for (tmptable= thd->temporary_tables; tmptable ; tmptable= tmptable->next)
     {
       if (tmptable->s->table_cache_key.length - TMP_TABLE_KEY_EXTRA == 
-          table->key_length() &&
-          !memcmp(tmptable->s->table_cache_key.str, table->data(),
-                  table->key_length()))
+          table->key_length &&
+          !memcmp(tmptable->s->table_cache_key.str, table->key,
+                  table->key_length))
       {
         DBUG_PRINT("qcache",
                    ("Temporary table detected: '%s.%s'",
                     tmptable->s->db.str, tmptable->s->table_name.str));
-        unlock();
         /*
           We should not store result of this query because it contain
           temporary tables => assign following variable to make check
@@ -1802,15 +1883,14 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
     }
 
     memset(&table_list, 0, sizeof(table_list));
-    table_list.db = table->db();
-    table_list.alias= table_list.table_name= table->table();
+    table_list.db = table->key;
+    table_list.alias= table_list.table_name= table->table_name;
 #ifndef NO_EMBEDDED_ACCESS_CHECKS
     if (check_table_access(thd,SELECT_ACL,&table_list, FALSE, 1,TRUE))
     {
       DBUG_PRINT("qcache",
 		 ("probably no SELECT access to %s.%s =>  return to normal processing",
 		  table_list.db, table_list.alias));
-      unlock();
       thd->lex->safe_to_cache_query=0;		// Don't try to cache this
       BLOCK_UNLOCK_RD(query_block);
       DBUG_RETURN(-1);				// Privilege error
@@ -1823,36 +1903,43 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 			    table_list.db, table_list.alias));
       BLOCK_UNLOCK_RD(query_block);
       thd->lex->safe_to_cache_query= 0;		// Don't try to cache this
-      goto err_unlock;				// Parse query
+      goto err;					// Parse query
     }
 #endif /*!NO_EMBEDDED_ACCESS_CHECKS*/
-    engine_data= table->engine_data();
-    if (table->callback()) 
+    engine_data= table->engine_data;
+    if (table->callback)
     {
       char qcache_se_key_name[FN_REFLEN + 1];
       size_t qcache_se_key_len;
-      engine_data= table->engine_data();
 
       qcache_se_key_len= build_table_filename(qcache_se_key_name,
                                               sizeof(qcache_se_key_name),
-                                              table->db(), table->table(),
+                                              table->key, table->table_name,
                                               "", 0);
    
-      if (!(*table->callback())(thd, qcache_se_key_name,
-                                static_cast<uint>(qcache_se_key_len),
-                                &engine_data))
+      if (!(*table->callback)(thd, qcache_se_key_name,
+                              static_cast<uint>(qcache_se_key_len),
+                              &engine_data))
       {
         DBUG_PRINT("qcache", ("Handler does not allow caching for %s.%s",
                                table_list.db, table_list.alias));
         BLOCK_UNLOCK_RD(query_block);
-        if (engine_data != table->engine_data())
+        if (engine_data != table->engine_data)
         {
           DBUG_PRINT("qcache",
                      ("Handler require invalidation queries of %s.%s %lu-%lu",
                       table_list.db, table_list.alias,
-                      (ulong) engine_data, (ulong) table->engine_data()));
-          invalidate_table_internal(thd, (uchar *) table->db(),
-                                    table->key_length());
+                      (ulong) engine_data, (ulong) table->engine_data));
+          /*
+            If the cache is busy, the queries are invalidated by a later
+            lookup, as the handler refuses them until then.
+          */
+          if (!try_lock(TRUE))
+          {
+            invalidate_table_internal(thd, (uchar *) table->key,
+                                      table->key_length);
+            unlock();
+          }
         }
         else
           thd->lex->safe_to_cache_query= 0;       // Don't try to cache this
@@ -1863,16 +1950,15 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
         */
         DBUG_ASSERT(! thd->transaction_rollback_request);
         trans_rollback_stmt(thd);
-        goto err_unlock;				// Parse query
+        goto err;				// Parse query
      }
    }
     else
       DBUG_PRINT("qcache", ("handler allow caching %s,%s",
 			    table_list.db, table_list.alias));
   }
-  move_to_query_list_end(query_block);
-  hits++;
-  unlock();
+  query->mark_hit();
+  my_atomic_add64(&hits, 1);
 
   /*
     Send cached result to client
@@ -1934,8 +2020,6 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
                         (ulong) thd->current_found_rows);
   DBUG_RETURN(1);				// Result sent to client
 
-err_unlock:
-  unlock();
 err:
   MYSQL_QUERY_CACHE_MISS(const_cast<char*>(thd->query().str));
   DBUG_RETURN(0);				// Query was not cached
@@ -2263,6 +2347,8 @@ void Query_cache::destroy()
 
     mysql_cond_destroy(&COND_cache_status_changed);
     mysql_mutex_destroy(&structure_guard_mutex);
+    for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
+      mysql_rwlock_destroy(&queries_lock[i]);
     initialized = 0;
   }
   DBUG_VOID_RETURN;
@@ -2280,6 +2366,8 @@ void Query_cache::init()
                    &structure_guard_mutex, MY_MUTEX_INIT_FAST);
   mysql_cond_init(key_COND_cache_status_changed,
                   &COND_cache_status_changed);
+  for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
+    mysql_rwlock_init(key_rwlock_query_cache_queries_lock, &queries_lock[i]);
   m_cache_lock_status= Query_cache::UNLOCKED;
   initialized = 1;
   /*
@@ -2430,9 +2518,13 @@ ulong Query_cache::init_cache()
 
   DUMP(this);
 
-  (void) my_hash_init(&queries, &my_charset_bin, def_query_hash_size, 0, 0,
-                      query_cache_query_get_key, 0, 0,
-                      key_memory_Query_cache);
+  lock_all_query_shards();
+  for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
+    (void) my_hash_init(&queries[i], &my_charset_bin,
+                        def_query_hash_size / QUERY_CACHE_QUERY_HASH_SHARDS,
+                        0, 0, query_cache_query_get_key, 0, 0,
+                        key_memory_Query_cache);
+  unlock_all_query_shards();
 #ifndef FN_NO_CASE_SENSE
   /*
     If lower_case_table_names!=0 then db and table names are already 
@@ -2507,9 +2599,12 @@ void Query_cache::free_cache()
 {
   DBUG_ENTER("Query_cache::free_cache");
 
+  lock_all_query_shards();
+  for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
+    my_hash_free(&queries[i]);
+  unlock_all_query_shards();
   my_free(cache);
   make_disabled();
-  my_hash_free(&queries);
   my_hash_free(&tables);
   DBUG_VOID_RETURN;
 }
@@ -2536,7 +2631,10 @@ void Query_cache::flush_cache()
 {
   QC_DEBUG_SYNC("wait_in_query_cache_flush2");
 
-  my_hash_reset(&queries);
+  lock_all_query_shards();
+  for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
+    my_hash_reset(&queries[i]);
+  unlock_all_query_shards();
   while (queries_blocks != 0)
   {
     BLOCK_LOCK_WR(queries_blocks);
@@ -2560,6 +2658,13 @@ my_bool Query_cache::free_old_query()
       Also we don't need remove locked queries at this point.
     */
     Query_cache_block *query_block= 0;
+    /*
+      Give the queries that were hit since they were last at the head of
+      the list a second chance, so that the list stays close to LRU order.
+    */
+    for (ulong i= 0;
+         i < queries_in_cache && queries_blocks->query()->clear_hit(); i++)
+      move_to_query_list_end(queries_blocks);
     if (queries_blocks != 0)
     {
       Query_cache_block *block = queries_blocks;
@@ -2683,12 +2788,89 @@ void Query_cache::free_query(Query_cache_block *query_block)
 		      (ulong) query_block,
 		      query_block->query()->length() ));
 
-  my_hash_delete(&queries,(uchar *) query_block);
+  delete_query(query_block);
   free_query_internal(query_block);
 
   DBUG_VOID_RETURN;
 }
 
+
+/*
+  Shards of the query hash.
+
+  The shard is taken from the high bits of the key hash, as the low bits
+  select the bucket within the shard.
+*/
+
+uint Query_cache::query_shard(const uchar *key, size_t length)
+{
+  ulong nr1= 1, nr2= 4;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, key, length, &nr1, &nr2);
+  return ((static_cast<uint32>(nr1) * 0x9E3779B1U) >> 16) %
+    QUERY_CACHE_QUERY_HASH_SHARDS;
+}
+
+
+uint Query_cache::query_shard(Query_cache_block *query_block)
+{
+  size_t length;
+  uchar *key= query_cache_query_get_key((uchar*) query_block, &length, 0);
+  return query_shard(key, length);
+}
+
+
+void Query_cache::lock_all_query_shards()
+{
+  for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
+    mysql_rwlock_wrlock(&queries_lock[i]);
+}
+
+
+void Query_cache::unlock_all_query_shards()
+{
+  for (uint i= QUERY_CACHE_QUERY_HASH_SHARDS; i-- > 0; )
+    mysql_rwlock_unlock(&queries_lock[i]);
+}
+
+
+/*
+  Add a query to the query hash. Requires structure_guard_mutex.
+*/
+
+my_bool Query_cache::insert_query(Query_cache_block *query_block)
+{
+  const uint shard= query_shard(query_block);
+  mysql_rwlock_wrlock(&queries_lock[shard]);
+  my_bool error= my_hash_insert(&queries[shard], (uchar*) query_block);
+  mysql_rwlock_unlock(&queries_lock[shard]);
+  return error;
+}
+
+
+/*
+  Remove a query from the query hash. Requires structure_guard_mutex.
+*/
+
+void Query_cache::delete_query(Query_cache_block *query_block)
+{
+  const uint shard= query_shard(query_block);
+  mysql_rwlock_wrlock(&queries_lock[shard]);
+  my_hash_delete(&queries[shard], (uchar*) query_block);
+  mysql_rwlock_unlock(&queries_lock[shard]);
+}
+
+
+/*
+  Find a query in the query hash. Requires structure_guard_mutex, which
+  is held by all threads that change the hash.
+*/
+
+Query_cache_block *Query_cache::find_query(const uchar *key, size_t length)
+{
+  HASH *const hash= &queries[query_shard(key, length)];
+  return (Query_cache_block *) my_hash_search(hash, key, length);
+}
+
 /*****************************************************************************
  Query data creation
 *****************************************************************************/
@@ -3960,12 +4142,18 @@ void Query_cache::pack_cache()
 
   if (first_block)
   {
+    /*
+      Keep send_result_to_client() out while the blocks are moved, as it
+      reads the table blocks of a query under the lock of its shard only.
+    */
+    lock_all_query_shards();
     do
     {
       Query_cache_block *next=block->pnext;
       ok = move_by_type(&border, &before, &gap, block);
       block = next;
     } while (ok && block != first_block);
+    unlock_all_query_shards();
 
     if (border != 0)
     {
@@ -4092,7 +4280,8 @@ my_bool Query_cache::move_by_type(uchar **border,
     uchar *key;
     size_t key_length;
     key=query_cache_query_get_key((uchar*) block, &key_length, 0);
-    my_hash_first(&queries, key, key_length, &record_idx);
+    HASH *const hash= &queries[query_shard(key, key_length)];
+    my_hash_first(hash, key, key_length, &record_idx);
     // Move table of used tables 
     memmove((char*) new_block->table(0), (char*) block->table(0),
 	   ALIGN_SIZE(n_tables*sizeof(Query_cache_block_table)));
@@ -4160,7 +4349,7 @@ my_bool Query_cache::move_by_type(uchar **border,
       query_cache_tls->first_query_block= new_block;
     }
     /* Fix hash to point at moved block */
-    my_hash_replace(&queries, &record_idx, (uchar*) new_block);
+    my_hash_replace(hash, &record_idx, (uchar*) new_block);
     DBUG_PRINT("qcache", ("moved %lu bytes to 0x%lx, new gap at 0x%lx",
 			len, (ulong) new_block, (ulong) *border));
     break;
@@ -4578,10 +4767,13 @@ bool Query_cache::check_integrity(enum_qcci_lock_mode locking)
   if ((locking == LOCK_WHILE_CHECKING) && (try_lock()))
     DBUG_RETURN(false);
 
-  if (my_hash_check(&queries))
+  for (uint i= 0; i < QUERY_CACHE_QUERY_HASH_SHARDS; i++)
   {
-    DBUG_PRINT("error", ("queries hash is damaged"));
-    result= true;
+    if (my_hash_check(&queries[i]))
+    {
+      DBUG_PRINT("error", ("queries hash is damaged"));
+      result= true;
+    }
   }
 
   if (my_hash_check(&tables))
@@ -4751,7 +4943,7 @@ bool Query_cache::check_integrity(enum_qcci_lock_mode locking)
 			    (ulong) block, (uint) block->type));
       size_t length;
       uchar *key = query_cache_query_get_key((uchar*) block, &length, 0);
-      uchar* val = my_hash_search(&queries, key, length);
+      uchar* val = (uchar*) find_query(key, length);
       if (((uchar*)block) != val)
       {
 	DBUG_PRINT("error", ("block 0x%lx found in queries hash like 0x%lx",
@@ -42,6 +42,9 @@ typedef ulonglong sql_mode_t;
 #define QUERY_CACHE_DEF_QUERY_HASH_SIZE		1024
 #define QUERY_CACHE_DEF_TABLE_HASH_SIZE		1024
 
+/* number of shards of the query hash, must be a power of 2 */
+#define QUERY_CACHE_QUERY_HASH_SHARDS		32
+
 /* minimal result data size when data allocated */
 #define QUERY_CACHE_MIN_RESULT_DATA_SIZE	1024*4
 
@@ -160,6 +163,8 @@ struct Query_cache_query
   ulong len;
   uint8 tbls_type;
   unsigned int last_pkt_nr;
+  /* set when the query is hit, see Query_cache::free_old_query() */
+  volatile int32 hit;
 
   Query_cache_query() {}                      /* Remove gcc warning */
   inline void init_n_lock();
@@ -182,6 +187,9 @@ struct Query_cache_query
   void lock_writing();
   void lock_reading();
   my_bool try_lock_writing();
+  my_bool try_lock_reading();
+  void mark_hit();
+  my_bool clear_hit();
   void unlock_writing();
   void unlock_reading();
 };
@@ -286,8 +294,10 @@ public:
   /* Info */
   ulong query_cache_size, query_cache_limit;
   /* statistics */
-  ulong free_memory, queries_in_cache, hits, inserts, refused,
+  ulong free_memory, queries_in_cache, inserts, refused,
     free_memory_blocks, total_blocks, lowmem_prunes;
+  /* updated without structure_guard_mutex, see send_result_to_client() */
+  volatile int64 hits;
 
 
 private:
@@ -312,6 +322,13 @@ protected:
     LOCK SEQUENCE (to prevent deadlocks):
       1. structure_guard_mutex
       2. query block (for operation inside query (query block/results))
+      3. queries_lock of the shard of the query
+
+    send_result_to_client() does not lock structure_guard_mutex. It
+    locks the shard of the query in queries_lock for reading, and only
+    tries to lock the query block, so it does not take part in the lock
+    sequence. pack_cache() locks all shards before the query blocks, as
+    it moves table blocks that are read under a shard lock.
 
     Thread doing cache flush releases the mutex once it sets
     m_cache_status flag, so other threads may bypass the cache as
@@ -327,7 +344,13 @@ protected:
 
   Query_cache_memory_bin *bins;			// free block lists
   Query_cache_memory_bin_step *steps;		// bins spacing info
-  HASH queries, tables;
+  /*
+    Hash of the queries, split into shards by the query key. A shard is
+    changed with both structure_guard_mutex and its queries_lock locked
+    for writing, so either lock is enough to search it.
+  */
+  HASH queries[QUERY_CACHE_QUERY_HASH_SHARDS], tables;
+  mysql_rwlock_t queries_lock[QUERY_CACHE_QUERY_HASH_SHARDS];
   /* options */
   ulong min_allocation_unit, min_result_data_size;
   uint def_query_hash_size, def_table_hash_size;
@@ -349,10 +372,19 @@ protected:
   static size_t filename_2_table_key (char *key, const char *filename,
                                       size_t *db_length);
 
+  /* Query hash shards */
+  static uint query_shard(const uchar *key, size_t length);
+  static uint query_shard(Query_cache_block *query_block);
+  void lock_all_query_shards();
+  void unlock_all_query_shards();
+
   /* The following functions require that structure_guard_mutex is locked */
   void flush_cache();
   my_bool free_old_query();
   void free_query(Query_cache_block *point);
+  my_bool insert_query(Query_cache_block *query_block);
+  void delete_query(Query_cache_block *query_block);
+  Query_cache_block *find_query(const uchar *key, size_t length);
   my_bool allocate_data_chain(Query_cache_block **result_block,
 			      ulong data_len,
 			      Query_cache_block *query_block,
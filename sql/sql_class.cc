@@ -43,6 +43,7 @@
 #include "sql_parse.h"                       // is_update_query
 #include "sql_plugin.h"                      // plugin_unlock
 #include "sql_prepare.h"                     // Prepared_statement
+#include "sql_stmt_template.h"               // stmt_template_cache_free
 #include "sql_time.h"                        // my_timeval_trunc
 #include "sql_timer.h"                       // thd_timer_destroy
 #include "sql_thd_internal_api.h"
@@ -1215,6 +1216,7 @@ THD::THD(bool enable_plugins)
 
   sp_proc_cache= NULL;
   sp_func_cache= NULL;
+  stmt_template_cache= NULL;
 
   /* Protocol */
   m_protocol= &protocol_text;			// Default protocol
@@ -1651,6 +1653,7 @@ void THD::cleanup_connection(void)
   cleanup_done= 0;
   init();
   stmt_map.reset();
+  stmt_template_cache_free(this);
   my_hash_init(&user_vars, system_charset_info, USER_VARS_HASH_SIZE, 0, 0,
                (my_hash_get_key) get_var_key,
                (my_hash_free_key) free_user_var, 0,
@@ -1818,6 +1821,7 @@ void THD::release_resources()
   mysql_mutex_unlock(&LOCK_thd_query);
 
   stmt_map.reset();                     /* close all prepared statements */
+  stmt_template_cache_free(this);
   if (!cleanup_done)
     cleanup();
 
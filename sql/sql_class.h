@@ -53,6 +53,7 @@
 
 class Reprepare_observer;
 class sp_cache;
+class Stmt_template_cache;
 class Rows_log_event;
 struct st_thd_timer;
 typedef struct st_log_info LOG_INFO;
@@ -442,6 +443,9 @@ typedef struct system_variables
   ulong auto_increment_increment, auto_increment_offset;
   ulong bulk_insert_buff_size;
   uint  eq_range_index_dive_limit;
+  uint  range_estimate_cache_size;
+  uint  scan_filter_batch_size;
+  uint  parallel_query_degree;
   ulong join_buff_size;
   ulong lock_wait_timeout;
   ulong max_allowed_packet;
@@ -464,6 +468,10 @@ typedef struct system_variables
   ulong net_write_timeout;
   ulong optimizer_prune_level;
   ulong optimizer_search_depth;
+  uint optimizer_dp_max_plans;
+  my_bool prepared_statement_plan_cache;
+  uint statement_template_cache_size;
+  ulonglong histogram_generation_max_mem_size;
   ulonglong parser_max_mem_size;
   ulong range_optimizer_max_mem_size;
   ulong preload_buff_size;
@@ -472,6 +480,7 @@ typedef struct system_variables
   ulong read_rnd_buff_size;
   ulong div_precincrement;
   ulong sortbuff_size;
+  uint  sort_threads;
   ulong max_sp_recursion_depth;
   ulong default_week_format;
   ulong max_seeks_for_key;
@@ -626,6 +635,10 @@ typedef struct system_status_var
   ulonglong com_stmt_fetch;
   ulonglong com_stmt_reset;
   ulonglong com_stmt_close;
+  /* Statement templates, see sql_stmt_template.h. */
+  ulonglong stmt_template_cache_hits;
+  ulonglong stmt_template_cache_misses;
+  ulonglong stmt_template_cache_invalidations;
 
   ulonglong bytes_received;
   ulonglong bytes_sent;
@@ -1698,6 +1711,8 @@ public:
 
   /** All prepared statements of this connection. */
   Prepared_statement_map stmt_map;
+  /** Statement templates of this connection, see sql_stmt_template.h. */
+  Stmt_template_cache *stmt_template_cache;
   /*
     A pointer to the stack frame of handle_one_connection(),
     which is called first in the thread for handling a client
@@ -301,7 +301,20 @@
 #define OPTIMIZER_SWITCH_USE_INDEX_EXTENSIONS      (1ULL << 16)
 #define OPTIMIZER_SWITCH_COND_FANOUT_FILTER        (1ULL << 17)
 #define OPTIMIZER_SWITCH_DERIVED_MERGE             (1ULL << 18)
-#define OPTIMIZER_SWITCH_LAST                      (1ULL << 19)
+/**
+   If this is on together with OPTIMIZER_SWITCH_BNL, a join buffer over
+   tables joined by equalities is probed through a hash table on the
+   equated columns instead of being scanned for every row.
+*/
+#define OPTIMIZER_SWITCH_HASH_JOIN                 (1ULL << 19)
+/**
+   If this is on, constant arguments of comparisons are evaluated once
+   before the optimization, and comparisons of an integer column plus or
+   minus a constant with a constant are rewritten to comparisons of the
+   column, see fold_cond_constants().
+*/
+#define OPTIMIZER_SWITCH_CONSTANT_FOLDING          (1ULL << 20)
+#define OPTIMIZER_SWITCH_LAST                      (1ULL << 21)
 
 #define OPTIMIZER_SWITCH_DEFAULT (OPTIMIZER_SWITCH_INDEX_MERGE | \
                                   OPTIMIZER_SWITCH_INDEX_MERGE_UNION | \
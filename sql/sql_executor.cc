@@ -32,8 +32,11 @@
 #include "log.h"              // sql_print_error
 #include "opt_trace.h"        // Opt_trace_object
 #include "sql_base.h"         // fill_record
+#include "sql_batch_filter.h" // Batch_filter
+#include "sql_group_hash.h"   // Group_hash
 #include "sql_join_buffer.h"  // st_cache_field
 #include "sql_optimizer.h"    // JOIN
+#include "sql_parallel_scan.h" // parallel_group_scan
 #include "sql_show.h"         // get_schema_tables_result
 #include "sql_tmp_table.h"    // create_tmp_table
 #include "json_dom.h"    // Json_wrapper
@@ -941,7 +944,8 @@ do_select(JOIN *join)
   {
     QEP_TAB *qep_tab= join->qep_tab + join->const_tables;
     DBUG_ASSERT(join->primary_tables);
-    error= join->first_select(join,qep_tab,0);
+    if (!parallel_group_scan(join, &error))
+      error= join->first_select(join,qep_tab,0);
     if (error >= NESTED_LOOP_OK)
       error= join->first_select(join,qep_tab,1);
   }
@@ -2437,6 +2441,46 @@ int read_first_record_seq(QEP_TAB *tab)
 }
 
 
+/**
+  Set up a table scan to read its rows through a Batch_filter, if the
+  scan and its condition allow it.
+
+  The filter reads rows ahead of the scan position, so it is only used
+  for plain SELECT scans that take no locks on the rows and do not need
+  the row position of the current row.
+
+  @param tab  Table that is scanned with rr_sequential()
+*/
+
+static void setup_batch_filter(QEP_TAB *tab)
+{
+  THD *const thd= tab->join()->thd;
+  const uint batch_size= thd->variables.scan_filter_batch_size;
+  if (batch_size == 0)
+    return;
+
+  if (!tab->batch_filter_checked)
+  {
+    TABLE *const table= tab->table();
+    tab->batch_filter_checked= true;
+    if (tab->condition() != NULL &&
+        thd->lex->sql_command == SQLCOM_SELECT &&
+        (table->reginfo.lock_type == TL_READ ||
+         table->reginfo.lock_type == TL_READ_HIGH_PRIORITY) &&
+        table->s->blob_fields == 0 &&
+        !tab->keep_current_rowid && tab->copy_current_rowid == NULL)
+      tab->batch_filter= Batch_filter::create(thd, table, tab->condition(),
+                                              batch_size);
+  }
+
+  if (tab->batch_filter == NULL ||
+      tab->batch_filter->init_scan(&tab->join()->examined_rows))
+    return;
+  tab->read_record.batch_filter= tab->batch_filter;
+  tab->read_record.read_record= rr_batch_filter;
+}
+
+
 /**
   @brief Prepare table for reading rows and read first record.
   @details
@@ -2474,6 +2518,8 @@ int join_init_read_record(QEP_TAB *tab)
   if (init_read_record(&tab->read_record, tab->join()->thd, NULL, tab,
                        1, 1, FALSE))
     return 1;
+  if (tab->read_record.read_record == rr_sequential)
+    setup_batch_filter(tab);
 
   return (*tab->read_record.read_record)(&tab->read_record);
 }
@@ -3390,6 +3436,120 @@ end:
 }
 
 
+/**
+  Store the GROUP BY key of the current row in the key buffer of a
+  grouping tmp table that has no hash_field.
+*/
+
+void store_group_key(TABLE *table)
+{
+  for (ORDER *group= table->group ; group ; group= group->next)
+  {
+    Item *item= *group->item;
+    item->save_org_in_field(group->field);
+    /* Store in the used key if the field was 0 */
+    if (item->maybe_null)
+      group->buff[-1]= (char) group->field->is_null();
+  }
+}
+
+
+/**
+  Complete the record of a new group in a grouping tmp table without
+  hash_field, after store_group_key() and copy_fields(). The aggregate
+  functions are left to the caller.
+
+  @return false if ok, true on error
+*/
+
+bool init_new_group_record(JOIN *join, QEP_TAB *const qep_tab)
+{
+  TABLE *const table= qep_tab->table();
+  ORDER *group;
+  KEY_PART_INFO *key_part;
+
+  /*
+    Copy null bits from group key to table
+    We can't copy all data as the key may have different format
+    as the row data (for example as with VARCHAR keys)
+  */
+  for (group= table->group, key_part= table->key_info[0].key_part;
+       group;
+       group= group->next, key_part++)
+  {
+    if (key_part->null_bit)
+      memcpy(table->record[0] + key_part->offset, group->buff, 1);
+  }
+  /* See comment on copy_funcs in end_update(). */
+  return copy_funcs(qep_tab->tmp_table_param->items_to_copy, join->thd);
+}
+
+
+/**
+  Write the record of a new group into a grouping tmp table, converting
+  the table to an on-disk table if it is full.
+*/
+
+enum_nested_loop_state write_new_group_record(JOIN *join,
+                                              QEP_TAB *const qep_tab)
+{
+  TABLE *const table= qep_tab->table();
+  Temp_table_param *const tmp_tbl= qep_tab->tmp_table_param;
+  int error;
+
+  if ((error=table->file->ha_write_row(table->record[0])))
+  {
+    if (create_ondisk_from_heap(join->thd, table,
+                                tmp_tbl->start_recinfo,
+                                &tmp_tbl->recinfo,
+				error, FALSE, NULL))
+      return NESTED_LOOP_ERROR;            // Not a table_is_full error
+    /* Change method to update rows */
+    if ((error= table->file->ha_index_init(0, 0)))
+    {
+      table->file->print_error(error, MYF(0));
+      return NESTED_LOOP_ERROR;
+    }
+  }
+  qep_tab->send_records++;
+  return NESTED_LOOP_OK;
+}
+
+
+/**
+  Group a row when the groups are kept in memory by a Group_hash, see
+  end_update(). The key of the group is in Temp_table_param::group_buff.
+*/
+
+static enum_nested_loop_state
+end_update_in_memory(JOIN *join, QEP_TAB *const qep_tab)
+{
+  TABLE *const table= qep_tab->table();
+  Group_hash *const hash= qep_tab->group_hash;
+  uchar *const key= qep_tab->tmp_table_param->group_buff;
+  const size_t reclength= table->s->reclength;
+
+  uchar *const group= hash->find(key);
+  if (group != NULL)
+  {
+    memcpy(table->record[0], group, reclength);
+    update_tmptable_sum_func(join->sum_funcs, table);
+    memcpy(group, table->record[0], reclength);
+    return NESTED_LOOP_OK;
+  }
+
+  if (init_new_group_record(join, qep_tab))
+    return NESTED_LOOP_ERROR;                   /* purecov: inspected */
+  init_tmptable_sum_functions(join->sum_funcs);
+  if (hash->add(key, table->record[0]))
+    return NESTED_LOOP_ERROR;                   /* purecov: inspected */
+  // Leave the rest of the groups to the tmp table
+  if (hash->is_full())
+    return hash->flush(join, qep_tab);
+  return NESTED_LOOP_OK;
+}
+
+
 /* ARGSUSED */
 /** Group by searching after group record and updating it if possible. */
 
@@ -3397,13 +3557,16 @@ static enum_nested_loop_state
 end_update(JOIN *join, QEP_TAB *const qep_tab, bool end_of_records)
 {
   TABLE *const table= qep_tab->table();
-  ORDER *group;
   int error;
   bool group_found= false;
   DBUG_ENTER("end_update");
 
   if (end_of_records)
+  {
+    if (qep_tab->group_hash != NULL && qep_tab->group_hash->is_active())
+      DBUG_RETURN(qep_tab->group_hash->flush(join, qep_tab));
     DBUG_RETURN(NESTED_LOOP_OK);
+  }
   if (join->thd->killed)			// Aborted by user
   {
     join->thd->send_kill_message();
@@ -3432,14 +3595,14 @@ end_update(JOIN *join, QEP_TAB *const qep_tab, bool end_of_records)
   }
   else
   {
-    for (group=table->group ; group ; group=group->next)
+    store_group_key(table);
+    if (!qep_tab->group_hash_checked)
     {
-      Item *item= *group->item;
-      item->save_org_in_field(group->field);
-      /* Store in the used key if the field was 0 */
-      if (item->maybe_null)
-        group->buff[-1]= (char) group->field->is_null();
+      qep_tab->group_hash_checked= true;
+      qep_tab->group_hash= Group_hash::create(join->thd, qep_tab);
     }
+    if (qep_tab->group_hash != NULL && qep_tab->group_hash->is_active())
+      DBUG_RETURN(end_update_in_memory(join, qep_tab));
     const uchar *key= tmp_tbl->group_buff;
     if (!table->file->ha_index_read_map(table->record[1],
                                         key,
@@ -3464,42 +3627,10 @@ end_update(JOIN *join, QEP_TAB *const qep_tab, bool end_of_records)
     DBUG_RETURN(NESTED_LOOP_OK);
   }
 
-  /*
-    Copy null bits from group key to table
-    We can't copy all data as the key may have different format
-    as the row data (for example as with VARCHAR keys)
-  */
-  if (!table->hash_field)
-  {
-    KEY_PART_INFO *key_part;
-    for (group= table->group, key_part= table->key_info[0].key_part;
-         group;
-         group= group->next, key_part++)
-    {
-      if (key_part->null_bit)
-        memcpy(table->record[0] + key_part->offset, group->buff, 1);
-    }
-    /* See comment on copy_funcs above. */
-    if (copy_funcs(tmp_tbl->items_to_copy, join->thd))
-      DBUG_RETURN(NESTED_LOOP_ERROR);           /* purecov: inspected */
-  }
+  if (!table->hash_field && init_new_group_record(join, qep_tab))
+    DBUG_RETURN(NESTED_LOOP_ERROR);             /* purecov: inspected */
   init_tmptable_sum_functions(join->sum_funcs);
-  if ((error=table->file->ha_write_row(table->record[0])))
-  {
-    if (create_ondisk_from_heap(join->thd, table,
-                                tmp_tbl->start_recinfo,
-                                &tmp_tbl->recinfo,
-				error, FALSE, NULL))
-      DBUG_RETURN(NESTED_LOOP_ERROR);            // Not a table_is_full error
-    /* Change method to update rows */
-    if ((error= table->file->ha_index_init(0, 0)))
-    {
-      table->file->print_error(error, MYF(0));
-      DBUG_RETURN(NESTED_LOOP_ERROR);
-    }
-  }
-  qep_tab->send_records++;
-  DBUG_RETURN(NESTED_LOOP_OK);
+  DBUG_RETURN(write_new_group_record(join, qep_tab));
 }
 
 
@@ -3757,8 +3888,8 @@ QEP_TAB::remove_duplicates()
 
   free_io_cache(tbl);				// Safety
   tbl->file->info(HA_STATUS_VARIABLE);
-  if (tbl->s->db_type() == heap_hton ||
-      (!tbl->s->blob_fields &&
+  if (!tbl->s->blob_fields &&
+      (tbl->s->db_type() == heap_hton ||
        ((ALIGN_SIZE(reclength) + HASH_OVERHEAD) * tbl->file->stats.records <
 	join()->thd->variables.sortbuff_size)))
     error=remove_dup_with_hash_index(join()->thd, tbl,
@@ -3781,6 +3912,12 @@ static bool remove_dup_with_compare(THD *thd, TABLE *table, Field **first_field,
   uchar *record;
   int error;
   ulong reclength= table->s->reclength-offset;
+  /*
+    A MEMORY table does not go on scanning from the row read by rnd_pos(),
+    its scan is restarted and the rows that have been kept are skipped.
+  */
+  const bool restart_scan= table->s->db_type() == heap_hton;
+  ulong kept= 0;
   DBUG_ENTER("remove_dup_with_compare");
 
   org_record=(char*) (record=table->record[0])+offset;
@@ -3847,8 +3984,23 @@ static bool remove_dup_with_compare(THD *thd, TABLE *table, Field **first_field,
     }
     if (!found)
       break;					// End of file
+    kept++;
     /* Restart search on next row */
-    error=file->ha_rnd_pos(record, file->ref);
+    if (restart_scan)
+    {
+      if ((error= file->ha_rnd_end()) || (error= file->ha_rnd_init(1)))
+        goto err;
+      for (ulong skipped= 0; ; )
+      {
+        error= file->ha_rnd_next(record);
+        if (error == HA_ERR_RECORD_DELETED)
+          continue;
+        if (error || skipped++ == kept)
+          break;
+      }
+    }
+    else
+      error=file->ha_rnd_pos(record, file->ref);
   }
 
   file->extra(HA_EXTRA_NO_CACHE);
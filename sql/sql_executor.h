@@ -22,6 +22,8 @@
 #include "records.h"               // READ_RECORD
 #include "sql_opt_exec_shared.h"   // QEP_shared_owner
 
+class Batch_filter;
+class Group_hash;
 class JOIN;
 class JOIN_TAB;
 class QEP_TAB;
@@ -259,13 +261,13 @@ public:
   {
     write_func= new_write_func;
   }
+  MY_ATTRIBUTE((warn_unused_result))
+  bool prepare_tmp_table();
 
 private:
   /** Write function that would be used for saving records in tmp table. */
   Next_select_func write_func;
   enum_nested_loop_state put_record(bool end_of_records);
-  MY_ATTRIBUTE((warn_unused_result))
-  bool prepare_tmp_table();
 };
 
 
@@ -276,6 +278,9 @@ enum_nested_loop_state end_send_group(JOIN *join, QEP_TAB *qep_tab,
                                       bool end_of_records);
 enum_nested_loop_state end_write_group(JOIN *join, QEP_TAB *qep_tab,
                                        bool end_of_records);
+void store_group_key(TABLE *table);
+bool init_new_group_record(JOIN *join, QEP_TAB *qep_tab);
+enum_nested_loop_state write_new_group_record(JOIN *join, QEP_TAB *qep_tab);
 enum_nested_loop_state sub_select(JOIN *join,QEP_TAB *qep_tab, bool
                                   end_of_records);
 enum_nested_loop_state
@@ -360,6 +365,10 @@ public:
     used_uneven_bit_fields(false),
     keep_current_rowid(false),
     copy_current_rowid(NULL),
+    batch_filter(NULL),
+    batch_filter_checked(false),
+    group_hash(NULL),
+    group_hash_checked(false),
     distinct(false),
     not_used_in_distinct(false),
     cache_idx_cond(NULL),
@@ -573,6 +582,22 @@ public:
   bool keep_current_rowid;
   st_cache_field *copy_current_rowid;
 
+  /**
+    Filter that evaluates the simple parts of condition() for batches of
+    rows read by a table scan. Set up by the first scan of the table if
+    scan_filter_batch_size is non-zero, NULL if it cannot be used.
+  */
+  Batch_filter *batch_filter;
+  bool batch_filter_checked;
+
+  /**
+    In-memory groups of a GROUP BY tmp table that is filled by
+    end_update(). Set up by the first row that is grouped, NULL if the
+    group key is not supported.
+  */
+  Group_hash *group_hash;
+  bool group_hash_checked;
+
   /** TRUE <=> remove duplicates on this table. */
   bool distinct;
 
@@ -0,0 +1,192 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  In-memory hash aggregation for GROUP BY tmp tables, see Group_hash.
+*/
+
+#include "sql_group_hash.h"
+
+#include "field.h"                              // Field
+#include "mysqld.h"                             // key_memory_Group_hash
+#include "sql_class.h"                          // THD
+#include "sql_optimizer.h"                      // JOIN
+#include "table.h"                              // TABLE
+
+#include <algorithm>
+
+/** Block size of the MEM_ROOT that holds the groups */
+static const size_t GROUP_HASH_BLOCK_SIZE= 32 * 1024;
+
+/** Size of the pointer to the next group that precedes each key image */
+static const size_t GROUP_HASH_LINK_SIZE= ALIGN_SIZE(sizeof(uchar *));
+
+
+/**
+  Whether equal values of a field always have the same key image, so that
+  groups can be compared with memcmp().
+*/
+
+static bool has_unique_key_image(const Field *field)
+{
+  switch (field->type())
+  {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+  case MYSQL_TYPE_YEAR:
+  case MYSQL_TYPE_NEWDECIMAL:
+  case MYSQL_TYPE_NEWDATE:
+  case MYSQL_TYPE_TIME2:
+  case MYSQL_TYPE_DATETIME2:
+  case MYSQL_TYPE_TIMESTAMP2:
+    return true;
+  default:
+    return false;
+  }
+}
+
+
+Group_hash *Group_hash::create(THD *thd, QEP_TAB *qep_tab)
+{
+  TABLE *const table= qep_tab->table();
+  DBUG_ENTER("Group_hash::create");
+
+  if (table->group == NULL || table->hash_field != NULL ||
+      table->s->keys == 0 || table->s->blob_fields != 0)
+    DBUG_RETURN(NULL);
+  for (ORDER *group= table->group; group; group= group->next)
+  {
+    if (!has_unique_key_image(group->field))
+      DBUG_RETURN(NULL);
+  }
+
+  // Same limit as for an in-memory tmp table, see create_tmp_table()
+  const ulonglong max_size=
+    std::min(thd->variables.tmp_table_size,
+             thd->variables.max_heap_table_size);
+  Group_hash *const hash=
+    new (thd->mem_root) Group_hash(qep_tab, table->key_info[0].key_length,
+                                   max_size);
+  if (hash == NULL)
+    DBUG_RETURN(NULL);
+  if (my_hash_init(&hash->m_hash, &my_charset_bin, 1024, GROUP_HASH_LINK_SIZE,
+                   hash->m_key_length, NULL, NULL, 0, key_memory_Group_hash))
+  {
+    delete hash;
+    DBUG_RETURN(NULL);
+  }
+  DBUG_RETURN(hash);
+}
+
+
+Group_hash::Group_hash(QEP_TAB *qep_tab, uint key_length,
+                       ulonglong max_size)
+  : m_qep_tab(qep_tab), m_key_length(key_length),
+    m_reclength(qep_tab->table()->s->reclength), m_max_size(max_size),
+    m_active(true), m_first(NULL), m_last(&m_first)
+{
+  init_sql_alloc(key_memory_Group_hash, &m_mem_root,
+                 GROUP_HASH_BLOCK_SIZE, 0);
+  my_hash_clear(&m_hash);
+}
+
+
+Group_hash::~Group_hash()
+{
+  my_hash_free(&m_hash);
+  free_root(&m_mem_root, MYF(0));
+}
+
+
+uchar *Group_hash::find(uchar *key)
+{
+  /*
+    The value of a NULL key part is whatever was stored last, clear it so
+    that all NULLs of the part have the same key image.
+  */
+  for (ORDER *group= m_qep_tab->table()->group; group; group= group->next)
+  {
+    if ((*group->item)->maybe_null && group->buff[-1])
+      memset(group->buff, 0, group->field->pack_length());
+  }
+  uchar *const entry= my_hash_search(&m_hash, key, m_key_length);
+  return entry ? entry + GROUP_HASH_LINK_SIZE + m_key_length : NULL;
+}
+
+
+bool Group_hash::add(const uchar *key, const uchar *record)
+{
+  const size_t size= GROUP_HASH_LINK_SIZE + m_key_length + m_reclength;
+  uchar *const entry= static_cast<uchar *>(alloc_root(&m_mem_root, size));
+  if (entry == NULL)
+    return true;
+  *reinterpret_cast<uchar **>(entry)= NULL;
+  memcpy(entry + GROUP_HASH_LINK_SIZE, key, m_key_length);
+  memcpy(entry + GROUP_HASH_LINK_SIZE + m_key_length, record, m_reclength);
+  if (my_hash_insert(&m_hash, entry))
+  {
+    my_error(ER_OUTOFMEMORY, MYF(ME_FATALERROR), size);
+    return true;
+  }
+  *m_last= entry;
+  m_last= reinterpret_cast<uchar **>(entry);
+  return false;
+}
+
+
+enum_nested_loop_state Group_hash::flush(JOIN *join, QEP_TAB *qep_tab)
+{
+  TABLE *const table= qep_tab->table();
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  DBUG_ENTER("Group_hash::flush");
+  DBUG_PRINT("info", ("writing %lu groups", m_hash.records));
+
+  /*
+    The elements of m_hash are moved around as it grows, so the groups are
+    written in the order they were linked in when first seen.
+  */
+  for (const uchar *entry= m_first; entry != NULL && rc == NESTED_LOOP_OK;
+       entry= *reinterpret_cast<uchar *const *>(entry))
+  {
+    memcpy(table->record[0], entry + GROUP_HASH_LINK_SIZE + m_key_length,
+           m_reclength);
+    rc= write_new_group_record(join, qep_tab);
+  }
+  m_active= false;
+  clear();
+  DBUG_RETURN(rc);
+}
+
+
+void Group_hash::clear()
+{
+  my_hash_reset(&m_hash);
+  free_root(&m_mem_root, MYF(0));
+  m_first= NULL;
+  m_last= &m_first;
+}
+
+
+void Group_hash::reset()
+{
+  clear();
+  m_active= true;
+}
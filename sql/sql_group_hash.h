@@ -0,0 +1,121 @@
+#ifndef SQL_GROUP_HASH_INCLUDED
+#define SQL_GROUP_HASH_INCLUDED
+
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/** @file In-memory hash aggregation for GROUP BY tmp tables */
+
+#include "my_global.h"
+#include "hash.h"                               // HASH
+#include "my_alloc.h"                           // MEM_ROOT
+#include "sql_alloc.h"                          // Sql_alloc
+#include "sql_executor.h"                       // enum_nested_loop_state
+
+class JOIN;
+class QEP_TAB;
+class THD;
+
+/**
+  Keeps the groups of a GROUP BY tmp table in memory while they are
+  aggregated.
+
+  end_update() normally looks up the group of every row in the index of
+  the tmp table, and updates the record of the group through the handler.
+  With a Group_hash, the records of the groups are kept in a MEM_ROOT
+  instead, and found through a hash on the key image that end_update()
+  builds in Temp_table_param::group_buff. The records are written to the
+  tmp table once, in the order the groups were first seen, when all rows
+  have been read.
+
+  If the records take more memory than an in-memory tmp table may use,
+  the groups so far are written to the tmp table, and the rest of the
+  execution continues with the lookups through the handler.
+
+  Only group keys whose key image is the same for all equal values are
+  supported: integers, DECIMAL and temporal types, and NULL.
+*/
+
+class Group_hash : public Sql_alloc
+{
+public:
+  /**
+    Create a hash for the GROUP BY tmp table of qep_tab.
+
+    @return The hash, or NULL if the group key is not supported.
+  */
+  static Group_hash *create(THD *thd, QEP_TAB *qep_tab);
+
+  ~Group_hash();
+
+  /** Whether groups are aggregated in memory in this execution */
+  bool is_active() const { return m_active; }
+
+  /**
+    Find the record of the group with the given key.
+
+    @param key  Key image in Temp_table_param::group_buff. The value
+                bytes of NULL key parts are cleared.
+
+    @return The record of the group, or NULL if it is a new group
+  */
+  uchar *find(uchar *key);
+
+  /**
+    Add a new group.
+
+    @param key     Key image, as given to find()
+    @param record  Initial record of the group
+
+    @retval false  OK
+    @retval true   Out of memory, an error has been reported
+  */
+  bool add(const uchar *key, const uchar *record);
+
+  /** Whether the groups use more memory than the tmp table may */
+  bool is_full() const { return m_mem_root.allocated_size > m_max_size; }
+
+  /**
+    Write all groups to the tmp table, and stop aggregating in memory for
+    the rest of the execution.
+  */
+  enum_nested_loop_state flush(JOIN *join, QEP_TAB *qep_tab);
+
+  /** Forget all groups, and aggregate in memory in the next execution */
+  void reset();
+
+private:
+  Group_hash(QEP_TAB *qep_tab, uint key_length, ulonglong max_size);
+
+  /** Free the groups */
+  void clear();
+
+  QEP_TAB *const m_qep_tab;
+  const uint m_key_length;
+  const uint m_reclength;
+  const ulonglong m_max_size;
+  bool m_active;
+  /**
+    Records of the groups, each preceded by a pointer to the next group
+    in the order the groups were first seen, and by its key image
+  */
+  MEM_ROOT m_mem_root;
+  HASH m_hash;
+  /** First group, and the pointer to set to the next group added */
+  uchar *m_first;
+  uchar **m_last;
+};
+
+#endif /* SQL_GROUP_HASH_INCLUDED */
@@ -2122,6 +2122,458 @@ enum_nested_loop_state JOIN_CACHE_BNL::join_matching_records(bool skip_last)
 }
 
 
+/*
+  Check whether two columns can be equated through the hash join key
+
+  SYNOPSIS
+    hash_join_compatible_fields()
+      a          column of one of the previous tables
+      b          column of the joined table
+      length OUT length of the sort key prefix to hash
+
+  DESCRIPTION
+    The hash key of a column is built over its sort key. Two columns can
+    only be used for the hash key if any pair of their values that is equal
+    according to the comparison performed by '=' always yields the same sort
+    key prefix of the returned length. This holds for columns of the same
+    type with the same representation of values, and for strings in the
+    same character set and collation.
+    Unequal values may still get equal hash values: such candidates are
+    rejected by the condition of the joined table, which is checked as for
+    BNL.
+
+  RETURN
+    TRUE    the columns can be equated through the hash key
+    FALSE   otherwise
+*/
+
+bool hash_join_compatible_fields(Field *a, Field *b, uint *length)
+{
+  if (a->real_type() != b->real_type() ||
+      (a->flags & BLOB_FLAG) || (b->flags & BLOB_FLAG))
+    return false;
+
+  switch (a->real_type()) {
+  case MYSQL_TYPE_DECIMAL:
+  case MYSQL_TYPE_FLOAT:
+  case MYSQL_TYPE_DOUBLE:
+  case MYSQL_TYPE_BIT:
+  case MYSQL_TYPE_ENUM:
+  case MYSQL_TYPE_SET:
+  case MYSQL_TYPE_GEOMETRY:
+  case MYSQL_TYPE_JSON:
+    return false;
+  default:
+    break;
+  }
+
+  if (a->result_type() == STRING_RESULT && !is_temporal_type(a->type()))
+  {
+    if (a->charset() != b->charset())
+      return false;
+    /*
+      Binary strings have their length stored at the end of the sort key,
+      so prefixes of keys of different lengths cannot be compared.
+    */
+    if (a->charset() == &my_charset_bin &&
+        a->sort_length() != b->sort_length())
+      return false;
+    *length= min(a->sort_length(), b->sort_length());
+    return *length > 0;
+  }
+
+  if (a->pack_length() != b->pack_length() ||
+      a->decimals() != b->decimals() ||
+      ((a->flags ^ b->flags) & UNSIGNED_FLAG))
+    return false;
+  *length= a->sort_length();
+  return *length > 0;
+}
+
+
+JOIN_CACHE_HASH::JOIN_CACHE_HASH(JOIN *j, QEP_TAB *qep_tab_arg,
+                                 JOIN_CACHE *prev)
+  : JOIN_CACHE_BNL(j, qep_tab_arg, prev), key_parts(j->thd->mem_root),
+  key_buff(NULL), hash_end(NULL), hash_records(0),
+  hash_buckets(NULL), hash_bucket_count(0)
+{}
+
+
+/* 
+  Initialize a hash join cache
+
+  SYNOPSIS
+    init()
+
+  DESCRIPTION
+    The function collects the pairs of columns that are equated by the
+    top-level conjuncts of the condition attached to the joined table and
+    that can be used to build the hash key, and then initializes the
+    cache exactly as a BNL cache does. If no such pair is found the cache
+    is used as a BNL cache.
+
+  RETURN
+    0   initialization with buffer allocations has been succeeded
+    1   otherwise
+*/
+
+int JOIN_CACHE_HASH::init()
+{
+  DBUG_ENTER("JOIN_CACHE_HASH::init");
+
+  if (qep_tab->condition() && collect_key_parts(qep_tab->condition()))
+    DBUG_RETURN(1);
+
+  if (!key_parts.empty())
+  {
+    uint max_length= 0;
+    for (size_t i= 0; i < key_parts.size(); i++)
+      max_length= max(max_length, key_parts[i].length);
+    if (!(key_buff= (uchar *) sql_alloc(max_length)))
+      DBUG_RETURN(1);
+
+    Opt_trace_context *const trace= &join->thd->opt_trace;
+    Opt_trace_object trace_wrapper(trace);
+    Opt_trace_array trace_key(trace, "hash_join_key");
+    for (size_t i= 0; i < key_parts.size(); i++)
+      trace_key.add(key_parts[i].cond);
+  }
+
+  if (JOIN_CACHE_BNL::init())
+    DBUG_RETURN(1);
+
+  /* The hash entries are aligned at the very end of the join buffer */
+  hash_end= reinterpret_cast<Hash_entry *>
+    (buff + (buff_size & ~static_cast<ulong>(sizeof(Hash_entry *) - 1)));
+
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Collect the pairs of equated columns for the hash key from a condition
+
+  SYNOPSIS
+    collect_key_parts()
+      cond    condition attached to the joined table, or its conjunct
+
+  DESCRIPTION
+    The function walks the top-level conjunction of the condition and adds
+    a hash key part for every equality between a column of the joined table
+    and a column of one of the previous tables (@see add_key_part).
+    Conjuncts guarded by a trigger are skipped unless the trigger is the
+    one that deactivates the join condition of an outer join whose only
+    inner table is the joined table: this trigger is always on while
+    matches for the records from the join buffer are looked for.
+
+  RETURN
+    TRUE    out of memory
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_HASH::collect_key_parts(Item *cond)
+{
+  if (cond->type() == Item::COND_ITEM &&
+      ((Item_cond *) cond)->functype() == Item_func::COND_AND_FUNC)
+  {
+    List_iterator<Item> li(*((Item_cond *) cond)->argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      if (collect_key_parts(item))
+        return true;
+    }
+    return false;
+  }
+
+  if (cond->type() != Item::FUNC_ITEM)
+    return false;
+
+  Item_func *const func= (Item_func *) cond;
+  switch (func->functype()) {
+  case Item_func::TRIG_COND_FUNC:
+    if (qep_tab->is_single_inner_for_outer_join() &&
+        ((Item_func_trig_cond *) func)->get_trig_var() ==
+        &qep_tab->not_null_compl)
+      return collect_key_parts(func->arguments()[0]);
+    return false;
+  case Item_func::EQ_FUNC:
+    return add_key_part(func);
+  default:
+    return false;
+  }
+}
+
+
+/*
+  Add a hash key part for an equality between two columns
+
+  SYNOPSIS
+    add_key_part()
+      eq      equality predicate
+
+  DESCRIPTION
+    The function adds a hash key part if one side of the equality is a
+    column of the joined table and the other side is a column of one of the
+    previous tables, and the columns are compatible for hashing
+    (@see hash_join_compatible_fields).
+
+  RETURN
+    TRUE    out of memory
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_HASH::add_key_part(Item_func *eq)
+{
+  Item *left= eq->arguments()[0]->real_item();
+  Item *right= eq->arguments()[1]->real_item();
+  if (left->type() != Item::FIELD_ITEM || right->type() != Item::FIELD_ITEM)
+    return false;
+
+  const table_map inner_map= qep_tab->table_ref->map();
+  const table_map outer_map= qep_tab->prefix_tables() & ~inner_map;
+  if (right->used_tables() != inner_map)
+    std::swap(left, right);
+  if (right->used_tables() != inner_map ||
+      (left->used_tables() & ~outer_map))
+    return false;
+
+  Hash_key_part part;
+  part.outer_field= ((Item_field *) left)->field;
+  part.inner_field= ((Item_field *) right)->field;
+  part.cond= eq;
+  if (!hash_join_compatible_fields(part.outer_field, part.inner_field,
+                                   &part.length))
+    return false;
+  return key_parts.push_back(part);
+}
+
+
+/*
+  Calculate the hash value of the current join key
+
+  SYNOPSIS
+    calc_hash()
+      outer       TRUE <=> use the columns of the previous tables,
+                  otherwise use the columns of the joined table
+      hash  OUT   the calculated hash value
+
+  DESCRIPTION
+    The function hashes the sort keys of the current values of the key
+    columns. A NULL value in any of them means that no equality of the key
+    can be true, so no hash value is calculated.
+
+  RETURN
+    TRUE    one of the key columns is NULL
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_HASH::calc_hash(bool outer, uint32 *hash)
+{
+  ulong nr1= 1, nr2= 4;
+  for (size_t i= 0; i < key_parts.size(); i++)
+  {
+    const Hash_key_part &part= key_parts[i];
+    Field *const field= outer ? part.outer_field : part.inner_field;
+    if (field->is_null())
+      return true;
+    field->make_sort_key(key_buff, part.length);
+    my_charset_bin.coll->hash_sort(&my_charset_bin, key_buff, part.length,
+                                   &nr1, &nr2);
+  }
+  *hash= static_cast<uint32>(nr1);
+  return false;
+}
+
+
+/*
+  Add a record into the join buffer of a hash join cache
+
+  SYNOPSIS
+    put_record_in_cache()
+
+  DESCRIPTION
+    The function writes the record into the join buffer as BNL does and adds
+    a hash entry for it, unless one of its key columns is NULL: such records
+    never match any row of the joined table.
+
+  RETURN
+    TRUE    if it has been decided that it should be the last record
+            in the join buffer,
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_HASH::put_record_in_cache()
+{
+  if (key_parts.empty())
+    return JOIN_CACHE_BNL::put_record_in_cache();
+
+  uint32 hash;
+  const bool null_key= calc_hash(true, &hash);
+  const bool is_full= JOIN_CACHE_BNL::put_record_in_cache();
+  if (!null_key)
+  {
+    Hash_entry *const entry= get_hash_entry(hash_records++);
+    entry->rec_ptr= last_rec_pos;
+    entry->hash= hash;
+  }
+  return is_full;
+}
+
+
+/* Reset the join buffer and the hash entries for reading/writing */
+
+void JOIN_CACHE_HASH::reset_cache(bool for_writing)
+{
+  JOIN_CACHE_BNL::reset_cache(for_writing);
+  if (for_writing)
+    hash_records= 0;
+}
+
+
+/*
+  Build the hash table over the entries of the buffered records
+
+  SYNOPSIS
+    build_hash_table()
+
+  DESCRIPTION
+    The function places an array of bucket heads right below the hash
+    entries and links each entry into the chain of its bucket. The entries
+    are linked in the order of the records in the join buffer, so matches
+    are generated in the same order as with BNL.
+    The space for the buckets has been reserved by put_record_in_cache().
+*/
+
+void JOIN_CACHE_HASH::build_hash_table()
+{
+  DBUG_ASSERT(hash_records > 0);
+  hash_bucket_count= hash_records;
+  hash_buckets= reinterpret_cast<uint32 *>(get_hash_entry(hash_records - 1)) -
+                hash_bucket_count;
+  DBUG_ASSERT(reinterpret_cast<uchar *>(hash_buckets) >= end_pos);
+  memset(hash_buckets, 0xFF, hash_bucket_count * sizeof(uint32));
+
+  for (uint idx= hash_records; idx-- > 0; )
+  {
+    Hash_entry *const entry= get_hash_entry(idx);
+    uint32 *const bucket= hash_buckets + entry->hash % hash_bucket_count;
+    entry->next= *bucket;
+    *bucket= idx;
+  }
+}
+
+
+/*
+  Using the hash table find matches from the next table for the records
+  from the join buffer
+
+  SYNOPSIS
+    join_matching_records()
+      skip_last    do not look for matches for the last partial join record 
+
+  DESCRIPTION
+    The function retrieves all rows of the join_tab table as BNL does, but
+    checks each of them only against the records from the join buffer
+    with the same hash value of the join key. If none of the buffered
+    records has a non-NULL key the joined table is not read at all.
+    If the value of skip_last is true the partial join record from the
+    record buffer is written into the join buffer without a hash entry and
+    the reading position is left at it, as the caller expects after BNL.
+
+  RETURN
+    return one of enum_nested_loop_state.
+*/
+
+enum_nested_loop_state JOIN_CACHE_HASH::join_matching_records(bool skip_last)
+{
+  if (key_parts.empty())
+    return JOIN_CACHE_BNL::join_matching_records(skip_last);
+
+  int error;
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+
+  qep_tab->table()->reset_null_row();
+
+  /* Return at once if there are no records in the join buffer */
+  if (!records)
+    return NESTED_LOOP_OK;
+
+  uchar *const skipped_rec= pos;
+  if (skip_last)
+    JOIN_CACHE_BNL::put_record_in_cache();
+
+  if (hash_records)
+  {
+    build_hash_table();
+
+    // See setup_join_buffering(=: dynamic range => no cache.
+    DBUG_ASSERT(!(qep_tab->dynamic_range() && qep_tab->quick()));
+
+    /* Start retrieving all records of the joined table */
+    if ((error= (*qep_tab->read_first_record)(qep_tab)))
+      rc= error < 0 ? NESTED_LOOP_OK : NESTED_LOOP_ERROR;
+    else
+    {
+      READ_RECORD *info= &qep_tab->read_record;
+      do
+      {
+        if (qep_tab->keep_current_rowid)
+          qep_tab->table()->file->position(qep_tab->table()->record[0]);
+
+        if (join->thd->killed)
+        {
+          /* The user has aborted the execution of the query */
+          join->thd->send_kill_message();
+          return NESTED_LOOP_KILLED;
+        }
+
+        join->examined_rows++;
+        if (const_cond)
+        {
+          const bool consider_record= const_cond->val_int() != FALSE;
+          if (join->thd->is_error())              // error in condition evaluation
+            return NESTED_LOOP_ERROR;
+          if (!consider_record)
+            continue;
+        }
+
+        /* A row with a NULL key column cannot match any buffered record */
+        uint32 hash;
+        if (calc_hash(false, &hash))
+          continue;
+
+        uint32 idx= hash_buckets[hash % hash_bucket_count];
+        while (idx != NO_ENTRY)
+        {
+          Hash_entry *const entry= get_hash_entry(idx);
+          idx= entry->next;
+          if (entry->hash != hash)
+            continue;
+          /* 
+            If only the first match is needed and it has been already found
+            for the buffered record then the record is skipped.
+          */
+          if (check_only_first_match && get_match_flag_by_pos(entry->rec_ptr))
+            continue;
+          get_record_by_pos(entry->rec_ptr);
+          rc= generate_full_extensions(entry->rec_ptr);
+          if (rc != NESTED_LOOP_OK)
+            return rc;
+        }
+      } while (!(error= info->read_record(info)));
+
+      if (error > 0)				// Fatal error
+        rc= NESTED_LOOP_ERROR;
+    }
+  }
+
+  /* The caller restores the skipped record by reading it at 'pos' */
+  pos= skipped_rec;
+  return rc;
+}
+
+
 bool JOIN_CACHE::calc_check_only_first_match(const QEP_TAB *t) const
 {
   if ((t->last_sj_inner() == t->idx() &&
@@ -2664,6 +3116,11 @@ JOIN_CACHE_BKA::init_join_matching_records(RANGE_SEQ_IF *seq_funcs, uint ranges)
       return error;
     }
   }
+  /*
+    The keys are single key lookups in the order of the join buffer, the
+    MRR implementation may sort them: mrr_mode has HA_MRR_KEY_LOOKUPS, see
+    setup_join_buffering().
+  */
   return
     file->multi_range_read_init(seq_funcs, (void*) this, ranges,
                                 mrr_mode, &mrr_buff);
@@ -488,7 +488,7 @@ public:
 
   /** Bits describing cache's type @sa setup_join_buffering() */
   enum enum_join_cache_type
-  {ALG_NONE= 0, ALG_BNL= 1, ALG_BKA= 2, ALG_BKA_UNIQUE= 4};
+  {ALG_NONE= 0, ALG_BNL= 1, ALG_BKA= 2, ALG_BKA_UNIQUE= 4, ALG_HASH= 8};
 
   virtual enum_join_cache_type cache_type() const= 0;
 
@@ -497,6 +497,7 @@ public:
   { return cache_type() & (ALG_BKA | ALG_BKA_UNIQUE ); }
 
   friend class JOIN_CACHE_BNL;
+  friend class JOIN_CACHE_HASH;
   friend class JOIN_CACHE_BKA;
   friend class JOIN_CACHE_BKA_UNIQUE;
 };
@@ -519,10 +520,126 @@ public:
 
   enum_join_cache_type cache_type() const { return ALG_BNL; }
 
-private:
+protected:
   Item *const_cond;
 };
 
+/*
+  The class JOIN_CACHE_HASH supports the hash join algorithm. It is a variant
+  of BNL where the records of the join buffer are additionally indexed by a
+  hash over the values of the columns of the previous tables that are
+  equated to columns of the joined table by top-level conjuncts of its
+  condition, e.g. t2.a=t1.a AND t2.b=t1.b. Each row of the joined table is
+  then only checked against the chain of buffered records with the same hash
+  value rather than against every buffered record.
+  The hash values are computed over the sort keys of the columns so that
+  equal values always get equal hash values; different values hashing to the
+  same chain are weeded out by the attached condition that is still checked
+  for every candidate pair.
+  The hash entries are placed at the very end of the join buffer, growing
+  towards the records; every record written into the buffer reserves room
+  for its entry and for one bucket of the hash table that is built over the
+  entries right before the records are joined:
+
+  buff
+  V
+  +---------------------------------------------------------------------+
+  | record_1 | record_2 | ... | record_n | -> free <- | buckets | entries |
+  +---------------------------------------------------------------------+
+                                                      ^                 ^
+                                                      |                 hash_end
+                                                      built by build_hash_table()
+
+  If the buffered records do not fit into the join buffer they are processed
+  in several passes exactly as with BNL: every pass builds the hash table
+  over the records put into the buffer so far and scans the joined table once.
+  When no suitable equality is found the cache works as a plain BNL cache.
+*/
+
+class JOIN_CACHE_HASH :public JOIN_CACHE_BNL
+{
+  /* A pair of columns equated by the condition of the joined table */
+  struct Hash_key_part
+  {
+    Field *outer_field;     /**< column of one of the previous tables */
+    Field *inner_field;     /**< column of the joined table */
+    uint length;            /**< length of the hashed sort key prefix */
+    Item *cond;             /**< the equality the columns are taken from */
+  };
+
+  /* The hash entry of a buffered record */
+  struct Hash_entry
+  {
+    uchar *rec_ptr;         /**< position of the record fields */
+    uint32 hash;            /**< hash value of the record's key */
+    uint32 next;            /**< next entry in the bucket chain */
+  };
+
+  /* Descriptors of the equated columns the hash key is built over */
+  Mem_root_array<Hash_key_part, true> key_parts;
+  /* Buffer to build the sort key of a single column in */
+  uchar *key_buff;
+
+  /* End of the array of hash entries, aligned, at the end of the buffer */
+  Hash_entry *hash_end;
+  /* Number of entries put into the hash entry array */
+  uint hash_records;
+  /* Bucket heads of the hash table built over the hash entries */
+  uint32 *hash_buckets;
+  /* Number of buckets of the hash table */
+  uint hash_bucket_count;
+
+  static const uint32 NO_ENTRY= 0xFFFFFFFF;
+
+  /* Space reserved in the buffer for the hash entry of one record */
+  static uint hash_space_per_record()
+  { return sizeof(Hash_entry) + sizeof(uint32); }
+
+  Hash_entry *get_hash_entry(uint idx) { return hash_end - idx - 1; }
+
+  /* Collect the pairs of equated columns usable for the hash key */
+  bool collect_key_parts(Item *cond);
+  bool add_key_part(Item_func *eq);
+
+  /* Calculate the hash of the current values of the outer or inner columns */
+  bool calc_hash(bool outer, uint32 *hash);
+
+  /* Build the hash table over the entries of the buffered records */
+  void build_hash_table();
+
+protected:
+
+  uint aux_buffer_min_size() const
+  { return key_parts.empty() ? 0 : 2 * hash_space_per_record(); }
+
+  ulong rem_space()
+  {
+    if (key_parts.empty())
+      return JOIN_CACHE_BNL::rem_space();
+    const ulong used= static_cast<ulong>(end_pos - buff) +
+      (records + 1) * hash_space_per_record() + sizeof(Hash_entry);
+    return buff_size > used ? buff_size - used : 0;
+  }
+
+  /* Add a record into the join buffer and its hash entry into the table */
+  bool put_record_in_cache();
+
+  /* Using the hash table find matches for the records from join buffer */
+  enum_nested_loop_state join_matching_records(bool skip_last);
+
+public:
+  JOIN_CACHE_HASH(JOIN *j, QEP_TAB *qep_tab_arg, JOIN_CACHE *prev);
+
+  /* Initialize the hash join cache */
+  int init();
+
+  /* Reset the join buffer and the hash table for reading/writing */
+  void reset_cache(bool for_writing);
+
+  enum_join_cache_type cache_type() const
+  { return key_parts.empty() ? ALG_BNL : ALG_HASH; }
+};
+
 class JOIN_CACHE_BKA :public JOIN_CACHE
 {
 protected:
@@ -878,4 +995,7 @@ public:
 };
 
 
+/* Check if two columns can be equated through the key of a hash join */
+bool hash_join_compatible_fields(Field *a, Field *b, uint *length);
+
 #endif /* SQL_JOIN_CACHE_INCLUDED */
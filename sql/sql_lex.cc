@@ -975,6 +975,51 @@ static LEX_STRING get_quoted_token(Lex_input_stream *lip,
 }
 
 
+/**
+  Accept the ASCII identifier characters that follow in the input stream,
+  all at once. An ASCII character is a character of its own in every
+  character set that a client can use, so only the other characters of an
+  identifier need to be looked at by the character set.
+
+  @param lip        Input stream
+  @param ident_map  Identifier characters of the character set
+*/
+
+static inline void skip_ascii_ident(Lex_input_stream *lip,
+                                    const uchar *ident_map)
+{
+  const uchar *const start= pointer_cast<const uchar *>(lip->get_ptr());
+  const uchar *const end=
+    pointer_cast<const uchar *>(lip->get_end_of_query());
+  const uchar *ptr= start;
+  while (ptr < end && *ptr < 0x80 && ident_map[*ptr])
+    ptr++;
+  lip->yySkipn(static_cast<int>(ptr - start));
+}
+
+
+/**
+  Accept the ASCII characters of a quoted string or identifier that follow
+  in the input stream, all at once, up to the quote or escape character.
+
+  @param lip     Input stream
+  @param quote   Quote character
+  @param escape  Escape character, or 0
+*/
+
+static inline void skip_ascii_text(Lex_input_stream *lip, uchar quote,
+                                   uchar escape)
+{
+  const uchar *const start= pointer_cast<const uchar *>(lip->get_ptr());
+  const uchar *const end=
+    pointer_cast<const uchar *>(lip->get_end_of_query());
+  const uchar *ptr= start;
+  while (ptr < end && *ptr < 0x80 && *ptr != quote && *ptr != escape)
+    ptr++;
+  lip->yySkipn(static_cast<int>(ptr - start));
+}
+
+
 /*
   Return an unescaped text literal without quotes
   Fix sometimes to do only one scan of the string
@@ -990,6 +1035,9 @@ static char *get_text(Lex_input_stream *lip, int pre_skip, int post_skip)
   sep= lip->yyGetLast();                        // String should end with this
   while (! lip->eof())
   {
+    skip_ascii_text(lip, sep, '\\');
+    if (lip->eof())
+      break;
     c= lip->yyGet();
     lip->tok_bitmap|= c;
     {
@@ -1507,8 +1555,11 @@ static int lex_one_token(YYSTYPE *yylval, THD *thd)
           }
           lip->skip_binary(l - 1);
         }
-        while (ident_map[c=lip->yyGet()])
+        for (;;)
         {
+          skip_ascii_ident(lip, ident_map);
+          if (!ident_map[c= lip->yyGet()])
+            break;
           switch (my_mbcharlen(cs, c))
           {
           case 1:
@@ -1656,8 +1707,11 @@ static int lex_one_token(YYSTYPE *yylval, THD *thd)
       if (use_mb(cs))
       {
 	result_state= IDENT_QUOTED;
-        while (ident_map[c=lip->yyGet()])
+        for (;;)
         {
+          skip_ascii_ident(lip, ident_map);
+          if (!ident_map[c= lip->yyGet()])
+            break;
           switch (my_mbcharlen(cs, c))
           {
           case 1:
@@ -1700,6 +1754,7 @@ static int lex_one_token(YYSTYPE *yylval, THD *thd)
       char quote_char= c;                       // Used char
       for(;;)
       {
+        skip_ascii_text(lip, quote_char, 0);
         c= lip->yyGet();
         if (c == 0)
         {
@@ -2271,6 +2326,7 @@ st_select_lex::st_select_lex
   subquery_in_having(false),
   first_execution(true),
   sj_pullout_done(false),
+  cached_join_order(NULL),
   exclude_from_table_unique_test(false),
   allow_merge_derived(true),
   prev_join_using(NULL),
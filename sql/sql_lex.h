@@ -76,6 +76,7 @@ typedef class st_select_lex SELECT_LEX;
 const size_t INITIAL_LEX_PLUGIN_LIST_SIZE = 16;
 class Opt_hints_global;
 class Opt_hints_qb;
+class Cached_join_order;
 
 #ifdef MYSQL_SERVER
 /*
@@ -1069,6 +1070,8 @@ public:
   bool first_execution;
   /// True when semi-join pull-out processing is complete 
   bool sj_pullout_done;
+  /// Join order kept from an earlier execution, see Cached_join_order
+  Cached_join_order *cached_join_order;
   /// exclude this query block from unique_table() check
   bool exclude_from_table_unique_test;
   /// Allow merge of immediate unnamed derived tables
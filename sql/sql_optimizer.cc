@@ -69,7 +69,7 @@ static bool
 update_ref_and_keys(THD *thd, Key_use_array *keyuse,JOIN_TAB *join_tab,
                     uint tables, Item *cond, COND_EQUAL *cond_equal,
                     table_map normal_tables, SELECT_LEX *select_lex,
-                    SARGABLE_PARAM **sargables);
+                    MEM_ROOT *key_field_root, SARGABLE_PARAM **sargables);
 static bool pull_out_semijoin_tables(JOIN *join);
 static void add_group_and_distinct_keys(JOIN *join, JOIN_TAB *join_tab);
 static ha_rows get_quick_record_count(THD *thd, JOIN_TAB *tab, ha_rows limit);
@@ -3006,7 +3006,9 @@ void revise_cache_usage(JOIN_TAB *join_tab)
     If block_nested_loop is turned on, and if all other criteria for using
     join buffering is fulfilled (see below), then join buffer is used 
     for any join operation (inner join, outer join, semi-join) with 'JT_ALL' 
-    access method.  In that case, a JOIN_CACHE_BNL type is always employed.
+    access method.  In that case, a JOIN_CACHE_BNL type is employed, unless
+    hash_join is turned on and the join planner chose a hash join for the
+    table, in which case a JOIN_CACHE_HASH type is employed.
 
     If an index is used to access rows of the joined table and batched_key_access
     is on, then a JOIN_CACHE_BKA type is employed. (Unless debug flag,
@@ -3179,7 +3181,13 @@ static bool setup_join_buffering(JOIN_TAB *tab, JOIN *join, uint no_jbuf_after)
       goto no_join_cache;
     }
 
-    tab->set_use_join_cache(JOIN_CACHE::ALG_BNL);
+    /*
+      Hash join is used if the join planner found it cheaper than BNL for
+      this table; a JOIN_CACHE_HASH falls back to BNL at execution if none
+      of the equalities can be used for its hash key.
+    */
+    tab->set_use_join_cache(tab->position()->use_hash_join ?
+                            JOIN_CACHE::ALG_HASH : JOIN_CACHE::ALG_BNL);
     return false;
   case JT_SYSTEM:
   case JT_CONST:
@@ -3221,6 +3229,8 @@ static bool setup_join_buffering(JOIN_TAB *tab, JOIN *join, uint no_jbuf_after)
 
     if (tab->table()->covering_keys.is_set(tab->ref().key))
       join_cache_flags|= HA_MRR_INDEX_ONLY;
+    // The lookup keys come in the order of the join buffer
+    join_cache_flags|= HA_MRR_KEY_LOOKUPS;
     rows= tab->table()->file->multi_range_read_info(tab->ref().key, 10, 20,
                                                   &bufsz,
                                                   &join_cache_flags, &cost);
@@ -4663,6 +4673,239 @@ propagate_cond_constants(THD *thd, I_List<COND_CMP> *save_list,
 }
 
 
+/**
+  Check whether an argument of a comparison is a constant that may be
+  evaluated when the condition is optimized.
+*/
+
+static bool is_foldable_const(Item *item)
+{
+  return item->const_item() && !item->is_expensive() &&
+         !item->has_subquery() && !item->has_stored_program();
+}
+
+
+/**
+  Evaluate a constant argument of a comparison with a non-constant one,
+  and replace it with a literal of its value, as propagate_cond_constants()
+  does for equalities. The constant is then evaluated once for the
+  execution, and not for each row. Only arguments that have the same
+  result type as the other argument are replaced, so that the comparison
+  is done the same way.
+
+  @param thd   Thread handler
+  @param func  Comparison
+
+  @returns false if success, true if error
+*/
+
+static bool fold_const_argument(THD *thd, Item_bool_func2 *func)
+{
+  Item **args= func->arguments();
+  for (uint i= 0; i < 2; i++)
+  {
+    Item *const value= args[i];
+    Item *const other= args[1 - i];
+    if (value->basic_const_item() || !is_foldable_const(value) ||
+        other->const_item() ||
+        value->result_type() != other->result_type() ||
+        value->result_type() == ROW_RESULT)
+      continue;
+    if (resolve_const_item(thd, &args[i], other))
+      return true;
+    args[i]->collation.set(value->collation);
+    args[i]->cmp_context= value->cmp_context;
+    func->update_used_tables();
+    if (func->set_cmp_func())
+      return true;
+  }
+  return false;
+}
+
+
+/**
+  Rewrite a comparison of field + c1, c1 + field or field - c1 with a
+  constant c2 to a comparison of the field with c2 - c1 or c2 + c1, so
+  that the range optimizer and ref access can use the field.
+
+  The rewrite is exact and is done only if
+  - field is a TINYINT, SMALLINT, MEDIUMINT or INT column, so that the
+    BIGINT sum can not overflow,
+  - c1, c2 and the sum are integer or decimal values, c1 and c2 are not
+    NULL, and the absolute value of c1 is less than 2^32,
+  - the sum can not be negative if it is computed as an unsigned integer,
+    as that gives an error for some values of the field.
+
+  @param thd   Thread handler
+  @param func  Comparison
+  @param side  The argument of func that may be field +/- c1
+
+  @returns false if success, true if error
+*/
+
+static bool fold_additive_argument(THD *thd, Item_bool_func2 *func,
+                                   uint side)
+{
+  Item **args= func->arguments();
+  Item *const value= args[1 - side];
+  if (args[side]->type() != Item::FUNC_ITEM || !is_foldable_const(value) ||
+      (value->result_type() != INT_RESULT &&
+       value->result_type() != DECIMAL_RESULT))
+    return false;
+
+  Item_func *const op= down_cast<Item_func *>(args[side]);
+  if (op->argument_count() != 2 ||
+      (op->result_type() != INT_RESULT && op->result_type() != DECIMAL_RESULT))
+    return false;
+  // Item_func_plus and Item_func_minus have no Functype of their own
+  const bool minus= !strcmp(op->func_name(), "-");
+  if (!minus && strcmp(op->func_name(), "+"))
+    return false;
+
+  // The field is the first argument of '-', and either argument of '+'
+  const uint field_pos= (!minus && op->arguments()[0]->const_item()) ? 1 : 0;
+  Item *const field_arg= op->arguments()[field_pos];
+  Item *const addend= op->arguments()[1 - field_pos];
+  if (field_arg->real_item()->type() != Item::FIELD_ITEM ||
+      !is_foldable_const(addend) ||
+      (addend->result_type() != INT_RESULT &&
+       addend->result_type() != DECIMAL_RESULT))
+    return false;
+  const Field *const field=
+    down_cast<Item_field *>(field_arg->real_item())->field;
+  switch (field->type())
+  {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+    break;
+  default:
+    return false;
+  }
+
+  my_decimal addend_buff, value_buff, bound, result;
+  const my_decimal *const c1= addend->val_decimal(&addend_buff);
+  if (thd->is_error())
+    return true;
+  if (addend->null_value)
+    return false;
+  const my_decimal *const c2= value->val_decimal(&value_buff);
+  if (thd->is_error())
+    return true;
+  if (value->null_value)
+    return false;
+
+  my_decimal abs_c1= *c1;
+  abs_c1.sign(false);
+  int2my_decimal(E_DEC_FATAL_ERROR, 1LL << 32, false, &bound);
+  if (my_decimal_cmp(&abs_c1, &bound) >= 0)
+    return false;
+
+  const bool negative_addend= !my_decimal_is_zero(c1) && c1->sign() != minus;
+  if (op->result_type() == INT_RESULT && op->unsigned_flag &&
+      (!field_arg->unsigned_flag || negative_addend))
+    return false;
+
+  if ((minus ? my_decimal_add(E_DEC_OK, &result, c2, c1) :
+               my_decimal_sub(E_DEC_OK, &result, c2, c1)) != E_DEC_OK)
+    return false;
+
+  Item *new_value= NULL;
+  longlong int_result;
+  if (addend->result_type() == INT_RESULT &&
+      value->result_type() == INT_RESULT &&
+      my_decimal2int(E_DEC_OK, &result, false, &int_result) == E_DEC_OK)
+    new_value= new Item_int(int_result);
+  else
+    new_value= new Item_decimal(&result);
+  if (new_value == NULL)
+    return true;
+
+  thd->change_item_tree(args + side, field_arg);
+  thd->change_item_tree(args + 1 - side, new_value);
+  field_arg->cmp_context= new_value->cmp_context=
+    item_cmp_type(field_arg->result_type(), new_value->result_type());
+  func->update_used_tables();
+  return func->set_cmp_func();
+}
+
+
+/**
+  Fold constants in the comparisons of a condition: evaluate constant
+  arguments, see fold_const_argument(), and take constants out of
+  additions to and subtractions from integer columns, see
+  fold_additive_argument(). Only the comparisons of AND and OR
+  conditions are looked at, not those inside other functions.
+
+  @param thd   Thread handler
+  @param cond  Condition
+
+  @returns false if success, true if error
+*/
+
+static bool fold_cond_constants(THD *thd, Item *cond)
+{
+  if (cond->type() == Item::COND_ITEM)
+  {
+    List_iterator_fast<Item> li(*down_cast<Item_cond *>(cond)->
+                                argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      if (fold_cond_constants(thd, item))
+        return true;
+    }
+    return false;
+  }
+  if (cond->type() != Item::FUNC_ITEM)
+    return false;
+
+  switch (down_cast<Item_func *>(cond)->functype())
+  {
+  case Item_func::EQ_FUNC:
+  case Item_func::EQUAL_FUNC:
+  case Item_func::NE_FUNC:
+  case Item_func::LT_FUNC:
+  case Item_func::LE_FUNC:
+  case Item_func::GE_FUNC:
+  case Item_func::GT_FUNC:
+    break;
+  default:
+    return false;
+  }
+  Item_bool_func2 *const func= down_cast<Item_bool_func2 *>(cond);
+  return fold_const_argument(thd, func) ||
+         fold_additive_argument(thd, func, 0) ||
+         fold_additive_argument(thd, func, 1);
+}
+
+
+/**
+  Fold constants in the join conditions of a join list and its nests.
+
+  @param thd        Thread handler
+  @param join_list  List of tables
+
+  @returns false if success, true if error
+*/
+
+static bool fold_join_cond_constants(THD *thd, List<TABLE_LIST> *join_list)
+{
+  List_iterator<TABLE_LIST> li(*join_list);
+  TABLE_LIST *table;
+  while ((table= li++))
+  {
+    if (table->nested_join &&
+        fold_join_cond_constants(thd, &table->nested_join->join_list))
+      return true;
+    if (table->join_cond() && fold_cond_constants(thd, table->join_cond()))
+      return true;
+  }
+  return false;
+}
+
+
 /**
   Assign each nested join structure a bit in nested_join_map.
 
@@ -5000,12 +5243,23 @@ bool JOIN::make_join_plan()
   DBUG_ENTER("JOIN::make_join_plan");
 
   SARGABLE_PARAM *sargables= NULL;
+  /*
+    The arrays of update_ref_and_keys() are used only until the sargable
+    predicates are updated from the const tables below. For a join of many
+    tables with multiple equalities they can be large, so they are not
+    left on the MEM_ROOT of the statement until it ends.
+    "key_field_root" has a short lifetime => not instrumented.
+  */
+  MEM_ROOT key_field_root;
 
   Opt_trace_context * const trace= &thd->opt_trace;
 
   if (init_planner_arrays())           // Create and initialize the arrays
     DBUG_RETURN(true);
 
+  init_sql_alloc(PSI_NOT_INSTRUMENTED, &key_field_root, MEM_ROOT_BLOCK_SIZE,
+                 0);
+
   // Outer join dependencies were initialized above, now complete the analysis.
   if (select_lex->outer_join)
     propagate_dependencies();
@@ -5018,8 +5272,11 @@ bool JOIN::make_join_plan()
   {
     if (update_ref_and_keys(thd, &keyuse_array, join_tab, tables, where_cond,
                             cond_equal, ~select_lex->outer_join, select_lex,
-                            &sargables))
+                            &key_field_root, &sargables))
+    {
+      free_root(&key_field_root, MYF(0));
       DBUG_RETURN(true);
+    }
   }
 
   /*
@@ -5029,7 +5286,10 @@ bool JOIN::make_join_plan()
   */
   if (!select_lex->sj_pullout_done && select_lex->sj_nests.elements &&
       pull_out_semijoin_tables(this))
+  {
+    free_root(&key_field_root, MYF(0));
     DBUG_RETURN(true);
+  }
 
   select_lex->sj_pullout_done= true;
   const uint sj_nests= select_lex->sj_nests.elements; // Changed by pull-out
@@ -5037,16 +5297,17 @@ bool JOIN::make_join_plan()
   if (!(select_lex->active_options() & OPTION_NO_CONST_TABLES))
   {
     // Detect tables that are const (0 or 1 row) and read their contents. 
-    if (extract_const_tables())
-      DBUG_RETURN(true);
-
     // Detect tables that are functionally dependent on const values.
-    if (extract_func_dependent_tables())
+    if (extract_const_tables() || extract_func_dependent_tables())
+    {
+      free_root(&key_field_root, MYF(0));
       DBUG_RETURN(true);
+    }
   }
   // Possibly able to create more sargable predicates from const rows.
   if (const_tables && sargables)
     update_sargable_from_const(sargables);
+  free_root(&key_field_root, MYF(0));
 
   // Make a first estimate of the fanout for each table in the query block.
   if (estimate_rowcount())
@@ -8078,6 +8339,9 @@ add_group_and_distinct_keys(JOIN *join, JOIN_TAB *join_tab)
                               for which we can make ref access based the WHERE
                               clause)
   @param       select_lex     current SELECT
+  @param       key_field_root MEM_ROOT for the arrays of Key_field and of
+                              sargable candidates, which are not needed once
+                              the caller is done with the sargables
   @param[out]  sargables      Array of found sargable candidates
       
    @retval
@@ -8090,7 +8354,7 @@ static bool
 update_ref_and_keys(THD *thd, Key_use_array *keyuse,JOIN_TAB *join_tab,
                     uint tables, Item *cond, COND_EQUAL *cond_equal,
                     table_map normal_tables, SELECT_LEX *select_lex,
-                    SARGABLE_PARAM **sargables)
+                    MEM_ROOT *key_field_root, SARGABLE_PARAM **sargables)
 {
   uint	and_level,i,found_eq_constant;
   Key_field *key_fields, *end, *field;
@@ -8121,7 +8385,7 @@ update_ref_and_keys(THD *thd, Key_use_array *keyuse,JOIN_TAB *join_tab,
   sz= max(sizeof(Key_field), sizeof(SARGABLE_PARAM)) *
     (((select_lex->cond_count + 1) * 2 +
       select_lex->between_count) * m + 1);
-  if (!(key_fields=(Key_field*)	thd->alloc(sz)))
+  if (!(key_fields=(Key_field*)	alloc_root(key_field_root, sz)))
     return TRUE; /* purecov: inspected */
   and_level= 0;
   field= end= key_fields;
@@ -8183,6 +8447,18 @@ update_ref_and_keys(THD *thd, Key_use_array *keyuse,JOIN_TAB *join_tab,
     if (join->generate_derived_keys())
       return true;
   }
+  /*
+    Reserve room for the key parts of all key fields, and the end marker,
+    at once: each time the array grows while they are added, the smaller
+    copy is left behind on the MEM_ROOT of the statement.
+  */
+  size_t keyuse_count= keyuse->size() + 1;
+  for (const Key_field *fld= field; fld != end; fld++)
+    keyuse_count+=
+      my_count_bits(fld->item_field->field->part_of_key.to_ulonglong());
+  if (keyuse->reserve(keyuse_count))
+    return true;
+
   /* fill keyuse with found key parts */
   for ( ; field != end ; field++)
   {
@@ -8331,6 +8607,7 @@ void JOIN::mark_const_table(JOIN_TAB *tab, Key_use *key)
   position->loosescan_key= MAX_KEY;    // Not a LooseScan
   position->sj_strategy= SJ_OPT_NONE;
   positions->use_join_buffer= false;
+  positions->use_hash_join= false;
 
   // Move the const table as far down as possible in best_ref
   JOIN_TAB **pos= best_ref + const_tables + 1;
@@ -9879,6 +10156,8 @@ ORDER *JOIN::remove_const(ORDER *first_order, Item *cond, bool change_list,
 /**
   Optimize conditions by 
 
+     0) with the constant_folding optimizer switch, folding constants in
+        the comparisons of a WHERE condition, see fold_cond_constants().
      a) applying transitivity to build multiple equality predicates
         (MEP): if x=y and y=z the MEP x=y=z is built. 
      b) apply constants where possible. If the value of x is known to be
@@ -9919,6 +10198,22 @@ bool optimize_cond(THD *thd, Item **cond, COND_EQUAL **cond_equal,
   */
   DBUG_ASSERT(*cond || join_list);
 
+  /*
+    Evaluate the constant arguments of comparisons, and take constants out
+    of arithmetic on integer columns, so that the steps below and the range
+    optimizer find more comparisons of a field with a constant.
+  */
+  if (join_list &&
+      thd->optimizer_switch_flag(OPTIMIZER_SWITCH_CONSTANT_FOLDING))
+  {
+    Opt_trace_object step_wrapper(trace);
+    step_wrapper.add_alnum("transformation", "constant_folding");
+    if ((*cond && fold_cond_constants(thd, *cond)) ||
+        fold_join_cond_constants(thd, join_list))
+      DBUG_RETURN(true);
+    step_wrapper.add("resulting_condition", *cond);
+  }
+
   /*
     Build all multiple equality predicates and eliminate equality
     predicates that can be inferred from these multiple equalities.
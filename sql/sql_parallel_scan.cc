@@ -0,0 +1,943 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Parallel aggregation for single table GROUP BY scans, see
+  parallel_group_scan().
+*/
+
+#include "sql_parallel_scan.h"
+
+#include "item_sum.h"                           // Item_sum
+#include "mysqld.h"                             // key_memory_*
+#include "records.h"                            // rr_sequential
+#include "sql_batch_filter.h"                   // Batch_filter
+#include "sql_class.h"                          // THD
+#include "sql_optimizer.h"                      // JOIN
+#include "sql_tmp_table.h"                      // Temp_table_param
+
+#include "mysql/psi/mysql_thread.h"
+
+#include <algorithm>
+
+/** Number of rows in each batch handed to a worker */
+static const uint PARALLEL_SCAN_BATCH_ROWS= 512;
+
+/** Sums are kept as hi * 2^32 + lo, with lo within (-2^62, 2^62) */
+static const longlong SUM_LO_LIMIT= 1LL << 62;
+static const longlong SUM_HI_UNIT= 1LL << 32;
+
+
+/** Partial result of one aggregate function for one group */
+
+struct Agg_state
+{
+  /** Number of rows with a non-NULL argument */
+  longlong count;
+  longlong sum_lo, sum_hi;
+  /** Smallest or largest argument, valid when count > 0 */
+  longlong value;
+};
+
+
+static inline void normalize_sum(Agg_state *state)
+{
+  const longlong carry= state->sum_lo / SUM_HI_UNIT;
+  state->sum_hi+= carry;
+  state->sum_lo-= carry * SUM_HI_UNIT;
+}
+
+
+/**
+  Hash table of partial groups, owned by one thread.
+
+  Each entry holds the GROUP BY values of the group, the partial results
+  of the aggregate functions and the first row of the group that was
+  seen, which provides the values of the other columns of the select list
+  when the group is written to the tmp table. Entries are stored back to
+  back in one buffer, and chained from the buckets by their number.
+  The buffers are not grown beyond a size limit, like an in-memory tmp
+  table is not.
+*/
+
+class Group_table
+{
+public:
+  Group_table(uint key_parts, uint agg_count, uint reclength,
+              size_t size_limit)
+    : m_key_parts(key_parts), m_agg_count(agg_count), m_reclength(reclength),
+      m_nulls_offset(HEADER_SIZE + key_parts * sizeof(longlong)),
+      m_aggs_offset(m_nulls_offset + ALIGN_SIZE(key_parts)),
+      m_row_offset(m_aggs_offset + agg_count * sizeof(Agg_state)),
+      m_entry_size(m_row_offset + ALIGN_SIZE(reclength)),
+      m_entries(NULL), m_entry_count(0), m_entry_capacity(0),
+      m_buckets(NULL), m_bucket_count(0),
+      m_size_limit(size_limit), m_over_limit(false)
+  {}
+
+  ~Group_table()
+  {
+    my_free(m_entries);
+    my_free(m_buckets);
+  }
+
+  /**
+    Find the group with the given key, or add it with 'row' as its first
+    row and empty aggregates.
+
+    @return The entry number, or NO_ENTRY if out of memory or if the
+            size limit would be exceeded, see over_limit()
+  */
+  uint find_or_add(const longlong *keys, const uchar *key_nulls,
+                   uint32 hash, const uchar *row)
+  {
+    if (m_bucket_count > 0)
+    {
+      for (uint no= m_buckets[hash & (m_bucket_count - 1)]; no != NO_ENTRY;
+           no= header(no)->next)
+      {
+        if (header(no)->hash == hash &&
+            !memcmp(entry(no) + HEADER_SIZE, keys,
+                    m_key_parts * sizeof(longlong)) &&
+            !memcmp(entry(no) + m_nulls_offset, key_nulls, m_key_parts))
+          return no;
+      }
+    }
+    if (m_entry_count * 2 >= m_bucket_count && grow_buckets())
+      return NO_ENTRY;
+    if (m_entry_count == m_entry_capacity && grow_entries())
+      return NO_ENTRY;
+
+    const uint no= m_entry_count++;
+    uchar *const e= entry(no);
+    Entry_header *const h= header(no);
+    h->hash= hash;
+    h->next= m_buckets[hash & (m_bucket_count - 1)];
+    m_buckets[hash & (m_bucket_count - 1)]= no;
+    memcpy(e + HEADER_SIZE, keys, m_key_parts * sizeof(longlong));
+    memcpy(e + m_nulls_offset, key_nulls, m_key_parts);
+    memset(e + m_aggs_offset, 0, m_agg_count * sizeof(Agg_state));
+    memcpy(e + m_row_offset, row, m_reclength);
+    return no;
+  }
+
+  uint entry_count() const { return m_entry_count; }
+  /** Whether an entry could not be added because of the size limit */
+  bool over_limit() const { return m_over_limit; }
+  void set_size_limit(size_t size_limit) { m_size_limit= size_limit; }
+  uint32 hash(uint no) const { return header(no)->hash; }
+  const longlong *keys(uint no) const
+  { return reinterpret_cast<const longlong *>(entry(no) + HEADER_SIZE); }
+  const uchar *key_nulls(uint no) const { return entry(no) + m_nulls_offset; }
+  Agg_state *aggs(uint no)
+  { return reinterpret_cast<Agg_state *>(entry(no) + m_aggs_offset); }
+  const uchar *row(uint no) const { return entry(no) + m_row_offset; }
+
+  static const uint NO_ENTRY= UINT_MAX32;
+
+private:
+  struct Entry_header
+  {
+    uint32 hash;
+    uint32 next;
+  };
+  static const uint HEADER_SIZE= ALIGN_SIZE(sizeof(Entry_header));
+
+  uchar *entry(uint no) const
+  { return m_entries + static_cast<size_t>(no) * m_entry_size; }
+  Entry_header *header(uint no) const
+  { return reinterpret_cast<Entry_header *>(entry(no)); }
+
+  /** Check that buffers of the given sizes fit within the size limit */
+  bool check_size(uint entry_capacity, uint bucket_count)
+  {
+    if (static_cast<size_t>(entry_capacity) * m_entry_size +
+        static_cast<size_t>(bucket_count) * sizeof(uint) <= m_size_limit)
+      return false;
+    m_over_limit= true;
+    return true;
+  }
+
+  bool grow_entries()
+  {
+    const uint capacity= m_entry_capacity ? m_entry_capacity * 2 : 64;
+    if (check_size(capacity, m_bucket_count))
+      return true;
+    uchar *entries= static_cast<uchar *>(
+      my_realloc(key_memory_Parallel_group_scan, m_entries,
+                 static_cast<size_t>(capacity) * m_entry_size,
+                 MYF(MY_ALLOW_ZERO_PTR)));
+    if (entries == NULL)
+      return true;
+    m_entries= entries;
+    m_entry_capacity= capacity;
+    return false;
+  }
+
+  bool grow_buckets()
+  {
+    const uint count= m_bucket_count ? m_bucket_count * 2 : 128;
+    if (check_size(m_entry_capacity, count))
+      return true;
+    uint *buckets= static_cast<uint *>(
+      my_malloc(key_memory_Parallel_group_scan, count * sizeof(uint),
+                MYF(0)));
+    if (buckets == NULL)
+      return true;
+    my_free(m_buckets);
+    m_buckets= buckets;
+    m_bucket_count= count;
+    for (uint i= 0; i < count; i++)
+      m_buckets[i]= NO_ENTRY;
+    for (uint no= 0; no < m_entry_count; no++)
+    {
+      Entry_header *const h= header(no);
+      h->next= m_buckets[h->hash & (count - 1)];
+      m_buckets[h->hash & (count - 1)]= no;
+    }
+    return false;
+  }
+
+  const uint m_key_parts, m_agg_count, m_reclength;
+  const size_t m_nulls_offset, m_aggs_offset, m_row_offset, m_entry_size;
+  uchar *m_entries;
+  uint m_entry_count, m_entry_capacity;
+  uint *m_buckets;
+  uint m_bucket_count;
+  size_t m_size_limit;
+  bool m_over_limit;
+};
+
+
+static uint32 group_hash(const longlong *keys, const uchar *key_nulls,
+                         uint key_parts)
+{
+  ulonglong h= 0;
+  for (uint i= 0; i < key_parts; i++)
+  {
+    h= (h ^ static_cast<ulonglong>(key_nulls[i] ? 0 : keys[i])) *
+      0x9E3779B97F4A7C15ULL;
+    h^= key_nulls[i] + (h >> 29);
+  }
+  return static_cast<uint32>(h >> 32);
+}
+
+
+class Parallel_group_scan;
+
+/** State of one worker thread */
+
+struct Scan_worker
+{
+  Parallel_group_scan *scan;
+  Batch_filter *filter;
+  Group_table *groups;
+  longlong *key_values;
+  uchar *key_nulls;
+  my_thread_handle thread;
+  bool started;
+  /** Number of rows that passed the WHERE condition */
+  ha_rows rows_selected;
+};
+
+
+/** Coordinator of a parallel GROUP BY scan, runs in the session thread */
+
+class Parallel_group_scan
+{
+public:
+  Parallel_group_scan(JOIN *join, QEP_TAB *tab, QEP_TAB *tmp_tab,
+                      uint worker_count)
+    : m_join(join), m_tab(tab), m_tmp_tab(tmp_tab), m_table(tab->table()),
+      m_reclength(tab->table()->s->reclength),
+      m_size_limit(static_cast<size_t>(
+        std::min(join->thd->variables.tmp_table_size,
+                 join->thd->variables.max_heap_table_size))),
+      m_values(NULL), m_key_parts(0), m_aggs(NULL), m_agg_count(0),
+      m_workers(NULL), m_worker_count(worker_count),
+      m_batches(NULL), m_batch_rows(NULL), m_batch_count(0),
+      m_free(NULL), m_free_count(0), m_full(NULL), m_full_count(0),
+      m_input_done(false), m_abort(false), m_out_of_memory(false),
+      m_over_limit(false)
+  {
+    mysql_mutex_init(key_LOCK_parallel_group_scan, &m_lock,
+                     MY_MUTEX_INIT_FAST);
+    mysql_cond_init(key_COND_parallel_group_scan, &m_cond);
+  }
+
+  ~Parallel_group_scan();
+
+  bool setup();
+  bool start_workers();
+  enum_nested_loop_state execute();
+  void worker_loop(Scan_worker *worker);
+  /** Whether the scan was abandoned because the groups took too much memory */
+  bool over_limit() const { return m_over_limit; }
+
+private:
+  /** An aggregate function, and the number of its argument in m_values */
+  struct Agg_spec
+  {
+    Item_sum *item;
+    Item_sum::Sumfunctype type;
+    uint value_no;
+  };
+
+  void stop_workers(bool abort);
+  void aggregate_batch(Scan_worker *worker, const uchar *rows, uint count);
+  bool merge_groups();
+  enum_nested_loop_state write_groups();
+
+  JOIN *const m_join;
+  QEP_TAB *const m_tab;
+  QEP_TAB *const m_tmp_tab;
+  TABLE *const m_table;
+  const uint m_reclength;
+  /** Memory that the groups of all workers may take together */
+  const size_t m_size_limit;
+
+  /** GROUP BY expressions followed by the aggregate arguments */
+  Item **m_values;
+  uint m_key_parts;
+  Agg_spec *m_aggs;
+  uint m_agg_count;
+
+  Scan_worker *m_workers;
+  uint m_worker_count;
+
+  /** Row buffers, and the number of rows in each */
+  uchar **m_batches;
+  uint *m_batch_rows;
+  uint m_batch_count;
+
+  /** Batches that can be filled, and batches waiting for a worker */
+  mysql_mutex_t m_lock;
+  mysql_cond_t m_cond;
+  uint *m_free;
+  uint m_free_count;
+  uint *m_full;
+  uint m_full_count;
+  bool m_input_done;
+  bool m_abort;
+  bool m_out_of_memory;
+  bool m_over_limit;
+};
+
+
+extern "C" void *parallel_group_scan_worker(void *arg)
+{
+  Scan_worker *const worker= static_cast<Scan_worker *>(arg);
+  if (my_thread_init())
+  {
+    worker->scan->worker_loop(NULL);
+    return NULL;
+  }
+  worker->scan->worker_loop(worker);
+  my_thread_end();
+  return NULL;
+}
+
+
+Parallel_group_scan::~Parallel_group_scan()
+{
+  if (m_workers != NULL)
+  {
+    for (uint i= 0; i < m_worker_count; i++)
+      delete m_workers[i].groups;
+  }
+  if (m_batches != NULL)
+  {
+    for (uint i= 0; i < m_batch_count; i++)
+      my_free(m_batches[i]);
+  }
+  mysql_cond_destroy(&m_cond);
+  mysql_mutex_destroy(&m_lock);
+}
+
+
+/**
+  Check that the query can be executed in parallel, and prepare the
+  filters of the workers.
+
+  @retval false  OK
+  @retval true   The query cannot use a parallel scan
+*/
+
+bool Parallel_group_scan::setup()
+{
+  THD *const thd= m_join->thd;
+  Item_sum **func_ptr;
+  ORDER *group;
+
+  for (group= m_tmp_tab->table()->group; group; group= group->next)
+    m_key_parts++;
+  for (func_ptr= m_join->sum_funcs; *func_ptr; func_ptr++)
+    m_agg_count++;
+
+  m_values= static_cast<Item **>(
+    thd->alloc(sizeof(Item *) * (m_key_parts + m_agg_count)));
+  m_aggs= static_cast<Agg_spec *>(thd->alloc(sizeof(Agg_spec) * m_agg_count));
+  m_workers= static_cast<Scan_worker *>(
+    thd->mem_calloc(sizeof(Scan_worker) * m_worker_count));
+  if (m_values == NULL || m_aggs == NULL || m_workers == NULL)
+    return true;
+
+  uint value_no= 0;
+  for (group= m_tmp_tab->table()->group; group; group= group->next)
+    m_values[value_no++]= *group->item;
+
+  for (uint i= 0; i < m_agg_count; i++)
+  {
+    Item_sum *const item= m_join->sum_funcs[i];
+    Agg_spec *const agg= &m_aggs[i];
+    agg->item= item;
+    agg->type= item->sum_func();
+    agg->value_no= value_no;
+    if (item->get_arg_count() != 1)
+      return true;
+    switch (agg->type)
+    {
+    case Item_sum::COUNT_FUNC:
+      break;
+    case Item_sum::SUM_FUNC:
+    case Item_sum::AVG_FUNC:
+      // Sums of integers are DECIMAL
+      if (item->result_type() != DECIMAL_RESULT)
+        return true;
+      break;
+    case Item_sum::MIN_FUNC:
+    case Item_sum::MAX_FUNC:
+      if (item->result_type() != INT_RESULT)
+        return true;
+      break;
+    default:
+      return true;
+    }
+    m_values[value_no++]= item->get_arg(0);
+  }
+
+  for (uint i= 0; i < m_worker_count; i++)
+  {
+    Scan_worker *const worker= &m_workers[i];
+    worker->scan= this;
+    worker->filter=
+      Batch_filter::create_exact(thd, m_table, m_tab->condition(), m_values,
+                                 value_no, PARALLEL_SCAN_BATCH_ROWS);
+    if (worker->filter == NULL || worker->filter->init_scan(NULL))
+      return true;
+    worker->key_values= static_cast<longlong *>(
+      thd->alloc(sizeof(longlong) * (m_key_parts + 1)));
+    worker->key_nulls= static_cast<uchar *>(thd->alloc(m_key_parts + 1));
+    worker->groups= new (std::nothrow) Group_table(m_key_parts, m_agg_count,
+                                                   m_reclength,
+                                                   m_size_limit /
+                                                   m_worker_count);
+    if (worker->key_values == NULL || worker->key_nulls == NULL ||
+        worker->groups == NULL)
+      return true;
+  }
+
+  // Partial sums must not overflow, see Agg_state
+  for (uint i= 0; i < m_agg_count; i++)
+  {
+    if ((m_aggs[i].type == Item_sum::SUM_FUNC ||
+         m_aggs[i].type == Item_sum::AVG_FUNC) &&
+        m_workers[0].filter->value_bits(m_aggs[i].value_no) > 32)
+      return true;
+  }
+
+  m_batch_count= 2 * m_worker_count;
+  m_batches= static_cast<uchar **>(
+    thd->mem_calloc(sizeof(uchar *) * m_batch_count));
+  m_batch_rows= static_cast<uint *>(thd->alloc(sizeof(uint) * m_batch_count));
+  m_free= static_cast<uint *>(thd->alloc(sizeof(uint) * m_batch_count));
+  m_full= static_cast<uint *>(thd->alloc(sizeof(uint) * m_batch_count));
+  if (m_batches == NULL || m_batch_rows == NULL ||
+      m_free == NULL || m_full == NULL)
+    return true;
+  for (uint i= 0; i < m_batch_count; i++)
+  {
+    m_batches[i]= static_cast<uchar *>(
+      my_malloc(key_memory_Parallel_group_scan,
+                static_cast<size_t>(PARALLEL_SCAN_BATCH_ROWS) * m_reclength,
+                MYF(0)));
+    if (m_batches[i] == NULL)
+      return true;
+    m_free[m_free_count++]= i;
+  }
+  return false;
+}
+
+
+/**
+  Start the worker threads.
+
+  @retval false  At least one worker is running
+  @retval true   No worker could be started
+*/
+
+bool Parallel_group_scan::start_workers()
+{
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+
+  uint started= 0;
+  for (uint i= 0; i < m_worker_count; i++)
+  {
+    Scan_worker *const worker= &m_workers[i];
+    if (mysql_thread_create(key_thread_parallel_group_scan, &worker->thread,
+                            &attr, parallel_group_scan_worker, worker))
+      break;
+    worker->started= true;
+    started++;
+  }
+  my_thread_attr_destroy(&attr);
+  return started == 0;
+}
+
+
+/**
+  Tell the workers that there are no more batches, and wait for them.
+
+  @param abort  Stop without processing the remaining batches
+*/
+
+void Parallel_group_scan::stop_workers(bool abort)
+{
+  mysql_mutex_lock(&m_lock);
+  m_input_done= true;
+  if (abort)
+    m_abort= true;
+  mysql_cond_broadcast(&m_cond);
+  mysql_mutex_unlock(&m_lock);
+
+  for (uint i= 0; i < m_worker_count; i++)
+  {
+    if (m_workers[i].started)
+    {
+      my_thread_join(&m_workers[i].thread, NULL);
+      m_workers[i].started= false;
+    }
+  }
+}
+
+
+void Parallel_group_scan::worker_loop(Scan_worker *worker)
+{
+  mysql_mutex_lock(&m_lock);
+  if (worker == NULL)
+  {
+    // The thread could not be initialized
+    m_out_of_memory= m_abort= true;
+    mysql_cond_broadcast(&m_cond);
+    mysql_mutex_unlock(&m_lock);
+    return;
+  }
+  for (;;)
+  {
+    while (m_full_count == 0 && !m_input_done && !m_abort)
+      mysql_cond_wait(&m_cond, &m_lock);
+    if (m_abort || m_full_count == 0)
+      break;
+    const uint batch= m_full[--m_full_count];
+    mysql_mutex_unlock(&m_lock);
+
+    aggregate_batch(worker, m_batches[batch], m_batch_rows[batch]);
+
+    mysql_mutex_lock(&m_lock);
+    m_free[m_free_count++]= batch;
+    mysql_cond_broadcast(&m_cond);
+  }
+  mysql_mutex_unlock(&m_lock);
+}
+
+
+/**
+  Filter the rows of a batch, and add the rows that pass to the partial
+  groups of the worker.
+*/
+
+void Parallel_group_scan::aggregate_batch(Scan_worker *worker,
+                                          const uchar *rows, uint count)
+{
+  Batch_filter *const filter= worker->filter;
+  Group_table *const groups= worker->groups;
+  const uchar *const selected= filter->evaluate(rows, count);
+
+  for (uint row= 0; row < count; row++)
+  {
+    if (selected != NULL && !selected[row])
+      continue;
+    worker->rows_selected++;
+
+    for (uint i= 0; i < m_key_parts; i++)
+    {
+      worker->key_nulls[i]= filter->nulls(i)[row];
+      worker->key_values[i]= worker->key_nulls[i] ? 0 :
+                                                    filter->values(i)[row];
+    }
+    const uint32 hash= group_hash(worker->key_values, worker->key_nulls,
+                                  m_key_parts);
+    const uint no= groups->find_or_add(worker->key_values, worker->key_nulls,
+                                       hash, rows + row * m_reclength);
+    if (no == Group_table::NO_ENTRY)
+    {
+      mysql_mutex_lock(&m_lock);
+      if (groups->over_limit())
+        m_over_limit= true;
+      else
+        m_out_of_memory= true;
+      m_abort= true;
+      mysql_cond_broadcast(&m_cond);
+      mysql_mutex_unlock(&m_lock);
+      return;
+    }
+
+    Agg_state *const state= groups->aggs(no);
+    for (uint i= 0; i < m_agg_count; i++)
+    {
+      const Agg_spec &agg= m_aggs[i];
+      if (filter->nulls(agg.value_no)[row])
+        continue;
+      const longlong value= filter->values(agg.value_no)[row];
+      Agg_state *const s= &state[i];
+      switch (agg.type)
+      {
+      case Item_sum::SUM_FUNC:
+      case Item_sum::AVG_FUNC:
+        s->sum_lo+= value;
+        if (s->sum_lo > SUM_LO_LIMIT || s->sum_lo < -SUM_LO_LIMIT)
+          normalize_sum(s);
+        break;
+      case Item_sum::MIN_FUNC:
+        if (s->count == 0 || value < s->value)
+          s->value= value;
+        break;
+      case Item_sum::MAX_FUNC:
+        if (s->count == 0 || value > s->value)
+          s->value= value;
+        break;
+      default:
+        break;
+      }
+      s->count++;
+    }
+  }
+}
+
+
+/**
+  Merge the partial groups of all workers into those of the first one,
+  which may then take all the memory the groups may take together. The
+  groups of the other workers are freed as they are merged.
+
+  @retval false  OK
+  @retval true   Out of memory, or the size limit was exceeded if
+                 m_over_limit is set
+*/
+
+bool Parallel_group_scan::merge_groups()
+{
+  Group_table *const result= m_workers[0].groups;
+  result->set_size_limit(m_size_limit);
+  for (uint w= 1; w < m_worker_count; w++)
+  {
+    Group_table *const groups= m_workers[w].groups;
+    for (uint no= 0; no < groups->entry_count(); no++)
+    {
+      const uint to= result->find_or_add(groups->keys(no),
+                                         groups->key_nulls(no),
+                                         groups->hash(no), groups->row(no));
+      if (to == Group_table::NO_ENTRY)
+      {
+        m_over_limit= result->over_limit();
+        return true;
+      }
+      Agg_state *const to_state= result->aggs(to);
+      const Agg_state *const from_state= groups->aggs(no);
+      for (uint i= 0; i < m_agg_count; i++)
+      {
+        Agg_state *const s= &to_state[i];
+        Agg_state from= from_state[i];
+        if (from.count == 0)
+          continue;
+        switch (m_aggs[i].type)
+        {
+        case Item_sum::SUM_FUNC:
+        case Item_sum::AVG_FUNC:
+          normalize_sum(s);
+          normalize_sum(&from);
+          s->sum_hi+= from.sum_hi;
+          s->sum_lo+= from.sum_lo;
+          break;
+        case Item_sum::MIN_FUNC:
+          if (s->count == 0 || from.value < s->value)
+            s->value= from.value;
+          break;
+        case Item_sum::MAX_FUNC:
+          if (s->count == 0 || from.value > s->value)
+            s->value= from.value;
+          break;
+        default:
+          break;
+        }
+        s->count+= from.count;
+      }
+    }
+    delete groups;
+    m_workers[w].groups= NULL;
+  }
+  return false;
+}
+
+
+/**
+  Write the merged groups into the GROUP BY tmp table, the way end_update()
+  writes a new group, with the aggregates taken from the workers.
+*/
+
+enum_nested_loop_state Parallel_group_scan::write_groups()
+{
+  THD *const thd= m_join->thd;
+  TABLE *const tmp_table= m_tmp_tab->table();
+  Temp_table_param *const tmp_tbl= m_tmp_tab->tmp_table_param;
+  Group_table *const groups= m_workers[0].groups;
+  QEP_tmp_table *const op= static_cast<QEP_tmp_table *>(m_tmp_tab->op);
+
+  if (!tmp_table->file->inited && op->prepare_tmp_table())
+    return NESTED_LOOP_ERROR;
+
+  my_decimal hi_unit, hi, lo, shifted, sum;
+  int2my_decimal(E_DEC_FATAL_ERROR, SUM_HI_UNIT, FALSE, &hi_unit);
+
+  for (uint no= 0; no < groups->entry_count(); no++)
+  {
+    if (thd->killed)
+    {
+      thd->send_kill_message();
+      return NESTED_LOOP_KILLED;
+    }
+    // The other columns of the select list come from the first row
+    memcpy(m_table->record[0], groups->row(no), m_reclength);
+    if (copy_fields(tmp_tbl, thd))
+      return NESTED_LOOP_ERROR;
+    store_group_key(tmp_table);
+    if (init_new_group_record(m_join, m_tmp_tab))
+      return NESTED_LOOP_ERROR;
+
+    Agg_state *const state= groups->aggs(no);
+    for (uint i= 0; i < m_agg_count; i++)
+    {
+      Agg_state *const s= &state[i];
+      if (m_aggs[i].type == Item_sum::SUM_FUNC ||
+          m_aggs[i].type == Item_sum::AVG_FUNC)
+      {
+        normalize_sum(s);
+        int2my_decimal(E_DEC_FATAL_ERROR, s->sum_hi, FALSE, &hi);
+        int2my_decimal(E_DEC_FATAL_ERROR, s->sum_lo, FALSE, &lo);
+        my_decimal_mul(E_DEC_FATAL_ERROR, &shifted, &hi, &hi_unit);
+        my_decimal_add(E_DEC_FATAL_ERROR, &sum, &shifted, &lo);
+      }
+      m_aggs[i].item->store_partial_result(s->count, &sum, s->value);
+    }
+
+    const enum_nested_loop_state rc= write_new_group_record(m_join,
+                                                            m_tmp_tab);
+    if (rc != NESTED_LOOP_OK)
+      return rc;
+  }
+  return NESTED_LOOP_OK;
+}
+
+
+enum_nested_loop_state Parallel_group_scan::execute()
+{
+  THD *const thd= m_join->thd;
+  READ_RECORD *const info= &m_tab->read_record;
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  ha_rows rows_read= 0;
+  DBUG_ENTER("Parallel_group_scan::execute");
+
+  for (;;)
+  {
+    if (thd->killed)
+    {
+      thd->send_kill_message();
+      rc= NESTED_LOOP_KILLED;
+      break;
+    }
+
+    mysql_mutex_lock(&m_lock);
+    while (m_free_count == 0 && !m_abort)
+      mysql_cond_wait(&m_cond, &m_lock);
+    if (m_abort)
+    {
+      mysql_mutex_unlock(&m_lock);
+      break;
+    }
+    const uint batch= m_free[--m_free_count];
+    mysql_mutex_unlock(&m_lock);
+
+    uchar *const rows= m_batches[batch];
+    uint count= 0;
+    int error= 0;
+    while (count < PARALLEL_SCAN_BATCH_ROWS &&
+           !(error= rr_sequential(info)))
+      memcpy(rows + count++ * m_reclength, info->record, m_reclength);
+    rows_read+= count;
+
+    mysql_mutex_lock(&m_lock);
+    if (count > 0)
+    {
+      m_batch_rows[batch]= count;
+      m_full[m_full_count++]= batch;
+    }
+    else
+      m_free[m_free_count++]= batch;
+    mysql_cond_broadcast(&m_cond);
+    mysql_mutex_unlock(&m_lock);
+
+    if (error > 0 || thd->is_error())
+      rc= NESTED_LOOP_ERROR;
+    if (error)
+      break;
+  }
+
+  stop_workers(rc != NESTED_LOOP_OK);
+  if (m_out_of_memory || rc != NESTED_LOOP_OK)
+  {
+    m_over_limit= false;
+    m_join->examined_rows+= rows_read;
+    if (m_out_of_memory)
+    {
+      my_error(ER_OUTOFMEMORY, MYF(ME_FATALERROR), 0);
+      rc= NESTED_LOOP_ERROR;
+    }
+    DBUG_RETURN(rc);
+  }
+
+  if (!m_over_limit && merge_groups() && !m_over_limit)
+  {
+    my_error(ER_OUTOFMEMORY, MYF(ME_FATALERROR), 0);
+    DBUG_RETURN(NESTED_LOOP_ERROR);
+  }
+  // The rows are read again by the serial scan, see parallel_group_scan()
+  if (m_over_limit)
+    DBUG_RETURN(NESTED_LOOP_OK);
+
+  m_join->examined_rows+= rows_read;
+  for (uint i= 0; i < m_worker_count; i++)
+    m_join->found_records+= m_workers[i].rows_selected;
+  DBUG_PRINT("info", ("%u groups from %lu rows",
+                      m_workers[0].groups->entry_count(),
+                      (ulong) rows_read));
+  DBUG_RETURN(write_groups());
+}
+
+
+/**
+  Check the parts of the plan that a parallel scan depends on.
+
+  @return The tmp table that the groups are written to, or NULL if the
+          query cannot use a parallel scan
+*/
+
+static QEP_TAB *parallel_group_scan_tmp_table(JOIN *join)
+{
+  THD *const thd= join->thd;
+
+  if (thd->lex->sql_command != SQLCOM_SELECT ||
+      join->select_lex->master_unit()->item != NULL ||
+      join->primary_tables != 1 || join->const_tables != 0 ||
+      join->tmp_tables != 1 ||
+      join->rollup.state != ROLLUP::STATE_NONE ||
+      join->sum_funcs == NULL || *join->sum_funcs == NULL)
+    return NULL;
+
+  QEP_TAB *const tab= join->qep_tab;
+  TABLE *const table= tab->table();
+  if (tab->type() != JT_ALL || tab->quick() != NULL ||
+      tab->filesort != NULL || tab->distinct ||
+      tab->materialize_table != NULL || tab->op != NULL ||
+      tab->next_select != sub_select_op ||
+      tab->keep_current_rowid || tab->copy_current_rowid != NULL ||
+      table->s->blob_fields != 0 ||
+      (table->reginfo.lock_type != TL_READ &&
+       table->reginfo.lock_type != TL_READ_HIGH_PRIORITY))
+    return NULL;
+
+  // The groups are written as end_update() would, see
+  // setup_tmptable_write_func()
+  QEP_TAB *const tmp_tab= join->qep_tab + join->primary_tables;
+  TABLE *const tmp_table= tmp_tab->table();
+  Temp_table_param *const tmp_tbl= tmp_tab->tmp_table_param;
+  if (tmp_tab->op == NULL || tmp_tab->op->type() != QEP_operation::OT_TMP_TABLE ||
+      tmp_table == NULL || tmp_table->group == NULL ||
+      tmp_table->hash_field != NULL || tmp_table->s->keys == 0 ||
+      tmp_tbl->sum_func_count == 0 || tmp_tbl->precomputed_group_by)
+    return NULL;
+  return tmp_tab;
+}
+
+
+bool parallel_group_scan(JOIN *join, enum_nested_loop_state *rc)
+{
+  THD *const thd= join->thd;
+  const uint degree= thd->variables.parallel_query_degree;
+  DBUG_ENTER("parallel_group_scan");
+
+  if (degree < 2)
+    DBUG_RETURN(false);
+  QEP_TAB *const tmp_tab= parallel_group_scan_tmp_table(join);
+  if (tmp_tab == NULL)
+    DBUG_RETURN(false);
+
+  QEP_TAB *const tab= join->qep_tab;
+  tab->table()->reset_null_row();
+  if (tab->read_first_record != join_init_read_record ||
+      init_read_record(&tab->read_record, thd, NULL, tab, 1, 1, FALSE))
+    DBUG_RETURN(false);
+  if (tab->read_record.read_record != rr_sequential)
+  {
+    end_read_record(&tab->read_record);
+    DBUG_RETURN(false);
+  }
+
+  Parallel_group_scan scan(join, tab, tmp_tab, degree);
+  if (scan.setup() || scan.start_workers())
+  {
+    // Leave the scan to sub_select(), which initializes it again
+    end_read_record(&tab->read_record);
+    DBUG_RETURN(false);
+  }
+  DBUG_PRINT("info", ("parallel scan of %s with %u threads",
+                      tab->table()->alias, degree));
+  *rc= scan.execute();
+  if (scan.over_limit())
+  {
+    /*
+      The groups do not fit in memory: aggregate in the tmp table, which
+      is converted to an on-disk table when it gets too large.
+    */
+    DBUG_PRINT("info", ("parallel scan of %s abandoned", tab->table()->alias));
+    end_read_record(&tab->read_record);
+    DBUG_RETURN(false);
+  }
+  DBUG_RETURN(true);
+}
@@ -0,0 +1,63 @@
+#ifndef SQL_PARALLEL_SCAN_INCLUDED
+#define SQL_PARALLEL_SCAN_INCLUDED
+
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/** @file Parallel aggregation for single table GROUP BY scans */
+
+#include "my_global.h"
+#include "sql_executor.h"                       // enum_nested_loop_state
+
+class JOIN;
+
+/**
+  Execute the table scan of a GROUP BY query over a single table with
+  several threads, if the query allows it.
+
+  The session thread reads the rows of the table in batches, because the
+  handler and the transaction belong to it. Worker threads evaluate the
+  WHERE condition for the rows of a batch, and aggregate the rows that
+  pass into a hash table of partial groups of their own. When the scan is
+  done, the partial groups of the workers are merged, and each group is
+  written into the GROUP BY tmp table of the query, from which the result
+  is sent as usual.
+
+  The partial groups of all workers together may take as much memory as
+  an in-memory tmp table, min(tmp_table_size, max_heap_table_size). If
+  they take more, the parallel scan is abandoned before anything is
+  written into the tmp table, and false is returned so that the query is
+  executed serially.
+
+  This is done when thd->variables.parallel_query_degree is larger than 1
+  for queries where
+  - the table is scanned with rr_sequential() by a plain SELECT,
+  - grouping is done with end_update() in a tmp table,
+  - the WHERE condition, the GROUP BY expressions and the arguments of the
+    aggregate functions can be evaluated by Batch_filter, and
+  - all aggregate functions are COUNT, SUM, AVG, MIN or MAX without
+    DISTINCT.
+
+  @param      join  Query to execute
+  @param[out] rc    Result of the scan, if it was done
+
+  @retval true   The scan was done, the tmp table holds all groups
+  @retval false  The query cannot use a parallel scan, or the groups did
+                 not fit in memory; the tmp table is untouched
+*/
+
+bool parallel_group_scan(JOIN *join, enum_nested_loop_state *rc);
+
+#endif /* SQL_PARALLEL_SCAN_INCLUDED */
@@ -54,6 +54,7 @@
 #include "sql_rename.h"       // mysql_rename_tables
 #include "sql_select.h"       // handle_query
 #include "sql_show.h"         // find_schema_table
+#include "sql_stmt_template.h" // stmt_template_cache_execute
 #include "sql_table.h"        // mysql_create_table
 #include "sql_tablespace.h"   // mysql_alter_tablespace
 #include "sql_test.h"         // mysql_print_status
@@ -5464,7 +5465,10 @@ void mysql_parse(THD *thd, Parser_state *parser_state)
 
     bool err= thd->get_stmt_da()->is_error();
 
-    if (!err)
+    /* A SELECT that only differs in literals from an earlier one */
+    const bool from_template= !err && stmt_template_cache_execute(thd);
+
+    if (!err && !from_template)
     {
       err= parse_sql(thd, parser_state, NULL);
       if (!err)
@@ -5473,7 +5477,7 @@ void mysql_parse(THD *thd, Parser_state *parser_state)
       found_semicolon= parser_state->m_lip.found_semicolon;
     }
 
-    if (!err)
+    if (!err && !from_template)
     {
       /*
         Rewrite the query for logging and for the Performance Schema statement
@@ -5526,7 +5530,7 @@ void mysql_parse(THD *thd, Parser_state *parser_state)
       }
     }
 
-    if (!err)
+    if (!err && !from_template)
     {
       thd->m_statement_psi= MYSQL_REFINE_STATEMENT(thd->m_statement_psi,
                                                    sql_statement_info[thd->lex->sql_command].m_key);
@@ -5585,7 +5589,7 @@ void mysql_parse(THD *thd, Parser_state *parser_state)
         }
       }
     }
-    else
+    else if (err)
     {
       /*
         Log the failed raw query in the Performance Schema. This statement did not
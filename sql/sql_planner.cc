@@ -30,9 +30,11 @@
 #include "opt_range.h"
 #include "opt_trace.h"
 #include "sql_executor.h"
+#include "sql_join_buffer.h"  // hash_join_compatible_fields()
 #include "merge_sort.h"
 #include <my_bit.h>
 #include "opt_hints.h"   // hint_table_state()
+#include "opt_plan_cache.h" // Cached_join_order
 #include "parse_tree_hints.h"
 
 #include <algorithm>
@@ -886,6 +888,91 @@ Optimize_table_order::calculate_scan_cost(const JOIN_TAB *tab,
   return scan_and_filter_cost;
 }
 
+
+/**
+  Check whether a table is joined to the tables of a partial plan by an
+  equality between columns, so that the rows of the partial plan put into
+  a join buffer can be looked up by hash when the table is scanned.
+
+  @param cond            condition to search for the equality; may be NULL
+  @param tab_map         map of the table to be joined
+  @param prefix_tables   map of the tables in the partial plan
+
+  @return true if a top-level conjunct of the condition equates a column of
+          the table to a column of a table in the partial plan, and the
+          columns can be equated through the key of a hash join
+          (@see hash_join_compatible_fields())
+*/
+
+static bool has_hash_join_equality(Item *cond, table_map tab_map,
+                                   table_map prefix_tables)
+{
+  if (cond == NULL)
+    return false;
+
+  if (cond->type() == Item::COND_ITEM)
+  {
+    if (((Item_cond *) cond)->functype() != Item_func::COND_AND_FUNC)
+      return false;
+    List_iterator<Item> li(*((Item_cond *) cond)->argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      if (has_hash_join_equality(item, tab_map, prefix_tables))
+        return true;
+    }
+    return false;
+  }
+
+  if (cond->type() != Item::FUNC_ITEM)
+    return false;
+
+  prefix_tables&= ~tab_map;
+  Item_func *const func= (Item_func *) cond;
+  if (func->functype() == Item_func::MULT_EQUAL_FUNC)
+  {
+    Item_equal *const item_equal= (Item_equal *) func;
+    if (item_equal->get_const())
+      return false;
+    Item_equal_iterator inner_it(*item_equal);
+    Item_field *inner;
+    while ((inner= inner_it++))
+    {
+      if (inner->used_tables() != tab_map)
+        continue;
+      Item_equal_iterator outer_it(*item_equal);
+      Item_field *outer;
+      while ((outer= outer_it++))
+      {
+        const table_map used= outer->used_tables();
+        uint length;
+        if (used && !(used & ~prefix_tables) &&
+            hash_join_compatible_fields(outer->field, inner->field, &length))
+          return true;
+      }
+    }
+    return false;
+  }
+
+  if (func->functype() == Item_func::EQ_FUNC)
+  {
+    Item *left= func->arguments()[0]->real_item();
+    Item *right= func->arguments()[1]->real_item();
+    if (left->type() != Item::FIELD_ITEM || right->type() != Item::FIELD_ITEM)
+      return false;
+    if (right->used_tables() != tab_map)
+      std::swap(left, right);
+    const table_map outer_used= left->used_tables();
+    uint length;
+    return right->used_tables() == tab_map &&
+           outer_used && !(outer_used & ~prefix_tables) &&
+           hash_join_compatible_fields(((Item_field *) left)->field,
+                                       ((Item_field *) right)->field,
+                                       &length);
+  }
+  return false;
+}
+
 /**
   Find the best access path for an extension of a partial execution
   plan and add this path to the plan.
@@ -917,6 +1004,7 @@ void Optimize_table_order::best_access_path(JOIN_TAB *tab,
 {
   bool found_condition= false;
   bool best_uses_jbuf=  false;
+  bool best_uses_hash_join= false;
   Opt_trace_context * const trace= &thd->opt_trace;
   TABLE *const table= tab->table();
   const Cost_model_server *const cost_model= join->cost_model();
@@ -1080,9 +1168,50 @@ void Optimize_table_order::best_access_path(JOIN_TAB *tab,
       This cost plus scan_cost gives us total cost of using
       TABLE/INDEX/RANGE SCAN.
     */
-    const double scan_total_cost= scan_read_cost +
+    double scan_total_cost= scan_read_cost +
       cost_model->row_evaluate_cost(prefix_rowcount * rows_after_filtering);
 
+    /*
+      With hash join the prefix rows are hashed once when they are put into
+      the join buffer and the scanned rows are hashed once when they are
+      read. The attached condition is then evaluated only for the row
+      combinations with equal join keys, assuming the default selectivity
+      of an equality.
+      The cost accumulated for the partial plan still includes the
+      evaluation of all row combinations as for BNL, which keeps the costs
+      of join orders comparable; the hash join cost decides whether the
+      scan is preferred to 'ref' access and to BNL.
+    */
+    bool use_hash_join= false;
+    bool hash_join_equality= false;
+    if (!disable_jbuf &&
+        thd->optimizer_switch_flag(OPTIMIZER_SWITCH_HASH_JOIN))
+    {
+      const table_map prefix_tables= join->all_table_map & ~remaining_tables;
+      hash_join_equality=
+        has_hash_join_equality(join->where_cond, tab->table_ref->map(),
+                               prefix_tables);
+      for (TABLE_LIST *tl= tab->table_ref;
+           tl != NULL && !hash_join_equality; tl= tl->embedding)
+        hash_join_equality=
+          has_hash_join_equality(tl->join_cond_optim(), tab->table_ref->map(),
+                                 prefix_tables);
+    }
+    if (hash_join_equality)
+    {
+      const double hash_total_cost= scan_read_cost +
+        cost_model->row_evaluate_cost(prefix_rowcount + rows_after_filtering +
+                                      prefix_rowcount * rows_after_filtering *
+                                      COND_FILTER_EQUALITY);
+      trace_access_scan.add("hash_join_cost", hash_total_cost);
+      if (hash_total_cost < scan_total_cost)
+      {
+        scan_total_cost= hash_total_cost;
+        use_hash_join= true;
+      }
+      trace_access_scan.add("using_hash_join", use_hash_join);
+    }
+
     trace_access_scan.add("resulting_rows", rows_after_filtering);
     trace_access_scan.add("cost", scan_total_cost);
 
@@ -1118,6 +1247,7 @@ void Optimize_table_order::best_access_path(JOIN_TAB *tab,
       }
       best_ref=       NULL;
       best_uses_jbuf= !disable_jbuf;
+      best_uses_hash_join= use_hash_join;
       ref_depend_map= 0;
     }
 
@@ -1156,6 +1286,7 @@ void Optimize_table_order::best_access_path(JOIN_TAB *tab,
   pos->ref_depend_map=  ref_depend_map;
   pos->loosescan_key=   MAX_KEY;
   pos->use_join_buffer= best_uses_jbuf;
+  pos->use_hash_join=   best_uses_jbuf && best_uses_hash_join;
 
   if (!best_ref &&
       idx == join->const_tables &&
@@ -1568,6 +1699,7 @@ semijoin_loosescan_fill_driving_table_position(const JOIN_TAB  *tab,
 
   pos->read_cost= DBL_MAX;
   pos->use_join_buffer= false;
+  pos->use_hash_join= false;
 
   Opt_trace_array trace_all_idx(trace, "indexes");
 
@@ -1844,6 +1976,15 @@ bool Optimize_table_order::choose_table_order()
     join->select_lex->active_options() & SELECT_STRAIGHT_JOIN;
   table_map join_tables;      ///< The tables involved in order selection
 
+  /*
+    A prepared statement may keep the join order of an earlier execution,
+    in which case only the access methods are chosen for that order.
+  */
+  const bool cache_order= !emb_sjm_nest &&
+                          Cached_join_order::is_applicable(join);
+  const Cached_join_order *const cached_order=
+    cache_order ? Cached_join_order::get(join) : NULL;
+
   if (emb_sjm_nest)
   {
     /* We're optimizing semi-join materialization nest, so put the 
@@ -1864,7 +2005,9 @@ bool Optimize_table_order::choose_table_order()
         Apply heuristic: pre-sort all access plans with respect to the number of
         records accessed.
     */
-    if (straight_join)
+    if (cached_order)
+      cached_order->apply(join);
+    else if (straight_join)
       merge_sort(join->best_ref + join->const_tables,
                  join->best_ref + join->tables,
                  Join_tab_compare_straight());
@@ -1877,6 +2020,8 @@ bool Optimize_table_order::choose_table_order()
   }
 
   Opt_trace_object wrapper(&join->thd->opt_trace);
+  if (cache_order)
+    wrapper.add("cached_join_order", cached_order != NULL);
   Opt_trace_array
     trace_plan(&join->thd->opt_trace, "considered_execution_plans",
                Opt_trace_context::GREEDY_SEARCH);
@@ -1896,12 +2041,16 @@ bool Optimize_table_order::choose_table_order()
                            Item::WALK_POSTFIX, NULL);
   }
 
-  if (straight_join)
+  if (straight_join || cached_order)
     optimize_straight_join(join_tables);
   else
   {
-    if (greedy_search(join_tables))
+    if (dp_search(join_tables))
+      optimize_straight_join(join_tables);
+    else if (greedy_search(join_tables))
       DBUG_RETURN(true);
+    if (cache_order)
+      Cached_join_order::save(join);
   }
 
   // Remaining part of this function not needed when processing semi-join nests.
@@ -2052,6 +2201,243 @@ void Optimize_table_order::optimize_straight_join(table_map join_tables)
 }
 
 
+/**
+  Add the edges of a condition to the join graph of dp_search(): a
+  conjunct that refers to several tables of the join, for example a
+  multiple equality, connects each of them to the others.
+
+  @param cond         Condition
+  @param join_tables  Tables of the join graph
+  @param[in,out] neighbours  Neighbours of each table, by table number
+*/
+
+static void add_join_graph_edges(Item *cond, table_map join_tables,
+                                 table_map *neighbours)
+{
+  if (cond->type() == Item::COND_ITEM &&
+      down_cast<Item_cond *>(cond)->functype() == Item_func::COND_AND_FUNC)
+  {
+    List_iterator<Item> li(*down_cast<Item_cond *>(cond)->argument_list());
+    Item *item;
+    while ((item= li++))
+      add_join_graph_edges(item, join_tables, neighbours);
+    return;
+  }
+  const table_map tables= cond->used_tables() & join_tables;
+  Table_map_iterator it(tables);
+  int tableno;
+  while ((tableno= it.next_bit()) != Table_map_iterator::BITMAP_END)
+    neighbours[tableno]|= tables & ~((table_map) 1 << tableno);
+}
+
+
+/**
+  A partial plan of dp_search(): the cheapest left-deep order found for a
+  set of tables, kept as the plan for the set without its last table and
+  the position of the last table.
+*/
+
+struct Dp_plan
+{
+  /** Tables of the plan, the key of the memo table; must be first */
+  table_map tables;
+  /** Plan for the tables before the last one */
+  const Dp_plan *prefix;
+  /** Access method and cost of the last table */
+  POSITION position;
+};
+
+
+/**
+  Find the join order of an inner join by dynamic programming over the
+  connected sets of tables of its join graph.
+
+    The join graph has an edge between two tables if a conjunct of the
+    WHERE condition refers to both. For every connected set of tables, the
+    cheapest left-deep plan is kept in a memo table. The plans for sets of
+    k+1 tables are built by appending each neighbouring table to the plans
+    for k tables, so that no plan with a cross product is considered.
+
+    Unlike greedy_search(), which is only exhaustive up to
+    optimizer_search_depth tables, this finds the cheapest left-deep order
+    without cross products. Its cost depends on the number of connected
+    sets rather than on the number of orders: a star join of n tables
+    around one fact table has about 2^(n-1) connected sets, and (n-1)!
+    orders. The search is given up when the memo table would hold more
+    than optimizer_dp_max_plans plans, which bounds the time and memory
+    that it takes.
+
+    The search is only done for query blocks without outer joins and
+    semi-joins, whose join graph is connected. The access methods are
+    chosen by best_access_path(), as in the greedy search; the cost of
+    sorting the result is added by optimize_straight_join() for the chosen
+    order only.
+
+  @param join_tables   set of the tables in the query
+
+  @retval true   The order is in join->best_ref, and the plan is to be
+                 finalized with optimize_straight_join()
+  @retval false  The search was not done or was given up
+*/
+
+bool Optimize_table_order::dp_search(table_map join_tables)
+{
+  const uint max_plans= thd->variables.optimizer_dp_max_plans;
+  const uint first= join->const_tables;
+  const Cost_model_server *const cost_model= join->cost_model();
+  Opt_trace_context *const trace= &thd->opt_trace;
+  DBUG_ENTER("Optimize_table_order::dp_search");
+
+  if (max_plans == 0 || join->tables - first < 3 || has_sj || emb_sjm_nest ||
+      join->select_lex->outer_join || join->where_cond == NULL)
+    DBUG_RETURN(false);
+
+  table_map neighbours[MAX_TABLES];
+  memset(neighbours, 0, sizeof(neighbours));
+  add_join_graph_edges(join->where_cond, join_tables, neighbours);
+
+  // join->map2table is only filled in once the order has been chosen
+  JOIN_TAB *tabs[MAX_TABLES];
+  for (uint i= first; i < join->tables; i++)
+    tabs[join->best_ref[i]->table_ref->tableno()]= join->best_ref[i];
+
+  // Give up unless the join graph is connected
+  table_map reached= join_tables & (~join_tables + 1);
+  for (table_map prev= 0; reached != prev; )
+  {
+    prev= reached;
+    Table_map_iterator it(prev);
+    int tableno;
+    while ((tableno= it.next_bit()) != Table_map_iterator::BITMAP_END)
+      reached|= neighbours[tableno];
+  }
+  if (reached != join_tables)
+  {
+    DBUG_PRINT("info", ("join graph is not connected"));
+    DBUG_RETURN(false);
+  }
+
+  MEM_ROOT root;
+  init_sql_alloc(PSI_NOT_INSTRUMENTED, &root, MEM_ROOT_BLOCK_SIZE, 0);
+  HASH memo;
+  if (my_hash_init(&memo, &my_charset_bin, 1024, 0, sizeof(table_map),
+                   NULL, NULL, 0, PSI_NOT_INSTRUMENTED))
+  {
+    free_root(&root, MYF(0));
+    DBUG_RETURN(false);
+  }
+
+  Mem_root_array<Dp_plan *, true> plans_a(&root), plans_b(&root);
+  Mem_root_array<Dp_plan *, true> *plans= &plans_a;
+  Mem_root_array<Dp_plan *, true> *next_plans= &plans_b;
+  uint plan_count= 0;
+  bool found= true;
+
+  // The plan for no tables, which all plans start with
+  Dp_plan empty;
+  empty.tables= 0;
+  empty.prefix= NULL;
+  plans->push_back(&empty);
+
+  {
+    // The access methods considered here are traced for the chosen order
+    Opt_trace_disable_I_S disable_trace(trace, true);
+
+    for (uint idx= first; idx < join->tables && found; idx++)
+    {
+      next_plans->clear();
+      for (size_t i= 0; i < plans->size() && found; i++)
+      {
+        const Dp_plan *const plan= plans->at(i);
+
+        // Put the plan in join->positions, for best_access_path()
+        uint pos= idx;
+        for (const Dp_plan *p= plan; p->tables != 0; p= p->prefix)
+          join->positions[--pos]= p->position;
+
+        table_map candidates= plan->tables == 0 ? join_tables : 0;
+        Table_map_iterator it(plan->tables);
+        int tableno;
+        while ((tableno= it.next_bit()) != Table_map_iterator::BITMAP_END)
+          candidates|= neighbours[tableno];
+        candidates&= join_tables & ~plan->tables;
+
+        const double prefix_rowcount= plan->tables == 0 ?
+          1.0 : plan->position.prefix_rowcount;
+        POSITION *const position= join->positions + idx;
+
+        Table_map_iterator cand_it(candidates);
+        while ((tableno= cand_it.next_bit()) != Table_map_iterator::BITMAP_END)
+        {
+          JOIN_TAB *const tab= tabs[tableno];
+          // Tables that must come later, as with STRAIGHT_JOIN
+          if (tab->dependent & join_tables & ~plan->tables)
+            continue;
+
+          {
+            Opt_trace_object trace_table(trace);
+            best_access_path(tab, join_tables & ~plan->tables, idx, false,
+                             prefix_rowcount, position);
+          }
+          position->set_prefix_join_cost(idx, cost_model);
+          position->no_semijoin();
+
+          const table_map tables= plan->tables | tab->table_ref->map();
+          Dp_plan *other=
+            reinterpret_cast<Dp_plan *>(my_hash_search(&memo,
+                                        pointer_cast<const uchar *>(&tables),
+                                        sizeof(tables)));
+          if (other == NULL)
+          {
+            if (++plan_count > max_plans ||
+                !(other= static_cast<Dp_plan *>(alloc_root(&root,
+                                                           sizeof(Dp_plan)))))
+            {
+              found= false;
+              break;
+            }
+            other->tables= tables;
+            if (my_hash_insert(&memo, reinterpret_cast<uchar *>(other)) ||
+                next_plans->push_back(other))
+            {
+              found= false;
+              break;
+            }
+          }
+          else if (position->prefix_cost >= other->position.prefix_cost)
+            continue;
+          other->prefix= plan;
+          other->position= *position;
+        }
+        if (thd->killed)
+          found= false;
+      }
+      std::swap(plans, next_plans);
+    }
+  }
+
+  // Dependencies may leave no plan for all tables
+  found= found && plans->size() == 1;
+  if (found)
+  {
+    DBUG_ASSERT(plans->at(0)->tables == join_tables);
+    uint idx= join->tables;
+    for (const Dp_plan *p= plans->at(0); p->tables != 0; p= p->prefix)
+      join->best_ref[--idx]= p->position.table;
+    DBUG_ASSERT(idx == first);
+  }
+
+  Opt_trace_object(trace).
+    add_alnum("join_enumeration", "dynamic_programming").
+    add("partial_plans", plan_count).
+    add("join_order_found", found);
+
+  my_hash_free(&memo);
+  free_root(&root, MYF(0));
+  DBUG_RETURN(found);
+}
+
+
 /**
   Check whether a semijoin materialization strategy is allowed for
   the current (semi)join table order.
@@ -37,7 +37,7 @@ class Opt_trace_object;
   The class has a sole public function that will calculate the most
   optimal plan based on the inputs and the environment, such as prune level
   and greedy optimizer search depth. For more information, see the
-  function headers for the private functions greedy_search(),
+  function headers for the private functions dp_search(), greedy_search(),
   best_extension_by_limited_search() and eq_ref_extension_by_limited_search().
 */
 
@@ -139,6 +139,7 @@ private:
   void backout_nj_state(const table_map remaining_tables,
                         const JOIN_TAB *tab);
   void optimize_straight_join(table_map join_tables);
+  bool dp_search(table_map join_tables);
   bool greedy_search(table_map remaining_tables);
   bool best_extension_by_limited_search(table_map remaining_tables,
                                         uint idx,
@@ -3027,7 +3027,8 @@ Prepared_statement::Prepared_statement(THD *thd_arg)
   flags((uint) IS_IN_USE),
   with_log(false),
   m_name(NULL_CSTR),
-  m_db(NULL_CSTR)
+  m_db(NULL_CSTR),
+  m_template_digest(NULL)
 {
   init_sql_alloc(key_memory_prepared_statement_main_mem_root,
                  &main_mem_root, thd_arg->variables.query_alloc_block_size,
@@ -3253,6 +3254,8 @@ bool Prepared_statement::prepare(const char *query_str, size_t query_length)
   if (is_audit_plugin_class_active(thd, MYSQL_AUDIT_GENERAL_CLASS))
     parser_state.m_input.m_compute_digest= true;
 #endif
+  if (is_template())
+    parser_state.m_input.m_compute_digest= true;
 
   thd->m_parser_state = &parser_state;
   invoke_pre_parse_rewrite_plugins(thd);
@@ -3275,6 +3278,14 @@ bool Prepared_statement::prepare(const char *query_str, size_t query_length)
 
   lex->set_trg_event_type_for_tables();
 
+  /*
+    The digest of a statement template is reported for each statement
+    executed with it. The token array above lives in the arena of the
+    statement, which is replaced on reprepare, so copy it.
+  */
+  if (!error && is_template())
+    m_template_digest->copy(&digest.m_digest_storage);
+
   /*
     Pre-clear the diagnostics area unless a warning was thrown
     during parsing.
@@ -3399,7 +3410,7 @@ bool Prepared_statement::prepare(const char *query_str, size_t query_length)
       sub-statements inside stored procedures are not logged into
       the general log.
     */
-    if (thd->sp_runtime_ctx == NULL)
+    if (thd->sp_runtime_ctx == NULL && !is_template())
     {
       if (thd->rewritten_query.length())
         query_logger.general_log_write(thd, COM_STMT_PREPARE,
@@ -3449,6 +3460,10 @@ Prepared_statement::set_parameters(String *expanded_query,
   bool is_sql_ps= packet == NULL;
   bool res= FALSE;
 
+  /* The parameters of a statement template are set by the caller. */
+  if (is_template())
+    return false;
+
   if (is_sql_ps)
   {
     /* SQL prepared statement */
@@ -3640,6 +3655,8 @@ Prepared_statement::reprepare()
   Prepared_statement copy(thd);
 
   copy.set_sql_prepare(); /* To suppress sending metadata to the client. */
+  if (is_template())
+    copy.set_template(m_template_digest);
 
   thd->status_var.com_stmt_reprepare++;
 
@@ -3947,7 +3964,8 @@ bool Prepared_statement::execute(String *expanded_query, bool open_cursor)
           a hash of that hash.
         */
         rewrite_query_if_needed(thd);
-        log_execute_line(thd);
+        if (!is_template())
+          log_execute_line(thd);
         thd->binlog_need_explicit_defaults_ts= lex->binlog_need_explicit_defaults_ts;
         error= mysql_execute_command(thd, true);
         MYSQL_QUERY_EXEC_DONE(error);
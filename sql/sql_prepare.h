@@ -18,6 +18,7 @@
 #include "sql_class.h"  // Query_arena
 
 struct LEX;
+struct sql_digest_storage;
 
 /**
   An interface that is used to take an action when
@@ -398,7 +399,8 @@ class Prepared_statement: public Query_arena
   enum flag_values
   {
     IS_IN_USE= 1,
-    IS_SQL_PREPARE= 2
+    IS_SQL_PREPARE= 2,
+    IS_TEMPLATE= 4
   };
 
 public:
@@ -444,6 +446,12 @@ private:
   */
   LEX_CSTRING m_db;
 
+  /**
+    Where the digest of a statement template is kept when it is prepared,
+    see set_template().
+  */
+  sql_digest_storage *m_template_digest;
+
   /**
     The memory root to allocate parsed tree elements (instances of Item,
     SELECT_LEX and other classes).
@@ -460,6 +468,18 @@ public:
   bool is_in_use() const { return flags & (uint) IS_IN_USE; }
   bool is_sql_prepare() const { return flags & (uint) IS_SQL_PREPARE; }
   void set_sql_prepare() { flags|= (uint) IS_SQL_PREPARE; }
+  bool is_template() const { return flags & (uint) IS_TEMPLATE; }
+  /**
+    Make this statement a statement template, see sql_stmt_template.h.
+    The caller sets the values of the parameters before execute_loop(),
+    and nothing is written to the general log. The digest of the statement
+    is stored in digest when it is prepared.
+  */
+  void set_template(sql_digest_storage *digest)
+  {
+    flags|= (uint) (IS_SQL_PREPARE | IS_TEMPLATE);
+    m_template_digest= digest;
+  }
   bool prepare(const char *packet, size_t packet_length);
   bool execute_loop(String *expanded_query,
                     bool open_cursor,
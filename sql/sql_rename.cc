@@ -21,6 +21,7 @@
 #include "sql_cache.h"                          // query_cache_*
 #include "sql_table.h"                         // build_table_filename
 #include "sql_trigger.h"          // change_trigger_table_name
+#include "histogram.h"            // rename_table_histograms
 #include "sql_view.h"             // mysql_frm_type, mysql_rename_view
 #include "lock.h"       // MYSQL_OPEN_SKIP_TEMPORARY
 #include "sql_base.h"   // tdc_remove_table, lock_table_names,
@@ -293,6 +294,9 @@ do_rename(THD *thd, TABLE_LIST *ren_table,
             (void) mysql_rename_table(hton, new_db, new_alias,
                                       ren_table->db, old_alias, NO_FK_CHECKS);
           }
+          else
+            rename_table_histograms(thd, ren_table->db, ren_table->table_name,
+                                    new_db, new_table_name);
         }
       }
       break;
@@ -38,6 +38,7 @@
 #include "records.h"             // init_read_record, end_read_record
 #include "filesort.h"            // filesort_free_buffers
 #include "opt_explain.h"
+#include "sql_group_hash.h"      // Group_hash
 #include "sql_join_buffer.h"     // JOIN_CACHE
 #include "sql_optimizer.h"       // JOIN
 #include "sql_tmp_table.h"       // tmp tables
@@ -822,6 +823,8 @@ void JOIN::reset()
     for (uint tmp= primary_tables; tmp < primary_tables + tmp_tables; tmp++)
     {
       TABLE *const tmp_table= qep_tab[tmp].table();
+      if (qep_tab[tmp].group_hash != NULL)
+        qep_tab[tmp].group_hash->reset();
       if (!tmp_table->is_created())
         continue;
       tmp_table->file->extra(HA_EXTRA_RESET_STATE);
@@ -1712,13 +1715,14 @@ void QEP_TAB::push_index_cond(const JOIN_TAB *join_tab,
     Fields of other non-const tables aren't allowed in following cases:
        type is:
         (JT_ALL | JT_INDEX_SCAN | JT_RANGE | JT_INDEX_MERGE)
-       and BNL is used.
+       and BNL or hash join is used.
     and allowed otherwise.
   */
   const bool other_tbls_ok=
     !((type() == JT_ALL || type() == JT_INDEX_SCAN ||
        type() == JT_RANGE || type() ==  JT_INDEX_MERGE) &&
-      join_tab->use_join_cache() == JOIN_CACHE::ALG_BNL);
+      (join_tab->use_join_cache() == JOIN_CACHE::ALG_BNL ||
+       join_tab->use_join_cache() == JOIN_CACHE::ALG_HASH));
 
   /*
     We will only attempt to push down an index condition when the
@@ -1975,6 +1979,7 @@ bool JOIN::setup_semijoin_materialized_table(JOIN_TAB *tab, uint tableno,
   sjm_pos->sj_strategy= SJ_OPT_NONE;
 
   sjm_pos->use_join_buffer= false;
+  sjm_pos->use_hash_join= false;
   /*
     No need to recalculate filter_effect since there are no post-read
     conditions for materialized tables.
@@ -2053,6 +2058,9 @@ void QEP_TAB::init_join_cache(JOIN_TAB *join_tab)
   case JOIN_CACHE::ALG_BNL:
     op= new JOIN_CACHE_BNL(join_, this, prev_cache);
     break;
+  case JOIN_CACHE::ALG_HASH:
+    op= new JOIN_CACHE_HASH(join_, this, prev_cache);
+    break;
   case JOIN_CACHE::ALG_BKA:
     op= new JOIN_CACHE_BKA(join_, this, join_tab->join_cache_flags, prev_cache);
     break;
@@ -2381,6 +2389,8 @@ void QEP_TAB::cleanup()
   // Delete parts specific of QEP_TAB:
   delete filesort;
   filesort= NULL;
+  delete group_hash;
+  group_hash= NULL;
   end_read_record(&read_record);
   if (quick_optim() != quick())
     delete quick_optim();
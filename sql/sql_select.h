@@ -393,6 +393,11 @@ typedef struct st_position : public Sql_alloc
   /** If ref-based access is used: bitmap of tables this table depends on  */
   table_map ref_depend_map;
   bool use_join_buffer; 
+  /**
+    If use_join_buffer is set: the join buffer is probed through a hash
+    table on the columns equated to columns of the preceding tables.
+  */
+  bool use_hash_join;
 
   /**
     Current optimization state: Semi-join strategy to be used for this
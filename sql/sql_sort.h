@@ -309,6 +309,7 @@ public:
   uchar *unique_buff;
   bool not_killable;
   bool using_pq;
+  uint sort_threads;          // Number of threads for sort_buffer()
   char* tmp_buffer;
 
   // The fields below are used only by Unique class.
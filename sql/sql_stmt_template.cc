@@ -0,0 +1,1122 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+  Statement templates, see sql_stmt_template.h.
+*/
+
+#include "sql_stmt_template.h"
+
+#include "hash.h"                               // HASH
+#include "item.h"                               // Item_param
+#include "item_func.h"                          // mqh_used
+#include "log.h"                                // query_logger
+#include "mysqld.h"                             // opt_general_log_raw
+#include "prealloced_array.h"                   // Prealloced_array
+#include "sql_audit.h"                          // is_audit_plugin_class_active
+#include "sql_class.h"                          // THD
+#include "sql_connect.h"                        // check_mqh
+#include "sql_digest.h"                         // sql_digest_storage
+#include "sql_prepare.h"                        // Prepared_statement
+#include "mysql/psi/mysql_statement.h"          // MYSQL_DIGEST_START
+
+namespace {
+
+/** A literal of a statement that is a parameter of its template */
+struct Stmt_literal
+{
+  enum enum_type
+  {
+    INT_LITERAL,
+    DECIMAL_LITERAL,
+    REAL_LITERAL,
+    STRING_LITERAL
+  };
+
+  enum_type type;
+  /** The literal as written, with the quotes of a string */
+  const char *str;
+  size_t length;
+  /** Value of an integer */
+  longlong integer;
+  /** Whether an integer is too big for a signed integer */
+  bool is_unsigned;
+};
+
+typedef Prealloced_array<Stmt_literal, 16> Stmt_literal_array;
+
+
+/**
+  Replaces the literals of a statement by parameter markers, when a
+  prepared statement can take them as parameters and doing so does not
+  change what the statement does.
+*/
+
+class Stmt_normalizer
+{
+public:
+  Stmt_normalizer(THD *thd, const char *query, size_t length)
+    : m_thd(thd), m_cs(thd->charset()), m_query(query),
+      m_end(query + length), m_copied(query),
+      m_ansi_quotes(thd->variables.sql_mode & MODE_ANSI_QUOTES),
+      m_literals(key_memory_prepared_statement_map),
+      m_depth(0), m_prev_type(TOKEN_NONE), m_prev_str(NULL), m_prev_length(0)
+  {
+    m_levels[0].clause= CLAUSE_NONE;
+    m_levels[0].no_parameters= false;
+  }
+
+  /**
+    Normalize the statement.
+
+    @retval false  OK, see text() and literals()
+    @retval true   The statement is not a statement that can be executed
+                   from a template
+  */
+  bool normalize();
+
+  const String &text() const { return m_text; }
+  const Stmt_literal_array &literals() const { return m_literals; }
+
+private:
+  /** Where in the statement a literal is */
+  enum enum_clause
+  {
+    /** Before the select list */
+    CLAUSE_NONE,
+    /** The select list, where the literals determine the result metadata */
+    CLAUSE_SELECT_LIST,
+    /** A condition or join condition */
+    CLAUSE_CONDITION,
+    /** LIMIT, where integers can be parameters */
+    CLAUSE_LIMIT,
+    /**
+      ORDER BY and GROUP BY, where integers are column numbers, and
+      others where a literal has a meaning of its own
+    */
+    CLAUSE_NO_PARAMETERS
+  };
+
+  enum enum_token
+  {
+    TOKEN_NONE,
+    TOKEN_WORD,
+    TOKEN_IDENTIFIER,
+    TOKEN_LITERAL,
+    TOKEN_PUNCTUATION
+  };
+
+  /** A level of parentheses */
+  struct Level
+  {
+    enum_clause clause;
+    /** Whether no literal in the parentheses can be a parameter */
+    bool no_parameters;
+  };
+
+  static const uint MAX_DEPTH= 64;
+
+  static bool is_ident_char(uchar c)
+  {
+    return my_isalnum(&my_charset_latin1, c) || c == '_' || c == '$' ||
+           c >= 0x80;
+  }
+  static bool is_digit(uchar c) { return c >= '0' && c <= '9'; }
+  static bool is_space(uchar c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+           c == '\v';
+  }
+  static bool is_word(const char *str, size_t length, const char *word)
+  {
+    return strlen(word) == length &&
+           native_strncasecmp(str, word, length) == 0;
+  }
+
+  bool prev_word_is(const char *word) const
+  {
+    return m_prev_type == TOKEN_WORD &&
+           is_word(m_prev_str, m_prev_length, word);
+  }
+  void set_prev(enum_token type, const char *str, const char *end)
+  {
+    m_prev_type= type;
+    m_prev_str= str;
+    m_prev_length= end - str;
+  }
+  uint mb_length(const char *p) const
+  {
+    return use_mb(m_cs) ? my_ismbchar(m_cs, p, m_end) : 0;
+  }
+
+  const char *skip_word(const char *p) const;
+  const char *skip_comment(const char *p) const;
+  const char *skip_quoted(const char *p, bool identifier) const;
+  bool starts_with_select() const;
+  bool word(const char *str, const char *end);
+  bool open_parenthesis();
+  bool literal(Stmt_literal *literal, const char *end);
+  bool may_be_parameter(const Stmt_literal &literal) const;
+
+  THD *const m_thd;
+  const CHARSET_INFO *const m_cs;
+  const char *const m_query;
+  const char *const m_end;
+  /** End of the part of the statement that is in m_text */
+  const char *m_copied;
+  const bool m_ansi_quotes;
+  String m_text;
+  Stmt_literal_array m_literals;
+  Level m_levels[MAX_DEPTH];
+  uint m_depth;
+  /** The token before the current one, not counting comments */
+  enum_token m_prev_type;
+  const char *m_prev_str;
+  size_t m_prev_length;
+};
+
+
+/** End of the word that starts at p */
+
+const char *Stmt_normalizer::skip_word(const char *p) const
+{
+  while (p < m_end)
+  {
+    const uint length= mb_length(p);
+    if (length > 0)
+      p+= length;
+    else if (is_ident_char(*p))
+      p++;
+    else
+      break;
+  }
+  return p;
+}
+
+
+/**
+  End of the comment that starts at p, or NULL if p does not start a
+  comment, or starts an unterminated one.
+*/
+
+const char *Stmt_normalizer::skip_comment(const char *p) const
+{
+  if (*p == '#' ||
+      (*p == '-' && p + 2 <= m_end && p[1] == '-' &&
+       (p + 2 == m_end || is_space(p[2]) || my_iscntrl(m_cs, p[2]))))
+  {
+    while (p < m_end && *p != '\n')
+      p++;
+    return p;
+  }
+  if (*p == '/' && p + 1 < m_end && p[1] == '*')
+  {
+    for (p+= 2; p + 1 < m_end; p++)
+    {
+      const uint length= mb_length(p);
+      if (length > 0)
+        p+= length - 1;
+      else if (p[0] == '*' && p[1] == '/')
+        return p + 2;
+    }
+  }
+  return NULL;
+}
+
+
+/**
+  End of the string or quoted identifier that starts at p, or NULL if it
+  is not terminated. Backslash escapes in strings are handled like
+  get_text() does.
+*/
+
+const char *Stmt_normalizer::skip_quoted(const char *p,
+                                         bool identifier) const
+{
+  const char quote= *p;
+  const bool backslash= !identifier &&
+    !(m_thd->variables.sql_mode & MODE_NO_BACKSLASH_ESCAPES);
+
+  for (p++; p < m_end; p++)
+  {
+    const uint length= mb_length(p);
+    if (length > 0)
+      p+= length - 1;
+    else if (*p == '\\' && backslash)
+      p++;
+    else if (*p == quote)
+    {
+      if (p + 1 < m_end && p[1] == quote)
+        p++;
+      else
+        return p + 1;
+    }
+  }
+  return NULL;
+}
+
+
+/** Whether the first word of the statement, after comments, is SELECT */
+
+bool Stmt_normalizer::starts_with_select() const
+{
+  const char *p= m_query;
+  while (p < m_end)
+  {
+    const char *comment_end;
+    if (is_space(*p))
+      p++;
+    else if (p + 2 < m_end && p[0] == '/' && p[1] == '*' && p[2] == '!')
+      return false;
+    else if ((comment_end= skip_comment(p)))
+      p= comment_end;
+    else
+      return is_word(p, skip_word(p) - p, "SELECT");
+  }
+  return false;
+}
+
+
+/**
+  Handle a word: keywords that start a clause of the statement.
+
+  @retval true  The statement can not be executed from a template
+*/
+
+bool Stmt_normalizer::word(const char *str, const char *end)
+{
+  const size_t length= end - str;
+  /* Read from the diagnostics area, that preparing the template resets */
+  if (is_word(str, length, "WARNING_COUNT") ||
+      is_word(str, length, "ERROR_COUNT"))
+    return true;
+
+  /* A column or variable of the same name as a keyword */
+  if (str > m_query && (str[-1] == '.' || str[-1] == '@'))
+    return false;
+
+  enum_clause *const clause= &m_levels[m_depth].clause;
+  if (is_word(str, length, "SELECT"))
+    *clause= CLAUSE_SELECT_LIST;
+  else if (is_word(str, length, "FROM") ||
+           is_word(str, length, "WHERE") ||
+           is_word(str, length, "HAVING") ||
+           is_word(str, length, "ON") ||
+           is_word(str, length, "JOIN"))
+    *clause= CLAUSE_CONDITION;
+  else if (is_word(str, length, "LIMIT"))
+    *clause= CLAUSE_LIMIT;
+  else if (is_word(str, length, "ORDER") ||
+           is_word(str, length, "GROUP") ||
+           is_word(str, length, "INTO") ||
+           is_word(str, length, "PROCEDURE") ||
+           is_word(str, length, "FOR") ||
+           is_word(str, length, "LOCK"))
+    *clause= CLAUSE_NO_PARAMETERS;
+  else if (is_word(str, length, "UNION"))
+    *clause= CLAUSE_NONE;
+  return false;
+}
+
+
+/**
+  Enter parentheses. The arguments of functions that take a type or a
+  search modifier are not parameters.
+
+  @retval true  The statement can not be executed from a template
+*/
+
+bool Stmt_normalizer::open_parenthesis()
+{
+  static const char *const type_words[]=
+  {
+    "AGAINST", "BINARY", "CAST", "CHAR", "CONVERT", "DATETIME", "DEC",
+    "DECIMAL", "DOUBLE", "FIXED", "FLOAT", "NCHAR", "NUMERIC", "TIME",
+    "TIMESTAMP", "VARBINARY", "VARCHAR", NULL
+  };
+
+  if (m_depth + 1 >= MAX_DEPTH)
+    return true;
+
+  const Level &outer= m_levels[m_depth];
+  Level *const level= &m_levels[++m_depth];
+  level->clause= outer.clause;
+  level->no_parameters= outer.no_parameters ||
+                        outer.clause == CLAUSE_SELECT_LIST ||
+                        outer.clause == CLAUSE_NO_PARAMETERS;
+  for (const char *const *word= type_words;
+       *word != NULL && !level->no_parameters; word++)
+    level->no_parameters= prev_word_is(*word);
+  return false;
+}
+
+
+/** Whether a literal can be a parameter where it is */
+
+bool Stmt_normalizer::may_be_parameter(const Stmt_literal &literal) const
+{
+  const Level &level= m_levels[m_depth];
+  if (level.no_parameters)
+    return false;
+  if (level.clause != CLAUSE_CONDITION &&
+      !(level.clause == CLAUSE_LIMIT &&
+        literal.type == Stmt_literal::INT_LITERAL))
+    return false;
+
+  /* Part of a name, a user variable name or a hexadecimal literal */
+  if (literal.str > m_query)
+  {
+    const uchar prev= literal.str[-1];
+    if (is_ident_char(prev) || prev == '.' || prev == '@')
+      return false;
+  }
+
+  /* JSON path of -> and ->> */
+  if (m_prev_type == TOKEN_PUNCTUATION && m_prev_length > 1 &&
+      m_prev_str[0] == '-')
+    return false;
+
+  /* Character set introducers, typed literals, and literal arguments */
+  if (m_prev_type == TOKEN_WORD &&
+      (m_prev_str[0] == '_' ||
+       prev_word_is("DATE") || prev_word_is("TIME") ||
+       prev_word_is("TIMESTAMP") || prev_word_is("ESCAPE") ||
+       prev_word_is("SEPARATOR") || prev_word_is("COLLATE") ||
+       prev_word_is("CHARSET") || prev_word_is("SET")))
+    return false;
+  return true;
+}
+
+
+/**
+  Handle a literal, replacing it by a parameter marker if possible.
+
+  @retval true  The statement can not be executed from a template
+*/
+
+bool Stmt_normalizer::literal(Stmt_literal *literal, const char *end)
+{
+  literal->length= end - literal->str;
+  bool parameter= may_be_parameter(*literal);
+
+  if (literal->type == Stmt_literal::STRING_LITERAL)
+  {
+    const char *next= end;
+    while (next < m_end && is_space(*next))
+      next++;
+    /* 'a' 'b' is one literal */
+    if (next < m_end && (*next == '\'' || (*next == '"' && !m_ansi_quotes)))
+      return true;
+    if (next < m_end && is_word(next, skip_word(next) - next, "COLLATE"))
+      parameter= false;
+  }
+
+  if (parameter)
+  {
+    if (m_text.append(m_copied, literal->str - m_copied) ||
+        m_text.append('?') ||
+        m_literals.push_back(*literal))
+      return true;
+    m_copied= end;
+  }
+  set_prev(TOKEN_LITERAL, literal->str, end);
+  return false;
+}
+
+
+bool Stmt_normalizer::normalize()
+{
+  if (!starts_with_select())
+    return true;
+
+  m_text.set_charset(m_cs);
+  const char *p= m_query;
+  while (p < m_end)
+  {
+    const char *const start= p;
+    const uchar c= *p;
+
+    if (is_space(c))
+    {
+      p++;
+      continue;
+    }
+    if (c == '/' && p + 2 < m_end && p[1] == '*' && p[2] == '!')
+      return true;                              // May hide a clause
+    if ((p= skip_comment(start)))
+      continue;
+    p= start;
+
+    if (mb_length(p) > 0 || (is_ident_char(c) && !is_digit(c)))
+    {
+      p= skip_word(p);
+      if (word(start, p))
+        return true;
+      set_prev(TOKEN_WORD, start, p);
+    }
+    else if (c == '`' || (c == '"' && m_ansi_quotes))
+    {
+      if (!(p= skip_quoted(start, true)))
+        return true;
+      set_prev(TOKEN_IDENTIFIER, start, p);
+    }
+    else if (c == '\'' || c == '"')
+    {
+      if (!(p= skip_quoted(start, false)))
+        return true;
+      Stmt_literal string= { Stmt_literal::STRING_LITERAL, start, 0, 0, false };
+      if (literal(&string, p))
+        return true;
+    }
+    else if (is_digit(c))
+    {
+      Stmt_literal number= { Stmt_literal::INT_LITERAL, start, 0, 0, false };
+      while (p < m_end && is_digit(*p))
+        p++;
+      if (p + 1 < m_end && *p == '.' && is_digit(p[1]))
+      {
+        number.type= Stmt_literal::DECIMAL_LITERAL;
+        for (p++; p < m_end && is_digit(*p); p++)
+        {}
+      }
+      if (p < m_end && (*p == 'e' || *p == 'E'))
+      {
+        const char *exponent= p + 1;
+        if (exponent < m_end && (*exponent == '+' || *exponent == '-'))
+          exponent++;
+        if (exponent < m_end && is_digit(*exponent))
+        {
+          number.type= Stmt_literal::REAL_LITERAL;
+          for (p= exponent; p < m_end && is_digit(*p); p++)
+          {}
+        }
+      }
+      if (p < m_end && (is_ident_char(*p) || *p == '.'))
+      {
+        /* A name that starts with digits, or a hexadecimal literal */
+        p= skip_word(p);
+        set_prev(TOKEN_IDENTIFIER, start, p);
+        continue;
+      }
+      if (number.type == Stmt_literal::INT_LITERAL)
+      {
+        /* The same types as the lexer gives integers, see int_token() */
+        char *int_end= const_cast<char *>(p);
+        int error;
+        number.integer= my_strtoll10(start, &int_end, &error);
+        if (error != 0)
+          number.type= Stmt_literal::DECIMAL_LITERAL;
+        else
+          number.is_unsigned=
+            static_cast<ulonglong>(number.integer) > LLONG_MAX;
+      }
+      if (literal(&number, p))
+        return true;
+    }
+    else
+    {
+      p++;
+      switch (c)
+      {
+      case '(':
+        if (open_parenthesis())
+          return true;
+        break;
+      case ')':
+        if (m_depth == 0)
+          return true;
+        m_depth--;
+        break;
+      case ';':                                 // Multiple statements
+      case '?':                                 // Already a parameter
+        return true;
+      case '-':
+        if (p < m_end && *p == '>')
+          p++;
+        if (p < m_end && p[-1] == '>' && *p == '>')
+          p++;
+        break;
+      }
+      set_prev(TOKEN_PUNCTUATION, start, p);
+    }
+  }
+
+  if (m_depth != 0)
+    return true;
+  return m_text.append(m_copied, m_end - m_copied);
+}
+
+
+/**
+  Set a parameter of a template to the value of a literal, like
+  Item_param::set_from_user_var() does for EXECUTE ... USING, giving it
+  the type that the literal has.
+
+  @retval true  Out of memory
+*/
+
+bool set_parameter(THD *thd, Item_param *param, const Stmt_literal &literal)
+{
+  switch (literal.type)
+  {
+  case Stmt_literal::INT_LITERAL:
+    param->item_result_type= INT_RESULT;
+    param->item_type= Item::INT_ITEM;
+    param->unsigned_flag= literal.is_unsigned;
+    param->set_int(literal.integer, static_cast<uint32>(literal.length));
+    return false;
+  case Stmt_literal::DECIMAL_LITERAL:
+    param->item_result_type= DECIMAL_RESULT;
+    param->item_type= Item::DECIMAL_ITEM;
+    param->unsigned_flag= true;
+    param->set_decimal(literal.str, literal.length);
+    return false;
+  case Stmt_literal::REAL_LITERAL:
+  {
+    char *end;
+    int error;
+    param->item_result_type= REAL_RESULT;
+    param->item_type= Item::REAL_ITEM;
+    param->unsigned_flag= false;
+    param->set_double(my_strntod(&my_charset_bin,
+                                 const_cast<char *>(literal.str),
+                                 literal.length, &end, &error));
+    return false;
+  }
+  case Stmt_literal::STRING_LITERAL:
+    break;
+  }
+
+  /* Remove the quotes and escapes like get_text() does */
+  const CHARSET_INFO *const client_cs= thd->variables.character_set_client;
+  const CHARSET_INFO *const connection_cs=
+    thd->variables.collation_connection;
+  const bool backslash=
+    !(thd->variables.sql_mode & MODE_NO_BACKSLASH_ESCAPES);
+  const char quote= literal.str[0];
+  const char *str= literal.str + 1;
+  const char *const end= literal.str + literal.length - 1;
+  char *const buf= static_cast<char *>(thd->alloc(end - str + 1));
+  if (buf == NULL)
+    return true;
+
+  char *to= buf;
+  uchar bits= 0;
+  for (; str < end; str++)
+  {
+    bits|= static_cast<uchar>(*str);
+    uint length;
+    if (use_mb(client_cs) && (length= my_ismbchar(client_cs, str, end)))
+    {
+      while (length--)
+        *to++= *str++;
+      str--;
+      continue;
+    }
+    if (backslash && *str == '\\' && str + 1 != end)
+    {
+      switch (*++str)
+      {
+      case 'n': *to++= '\n'; break;
+      case 't': *to++= '\t'; break;
+      case 'r': *to++= '\r'; break;
+      case 'b': *to++= '\b'; break;
+      case '0': *to++= 0; break;
+      case 'Z': *to++= '\032'; break;
+      case '_':
+      case '%':
+        *to++= '\\';
+        /* Fall through */
+      default:
+        *to++= *str;
+        break;
+      }
+    }
+    else if (*str == quote)
+      *to++= *str++;                            // Two quotes
+    else
+      *to++= *str;
+  }
+
+  size_t dummy_offset;
+  param->item_result_type= STRING_RESULT;
+  param->item_type= Item::STRING_ITEM;
+  param->value.cs_info.character_set_client= client_cs;
+  param->value.cs_info.character_set_of_placeholder=
+    String::needs_conversion(0, client_cs, connection_cs, &dummy_offset) ?
+    client_cs : connection_cs;
+  param->value.cs_info.final_character_set_of_str_value= connection_cs;
+  if (param->set_str(buf, to - buf) || param->convert_str_value(thd))
+    return true;
+  param->collation.set(connection_cs, DERIVATION_COERCIBLE,
+                       !(bits & 0x80) && my_charset_is_ascii_based(client_cs) ?
+                       MY_REPERTOIRE_ASCII : MY_REPERTOIRE_UNICODE30);
+  return false;
+}
+
+
+/**
+  Count a prepared statement of a template in prepared_stmt_count, unless
+  max_prepared_stmt_count is reached.
+
+  @retval false  OK
+  @retval true   The limit is reached, nothing was counted
+*/
+
+static bool count_prepared_stmt()
+{
+  bool limit_reached;
+  mysql_mutex_lock(&LOCK_prepared_stmt_count);
+  limit_reached= prepared_stmt_count >= max_prepared_stmt_count;
+  if (!limit_reached)
+    prepared_stmt_count++;
+  mysql_mutex_unlock(&LOCK_prepared_stmt_count);
+  return limit_reached;
+}
+
+
+/** Discount a prepared statement counted by count_prepared_stmt() */
+
+static void discount_prepared_stmt()
+{
+  mysql_mutex_lock(&LOCK_prepared_stmt_count);
+  DBUG_ASSERT(prepared_stmt_count > 0);
+  prepared_stmt_count--;
+  mysql_mutex_unlock(&LOCK_prepared_stmt_count);
+}
+
+
+/** A statement template */
+
+class Stmt_template
+{
+public:
+  /** Create a template without a prepared statement */
+  static Stmt_template *create(THD *thd, const String &text);
+
+  ~Stmt_template()
+  {
+    if (m_stmt != NULL)
+    {
+      delete m_stmt;
+      discount_prepared_stmt();
+    }
+    my_free(m_buffer);
+  }
+
+  /**
+    Prepare the statement of the template.
+
+    @param thd            Thread
+    @param literal_count  Number of literals of the statement that are
+                          parameters of the template
+
+    @retval false  OK, or the statement can not be executed from a
+                   template, in which case stmt() is NULL
+    @retval true   The statement could not be prepared for a reason that
+                   may go away, such as a missing table or
+                   max_prepared_stmt_count being reached, and the
+                   template must not be cached
+  */
+  bool prepare(THD *thd, uint literal_count);
+
+  /**
+    Execute the statement of thd->query() with the template, taking its
+    literals as the values of the parameters. Errors are reported in the
+    diagnostics area.
+  */
+  void execute(THD *thd, const Stmt_literal_array &literals);
+
+  /**
+    Whether the template was prepared in the same context as the current
+    statement is executed in.
+  */
+  bool matches_context(const THD *thd) const
+  {
+    const LEX_CSTRING db= thd->db();
+    return m_sql_mode == thd->variables.sql_mode &&
+           m_client_cs == thd->variables.character_set_client &&
+           m_connection_cs == thd->variables.collation_connection &&
+           m_db.length == db.length &&
+           (db.length == 0 || memcmp(m_db.str, db.str, db.length) == 0);
+  }
+
+  Prepared_statement *stmt() const { return m_stmt; }
+
+  static uchar *get_key(const uchar *record, size_t *length, my_bool)
+  {
+    const Stmt_template *tmpl= reinterpret_cast<const Stmt_template *>(record);
+    *length= tmpl->m_text.length;
+    return reinterpret_cast<uchar *>(const_cast<char *>(tmpl->m_text.str));
+  }
+  static void free_template(void *record)
+  {
+    delete static_cast<Stmt_template *>(record);
+  }
+
+  /** Neighbours in the list of templates, most recently used first */
+  Stmt_template *m_prev;
+  Stmt_template *m_next;
+
+private:
+  Stmt_template()
+    : m_prev(NULL), m_next(NULL), m_buffer(NULL), m_stmt(NULL),
+      m_sql_mode(0), m_client_cs(NULL), m_connection_cs(NULL)
+  {}
+
+  /** Holds m_text, m_db and the token array of m_digest */
+  char *m_buffer;
+  /** The normalized statement */
+  LEX_CSTRING m_text;
+  Prepared_statement *m_stmt;
+  LEX_CSTRING m_db;
+  sql_mode_t m_sql_mode;
+  const CHARSET_INFO *m_client_cs;
+  const CHARSET_INFO *m_connection_cs;
+  /** Digest of the statement, for the Performance Schema */
+  sql_digest_storage m_digest;
+};
+
+
+Stmt_template *Stmt_template::create(THD *thd, const String &text)
+{
+  const LEX_CSTRING db= thd->db();
+  Stmt_template *const tmpl= new Stmt_template();
+  if (tmpl == NULL)
+    return NULL;
+  if (!(tmpl->m_buffer=
+        static_cast<char *>(my_malloc(key_memory_prepared_statement_map,
+                                      text.length() + db.length + 2 +
+                                      max_digest_length, MYF(0)))))
+  {
+    delete tmpl;
+    return NULL;
+  }
+
+  char *const text_buf= tmpl->m_buffer;
+  memcpy(text_buf, text.ptr(), text.length());
+  text_buf[text.length()]= '\0';
+  tmpl->m_text.str= text_buf;
+  tmpl->m_text.length= text.length();
+
+  char *const db_buf= text_buf + text.length() + 1;
+  if (db.length > 0)
+    memcpy(db_buf, db.str, db.length);
+  db_buf[db.length]= '\0';
+  tmpl->m_db.str= db_buf;
+  tmpl->m_db.length= db.length;
+
+  tmpl->m_digest.reset(reinterpret_cast<uchar *>(db_buf + db.length + 1),
+                       max_digest_length);
+  tmpl->m_sql_mode= thd->variables.sql_mode;
+  tmpl->m_client_cs= thd->variables.character_set_client;
+  tmpl->m_connection_cs= thd->variables.collation_connection;
+  return tmpl;
+}
+
+
+bool Stmt_template::prepare(THD *thd, uint literal_count)
+{
+  Diagnostics_area *const da= thd->get_stmt_da();
+  /* Preparing a template is not counted in Com_stmt_prepare */
+  const ulonglong com_stmt_prepare= thd->status_var.com_stmt_prepare;
+  DBUG_ENTER("Stmt_template::prepare");
+
+  /*
+    The prepared statement of a template counts against
+    max_prepared_stmt_count like the ones of the session do.
+  */
+  if (count_prepared_stmt())
+  {
+    DBUG_PRINT("info", ("max_prepared_stmt_count reached"));
+    DBUG_RETURN(true);
+  }
+
+  Prepared_statement *const stmt= new Prepared_statement(thd);
+  if (stmt == NULL)
+  {
+    discount_prepared_stmt();
+    DBUG_RETURN(true);
+  }
+  stmt->set_template(&m_digest);
+
+  const bool error= stmt->prepare(m_text.str, m_text.length);
+  thd->status_var.com_stmt_prepare= com_stmt_prepare;
+
+  if (!error &&
+      da->current_statement_cond_count() == 0 &&
+      stmt->lex->sql_command == SQLCOM_SELECT &&
+      !stmt->lex->describe &&
+      stmt->param_count == literal_count)
+  {
+    m_stmt= stmt;
+    DBUG_RETURN(false);
+  }
+
+  /*
+    Parse errors and statements that are prepared differently are not
+    tried again. Other errors are reported again when the statement is
+    parsed.
+  */
+  const bool retry= error && da->mysql_errno() != ER_PARSE_ERROR;
+  DBUG_PRINT("info", ("not a template, retry: %d", retry));
+  delete stmt;
+  discount_prepared_stmt();
+  thd->clear_error();
+  da->reset_condition_info(thd);
+  DBUG_RETURN(retry);
+}
+
+
+void Stmt_template::execute(THD *thd, const Stmt_literal_array &literals)
+{
+  const LEX_CSTRING query= thd->query();
+  DBUG_ENTER("Stmt_template::execute");
+
+  MYSQL_SET_STATEMENT_TEXT(thd->m_statement_psi, query.str, query.length);
+  if (!(opt_general_log_raw || thd->slave_thread))
+    query_logger.general_log_write(thd, COM_QUERY, query.str, query.length);
+
+  if (thd->m_digest != NULL)
+  {
+    PSI_digest_locker *const locker=
+      MYSQL_DIGEST_START(thd->m_statement_psi);
+    thd->m_digest->m_digest_storage.copy(&m_digest);
+    if (locker != NULL)
+      MYSQL_DIGEST_END(locker, &thd->m_digest->m_digest_storage);
+  }
+
+  thd->m_statement_psi=
+    MYSQL_REFINE_STATEMENT(thd->m_statement_psi,
+                           sql_statement_info[SQLCOM_SELECT].m_key);
+
+#ifndef NO_EMBEDDED_ACCESS_CHECKS
+  if (mqh_used && thd->get_user_connect() && check_mqh(thd, SQLCOM_SELECT))
+  {
+    if (thd->is_classic_protocol())
+      thd->get_protocol_classic()->get_net()->error= 0;
+    DBUG_VOID_RETURN;
+  }
+#endif
+
+  for (size_t i= 0; i < literals.size(); i++)
+  {
+    if (set_parameter(thd, m_stmt->param_array[i], literals[i]))
+    {
+      my_error(ER_OUT_OF_RESOURCES, MYF(0));
+      DBUG_VOID_RETURN;
+    }
+  }
+
+  /*
+    Executing a template is not counted in Com_stmt_execute. A template
+    that is reprepared is counted as invalidated.
+  */
+  STATUS_VAR *const status= &thd->status_var;
+  const ulonglong com_stmt_prepare= status->com_stmt_prepare;
+  const ulonglong com_stmt_execute= status->com_stmt_execute;
+  const ulonglong com_stmt_reprepare= status->com_stmt_reprepare;
+
+  /* The query is logged with its literals, see Prepared_statement::execute */
+  String expanded_query(const_cast<char *>(query.str), query.length,
+                        thd->charset());
+  m_stmt->execute_loop(&expanded_query, false, NULL, NULL);
+
+  status->stmt_template_cache_invalidations+=
+    status->com_stmt_reprepare - com_stmt_reprepare;
+  status->com_stmt_prepare= com_stmt_prepare;
+  status->com_stmt_execute= com_stmt_execute;
+  status->com_stmt_reprepare= com_stmt_reprepare;
+  DBUG_VOID_RETURN;
+}
+
+} // namespace
+
+
+/**
+  The statement templates of a session, in a hash on the normalized text,
+  and in a list ordered by the last use, to evict the least recently used
+  one when the cache is full.
+*/
+
+class Stmt_template_cache
+{
+public:
+  Stmt_template_cache()
+    : m_in_use(false), m_first(NULL), m_last(NULL)
+  {
+    my_hash_init(&m_hash, &my_charset_bin, 16, 0, 0, Stmt_template::get_key,
+                 Stmt_template::free_template, 0, key_memory_prepared_statement_map);
+  }
+
+  ~Stmt_template_cache()
+  {
+    my_hash_free(&m_hash);
+  }
+
+  /** Find a template, making it the most recently used one */
+  Stmt_template *find(const String &text)
+  {
+    Stmt_template *const tmpl= reinterpret_cast<Stmt_template *>(
+      my_hash_search(&m_hash, reinterpret_cast<const uchar *>(text.ptr()),
+                     text.length()));
+    if (tmpl != NULL)
+    {
+      unlink(tmpl);
+      link_first(tmpl);
+    }
+    return tmpl;
+  }
+
+  /**
+    Add a template as the most recently used one.
+
+    @retval true  Out of memory, the template has been freed
+  */
+  bool add(Stmt_template *tmpl)
+  {
+    if (my_hash_insert(&m_hash, reinterpret_cast<uchar *>(tmpl)))
+    {
+      delete tmpl;
+      return true;
+    }
+    link_first(tmpl);
+    return false;
+  }
+
+  /** Remove and free a template */
+  void remove(Stmt_template *tmpl)
+  {
+    unlink(tmpl);
+    my_hash_delete(&m_hash, reinterpret_cast<uchar *>(tmpl));
+  }
+
+  /** Remove the least recently used templates until at most size remain */
+  void evict(ulong size)
+  {
+    while (m_hash.records > size)
+      remove(m_last);
+  }
+
+  /** Whether a statement is being executed with a template */
+  bool m_in_use;
+
+private:
+  void link_first(Stmt_template *tmpl)
+  {
+    tmpl->m_prev= NULL;
+    tmpl->m_next= m_first;
+    if (m_first != NULL)
+      m_first->m_prev= tmpl;
+    else
+      m_last= tmpl;
+    m_first= tmpl;
+  }
+
+  void unlink(Stmt_template *tmpl)
+  {
+    if (tmpl->m_prev != NULL)
+      tmpl->m_prev->m_next= tmpl->m_next;
+    else
+      m_first= tmpl->m_next;
+    if (tmpl->m_next != NULL)
+      tmpl->m_next->m_prev= tmpl->m_prev;
+    else
+      m_last= tmpl->m_prev;
+  }
+
+  HASH m_hash;
+  Stmt_template *m_first;
+  Stmt_template *m_last;
+};
+
+
+bool stmt_template_cache_execute(THD *thd)
+{
+  const uint size= thd->variables.statement_template_cache_size;
+  DBUG_ENTER("stmt_template_cache_execute");
+
+  if (size == 0)
+  {
+    stmt_template_cache_free(thd);
+    DBUG_RETURN(false);
+  }
+
+  /* Audit plugins that are notified of the parse expect one */
+  if (thd->sp_runtime_ctx != NULL || thd->in_sub_stmt || thd->slave_thread
+#ifndef EMBEDDED_LIBRARY
+      || is_audit_plugin_class_active(thd, MYSQL_AUDIT_PARSE_CLASS)
+#endif
+      )
+    DBUG_RETURN(false);
+
+  Stmt_normalizer normalizer(thd, thd->query().str, thd->query().length);
+  if (normalizer.normalize())
+    DBUG_RETURN(false);
+
+  if (thd->stmt_template_cache == NULL &&
+      !(thd->stmt_template_cache= new Stmt_template_cache()))
+    DBUG_RETURN(false);
+  Stmt_template_cache *const cache= thd->stmt_template_cache;
+  if (cache->m_in_use)
+    DBUG_RETURN(false);
+
+  STATUS_VAR *const status= &thd->status_var;
+  Stmt_template *tmpl= cache->find(normalizer.text());
+  if (tmpl != NULL && !tmpl->matches_context(thd))
+  {
+    DBUG_PRINT("info", ("template prepared in another context"));
+    cache->remove(tmpl);
+    status->stmt_template_cache_invalidations++;
+    tmpl= NULL;
+  }
+
+  if (tmpl != NULL && tmpl->stmt() != NULL)
+    status->stmt_template_cache_hits++;
+  else
+    status->stmt_template_cache_misses++;
+
+  if (tmpl == NULL)
+  {
+    cache->evict(size - 1);
+    if (!(tmpl= Stmt_template::create(thd, normalizer.text())))
+      DBUG_RETURN(false);
+    cache->m_in_use= true;
+    const bool retry= tmpl->prepare(thd, normalizer.literals().size());
+    cache->m_in_use= false;
+    if (retry)
+    {
+      delete tmpl;
+      DBUG_RETURN(false);
+    }
+    if (cache->add(tmpl))
+      DBUG_RETURN(false);
+  }
+  if (tmpl->stmt() == NULL)
+    DBUG_RETURN(false);
+
+  cache->m_in_use= true;
+  tmpl->execute(thd, normalizer.literals());
+  cache->m_in_use= false;
+  DBUG_RETURN(true);
+}
+
+
+void stmt_template_cache_free(THD *thd)
+{
+  delete thd->stmt_template_cache;
+  thd->stmt_template_cache= NULL;
+}
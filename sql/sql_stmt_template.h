@@ -0,0 +1,67 @@
+#ifndef SQL_STMT_TEMPLATE_INCLUDED
+#define SQL_STMT_TEMPLATE_INCLUDED
+
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+  Statement templates: SELECT statements sent as text, kept prepared with
+  their literals as parameters.
+
+  Applications often send the same SELECT statement over and over with
+  different literals. With statement_template_cache_size > 0, such a
+  statement is normalized before it is parsed: the literals that a prepared
+  statement can take as parameters are replaced by '?'. The normalized
+  text is the key of a per-session cache of prepared statements, the
+  templates. A statement whose template is cached is executed as an
+  execution of the template with the literals as the values of the
+  parameters, without being parsed, and with the optimizer reusing what
+  prepared statements keep between executions.
+
+  The literals of the select list, of ORDER BY and GROUP BY, and those
+  that the grammar requires to be literals, such as the format of a CAST
+  or a character set introducer, are kept in the normalized text.
+  Statements that can not be prepared that way, or that give warnings
+  when they are, are remembered so that they are not prepared again.
+
+  The prepared statement of a template counts in Prepared_stmt_count and
+  against max_prepared_stmt_count. When that limit is reached, statements
+  are parsed and no template is added to the cache.
+
+  A template is dropped, and counted as invalidated, when the statement is
+  executed with another current database, SQL mode or character set than
+  the template was prepared with. A template that is reprepared because a
+  table it uses has changed is counted as invalidated as well.
+*/
+
+class THD;
+class Stmt_template_cache;
+
+/**
+  Execute the statement of thd->query() from a statement template, called
+  instead of parsing it.
+
+  @retval true   The statement was executed, or it failed with an error
+                 in the diagnostics area
+  @retval false  The statement can not be executed from a template and
+                 must be parsed
+*/
+bool stmt_template_cache_execute(THD *thd);
+
+/** Free the statement templates of a session */
+void stmt_template_cache_free(THD *thd);
+
+#endif /* SQL_STMT_TEMPLATE_INCLUDED */
@@ -42,6 +42,7 @@
                                        // make_unireg_sortorder
 #include "sql_handler.h"               // mysql_ha_rm_tables
 #include "discover.h"                  // readfrm
+#include "histogram.h"                 // drop_table_histograms
 #include "log_event.h"                 // Query_log_event
 #include <hash.h>
 #include <myisam.h>
@@ -2566,6 +2567,7 @@ int mysql_rm_table_no_locks(THD *thd, TABLE_LIST *tables, bool if_exists,
         {
           non_tmp_table_deleted= TRUE;
           new_error= drop_all_triggers(thd, db, table->table_name);
+          drop_table_histograms(thd, db, table->table_name);
         }
         error|= new_error;
         /* Invalidate even if we failed to delete the .FRM file. */
@@ -7632,6 +7634,8 @@ static bool mysql_inplace_alter_table(THD *thd,
                                 alter_ctx->db, alter_ctx->alias, NO_FK_CHECKS);
       DBUG_RETURN(true);
     }
+    rename_table_histograms(thd, alter_ctx->db, alter_ctx->table_name,
+                            alter_ctx->new_db, alter_ctx->new_name);
   }
 
   DBUG_RETURN(false);
@@ -8848,6 +8852,9 @@ simple_rename_or_index_change(THD *thd, TABLE_LIST *table_list,
                                 NO_FK_CHECKS);
       error= -1;
     }
+    else
+      rename_table_histograms(thd, alter_ctx->db, alter_ctx->table_name,
+                              alter_ctx->new_db, alter_ctx->new_name);
   }
 
   if (!error)
@@ -10000,6 +10007,9 @@ bool mysql_alter_table(THD *thd, const char *new_db, const char *new_name,
                               FN_FROM_IS_TMP | NO_FK_CHECKS);
     goto err_with_mdl;
   }
+  if (alter_ctx.is_table_renamed())
+    rename_table_histograms(thd, alter_ctx.db, alter_ctx.table_name,
+                            alter_ctx.new_db, alter_ctx.new_name);
 
   // ALTER TABLE succeeded, delete the backup of the old table.
   if (quick_rm_table(thd, old_db_type, alter_ctx.db, backup_name, FN_IS_TMP))
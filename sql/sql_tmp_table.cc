@@ -665,6 +665,7 @@ create_tmp_table(THD *thd, Temp_table_param *param, List<Item> &fields,
   uint fieldnr= 0;
   ulong reclength, string_total_length, distinct_key_length= 0;
   bool  using_unique_constraint= false;
+  bool  blobs_on_disk= false;
   bool  use_packed_rows= false;
   bool  not_all_columns= !(select_options & TMP_TABLE_ALL_COLUMNS);
   char  *tmpname,path[FN_REFLEN];
@@ -1046,6 +1047,25 @@ update_hidden:
   share->fields= field_count;
   share->blob_fields= blob_count;
 
+  /*
+    BLOB columns are kept in memory as well, but the MEMORY engine cannot
+    index them. Long BLOBs in the group key use the unique constraint, a
+    short one (e.g. TINYTEXT) would be part of the key.
+    INFORMATION_SCHEMA tables with BLOBs stay on disk: CREATE TABLE ... LIKE
+    copies their engine, and a MEMORY table of a user cannot have BLOBs.
+  */
+  if (param->schema_table && blob_count)
+    blobs_on_disk= true;
+  else if (group && !using_unique_constraint && blob_count)
+  {
+    for (ORDER *cur_group= group; cur_group; cur_group= cur_group->next)
+    {
+      Field *field= (*cur_group->item)->get_tmp_table_field();
+      if (field && (field->flags & BLOB_FLAG))
+        blobs_on_disk= true;
+    }
+  }
+
   /* If result table is small; use a heap */
   if (select_options & TMP_TABLE_FORCE_MYISAM)
   {
@@ -1053,7 +1073,7 @@ update_hidden:
     table->file= get_new_handler(share, &table->mem_root,
                                  share->db_type());
   }
-  else if (blob_count ||
+  else if (blobs_on_disk ||
            (thd->variables.big_tables &&
             !(select_options & SELECT_SMALL_RESULT)))
   {
@@ -53,6 +53,7 @@ Note: YYTHD is passed as an argument to yyparse(), and subsequently to yylex().
 #include "sp.h"
 #include "sql_alter.h"                         // Sql_cmd_alter_table*
 #include "sql_truncate.h"                      // Sql_cmd_truncate_table
+#include "histogram.h"                         // HISTOGRAM_DEFAULT_BUCKETS
 #include "sql_admin.h"                         // Sql_cmd_analyze/Check..._table
 #include "sql_partition_admin.h"               // Sql_cmd_alter_table_*_part.
 #include "sql_handler.h"                       // Sql_cmd_handler_*
@@ -1200,7 +1201,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, YYLTYPE **c, ulong *yystacksize);
         delete_option
 
 %type <ulong_num>
-        ulong_num real_ulong_num merge_insert_types
+        ulong_num real_ulong_num merge_insert_types opt_histogram_buckets
         ws_nweights func_datetime_precision
         ws_level_flag_desc ws_level_flag_reverse ws_level_flags
         opt_ws_levels ws_level_list ws_level_list_item ws_level_number
@@ -8737,6 +8738,52 @@ analyze:
             if (lex->m_sql_cmd == NULL)
               MYSQL_YYABORT;
           }
+          opt_histogram
+        ;
+
+/*
+  HISTOGRAM and BUCKETS are not keywords, so that they do not change the
+  digests of statements that use them as names.
+*/
+opt_histogram:
+          /* empty */ {}
+        | UPDATE_SYM ident ON using_list opt_histogram_buckets
+          {
+            if (my_strcasecmp(system_charset_info, $2.str, "HISTOGRAM"))
+            {
+              my_syntax_error(ER(ER_SYNTAX_ERROR));
+              MYSQL_YYABORT;
+            }
+            Sql_cmd_analyze_table *cmd=
+              static_cast<Sql_cmd_analyze_table*>(Lex->m_sql_cmd);
+            cmd->set_histogram_command(Sql_cmd_analyze_table::UPDATE_HISTOGRAM,
+                                       $4, $5);
+          }
+        | DROP ident ON using_list
+          {
+            if (my_strcasecmp(system_charset_info, $2.str, "HISTOGRAM"))
+            {
+              my_syntax_error(ER(ER_SYNTAX_ERROR));
+              MYSQL_YYABORT;
+            }
+            Sql_cmd_analyze_table *cmd=
+              static_cast<Sql_cmd_analyze_table*>(Lex->m_sql_cmd);
+            cmd->set_histogram_command(Sql_cmd_analyze_table::DROP_HISTOGRAM,
+                                       $4, 0);
+          }
+        ;
+
+opt_histogram_buckets:
+          /* empty */ { $$= HISTOGRAM_DEFAULT_BUCKETS; }
+        | WITH ulong_num ident
+          {
+            if (my_strcasecmp(system_charset_info, $3.str, "BUCKETS"))
+            {
+              my_syntax_error(ER(ER_SYNTAX_ERROR));
+              MYSQL_YYABORT;
+            }
+            $$= $2;
+          }
         ;
 
 binlog_base64_event:
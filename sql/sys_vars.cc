@@ -2694,6 +2694,43 @@ static Sys_var_ulong Sys_optimizer_search_depth(
        SESSION_VAR(optimizer_search_depth), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, MAX_TABLES+1), DEFAULT(MAX_TABLES+1), BLOCK_SIZE(1));
 
+static Sys_var_uint Sys_optimizer_dp_max_plans(
+       "optimizer_dp_max_plans",
+       "Maximum number of partial plans that the query optimizer keeps "
+       "when it searches for a join order by dynamic programming over "
+       "the connected sets of tables of an inner join. If more are "
+       "needed, the greedy search is used instead. If set to 0, the "
+       "greedy search is always used",
+       SESSION_VAR(optimizer_dp_max_plans), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024 * 1024), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_mybool Sys_prepared_statement_plan_cache(
+       "prepared_statement_plan_cache",
+       "Keep the join order chosen for a query block of a prepared "
+       "statement, and reuse it in later executions as long as the "
+       "parameter types, the tables and their estimated row counts "
+       "stay the same, instead of searching for a join order again",
+       SESSION_VAR(prepared_statement_plan_cache), CMD_LINE(OPT_ARG),
+       DEFAULT(FALSE));
+
+static Sys_var_uint Sys_statement_template_cache_size(
+       "statement_template_cache_size",
+       "Number of SELECT statements sent as text that are kept prepared, "
+       "with their literals as parameters, so that later statements that "
+       "differ only in the literals are executed without being parsed. "
+       "0 disables the cache",
+       SESSION_VAR(statement_template_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 16384), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulonglong Sys_histogram_generation_max_mem_size(
+      "histogram_generation_max_mem_size",
+      "Maximum amount of memory that ANALYZE TABLE ... UPDATE HISTOGRAM "
+      "may use for the sample of the rows it builds histograms from. "
+      "If the table does not fit, a random sample of its rows is used.",
+      SESSION_VAR(histogram_generation_max_mem_size),
+      CMD_LINE(REQUIRED_ARG), VALID_RANGE(1000000, ULLONG_MAX),
+      DEFAULT(20000000), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_range_optimizer_max_mem_size(
       "range_optimizer_max_mem_size",
       "Maximum amount of memory used by the range optimizer "
@@ -2782,7 +2819,7 @@ static const char *optimizer_switch_names[]=
   "materialization", "semijoin", "loosescan", "firstmatch", "duplicateweedout",
   "subquery_materialization_cost_based",
   "use_index_extensions", "condition_fanout_filter", "derived_merge",
-  "default", NullS
+  "hash_join", "constant_folding", "default", NullS
 };
 static Sys_var_flagset Sys_optimizer_switch(
        "optimizer_switch",
@@ -2793,7 +2830,8 @@ static Sys_var_flagset Sys_optimizer_switch(
        ", materialization, semijoin, loosescan, firstmatch, duplicateweedout,"
        " subquery_materialization_cost_based"
        ", block_nested_loop, batched_key_access, use_index_extensions,"
-       " condition_fanout_filter, derived_merge} and val is one of "
+       " condition_fanout_filter, derived_merge, hash_join, constant_folding}"
+       " and val is one of "
        "{on, off, default}",
        SESSION_VAR(optimizer_switch), CMD_LINE(REQUIRED_ARG),
        optimizer_switch_names, DEFAULT(OPTIMIZER_SWITCH_DEFAULT),
@@ -3159,6 +3197,34 @@ static Sys_var_uint Sys_eq_range_index_dive_limit(
        SESSION_VAR(eq_range_index_dive_limit), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, UINT_MAX32), DEFAULT(200), BLOCK_SIZE(1));
 
+static Sys_var_uint Sys_range_estimate_cache_size(
+       "range_estimate_cache_size",
+       "Number of estimates of the rows in index ranges that are kept in "
+       "each open table, so that later statements do not dive into the "
+       "index again for the same ranges. An estimate is not used after "
+       "more than 1/16 of the rows of the table have changed. Only used "
+       "for storage engines that count the changes, such as InnoDB. "
+       "0 disables the cache",
+       SESSION_VAR(range_estimate_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 65536), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_uint Sys_scan_filter_batch_size(
+       "scan_filter_batch_size",
+       "Number of rows that a table scan reads ahead to evaluate simple "
+       "integer comparisons of the WHERE condition for all of them at "
+       "once, skipping the rows that cannot match. "
+       "If set to 0, the condition is evaluated one row at a time.",
+       SESSION_VAR(scan_filter_batch_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 65536), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_uint Sys_parallel_query_degree(
+       "parallel_query_degree",
+       "Number of threads that filter and aggregate the rows of a "
+       "GROUP BY query over a single table scan. "
+       "If set to 1, the query is executed by the session thread only.",
+       SESSION_VAR(parallel_query_degree), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, 64), DEFAULT(1), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_range_alloc_block_size(
        "range_alloc_block_size",
        "Allocation block size for storing ranges during optimization",
@@ -3618,6 +3684,14 @@ static Sys_var_ulong Sys_sort_buffer(
        VALID_RANGE(MIN_SORT_MEMORY, ULONG_MAX), DEFAULT(DEFAULT_SORT_MEMORY),
        BLOCK_SIZE(1));
 
+static Sys_var_uint Sys_sort_threads(
+       "sort_threads",
+       "Number of threads that sort the keys of a sort buffer. Each thread "
+       "sorts at least 16384 keys. If set to 1, keys are sorted by the "
+       "session thread only.",
+       SESSION_VAR(sort_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, 64), DEFAULT(1), BLOCK_SIZE(1));
+
 /**
   Check sql modes strict_mode, 'NO_ZERO_DATE', 'NO_ZERO_IN_DATE' and
   'ERROR_FOR_DIVISION_BY_ZERO' are used together. If only subset of it
@@ -5414,6 +5488,14 @@ static Sys_var_ulong Sys_sp_cache_size(
        GLOBAL_VAR(stored_program_cache_size), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(16, 512 * 1024), DEFAULT(256), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_sp_shared_cache_size(
+       "stored_program_shared_cache",
+       "The upper limit for number of stored routines that are kept for "
+       "other connections when a connection no longer uses them, so that "
+       "they do not need to be parsed again. 0 disables the shared cache.",
+       GLOBAL_VAR(stored_program_shared_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 512 * 1024), DEFAULT(0), BLOCK_SIZE(1));
+
 static bool check_pseudo_slave_mode(sys_var *self, THD *thd, set_var *var)
 {
   if (check_outside_trx(self, thd, var))
@@ -23,9 +23,11 @@
 #include "auth_common.h"                 // acl_getroot
 #include "binlog.h"                      // mysql_bin_log
 #include "debug_sync.h"                  // DEBUG_SYNC
+#include "histogram.h"                   // attach_histograms
 #include "item_cmpfunc.h"                // and_conds
 #include "key.h"                         // find_ref_key
 #include "log.h"                         // sql_print_warning
+#include "opt_range_cache.h"             // Range_estimate_cache
 #include "opt_trace.h"                   // opt_trace_disable_if_no_security_...
 #include "parse_file.h"                  // sql_parse_prepare
 #include "partition_info.h"              // partition_info
@@ -824,6 +826,10 @@ int open_table_def(THD *thd, TABLE_SHARE *share, uint db_flags)
 
   share->table_category= get_table_category(share->db, share->table_name);
 
+  if (!error && table_type == 1 && share->tmp_table == NO_TMP_TABLE &&
+      share->table_category == TABLE_CATEGORY_USER)
+    attach_histograms(share);
+
   if (!error)
     thd->status_var.opened_shares++;
 
@@ -3478,6 +3484,8 @@ int closefrm(TABLE *table, bool free_share)
   }
   delete table->file;
   table->file= 0;				/* For easier errorchecking */
+  delete table->range_estimate_cache;
+  table->range_estimate_cache= NULL;
   if (table->part_info)
   {
     /* Allocated through table->mem_root, freed below */
@@ -45,11 +45,13 @@ class Table_trigger_dispatcher;
 class Query_result_union;
 class Temp_table_param;
 class Index_hint;
+class Histogram;
 struct Name_resolution_context;
 struct LEX;
 typedef int8 plan_idx;
 class Opt_hints_qb;
 class Opt_hints_table;
+class Range_estimate_cache;
 
 #define store_record(A,B) memcpy((A)->B,(A)->record[0],(size_t) (A)->s->reclength)
 #define restore_record(A,B) memcpy((A)->record[0],(A)->B,(size_t) (A)->s->reclength)
@@ -581,6 +583,11 @@ struct TABLE_SHARE
   Field **found_next_number_field;
   KEY  *key_info;			/* data of keys defined for the table */
   uint	*blob_field;			/* Index to blobs in Field arrray*/
+  /**
+    Histograms of the columns, indexed by field number, or NULL if the
+    table has none. See attach_histograms().
+  */
+  const Histogram **histograms;
 
   uchar	*default_values;		/* row with default values */
   LEX_STRING comment;			/* Comment about table */
@@ -626,6 +633,10 @@ struct TABLE_SHARE
                                            (no generated-only generated fields) */
 
   plugin_ref db_plugin;			/* storage engine plugin */
+  /** The histogram of a column, or NULL */
+  const Histogram *find_histogram(uint field_index) const
+  { return histograms ? histograms[field_index] : NULL; }
+
   inline handlerton *db_type() const	/* table_type for handler */
   { 
     // DBUG_ASSERT(db_plugin);
@@ -1146,6 +1157,9 @@ public:
   */
   ha_rows       quick_condition_rows;
 
+  /// Estimates of records_in_range() kept between statements, or NULL
+  Range_estimate_cache *range_estimate_cache;
+
   uint          lock_position;          /* Position in MYSQL_LOCK.table */
   uint          lock_data_start;        /* Start pos. in MYSQL_LOCK.locks */
   uint          lock_count;             /* Number of locks */
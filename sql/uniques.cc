@@ -37,6 +37,8 @@
 #include "sql_base.h"                           // TEMP_PREFIX
 #include "priority_queue.h"
 #include "malloc_allocator.h"
+#include "my_murmur3.h"                         // murmur3_32
+#include "mysqld.h"                             // key_memory_Unique_hash
 
 #include <algorithm>
 
@@ -728,3 +730,239 @@ err:
   outfile->end_of_file=save_pos;
   return error;
 }
+
+
+/** Initial capacity of the hash table of a Unique_hash, at most */
+static const ulong UNIQUE_HASH_INITIAL_CAPACITY= 1024;
+
+
+Unique_hash::Unique_hash(uint size_arg, ulonglong max_in_memory_size_arg,
+                         uint level_arg)
+  : m_size(size_arg), m_max_in_memory_size(max_in_memory_size_arg),
+    m_level(level_arg), m_capacity(0), m_elements(0), m_keys(NULL),
+    m_hashes(NULL), m_files(NULL)
+{
+  /* The table is at most half full, and has room for one key at least */
+  const ulonglong slot_size= m_size + sizeof(uint32);
+  m_max_capacity= 2;
+  while (m_max_capacity * 2 * slot_size <= m_max_in_memory_size &&
+         m_max_capacity < (1UL << 30))
+    m_max_capacity*= 2;
+}
+
+
+Unique_hash::~Unique_hash()
+{
+  reset();
+  free_memory();
+}
+
+
+uint32 Unique_hash::hash(const uchar *key) const
+{
+  const uint32 nr= murmur3_32(key, m_size, m_level * 0x9E3779B9U);
+  return nr ? nr : 1;
+}
+
+
+void Unique_hash::free_memory()
+{
+  my_free(m_keys);
+  my_free(m_hashes);
+  m_keys= NULL;
+  m_hashes= NULL;
+  m_capacity= 0;
+  m_elements= 0;
+}
+
+
+/**
+  Rehash the keys into a table with the given number of slots.
+*/
+
+bool Unique_hash::resize(ulong capacity)
+{
+  uchar *keys= static_cast<uchar*>(my_malloc(key_memory_Unique_hash,
+                                             capacity * m_size, MYF(MY_WME)));
+  uint32 *hashes=
+    static_cast<uint32*>(my_malloc(key_memory_Unique_hash,
+                                   capacity * sizeof(uint32),
+                                   MYF(MY_WME | MY_ZEROFILL)));
+  if (keys == NULL || hashes == NULL)
+  {
+    my_free(keys);
+    my_free(hashes);
+    return true;
+  }
+  const ulong mask= capacity - 1;
+  for (ulong i= 0; i < m_capacity; i++)
+  {
+    if (m_hashes[i] == 0)
+      continue;
+    ulong slot= m_hashes[i] & mask;
+    while (hashes[slot] != 0)
+      slot= (slot + 1) & mask;
+    hashes[slot]= m_hashes[i];
+    memcpy(keys + slot * m_size, m_keys + i * m_size, m_size);
+  }
+  my_free(m_keys);
+  my_free(m_hashes);
+  m_keys= keys;
+  m_hashes= hashes;
+  m_capacity= capacity;
+  return false;
+}
+
+
+/**
+  Append the keys in the hash table to the partition files, and empty it.
+  The top bits of the hash select the file, the table uses the low ones.
+*/
+
+bool Unique_hash::spill()
+{
+  if (m_files == NULL)
+  {
+    m_files= static_cast<IO_CACHE*>(
+      my_malloc(key_memory_Unique_hash,
+                UNIQUE_HASH_PARTITIONS * sizeof(IO_CACHE),
+                MYF(MY_WME | MY_ZEROFILL)));
+    if (m_files == NULL)
+      return true;
+    for (uint i= 0; i < UNIQUE_HASH_PARTITIONS; i++)
+    {
+      if (open_cached_file(&m_files[i], mysql_tmpdir, TEMP_PREFIX,
+                           DISK_BUFFER_SIZE, MYF(MY_WME)))
+        return true;
+    }
+  }
+  for (ulong i= 0; i < m_capacity; i++)
+  {
+    if (m_hashes[i] == 0)
+      continue;
+    const uint partition= m_hashes[i] >> 28;
+    if (my_b_write(&m_files[partition], m_keys + i * m_size, m_size))
+      return true;
+  }
+  memset(m_hashes, 0, m_capacity * sizeof(uint32));
+  m_elements= 0;
+  return false;
+}
+
+
+bool Unique_hash::unique_add(const void *key_arg)
+{
+  const uchar *key= static_cast<const uchar*>(key_arg);
+  const uint32 nr= hash(key);
+
+  if (m_capacity == 0 &&
+      resize(std::min(m_max_capacity, UNIQUE_HASH_INITIAL_CAPACITY)))
+    return true;
+
+  ulong mask= m_capacity - 1;
+  ulong slot= nr & mask;
+  while (m_hashes[slot] != 0)
+  {
+    if (m_hashes[slot] == nr && !memcmp(m_keys + slot * m_size, key, m_size))
+      return false;                             // Duplicate
+    slot= (slot + 1) & mask;
+  }
+
+  if ((m_elements + 1) * 2 > m_capacity)
+  {
+    if (m_capacity < m_max_capacity)
+    {
+      if (resize(m_capacity * 2))
+        return true;
+    }
+    else if (spill())
+      return true;
+    mask= m_capacity - 1;
+    slot= nr & mask;
+    while (m_hashes[slot] != 0)
+      slot= (slot + 1) & mask;
+  }
+  m_hashes[slot]= nr;
+  memcpy(m_keys + slot * m_size, key, m_size);
+  m_elements++;
+  return false;
+}
+
+
+int Unique_hash::walk(tree_walk_action action, void *walk_action_arg)
+{
+  if (m_files == NULL)
+  {
+    for (ulong i= 0; i < m_capacity; i++)
+    {
+      if (m_hashes[i] == 0)
+        continue;
+      const int res= action(m_keys + i * m_size, 1, walk_action_arg);
+      if (res)
+        return res;
+    }
+    return 0;
+  }
+
+  /* Move the rest to the files, and leave the memory to the partitions */
+  if (spill())
+    return 1;
+  free_memory();
+
+  uchar *const key= static_cast<uchar*>(my_malloc(key_memory_Unique_hash,
+                                                  m_size, MYF(MY_WME)));
+  if (key == NULL)
+    return 1;
+  int res= 0;
+  for (uint i= 0; i < UNIQUE_HASH_PARTITIONS && res == 0; i++)
+  {
+    IO_CACHE *const file= &m_files[i];
+    if (my_b_tell(file) == 0)
+      continue;
+    if (flush_io_cache(file) || reinit_io_cache(file, READ_CACHE, 0L, 0, 0))
+    {
+      res= 1;
+      break;
+    }
+    Unique_hash partition(m_size, m_max_in_memory_size, m_level + 1);
+    while (!my_b_read(file, key, m_size))
+    {
+      if (partition.unique_add(key))
+      {
+        res= 1;
+        break;
+      }
+    }
+    if (res == 0 && file->error != 0)
+      res= 1;
+    if (res == 0)
+      res= partition.walk(action, walk_action_arg);
+    /* The file is not needed anymore, free its space */
+    close_cached_file(file);
+  }
+  my_free(key);
+  return res;
+}
+
+
+void Unique_hash::reset()
+{
+  if (m_files != NULL)
+  {
+    for (uint i= 0; i < UNIQUE_HASH_PARTITIONS; i++)
+      close_cached_file(&m_files[i]);
+    my_free(m_files);
+    m_files= NULL;
+  }
+  /*
+    Clearing a table that has grown would cost as much for every small
+    set of keys that follows a large one, e.g. in each group of COUNT
+    (DISTINCT). Start over from the initial size instead: growing again
+    costs about as much as adding the keys.
+  */
+  if (m_capacity > UNIQUE_HASH_INITIAL_CAPACITY)
+    free_memory();
+  else if (m_hashes != NULL)
+    memset(m_hashes, 0, m_capacity * sizeof(uint32));
+  m_elements= 0;
+}
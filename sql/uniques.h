@@ -85,6 +85,87 @@ public:
 };
 
 
+/**
+  Number of files that the keys of a Unique_hash are partitioned into when
+  they do not fit in memory.
+*/
+#define UNIQUE_HASH_PARTITIONS 16
+
+/**
+  Removal of duplicates for fixed size keys that are equal only if all
+  their bytes are equal.
+
+  The keys are stored in an open addressing hash table with linear
+  probing, so adding a key is a hash lookup instead of a tree insert, and
+  no per-key node is allocated. When the table would use more than
+  max_in_memory_size bytes, its keys are appended to one of
+  UNIQUE_HASH_PARTITIONS files chosen by the hash of the key, and the
+  table starts over empty. Duplicates of a key are then always in the
+  same file, so walk() can remove them one file at a time, with a
+  Unique_hash of its own. That one hashes with another seed, so it
+  partitions the file further if it does not fit in memory either.
+
+  Unlike Unique, the keys are not walked in sorted order.
+*/
+
+class Unique_hash : public Sql_alloc
+{
+public:
+  /**
+    @param size_arg                  Size of a key
+    @param max_in_memory_size_arg    Memory the hash table may use
+    @param level_arg                 Partitioning level, selects the seed
+                                     of the hash function
+  */
+  Unique_hash(uint size_arg, ulonglong max_in_memory_size_arg,
+              uint level_arg= 0);
+  ~Unique_hash();
+
+  /**
+    Add a key, unless it has been added before.
+
+    @retval false  OK
+    @retval true   Out of memory or write error, it has been reported
+  */
+  bool unique_add(const void *key);
+
+  /** Whether all keys are in memory, and elements_in_memory() are unique */
+  bool is_in_memory() const { return m_files == NULL; }
+  ulong elements_in_memory() const { return m_elements; }
+
+  /**
+    Call action for each unique key, in no particular order. If keys have
+    been written to disk, reset() must be called before the object is
+    used again.
+
+    @return The first non-zero value returned by action, or 1 on error
+  */
+  int walk(tree_walk_action action, void *walk_action_arg);
+
+  /** Forget all keys */
+  void reset();
+
+private:
+  uint32 hash(const uchar *key) const;
+  bool resize(ulong capacity);
+  bool spill();
+  void free_memory();
+
+  const uint m_size;
+  const ulonglong m_max_in_memory_size;
+  const uint m_level;
+  /** Largest capacity that fits in m_max_in_memory_size */
+  ulong m_max_capacity;
+  /** Number of slots, a power of two */
+  ulong m_capacity;
+  ulong m_elements;
+  /** Key of each slot */
+  uchar *m_keys;
+  /** Hash value of each slot, 0 for an empty slot */
+  uint32 *m_hashes;
+  /** Partition files, NULL while all keys are in memory */
+  IO_CACHE *m_files;
+};
 
 
 #endif  // UNIQUES_INCLUDED
@@ -385,16 +385,23 @@ int ha_heap::rnd_pos(uchar * buf, uchar *pos)
   MYSQL_READ_ROW_START(table_share->db.str, table_share->table_name.str,
                        FALSE);
   ha_statistic_increment(&SSV::ha_read_rnd_count);
-  memcpy(&heap_position, pos, sizeof(HEAP_PTR));
+  heap_position= (HEAP_PTR) (intptr) my_get_ptr(pos, ref_length);
   error=heap_rrnd(file, buf, heap_position);
   table->status=error ? STATUS_NOT_FOUND: 0;
   MYSQL_READ_ROW_DONE(error);
   return error;
 }
 
+/*
+  The pointer is stored with the most significant byte first, like the
+  positions of MyISAM. Filesort breaks ties between equal sort keys by
+  comparing the refs, so rows of a block keep the order they were
+  written in, also for internal tables with BLOBs.
+*/
+
 void ha_heap::position(const uchar *record)
 {
-  *(HEAP_PTR*) ref= heap_position(file);	// Ref is aligned
+  my_store_ptr(ref, ref_length, (my_off_t) (intptr) heap_position(file));
 }
 
 int ha_heap::info(uint flag)
@@ -652,6 +659,7 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   ha_rows max_rows;
   HP_KEYDEF *keydef;
   HA_KEYSEG *seg;
+  HP_BLOBDEF *blobdef;
   TABLE_SHARE *share= table_arg->s;
   bool found_real_auto_increment= 0;
 
@@ -662,10 +670,25 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
 
   if (!(keydef= (HP_KEYDEF*) my_malloc(hp_key_memory_HP_KEYDEF,
                                        keys * sizeof(HP_KEYDEF) +
-				       parts * sizeof(HA_KEYSEG),
+				       parts * sizeof(HA_KEYSEG) +
+                                       share->blob_fields * sizeof(HP_BLOBDEF),
 				       MYF(MY_WME))))
     return my_errno();
   seg= reinterpret_cast<HA_KEYSEG*>(keydef + keys);
+  blobdef= reinterpret_cast<HP_BLOBDEF*>(seg + parts);
+
+  /*
+    Only internal temporary tables can have BLOB columns, see
+    HA_NO_BLOBS. They are never part of a key of such a table.
+  */
+  DBUG_ASSERT(internal_table || share->blob_fields == 0);
+  for (uint i= 0; i < share->blob_fields; i++)
+  {
+    Field_blob *field=
+      static_cast<Field_blob*>(table_arg->field[share->blob_field[i]]);
+    blobdef[i].offset= field->offset(table_arg->record[0]);
+    blobdef[i].packlength= field->pack_length_no_ptr();
+  }
   for (key= 0; key < keys; key++)
   {
     KEY *pos= table_arg->key_info+key;
@@ -693,6 +716,7 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
     for (; key_part != key_part_end; key_part++, seg++)
     {
       Field *field= key_part->field;
+      DBUG_ASSERT(!(key_part->key_part_flag & HA_BLOB_PART));
 
       if (pos->algorithm == HA_KEY_ALG_BTREE)
 	seg->type= field->key_type();
@@ -745,6 +769,13 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   hp_create_info->auto_key= auto_key;
   hp_create_info->auto_key_type= auto_key_type;
   hp_create_info->max_table_size=current_thd->variables.max_heap_table_size;
+  /*
+    The size of the BLOB data is not known up front, so max_rows does not
+    limit the size of a table with BLOBs to tmp_table_size.
+  */
+  if (internal_table && share->blob_fields)
+    set_if_smaller(hp_create_info->max_table_size,
+                   current_thd->variables.tmp_table_size);
   hp_create_info->with_auto_increment= found_real_auto_increment;
   hp_create_info->internal_table= internal_table;
 
@@ -757,6 +788,8 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   hp_create_info->keys= share->keys;
   hp_create_info->reclength= share->reclength;
   hp_create_info->keydef= keydef;
+  hp_create_info->blobs= share->blob_fields;
+  hp_create_info->blobdef= blobdef;
   return 0;
 }
 
@@ -0,0 +1,220 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/*
+  Storage of BLOB columns.
+
+  A record in the heap block holds the length and a pointer for each BLOB
+  column, like the record buffer of the server does. The data of all BLOB
+  columns of a record is kept in one separately allocated chunk, that
+  starts with its length and is followed by the data of the columns in
+  column order. The chunk is freed when the record is deleted or updated,
+  and is counted in data_length, so that the table gets full when the data
+  would exceed max_table_size.
+*/
+
+#include "heapdef.h"
+
+/* Header of a chunk, the data of the columns follows it */
+typedef struct st_hp_blob_chunk
+{
+  size_t length;			/* Length of the data */
+} HP_BLOB_CHUNK;
+
+#define HP_BLOB_CHUNK_HEADER MY_ALIGN(sizeof(HP_BLOB_CHUNK), sizeof(char*))
+
+
+static inline uint32 blob_length(const HP_BLOBDEF *blob, const uchar *record)
+{
+  const uchar *pos= record + blob->offset;
+  switch (blob->packlength) {
+  case 1:
+    return (uint32) *pos;
+  case 2:
+    return uint2korr(pos);
+  case 3:
+    return uint3korr(pos);
+  case 4:
+    return uint4korr(pos);
+  default:
+    DBUG_ASSERT(0);
+    return 0;
+  }
+}
+
+
+/* The pointer follows the length, and need not be aligned */
+
+static inline uchar *get_blob_ptr(const HP_BLOBDEF *blob, const uchar *record)
+{
+  uchar *ptr;
+  memcpy(&ptr, record + blob->offset + blob->packlength, sizeof(ptr));
+  return ptr;
+}
+
+
+static inline void set_blob_ptr(const HP_BLOBDEF *blob, uchar *record,
+                                uchar *ptr)
+{
+  memcpy(record + blob->offset + blob->packlength, &ptr, sizeof(ptr));
+}
+
+
+/*
+  Allocate the chunk for the BLOB data of a record.
+
+  SYNOPSIS
+    hp_alloc_blobs()
+    share       Table
+    record      Record to be written, in the format of the server
+    check_size  Whether to fail if the table would get too big
+    chunk       Out: the chunk, or NULL if all BLOB columns are empty
+
+  NOTES
+    Updates do not check the size: the caller of an update can not
+    convert the table to an on-disk one, only the next write will fail.
+
+  RETURN
+    0                        OK
+    HA_ERR_RECORD_FILE_FULL  The data would exceed max_table_size
+    ENOMEM                   Out of memory
+*/
+
+int hp_alloc_blobs(HP_SHARE *share, const uchar *record, my_bool check_size,
+                   uchar **chunk)
+{
+  HP_BLOBDEF *blob, *end;
+  size_t length= 0;
+  DBUG_ENTER("hp_alloc_blobs");
+
+  for (blob= share->blobdef, end= blob + share->blobs; blob < end; blob++)
+    length+= blob_length(blob, record);
+
+  *chunk= NULL;
+  if (!length)
+    DBUG_RETURN(0);
+
+  length+= HP_BLOB_CHUNK_HEADER;
+  if (check_size &&
+      share->data_length + share->index_length + length >
+      share->max_table_size)
+  {
+    set_my_errno(HA_ERR_RECORD_FILE_FULL);
+    DBUG_RETURN(HA_ERR_RECORD_FILE_FULL);
+  }
+  if (!(*chunk= (uchar*) my_malloc(hp_key_memory_HP_BLOB, length, MYF(0))))
+  {
+    set_my_errno(ENOMEM);
+    DBUG_RETURN(ENOMEM);
+  }
+  ((HP_BLOB_CHUNK*) *chunk)->length= length;
+  share->data_length+= length;
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Copy the BLOB data of a record into its chunk.
+
+  SYNOPSIS
+    hp_store_blobs()
+    share     Table
+    pos       Record in the heap block, its BLOB pointers still point to
+              the data given by the caller
+    chunk     Chunk from hp_alloc_blobs() for the record
+
+  NOTES
+    The pointers of the record are changed to point into the chunk.
+    Empty columns get a NULL pointer.
+*/
+
+void hp_store_blobs(HP_SHARE *share, uchar *pos, uchar *chunk)
+{
+  HP_BLOBDEF *blob, *end;
+  uchar *data= chunk + HP_BLOB_CHUNK_HEADER;
+
+  for (blob= share->blobdef, end= blob + share->blobs; blob < end; blob++)
+  {
+    uint32 length= blob_length(blob, pos);
+    if (length)
+    {
+      memcpy(data, get_blob_ptr(blob, pos), length);
+      set_blob_ptr(blob, pos, data);
+      data+= length;
+    }
+    else
+      set_blob_ptr(blob, pos, NULL);
+  }
+}
+
+
+/* Free a chunk from hp_alloc_blobs() */
+
+void hp_free_blob_chunk(HP_SHARE *share, uchar *chunk)
+{
+  if (chunk)
+  {
+    share->data_length-= ((HP_BLOB_CHUNK*) chunk)->length;
+    my_free(chunk);
+  }
+}
+
+
+/*
+  Get the chunk of a record in the heap block.
+
+  NOTES
+    The data of the first non-empty column starts right after the header
+    of the chunk.
+
+  RETURN
+    The chunk, or NULL if all BLOB columns of the record are empty
+*/
+
+uchar *hp_blob_chunk(HP_SHARE *share, const uchar *pos)
+{
+  HP_BLOBDEF *blob, *end;
+
+  for (blob= share->blobdef, end= blob + share->blobs; blob < end; blob++)
+  {
+    uchar *data= get_blob_ptr(blob, pos);
+    if (data)
+      return data - HP_BLOB_CHUNK_HEADER;
+  }
+  return NULL;
+}
+
+
+/* Free the BLOB data of a record in the heap block */
+
+void hp_free_blobs(HP_SHARE *share, uchar *pos)
+{
+  hp_free_blob_chunk(share, hp_blob_chunk(share, pos));
+}
+
+
+/* Free the BLOB data of all records, before the blocks are freed */
+
+void hp_free_all_blobs(HP_SHARE *share)
+{
+  ulong pos, end= share->records + share->deleted;
+
+  for (pos= 0; pos < end; pos++)
+  {
+    uchar *record= hp_find_block(&share->block, pos);
+    if (record[share->reclength])
+      hp_free_blobs(share, record);
+  }
+}
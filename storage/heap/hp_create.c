@@ -134,7 +134,8 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
     if (!(share= (HP_SHARE*) my_malloc(hp_key_memory_HP_SHARE,
                                        (uint) sizeof(HP_SHARE)+
 				       keys*sizeof(HP_KEYDEF)+
-				       key_segs*sizeof(HA_KEYSEG),
+				       key_segs*sizeof(HA_KEYSEG)+
+				       create_info->blobs*sizeof(HP_BLOBDEF),
 				       MYF(MY_ZEROFILL))))
       goto err;
     share->keydef= (HP_KEYDEF*) (share + 1);
@@ -175,6 +176,11 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
       if ((keyinfo->flag & HA_AUTO_KEY) && create_info->with_auto_increment)
         share->auto_key= i + 1;
     }
+    share->blobdef= (HP_BLOBDEF*) keyseg;
+    share->blobs= create_info->blobs;
+    if (share->blobs)
+      memcpy(share->blobdef, create_info->blobdef,
+             sizeof(HP_BLOBDEF) * share->blobs);
     share->min_records= min_records;
     share->max_records= max_records;
     share->max_table_size= create_info->max_table_size;
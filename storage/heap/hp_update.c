@@ -20,7 +20,7 @@
 int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
 {
   HP_KEYDEF *keydef, *end, *p_lastinx;
-  uchar *pos;
+  uchar *pos, *blobs= NULL;
   my_bool auto_key_changed= 0;
   HP_SHARE *share= info->s;
   DBUG_ENTER("heap_update");
@@ -30,6 +30,8 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
 
   if (info->opt_flag & READ_CHECK_USED && hp_rectest(info,old))
     DBUG_RETURN(my_errno());				/* Record changed */
+  if (share->blobs && hp_alloc_blobs(share, heap_new, 0, &blobs))
+    DBUG_RETURN(my_errno());
   if (--(share->records) < share->blength >> 1) share->blength>>= 1;
   share->changed=1;
 
@@ -46,7 +48,16 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
     }
   }
 
-  memcpy(pos,heap_new,(size_t) share->reclength);
+  if (share->blobs)
+  {
+    /* The new BLOB values may point into the chunk of the old record */
+    uchar *old_blobs= hp_blob_chunk(share, pos);
+    memcpy(pos,heap_new,(size_t) share->reclength);
+    hp_store_blobs(share, pos, blobs);
+    hp_free_blob_chunk(share, old_blobs);
+  }
+  else
+    memcpy(pos,heap_new,(size_t) share->reclength);
   if (++(share->records) == share->blength) share->blength+= share->blength;
 
 #if !defined(DBUG_OFF) && defined(EXTRA_HEAP_DEBUG)
@@ -65,6 +76,7 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
       /* we don't need to delete non-inserted key from rb-tree */
       if ((*keydef->write_key)(info, keydef, old, pos))
       {
+        hp_free_blob_chunk(share, blobs);
         if (++(share->records) == share->blength)
 	  share->blength+= share->blength;
         DBUG_RETURN(my_errno());
@@ -82,6 +94,7 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
       keydef--;
     }
   }
+  hp_free_blob_chunk(share, blobs);
   if (++(share->records) == share->blength)
     share->blength+= share->blength;
   DBUG_RETURN(my_errno());
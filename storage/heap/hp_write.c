@@ -32,7 +32,7 @@ static HASH_INFO *hp_find_free_hash(HP_SHARE *info, HP_BLOCK *block,
 int heap_write(HP_INFO *info, const uchar *record)
 {
   HP_KEYDEF *keydef, *end;
-  uchar *pos;
+  uchar *pos, *blobs= NULL;
   HP_SHARE *share=info->s;
   DBUG_ENTER("heap_write");
 #ifndef DBUG_OFF
@@ -46,14 +46,19 @@ int heap_write(HP_INFO *info, const uchar *record)
     DBUG_RETURN(my_errno());
   share->changed=1;
 
-  for (keydef = share->keydef, end = keydef + share->keys; keydef < end;
-       keydef++)
+  keydef= share->keydef;
+  if (share->blobs && hp_alloc_blobs(share, record, 1, &blobs))
+    goto err_blobs;
+
+  for (end = keydef + share->keys; keydef < end; keydef++)
   {
     if ((*keydef->write_key)(info, keydef, record, pos))
       goto err;
   }
 
   memcpy(pos,record,(size_t) share->reclength);
+  if (share->blobs)
+    hp_store_blobs(share, pos, blobs);
   pos[share->reclength]=1;		/* Mark record as not deleted */
   if (++share->records == share->blength)
     share->blength+= share->blength;
@@ -87,7 +92,9 @@ err:
       break;
     keydef--;
   } 
+  hp_free_blob_chunk(share, blobs);
 
+err_blobs:
   share->deleted++;
   *((uchar**) pos)=share->del_link;
   share->del_link=pos;
@@ -79,6 +79,44 @@ buf_calc_page_crc32(
 	return(c1 ^ c2);
 }
 
+/** Copies a page and calculates its CRC32 checksum in the same pass, so
+that the page is only read once. The result is the same as that of
+buf_calc_page_crc32(page). The checksum is not stored in either copy.
+@param[out]	dst		destination (UNIV_PAGE_SIZE bytes), must not
+overlap page
+@param[in]	page		buffer page (UNIV_PAGE_SIZE bytes)
+@return checksum */
+uint32_t
+buf_calc_page_crc32_copy(
+	byte*		dst,
+	const byte*	page)
+{
+	/* The same fields as in buf_calc_page_crc32() are skipped,
+	they are copied as is. */
+
+	memcpy(dst, page, FIL_PAGE_OFFSET);
+
+	const uint32_t	c1 = ut_crc32_copy(
+		dst + FIL_PAGE_OFFSET,
+		page + FIL_PAGE_OFFSET,
+		FIL_PAGE_FILE_FLUSH_LSN - FIL_PAGE_OFFSET);
+
+	memcpy(dst + FIL_PAGE_FILE_FLUSH_LSN,
+	       page + FIL_PAGE_FILE_FLUSH_LSN,
+	       FIL_PAGE_DATA - FIL_PAGE_FILE_FLUSH_LSN);
+
+	const uint32_t	c2 = ut_crc32_copy(
+		dst + FIL_PAGE_DATA,
+		page + FIL_PAGE_DATA,
+		UNIV_PAGE_SIZE - FIL_PAGE_DATA - FIL_PAGE_END_LSN_OLD_CHKSUM);
+
+	memcpy(dst + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_OLD_CHKSUM,
+	       page + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_OLD_CHKSUM,
+	       FIL_PAGE_END_LSN_OLD_CHKSUM);
+
+	return(c1 ^ c2);
+}
+
 /********************************************************************//**
 Calculates a page checksum which is stored to the page when it is written
 to a file. Note that we must be careful to calculate the same value on
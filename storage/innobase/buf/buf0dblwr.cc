@@ -1087,7 +1087,11 @@ space to appear. */
 void
 buf_dblwr_add_to_batch(
 /*====================*/
-	buf_page_t*	bpage)	/*!< in: buffer block to write */
+	buf_page_t*	bpage,		/*!< in: buffer block to write */
+	bool		copy_crc32)	/*!< in: whether to calculate and
+					store the CRC32 checksum of the
+					uncompressed page while copying it,
+					see buf_flush_init_for_writing() */
 {
 	ut_a(buf_page_in_file(bpage));
 
@@ -1133,10 +1137,30 @@ try_again:
 	} else {
 		ut_a(buf_page_get_state(bpage) == BUF_BLOCK_FILE_PAGE);
 
-		UNIV_MEM_ASSERT_RW(((buf_block_t*) bpage)->frame,
-				   bpage->size.logical());
+		byte*	frame = ((buf_block_t*) bpage)->frame;
 
-		memcpy(p, ((buf_block_t*) bpage)->frame, bpage->size.logical());
+		UNIV_MEM_ASSERT_RW(frame, bpage->size.logical());
+
+		if (copy_crc32) {
+			const uint32_t	checksum = buf_calc_page_crc32_copy(
+				p, frame);
+
+			/* The page is written to the data file from the
+			frame, store the checksum in both copies. */
+			mach_write_to_4(frame + FIL_PAGE_SPACE_OR_CHKSUM,
+					checksum);
+			mach_write_to_4(frame + UNIV_PAGE_SIZE
+					- FIL_PAGE_END_LSN_OLD_CHKSUM,
+					checksum);
+
+			mach_write_to_4(p + FIL_PAGE_SPACE_OR_CHKSUM,
+					checksum);
+			mach_write_to_4(p + UNIV_PAGE_SIZE
+					- FIL_PAGE_END_LSN_OLD_CHKSUM,
+					checksum);
+		} else {
+			memcpy(p, frame, bpage->size.logical());
+		}
 	}
 
 	buf_dblwr->buf_block_arr[buf_dblwr->first_free] = bpage;
@@ -831,14 +831,20 @@ buf_flush_update_zip_checksum(
 @param[in,out]	page		page frame
 @param[in,out]	page_zip_	compressed page, or NULL if uncompressed
 @param[in]	newest_lsn	newest modification LSN to the page
-@param[in]	skip_checksum	whether to disable the page checksum */
-void
+@param[in]	skip_checksum	whether to disable the page checksum
+@param[in]	defer_crc32	whether the caller will calculate and store
+a CRC32 checksum itself while copying the page, see
+buf_calc_page_crc32_copy()
+@return true if a CRC32 checksum is to be stored, but was not stored
+because of defer_crc32 */
+bool
 buf_flush_init_for_writing(
 	const buf_block_t*	block,
 	byte*			page,
 	void*			page_zip_,
 	lsn_t			newest_lsn,
-	bool			skip_checksum)
+	bool			skip_checksum,
+	bool			defer_crc32)
 {
 	ib_uint32_t	checksum = BUF_NO_CHECKSUM_MAGIC;
 
@@ -875,7 +881,7 @@ buf_flush_init_for_writing(
 			buf_flush_update_zip_checksum(
 				page_zip->data, size, newest_lsn);
 
-			return;
+			return(false);
 		}
 
 		ib::error() << "The compressed page to be written"
@@ -951,6 +957,12 @@ buf_flush_init_for_writing(
 		switch ((srv_checksum_algorithm_t) srv_checksum_algorithm) {
 		case SRV_CHECKSUM_ALGORITHM_CRC32:
 		case SRV_CHECKSUM_ALGORITHM_STRICT_CRC32:
+			if (defer_crc32) {
+				/* Both checksum fields are written by
+				the caller. */
+				return(true);
+			}
+
 			checksum = buf_calc_page_crc32(page);
 			mach_write_to_4(page + FIL_PAGE_SPACE_OR_CHKSUM,
 					checksum);
@@ -989,6 +1001,8 @@ buf_flush_init_for_writing(
 
 	mach_write_to_4(page + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_OLD_CHKSUM,
 			checksum);
+
+	return(false);
 }
 
 #ifndef UNIV_HOTBACKUP
@@ -1006,6 +1020,7 @@ buf_flush_write_block_low(
 	bool		sync)		/*!< in: true if sync IO request */
 {
 	page_t*	frame = NULL;
+	bool	copy_crc32 = false;
 
 #ifdef UNIV_DEBUG
 	buf_pool_t*	buf_pool = buf_pool_from_bpage(bpage);
@@ -1040,6 +1055,15 @@ buf_flush_write_block_low(
 		log_write_up_to(bpage->newest_modification, true);
 	}
 
+	/* Disable use of double-write buffer for temporary tablespace.
+	Given the nature and load of temporary tablespace doublewrite buffer
+	adds an overhead during flushing. */
+
+	const bool	use_dblwr = srv_use_doublewrite_buf
+		&& buf_dblwr != NULL
+		&& !srv_read_only_mode
+		&& !fsp_is_system_temporary(bpage->id.space());
+
 	switch (buf_page_get_state(bpage)) {
 	case BUF_BLOCK_POOL_WATCH:
 	case BUF_BLOCK_ZIP_PAGE: /* The page should be dirty. */
@@ -1063,23 +1087,23 @@ buf_flush_write_block_low(
 			frame = ((buf_block_t*) bpage)->frame;
 		}
 
-		buf_flush_init_for_writing(
+		/* An uncompressed page that is added to a doublewrite
+		batch is copied to the doublewrite buffer. A CRC32 checksum
+		is then calculated during that copy instead of in a separate
+		pass over the page. */
+		copy_crc32 = buf_flush_init_for_writing(
 			reinterpret_cast<const buf_block_t*>(bpage),
 			reinterpret_cast<const buf_block_t*>(bpage)->frame,
 			bpage->zip.data ? &bpage->zip : NULL,
 			bpage->newest_modification,
-			fsp_is_checksum_disabled(bpage->id.space()));
+			fsp_is_checksum_disabled(bpage->id.space()),
+			use_dblwr
+			&& flush_type != BUF_FLUSH_SINGLE_PAGE
+			&& bpage->zip.data == NULL);
 		break;
 	}
 
-	/* Disable use of double-write buffer for temporary tablespace.
-	Given the nature and load of temporary tablespace doublewrite buffer
-	adds an overhead during flushing. */
-
-	if (!srv_use_doublewrite_buf
-	    || buf_dblwr == NULL
-	    || srv_read_only_mode
-	    || fsp_is_system_temporary(bpage->id.space())) {
+	if (!use_dblwr) {
 
 		ut_ad(!srv_read_only_mode
 		      || fsp_is_system_temporary(bpage->id.space()));
@@ -1096,7 +1120,7 @@ buf_flush_write_block_low(
 		buf_dblwr_write_single_page(bpage, sync);
 	} else {
 		ut_ad(!sync);
-		buf_dblwr_add_to_batch(bpage);
+		buf_dblwr_add_to_batch(bpage, copy_crc32);
 	}
 
 	/* When doing single page flushing the IO is done synchronously
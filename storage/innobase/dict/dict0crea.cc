@@ -46,6 +46,7 @@ Created 1/8/1996 Heikki Tuuri
 #include "ut0vec.h"
 #include "dict0priv.h"
 #include "fts0priv.h"
+#include "ibuf0ibuf.h"
 #include "fsp0space.h"
 #include "fsp0sysspace.h"
 #include "srv0start.h"
@@ -1138,6 +1139,8 @@ dict_drop_index_tree(
 
 	ut_ad(len == 8);
 
+	ibuf_drop_index(space, mach_read_from_8(ptr));
+
 	bool			found;
 	const page_size_t	page_size(fil_space_get_page_size(space,
 								  &found));
@@ -551,6 +551,7 @@ dict_stats_empty_table(
 	table->stat_sum_of_other_index_sizes
 		= UT_LIST_GET_LEN(table->indexes) - 1;
 	table->stat_modified_counter = 0;
+	table->stat_generation++;
 
 	dict_index_t*	index;
 
@@ -670,6 +671,7 @@ dict_stats_copy(
 	dst->stat_clustered_index_size = src->stat_clustered_index_size;
 	dst->stat_sum_of_other_index_sizes = src->stat_sum_of_other_index_sizes;
 	dst->stat_modified_counter = src->stat_modified_counter;
+	dst->stat_generation++;
 
 	dict_index_t*	dst_idx;
 	dict_index_t*	src_idx;
@@ -927,6 +929,7 @@ dict_stats_update_transient(
 	table->stats_last_recalc = ut_time();
 
 	table->stat_modified_counter = 0;
+	table->stat_generation++;
 
 	table->stat_initialized = TRUE;
 }
@@ -2246,6 +2249,7 @@ dict_stats_update_persistent(
 	table->stats_last_recalc = ut_time();
 
 	table->stat_modified_counter = 0;
+	table->stat_generation++;
 
 	table->stat_initialized = TRUE;
 
@@ -5741,7 +5741,8 @@ fil_io(
 
 		req_type.set_punch_hole();
 
-		req_type.compression_algorithm(space->compression_type);
+		req_type.compression_algorithm(
+			space->compression_type, space->compression_level);
 
 	} else {
 		req_type.clear_compressed();
@@ -7224,6 +7225,7 @@ fil_set_compression(
 	}
 
 	space->compression_type = compression.m_type;
+	space->compression_level = compression.m_level;
 
 	if (space->compression_type != Compression::NONE) {
 
@@ -395,6 +395,7 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 	PSI_KEY(ibuf_bitmap_mutex),
 	PSI_KEY(ibuf_mutex),
 	PSI_KEY(ibuf_pessimistic_insert_mutex),
+	PSI_KEY(ibuf_stat_per_index_mutex),
 	PSI_KEY(log_sys_mutex),
 	PSI_KEY(log_sys_write_mutex),
 	PSI_KEY(log_cmdq_mutex),
@@ -427,6 +428,7 @@ static PSI_mutex_info all_innodb_mutexes[] = {
 	PSI_KEY(lock_wait_mutex),
 	PSI_KEY(trx_mutex),
 	PSI_KEY(srv_threads_mutex),
+	PSI_KEY(srv_conc_mutex),
 #  ifndef PFS_SKIP_EVENT_MUTEX
 	PSI_KEY(event_mutex),
 	PSI_KEY(event_manager_mutex),
@@ -1498,7 +1500,8 @@ innobase_srv_conc_enter_innodb(
 			--trx->n_tickets_to_enter_innodb;
 
 		} else if (trx->mysql_thd != NULL
-			   && thd_is_replication_slave_thread(trx->mysql_thd)) {
+			   && thd_is_replication_slave_thread(trx->mysql_thd)
+			   && !srv_thread_concurrency_queue) {
 
 			UT_WAIT_FOR(
 				srv_conc_get_active_threads()
@@ -2357,7 +2360,9 @@ Compression::is_none(const char* algorithm)
 	return(false);
 }
 
-/** Check for supported COMPRESS := (ZLIB | LZ4 | NONE) supported values
+/** Check for supported COMPRESS := (ZLIB | LZ4 | NONE) [":" level]
+supported values. The level is a per tablespace override of
+innodb_compression_level for ZLIB and the acceleration factor for LZ4.
 @param[in]	name		Name of the compression algorithm
 @param[out]	compression	The compression algorithm
 @return DB_SUCCESS or DB_UNSUPPORTED */
@@ -2366,22 +2371,64 @@ Compression::check(
 	const char*	algorithm,
 	Compression*	compression)
 {
+	compression->m_level = 0;
+
 	if (is_none(algorithm)) {
 
 		compression->m_type = NONE;
 
-	} else if (innobase_strcasecmp(algorithm, "zlib") == 0) {
+		return(DB_SUCCESS);
+	}
+
+	char		name[sizeof("zlib")];
+	const char*	level = strchr(algorithm, ':');
+	ulint		len = (level == NULL)
+		? strlen(algorithm)
+		: static_cast<ulint>(level - algorithm);
+
+	if (len >= sizeof(name)) {
+		return(DB_UNSUPPORTED);
+	}
+
+	memcpy(name, algorithm, len);
+	name[len] = 0;
+
+	ulint		max_level;
+
+	if (innobase_strcasecmp(name, "zlib") == 0) {
 
 		compression->m_type = ZLIB;
+		max_level = ZLIB_MAX_LEVEL;
 
-	} else if (innobase_strcasecmp(algorithm, "lz4") == 0) {
+	} else if (innobase_strcasecmp(name, "lz4") == 0) {
 
 		compression->m_type = LZ4;
+		max_level = LZ4_MAX_LEVEL;
 
 	} else {
 		return(DB_UNSUPPORTED);
 	}
 
+	if (level != NULL) {
+
+		char*		end;
+		ulint		n;
+
+		++level;
+
+		if (!isdigit(static_cast<unsigned char>(*level))) {
+			return(DB_UNSUPPORTED);
+		}
+
+		n = strtoul(level, &end, 10);
+
+		if (*end != 0 || n == 0 || n > max_level) {
+			return(DB_UNSUPPORTED);
+		}
+
+		compression->m_level = n;
+	}
+
 	return(DB_SUCCESS);
 }
 
@@ -8486,6 +8533,8 @@ ha_innobase::index_end(void)
 
 	in_range_check_pushed_down = FALSE;
 
+	m_prebuilt->m_key_ordered = false;
+
 	m_ds_mrr.dsmrr_close();
 
 	DBUG_RETURN(0);
@@ -13536,6 +13585,33 @@ func_exit:
 	DBUG_RETURN((ha_rows) n_rows);
 }
 
+/*********************************************************************//**
+Gets the number of rows changed in the table since its statistics were
+last recalculated, which tells when cached estimates of records_in_range()
+are stale.
+@return dict_table_t::stat_modified_counter */
+
+ha_rows
+ha_innobase::stat_modified_rows()
+/*==============================*/
+{
+	/* The counter is read without a latch, like in
+	row_update_statistics_if_needed(). */
+	return(static_cast<ha_rows>(m_prebuilt->table->stat_modified_counter));
+}
+
+/*********************************************************************//**
+Gets the number of times the statistics of the table have been
+recalculated, which restarts the count of stat_modified_rows().
+@return dict_table_t::stat_generation */
+
+ulonglong
+ha_innobase::stat_generation()
+/*===========================*/
+{
+	return(m_prebuilt->table->stat_generation);
+}
+
 /*********************************************************************//**
 Gives an UPPER BOUND to the number of rows in a table. This is used in
 filesort.cc.
@@ -15249,6 +15325,10 @@ ha_innobase::extra(
 	case HA_EXTRA_WRITE_CANNOT_REPLACE:
 		thd_to_trx(ha_thd())->duplicates &= ~TRX_DUP_REPLACE;
 		break;
+	case HA_EXTRA_KEY_ORDERED_READS:
+		/* Reset by index_end() */
+		m_prebuilt->m_key_ordered = true;
+		break;
 	default:/* Do nothing */
 		;
 	}
@@ -19353,6 +19433,15 @@ static MYSQL_SYSVAR_ULONG(purge_batch_size, srv_purge_batch_size,
   1,			/* Minimum value */
   5000, 0);		/* Maximum value */
 
+static MYSQL_SYSVAR_ULONG(version_cache_size, srv_vers_cache_size,
+  PLUGIN_VAR_OPCMDARG,
+  "Maximum memory in bytes used by each read view to cache the old row"
+  " versions built for consistent reads. 0 disables the cache.",
+  NULL, NULL,
+  0,			/* Default setting */
+  0,			/* Minimum value */
+  1024 * 1024 * 1024, 0);	/* Maximum value */
+
 static MYSQL_SYSVAR_ULONG(purge_threads, srv_n_purge_threads,
   PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
   "Purge threads can be from 1 to 32. Default is 4.",
@@ -19873,6 +19962,14 @@ static MYSQL_SYSVAR_ULONG(thread_concurrency, srv_thread_concurrency,
   "Helps in performance tuning in heavily concurrent environments. Sets the maximum number of threads allowed inside InnoDB. Value 0 will disable the thread throttling.",
   NULL, NULL, 0, 0, 1000, 0);
 
+static MYSQL_SYSVAR_BOOL(thread_concurrency_queue,
+  srv_thread_concurrency_queue,
+  PLUGIN_VAR_OPCMDARG,
+  "Let threads that cannot enter InnoDB because of innodb_thread_concurrency"
+  " wait in a FIFO queue instead of sleeping. Replication threads and"
+  " transactions holding locks are admitted first.",
+  NULL, NULL, FALSE);
+
 static MYSQL_SYSVAR_ULONG(
   adaptive_max_sleep_delay, srv_adaptive_max_sleep_delay,
   PLUGIN_VAR_RQCMDARG,
@@ -20025,6 +20122,13 @@ static MYSQL_SYSVAR_UINT(change_buffer_max_size,
   NULL, innodb_change_buffer_max_size_update,
   CHANGE_BUFFER_DEFAULT_SIZE, 0, 50, 0);
 
+static MYSQL_SYSVAR_ULONG(change_buffer_merge_threads,
+  srv_n_ibuf_merge_threads,
+  PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+  "Number of background threads merging the change buffer, from 0 to 32."
+  " 0 lets the master thread merge it.",
+  NULL, NULL, 0, 0, 32, 0);
+
 static MYSQL_SYSVAR_ENUM(stats_method, srv_innodb_stats_method,
    PLUGIN_VAR_RQCMDARG,
   "Specifies how InnoDB index statistics collection code should"
@@ -20293,6 +20397,7 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(spin_wait_delay),
   MYSQL_SYSVAR(table_locks),
   MYSQL_SYSVAR(thread_concurrency),
+  MYSQL_SYSVAR(thread_concurrency_queue),
   MYSQL_SYSVAR(adaptive_max_sleep_delay),
   MYSQL_SYSVAR(thread_sleep_delay),
   MYSQL_SYSVAR(tmpdir),
@@ -20304,6 +20409,7 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
 #endif /* HAVE_LIBNUMA */
   MYSQL_SYSVAR(change_buffering),
   MYSQL_SYSVAR(change_buffer_max_size),
+  MYSQL_SYSVAR(change_buffer_merge_threads),
 #if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
   MYSQL_SYSVAR(change_buffering_debug),
   MYSQL_SYSVAR(disable_background_merge),
@@ -20320,6 +20426,7 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(monitor_reset_all),
   MYSQL_SYSVAR(purge_threads),
   MYSQL_SYSVAR(purge_batch_size),
+  MYSQL_SYSVAR(version_cache_size),
 #ifdef UNIV_DEBUG
   MYSQL_SYSVAR(background_drop_list_empty),
   MYSQL_SYSVAR(purge_run_now),
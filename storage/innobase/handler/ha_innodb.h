@@ -211,6 +211,10 @@ public:
 		key_range*		min_key,
 		key_range*		max_key);
 
+	ha_rows stat_modified_rows();
+
+	ulonglong stat_generation();
+
 	ha_rows estimate_rows_upper_bound();
 
 	void update_create_info(HA_CREATE_INFO* create_info);
@@ -1784,6 +1784,7 @@ ha_innopart::index_end()
 	if (part_id == MY_BIT_NONE) {
 		/* Never initialized any index. */
 		active_index = MAX_KEY;
+		m_prebuilt->m_key_ordered = false;
 		DBUG_RETURN(0);
 	}
 	if (m_ordered) {
@@ -66,6 +66,10 @@ my_bool	srv_ibuf_disable_background_merge;
 #include "fsp0sysspace.h"
 #include "rem0cmp.h"
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 /*	STRUCTURE OF AN INSERT BUFFER RECORD
 
 In versions < 4.1.x:
@@ -288,6 +292,36 @@ static ib_mutex_t	ibuf_mutex;
 /** The mutex protecting the insert buffer bitmaps */
 static ib_mutex_t	ibuf_bitmap_mutex;
 
+/** The mutex protecting ibuf_stat_per_index */
+static ib_mutex_t	ibuf_stat_per_index_mutex;
+
+/** Tablespace and index identifier of a secondary index */
+typedef std::pair<ulint, index_id_t>	ibuf_stat_index_t;
+
+/** Number of buffered changes, indexed by the tablespace identifier and
+dict_index_t::id */
+typedef std::map<
+	ibuf_stat_index_t,
+	ulint,
+	std::less<ibuf_stat_index_t>,
+	ut_allocator<std::pair<const ibuf_stat_index_t, ulint> > >
+	ibuf_stat_per_index_t;
+
+/** Number of buffered changes per secondary index. Changes which were
+buffered before the server was started are not counted, and an index
+is removed from the map once its changes have been merged, or deleted
+with its tablespace or index tree. Protected by
+ibuf_stat_per_index_mutex. */
+static ibuf_stat_per_index_t*	ibuf_stat_per_index;
+
+/** Maximum number of indexes listed by ibuf_print() */
+static const ulint	IBUF_STAT_PER_INDEX_PRINT_MAX = 10;
+
+/** The (space, page) position from which the change buffer merge
+threads continue their sweep of the ibuf tree. Protected by ibuf_mutex. */
+static ulint		ibuf_merge_sweep_space;
+static ulint		ibuf_merge_sweep_page_no;
+
 /** The area in pages from which contract looks for page numbers for merge */
 const ulint		IBUF_MERGE_AREA = 8;
 
@@ -459,6 +493,11 @@ ibuf_close(void)
 
 	mutex_free(&ibuf_bitmap_mutex);
 
+	mutex_free(&ibuf_stat_per_index_mutex);
+
+	UT_DELETE(ibuf_stat_per_index);
+	ibuf_stat_per_index = NULL;
+
 	dict_table_t*	ibuf_table = ibuf->index->table;
 	rw_lock_free(&ibuf->index->lock);
 	dict_mem_index_free(ibuf->index);
@@ -517,6 +556,17 @@ ibuf_init_at_db_start(void)
 	mutex_create(LATCH_ID_IBUF_PESSIMISTIC_INSERT,
 		     &ibuf_pessimistic_insert_mutex);
 
+	/* ibuf_stat_per_index_mutex is acquired while holding index
+	page latches in ibuf_merge_or_delete_for_page(), and no other
+	latch is acquired while holding it. */
+	mutex_create(LATCH_ID_IBUF_STAT_PER_INDEX,
+		     &ibuf_stat_per_index_mutex);
+
+	ibuf_stat_per_index = UT_NEW_NOKEY(ibuf_stat_per_index_t());
+
+	ibuf_merge_sweep_space = 0;
+	ibuf_merge_sweep_page_no = 0;
+
 	mtr_start(&mtr);
 
 	mtr_x_lock_space(IBUF_SPACE_ID, &mtr);
@@ -1429,6 +1479,111 @@ ibuf_add_ops(
 	}
 }
 
+/** Count changes that were buffered for an index.
+@param[in]	space		tablespace identifier
+@param[in]	index_id	index identifier
+@param[in]	n		number of buffered changes */
+static
+void
+ibuf_stat_per_index_add(
+	ulint		space,
+	index_id_t	index_id,
+	ulint		n)
+{
+	mutex_enter(&ibuf_stat_per_index_mutex);
+	(*ibuf_stat_per_index)[ibuf_stat_index_t(space, index_id)] += n;
+	mutex_exit(&ibuf_stat_per_index_mutex);
+}
+
+/** Discount changes that were merged or discarded for an index.
+@param[in]	space		tablespace identifier
+@param[in]	index_id	index identifier
+@param[in]	n		number of merged or discarded changes */
+static
+void
+ibuf_stat_per_index_sub(
+	ulint		space,
+	index_id_t	index_id,
+	ulint		n)
+{
+	mutex_enter(&ibuf_stat_per_index_mutex);
+
+	ibuf_stat_per_index_t::iterator	it
+		= ibuf_stat_per_index->find(
+			ibuf_stat_index_t(space, index_id));
+
+	/* The changes may have been buffered before the startup */
+	if (it != ibuf_stat_per_index->end()) {
+		if (it->second <= n) {
+			ibuf_stat_per_index->erase(it);
+		} else {
+			it->second -= n;
+		}
+	}
+
+	mutex_exit(&ibuf_stat_per_index_mutex);
+}
+
+/** Discount all the changes of the indexes of a tablespace, when they
+are deleted with the tablespace. The change buffer records do not tell
+which index they are for.
+@param[in]	space		tablespace identifier */
+static
+void
+ibuf_stat_per_index_drop_space(
+	ulint		space)
+{
+	mutex_enter(&ibuf_stat_per_index_mutex);
+
+	ibuf_stat_per_index->erase(
+		ibuf_stat_per_index->lower_bound(
+			ibuf_stat_index_t(space, 0)),
+		ibuf_stat_per_index->upper_bound(
+			ibuf_stat_index_t(space, IB_ID_MAX)));
+
+	mutex_exit(&ibuf_stat_per_index_mutex);
+}
+
+/** Print the indexes with the most buffered changes.
+@param[in,out]	file	file where to print */
+static
+void
+ibuf_stat_per_index_print(
+	FILE*	file)
+{
+	typedef std::pair<ulint, index_id_t>	count_t;
+	typedef std::vector<count_t, ut_allocator<count_t> >	counts_t;
+
+	counts_t	counts;
+
+	mutex_enter(&ibuf_stat_per_index_mutex);
+
+	counts.reserve(ibuf_stat_per_index->size());
+
+	for (ibuf_stat_per_index_t::const_iterator it
+		     = ibuf_stat_per_index->begin();
+	     it != ibuf_stat_per_index->end();
+	     ++it) {
+
+		counts.push_back(count_t(it->second, it->first.second));
+	}
+
+	mutex_exit(&ibuf_stat_per_index_mutex);
+
+	ulint	n_print = ut_min(counts.size(), IBUF_STAT_PER_INDEX_PRINT_MAX);
+
+	std::partial_sort(counts.begin(), counts.begin() + n_print,
+			  counts.end(), std::greater<count_t>());
+
+	fprintf(file, "buffered operations for %lu indexes:\n",
+		(ulong) counts.size());
+
+	for (ulint i = 0; i < n_print; i++) {
+		fprintf(file, " index id " IB_ID_FMT ": %lu\n",
+			counts[i].second, (ulong) counts[i].first);
+	}
+}
+
 /****************************************************************//**
 Print operation counts. The array must be of size IBUF_OP_COUNT. */
 static
@@ -2672,28 +2827,18 @@ ibuf_contract(
 	return(ibuf_merge_pages(&n_pages, sync));
 }
 
-/** Contract the change buffer by reading pages to the buffer pool.
+/** Determine how many pages a background merge batch should read.
 @param[in]	full		If true, do a full contraction based
 on PCT_IO(100). If false, the size of contract batch is determined
 based on the current size of the change buffer.
-@return a lower limit for the combined size in bytes of entries which
-will be merged from ibuf trees to the pages read, 0 if ibuf is
-empty */
+@return number of pages to merge */
+static
 ulint
-ibuf_merge_in_background(
+ibuf_merge_batch_size(
 	bool	full)
 {
-	ulint	sum_bytes	= 0;
-	ulint	sum_pages	= 0;
-	ulint	n_pag2;
 	ulint	n_pages;
 
-#if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
-	if (srv_ibuf_disable_background_merge) {
-		return(0);
-	}
-#endif /* UNIV_DEBUG || UNIV_IBUF_DEBUG */
-
 	if (full) {
 		/* Caller has requested a full batch */
 		n_pages = PCT_IO(100);
@@ -2715,6 +2860,33 @@ ibuf_merge_in_background(
 		mutex_exit(&ibuf_mutex);
 	}
 
+	return(n_pages);
+}
+
+/** Contract the change buffer by reading pages to the buffer pool.
+@param[in]	full		If true, do a full contraction based
+on PCT_IO(100). If false, the size of contract batch is determined
+based on the current size of the change buffer.
+@return a lower limit for the combined size in bytes of entries which
+will be merged from ibuf trees to the pages read, 0 if ibuf is
+empty */
+ulint
+ibuf_merge_in_background(
+	bool	full)
+{
+	ulint	sum_bytes	= 0;
+	ulint	sum_pages	= 0;
+	ulint	n_pag2;
+	ulint	n_pages;
+
+#if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
+	if (srv_ibuf_disable_background_merge) {
+		return(0);
+	}
+#endif /* UNIV_DEBUG || UNIV_IBUF_DEBUG */
+
+	n_pages = ibuf_merge_batch_size(full);
+
 	while (sum_pages < n_pages) {
 		ulint	n_bytes;
 
@@ -2731,6 +2903,201 @@ ibuf_merge_in_background(
 	return(sum_bytes);
 }
 
+/** Contract the change buffer by reading the pages that follow the
+merge sweep position to the buffer pool. The merge threads share the
+sweep position, so that together they walk the ibuf tree in
+(space, page) order instead of picking random leaf pages.
+@param[out]	n_pages		number of pages merged
+@return a lower limit for the combined size in bytes of entries which
+will be merged from ibuf trees to the pages read, 0 if ibuf is
+empty */
+static
+ulint
+ibuf_merge_sweep(
+	ulint*	n_pages)
+{
+	mtr_t		mtr;
+	btr_pcur_t	pcur;
+	ulint		sum_sizes;
+	ulint		page_nos[IBUF_MAX_N_PAGES_MERGED];
+	ulint		space_ids[IBUF_MAX_N_PAGES_MERGED];
+	ulint		space;
+	ulint		page_no;
+
+	*n_pages = 0;
+
+	mutex_enter(&ibuf_mutex);
+	space = ibuf_merge_sweep_space;
+	page_no = ibuf_merge_sweep_page_no;
+	mutex_exit(&ibuf_mutex);
+
+retry:
+	mem_heap_t*	heap = mem_heap_create(512);
+	dtuple_t*	tuple = ibuf_search_tuple_build(space, page_no, heap);
+
+	ibuf_mtr_start(&mtr);
+
+	/* Position the cursor on the first record at or after the
+	sweep position. */
+
+	btr_pcur_open(
+		ibuf->index, tuple, PAGE_CUR_GE, BTR_SEARCH_LEAF, &pcur,
+		&mtr);
+
+	mem_heap_free(heap);
+
+	ut_ad(page_validate(btr_pcur_get_page(&pcur), ibuf->index));
+
+	if (page_is_empty(btr_pcur_get_page(&pcur))) {
+		/* If a B-tree page is empty, it must be the root page
+		and the whole B-tree must be empty. InnoDB does not
+		allow empty B-tree pages other than the root. */
+		ut_ad(ibuf->empty);
+		ut_ad(page_get_space_id(btr_pcur_get_page(&pcur))
+		      == IBUF_SPACE_ID);
+		ut_ad(page_get_page_no(btr_pcur_get_page(&pcur))
+		      == FSP_IBUF_TREE_ROOT_PAGE_NO);
+
+		ibuf_mtr_commit(&mtr);
+		btr_pcur_close(&pcur);
+
+		return(0);
+	}
+
+	if (!btr_pcur_is_on_user_rec(&pcur)
+	    && !btr_pcur_move_to_next_user_rec(&pcur, &mtr)) {
+
+		ibuf_mtr_commit(&mtr);
+		btr_pcur_close(&pcur);
+
+		if (space == 0 && page_no == 0) {
+			return(0);
+		}
+
+		/* The sweep reached the end of the tree. Start over
+		from the beginning. */
+		space = 0;
+		page_no = 0;
+
+		goto retry;
+	}
+
+	sum_sizes = ibuf_get_merge_page_nos(TRUE,
+					    btr_pcur_get_rec(&pcur), &mtr,
+					    space_ids,
+					    page_nos, n_pages);
+
+	ibuf_mtr_commit(&mtr);
+	btr_pcur_close(&pcur);
+
+	if (*n_pages == 0) {
+		return(0);
+	}
+
+	/* Let the next batch continue after the last page of this one.
+	If several threads race here, some pages may be requested twice,
+	but buf_read_page_low() skips the pages that already are in the
+	buffer pool. */
+	mutex_enter(&ibuf_mutex);
+	ibuf_merge_sweep_space = space_ids[*n_pages - 1];
+	ibuf_merge_sweep_page_no = page_nos[*n_pages - 1] + 1;
+	mutex_exit(&ibuf_mutex);
+
+	/* Wait for the last read, so that each merge thread has at most
+	one batch in flight. */
+	buf_read_ibuf_merge_pages(true, space_ids, page_nos, *n_pages);
+
+	return(sum_sizes + 1);
+}
+
+/** Merge a batch of change buffer entries in a merge thread. The
+background batch size determined by the io_capacity is divided among
+the merge threads.
+@param[in]	full	whether the server has been idle, see
+ibuf_merge_in_background() */
+static
+void
+ibuf_merge_thread_batch(
+	bool	full)
+{
+	ulint	sum_pages	= 0;
+	ulint	n_pages;
+
+	/* We perform a dirty read of ibuf->empty, like ibuf_merge(). */
+	if (ibuf->empty) {
+		return;
+	}
+
+#if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
+	if (srv_ibuf_disable_background_merge || ibuf_debug) {
+		return;
+	}
+#endif /* UNIV_DEBUG || UNIV_IBUF_DEBUG */
+
+	n_pages = ibuf_merge_batch_size(full) / srv_n_ibuf_merge_threads;
+
+	if (n_pages == 0) {
+		n_pages = 1;
+	}
+
+	while (sum_pages < n_pages
+	       && srv_shutdown_state == SRV_SHUTDOWN_NONE) {
+
+		ulint	n_pag2;
+
+		if (ibuf_merge_sweep(&n_pag2) == 0) {
+			return;
+		}
+
+		sum_pages += n_pag2;
+	}
+}
+
+/** This is the change buffer merge thread. It wakes up once per second,
+or when a user thread finds the change buffer to be too big, and merges
+a batch of buffered changes to the index pages.
+@param[in]	arg	a dummy parameter required by os_thread_create.
+@return	this function does not return, calls os_thread_exit() */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(ibuf_merge_thread)(
+	void*	arg MY_ATTRIBUTE((unused)))
+{
+	my_thread_init();
+
+	ut_ad(!srv_read_only_mode);
+
+	os_atomic_increment_ulint(&srv_n_ibuf_merge_threads_active, 1);
+
+	ulint	old_activity_count = srv_get_activity_count();
+
+	while (srv_shutdown_state == SRV_SHUTDOWN_NONE) {
+		int64_t	sig_count = os_event_reset(srv_ibuf_merge_event);
+
+		os_event_wait_time_low(srv_ibuf_merge_event, 1000000,
+				       sig_count);
+
+		if (srv_shutdown_state != SRV_SHUTDOWN_NONE) {
+			break;
+		}
+
+		/* Like the master thread, do full batches while the
+		server is idle. */
+		bool	full = !srv_check_activity(old_activity_count);
+
+		old_activity_count = srv_get_activity_count();
+
+		ibuf_merge_thread_batch(full);
+	}
+
+	os_atomic_decrement_ulint(&srv_n_ibuf_merge_threads_active, 1);
+
+	my_thread_end();
+	os_thread_exit();
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
 /*********************************************************************//**
 Contract insert buffer trees after insert if they are too big. */
 UNIV_INLINE
@@ -2761,6 +3128,13 @@ ibuf_contract_after_insert(
 
 	sync = (size >= max_size + IBUF_CONTRACT_ON_INSERT_SYNC);
 
+	if (!sync && srv_n_ibuf_merge_threads_active > 0) {
+		/* Let the merge threads contract the change buffer
+		instead of delaying this user thread. */
+		os_event_set(srv_ibuf_merge_event);
+		return;
+	}
+
 	/* Contract at least entry_size many bytes */
 	sum_sizes = 0;
 	size = 1;
@@ -3806,6 +4180,8 @@ skip_watch:
 		/* fprintf(stderr, "Ibuf insert for page no %lu of index %s\n",
 		page_no, index->name); */
 #endif
+		ibuf_stat_per_index_add(index->space, index->id, 1);
+
 		DBUG_RETURN(TRUE);
 
 	} else {
@@ -4761,6 +5137,25 @@ reset_bit:
 	ibuf_add_ops(ibuf->n_merged_ops, mops);
 	ibuf_add_ops(ibuf->n_discarded_ops, dops);
 
+	if (block != NULL && fil_page_index_page_check(block->frame)) {
+		ulint	n_ops = 0;
+
+		for (ulint i = 0; i < IBUF_OP_COUNT; i++) {
+			n_ops += mops[i] + dops[i];
+		}
+
+		if (n_ops > 0) {
+			ibuf_stat_per_index_sub(
+				page_id.space(),
+				btr_page_get_index_id(block->frame), n_ops);
+		}
+	} else if (block == NULL && !update_ibuf_bitmap) {
+		/* The tablespace has been or is being deleted. If the
+		page was freed or is being reused instead, its index has
+		been dropped, see ibuf_drop_index(). */
+		ibuf_stat_per_index_drop_space(page_id.space());
+	}
+
 	if (space != NULL) {
 		fil_space_release(space);
 	}
@@ -4851,10 +5246,26 @@ leave_loop:
 	btr_pcur_close(&pcur);
 
 	ibuf_add_ops(ibuf->n_discarded_ops, dops);
+	ibuf_stat_per_index_drop_space(space);
 
 	mem_heap_free(heap);
 }
 
+/** Discount the buffered changes of an index whose tree is dropped. The
+changes are deleted when the pages of the index are freed or reused,
+which does not tell which index they were for.
+@param[in]	space		tablespace identifier
+@param[in]	index_id	index identifier */
+void
+ibuf_drop_index(
+	ulint		space,
+	index_id_t	index_id)
+{
+	mutex_enter(&ibuf_stat_per_index_mutex);
+	ibuf_stat_per_index->erase(ibuf_stat_index_t(space, index_id));
+	mutex_exit(&ibuf_stat_per_index_mutex);
+}
+
 /******************************************************************//**
 Looks if the insert buffer is empty.
 @return true if empty */
@@ -4923,6 +5334,8 @@ ibuf_print(
 #endif /* UNIV_IBUF_COUNT_DEBUG */
 
 	mutex_exit(&ibuf_mutex);
+
+	ibuf_stat_per_index_print(file);
 }
 
 /******************************************************************//**
@@ -48,6 +48,18 @@ buf_calc_page_crc32(
 	const byte*	page,
 	bool		use_legacy_big_endian = false);
 
+/** Copies a page and calculates its CRC32 checksum in the same pass, so
+that the page is only read once. The result is the same as that of
+buf_calc_page_crc32(page). The checksum is not stored in either copy.
+@param[out]	dst		destination (UNIV_PAGE_SIZE bytes), must not
+overlap page
+@param[in]	page		buffer page (UNIV_PAGE_SIZE bytes)
+@return checksum */
+uint32_t
+buf_calc_page_crc32_copy(
+	byte*		dst,
+	const byte*	page);
+
 /********************************************************************//**
 Calculates a page checksum which is stored to the page when it is written
 to a file. Note that we must be careful to calculate the same value on
@@ -91,7 +91,11 @@ space to appear. */
 void
 buf_dblwr_add_to_batch(
 /*====================*/
-	buf_page_t*	bpage);	/*!< in: buffer block to write */
+	buf_page_t*	bpage,		/*!< in: buffer block to write */
+	bool		copy_crc32);	/*!< in: whether to calculate and
+					store the CRC32 checksum of the
+					uncompressed page while copying it,
+					see buf_flush_init_for_writing() */
 
 /********************************************************************//**
 Flush a batch of writes to the datafiles that have already been
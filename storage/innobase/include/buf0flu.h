@@ -74,14 +74,20 @@ buf_flush_write_complete(
 @param[in,out]	page		page frame
 @param[in,out]	page_zip_	compressed page, or NULL if uncompressed
 @param[in]	newest_lsn	newest modification LSN to the page
-@param[in]	skip_checksum	whether to disable the page checksum */
-void
+@param[in]	skip_checksum	whether to disable the page checksum
+@param[in]	defer_crc32	whether the caller will calculate and store
+a CRC32 checksum itself while copying the page, see
+buf_calc_page_crc32_copy()
+@return true if a CRC32 checksum is to be stored, but was not stored
+because of defer_crc32 */
+bool
 buf_flush_init_for_writing(
 	const buf_block_t*	block,
 	byte*			page,
 	void*			page_zip_,
 	lsn_t			newest_lsn,
-	bool			skip_checksum);
+	bool			skip_checksum,
+	bool			defer_crc32 = false);
 
 #ifndef UNIV_HOTBACKUP
 # if defined UNIV_DEBUG || defined UNIV_IBUF_DEBUG
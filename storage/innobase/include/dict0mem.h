@@ -1596,6 +1596,12 @@ struct dict_table_t {
 	any latch, because this is only used for heuristics. */
 	ib_uint64_t				stat_modified_counter;
 
+	/** Incremented when stat_modified_counter is reset to zero at
+	statistics calculation, so that a value of the counter can be told
+	from the same value counted since a later calculation. Not protected
+	by any latch, like stat_modified_counter. */
+	ib_uint64_t				stat_generation;
+
 	/** Background stats thread is not working on this table. */
 	#define BG_STAT_NONE			0
 
@@ -219,6 +219,9 @@ struct fil_space_t {
 	/** Compression algorithm */
 	Compression::Type	compression_type;
 
+	/** Compression level, 0 means the algorithm default */
+	ulint			compression_level;
+
 	/** Encryption algorithm */
 	Encryption::Type	encryption_type;
 
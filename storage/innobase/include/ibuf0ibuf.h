@@ -356,6 +356,16 @@ void
 ibuf_delete_for_discarded_space(
 /*============================*/
 	ulint	space);	/*!< in: space id */
+
+/** Discount the buffered changes of an index whose tree is dropped. The
+changes are deleted when the pages of the index are freed or reused,
+which does not tell which index they were for.
+@param[in]	space		tablespace identifier
+@param[in]	index_id	index identifier */
+void
+ibuf_drop_index(
+	ulint		space,
+	index_id_t	index_id);
 /** Contract the change buffer by reading pages to the buffer pool.
 @param[in]	full		If true, do a full contraction based
 on PCT_IO(100). If false, the size of contract batch is determined
@@ -367,6 +377,16 @@ ulint
 ibuf_merge_in_background(
 	bool	full);
 
+/** This is the change buffer merge thread. It wakes up once per second,
+or when a user thread finds the change buffer to be too big, and merges
+a batch of buffered changes to the index pages.
+@param[in]	arg	a dummy parameter required by os_thread_create.
+@return	this function does not return, calls os_thread_exit() */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(ibuf_merge_thread)(
+	void*	arg);
+
 /** Contracts insert buffer trees by reading pages referring to space_id
 to the buffer pool.
 @returns number of pages merged.*/
@@ -214,14 +214,22 @@ struct Compression {
 		uint16_t	m_compressed_size;
 	};
 
+	/** Highest level accepted in COMPRESSION="zlib:N" */
+	static const ulint	ZLIB_MAX_LEVEL = 9;
+
+	/** Highest acceleration accepted in COMPRESSION="lz4:N" */
+	static const ulint	LZ4_MAX_LEVEL = 100;
+
 	/** Default constructor */
-	Compression() : m_type(NONE) { };
+	Compression() : m_type(NONE), m_level() { };
 
 	/** Specific constructor
-	@param[in]	type		Algorithm type */
-	explicit Compression(Type type)
+	@param[in]	type		Algorithm type
+	@param[in]	level		Algorithm specific level, 0 for default */
+	explicit Compression(Type type, ulint level = 0)
 		:
-		m_type(type)
+		m_type(type),
+		m_level(level)
 	{
 #ifdef UNIV_DEBUG
 		switch (m_type) {
@@ -241,9 +249,11 @@ struct Compression {
 	static bool is_compressed_page(const byte* page)
 		MY_ATTRIBUTE((warn_unused_result));
 
-        /** Check wether the compression algorithm is supported.
+        /** Check wether the compression algorithm is supported. The
+        algorithm can be followed by an optional level, "zlib:1".
         @param[in]      algorithm       Compression algorithm to check
-        @param[out]     type            The type that algorithm maps to
+        @param[out]     type            The type and level that algorithm
+					maps to
         @return DB_SUCCESS or error code */
 	static dberr_t check(const char* algorithm, Compression* type)
 		MY_ATTRIBUTE((warn_unused_result));
@@ -298,6 +308,12 @@ struct Compression {
 
 	/** Compression type */
 	Type		m_type;
+
+	/** Compression level. For ZLib this is the compress2() level and
+	for LZ4 it is the acceleration factor. 0 means use the default,
+	that is innodb_compression_level for ZLib. The level is only used
+	when writing, it is not stored in the page. */
+	ulint		m_level;
 };
 
 /** Encryption key length */
@@ -712,8 +728,9 @@ public:
 	}
 
 	/** Set compression algorithm
-	@param[in] compression	The compression algorithm to use */
-	void compression_algorithm(Compression::Type type)
+	@param[in] type		The compression algorithm to use
+	@param[in] level	The compression level, 0 for default */
+	void compression_algorithm(Compression::Type type, ulint level = 0)
 	{
 		if (type == Compression::NONE) {
 			return;
@@ -722,6 +739,7 @@ public:
 		set_punch_hole();
 
 		m_compression.m_type = type;
+		m_compression.m_level = level;
 	}
 
 	/** Get the compression algorithm.
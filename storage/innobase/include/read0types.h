@@ -34,6 +34,8 @@ Created 2/16/1997 Heikki Tuuri
 // Friend declaration
 class MVCC;
 
+struct row_vers_cache_t;
+
 /** Read view lists the trx ids of those transactions for which a consistent
 read should not see the modifications to the database. */
 
@@ -241,6 +243,26 @@ public:
 		return(m_ids.empty());
 	}
 
+	/**
+	@return the cache of old record versions built for this view */
+	row_vers_cache_t*& vers_cache()
+	{
+		return(m_vers_cache);
+	}
+
+	/**
+	Check whether the view was reopened since the last call, that is,
+	whether the cached old record versions may be for another snapshot.
+	@return true if the view was reopened */
+	bool vers_cache_reset()
+	{
+		bool	stale = m_vers_cache_stale;
+
+		m_vers_cache_stale = false;
+
+		return(stale);
+	}
+
 #ifdef UNIV_DEBUG
 	/**
 	@param rhs		view to compare with
@@ -321,6 +343,13 @@ private:
 	/** AC-NL-RO transaction view that has been "closed". */
 	bool		m_closed;
 
+	/** Old record versions built for this view, or NULL. Only
+	accessed by the thread using the view. */
+	row_vers_cache_t*	m_vers_cache;
+
+	/** true if m_vers_cache may be for an earlier snapshot */
+	bool		m_vers_cache_stale;
+
 	typedef UT_LIST_NODE_T(ReadView) node_t;
 
 	/** List of read views in trx_sys */
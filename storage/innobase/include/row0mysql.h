@@ -920,6 +920,9 @@ struct row_prebuilt_t {
 	/** Return materialized key for secondary index scan */
 	bool		m_read_virtual_key;
 
+	/** Searches are made in key order, see HA_EXTRA_KEY_ORDERED_READS */
+	bool		m_key_ordered;
+
 	/** The MySQL table object */
 	TABLE*		m_mysql_table;
 
@@ -37,6 +37,7 @@ Created 2/6/1997 Heikki Tuuri
 
 // Forward declaration
 class ReadView;
+struct row_vers_cache_t;
 
 /*****************************************************************//**
 Finds out if an active transaction has inserted or modified a secondary
@@ -146,6 +147,11 @@ row_vers_build_for_semi_consistent_read(
 	const dtuple_t**vrow);	/*!< out: holds virtual column info if any
 				is updated in the view */
 
+/** Free a cache of old record versions built for a read view.
+@param[in,out]	cache	cache to free, or NULL */
+void
+row_vers_cache_free(
+	row_vers_cache_t*	cache);
 
 #ifndef UNIV_NONINL
 #include "row0vers.ic"
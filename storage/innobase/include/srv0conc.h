@@ -52,7 +52,20 @@ we could get a deadlock. Value of 0 will disable the concurrency check. */
 
 extern ulong	srv_thread_concurrency;
 
+/** If TRUE, threads that cannot enter InnoDB because of
+srv_thread_concurrency wait in a queue instead of sleeping and retrying. */
+extern my_bool	srv_thread_concurrency_queue;
+
 struct row_prebuilt_t;
+
+/** Create the admission queue. */
+void
+srv_conc_init();
+
+/** Free the admission queue. */
+void
+srv_conc_free();
+
 /*********************************************************************//**
 Puts an OS thread to wait if there are too many concurrent threads
 (>= srv_thread_concurrency) inside InnoDB. The threads wait in a FIFO queue.
@@ -341,6 +341,7 @@ enum monitor_id_t {
 	MONITOR_INDEX_REORG_ATTEMPTS,
 	MONITOR_INDEX_REORG_SUCCESSFUL,
 	MONITOR_INDEX_DISCARD,
+	MONITOR_INDEX_LEAF_REUSE,
 
 	/* Adaptive Hash Index related counters */
 	MONITOR_MODULE_ADAPTIVE_HASH,
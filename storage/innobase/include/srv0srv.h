@@ -154,6 +154,9 @@ extern os_event_t	srv_buf_dump_event;
 /** The buffer pool resize thread waits on this event. */
 extern os_event_t	srv_buf_resize_event;
 
+/** Event to signal the change buffer merge threads */
+extern os_event_t	srv_ibuf_merge_event;
+
 /** The buffer pool dump/load file name */
 #define SRV_BUF_DUMP_FILENAME_DEFAULT	"ib_buffer_pool"
 extern char*		srv_buf_dump_filename;
@@ -335,6 +338,9 @@ extern ulint	srv_n_write_io_threads;
 
 extern uint	srv_change_buffer_max_size;
 
+/** Number of change buffer merge threads */
+extern ulong	srv_n_ibuf_merge_threads;
+
 /* Number of IO operations per second the server can do */
 extern ulong    srv_io_capacity;
 
@@ -409,6 +415,9 @@ extern ibool	srv_buf_dump_thread_active;
 /* true during the lifetime of the buffer pool resize thread */
 extern bool	srv_buf_resize_thread_active;
 
+/* Number of change buffer merge threads that are running */
+extern ulint	srv_n_ibuf_merge_threads_active;
+
 /* TRUE during the lifetime of the stats thread */
 extern ibool	srv_dict_stats_thread_active;
 
@@ -450,6 +459,10 @@ extern ulong srv_n_purge_threads;
 /* the number of pages to purge in one batch */
 extern ulong srv_purge_batch_size;
 
+/** Maximum size in bytes of the old record versions cached for one
+read view, 0 disables the cache */
+extern ulong srv_vers_cache_size;
+
 /* the number of sync wait arrays */
 extern ulong srv_sync_array_size;
 
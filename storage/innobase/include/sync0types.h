@@ -325,6 +325,7 @@ enum latch_id_t {
 	LATCH_ID_IBUF_BITMAP,
 	LATCH_ID_IBUF,
 	LATCH_ID_IBUF_PESSIMISTIC_INSERT,
+	LATCH_ID_IBUF_STAT_PER_INDEX,
 	LATCH_ID_LOG_SYS,
 	LATCH_ID_LOG_WRITE,
 	LATCH_ID_LOG_FLUSH_ORDER,
@@ -359,6 +360,7 @@ enum latch_id_t {
 	LATCH_ID_TRX_SYS,
 	LATCH_ID_SRV_SYS,
 	LATCH_ID_SRV_SYS_TASKS,
+	LATCH_ID_SRV_CONC,
 	LATCH_ID_PAGE_ZIP_STAT_PER_INDEX,
 	LATCH_ID_EVENT_MANAGER,
 	LATCH_ID_EVENT_MUTEX,
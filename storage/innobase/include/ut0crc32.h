@@ -54,7 +54,23 @@ extern ut_crc32_func_t	ut_crc32_legacy_big_endian;
 but very slow). */
 extern ut_crc32_func_t	ut_crc32_byte_by_byte;
 
+/** Copies len bytes from src to dst and calculates their CRC32 in the same
+pass over the data.
+@param dst - copy destination, must not overlap src.
+@param src - data over which to calculate CRC32.
+@param len - data length in bytes.
+@return CRC32 of src, same as ut_crc32(src, len) */
+typedef uint32_t	(*ut_crc32_copy_func_t)(byte* dst, const byte* src,
+						ulint len);
+
+/** Pointer to CRC32 calculation function that also copies the data. */
+extern ut_crc32_copy_func_t	ut_crc32_copy;
+
 /** Flag that tells whether the CPU supports CRC32 or not */
 extern bool		ut_crc32_sse2_enabled;
 
+/** Flag that tells whether the CPU supports PCLMULQDQ or not. It is
+used for combining the checksums of interleaved streams. */
+extern bool		ut_crc32_pclmul_enabled;
+
 #endif /* ut0crc32_h */
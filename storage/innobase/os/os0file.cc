@@ -1316,7 +1316,8 @@ os_file_compress_page(
 	ulint*		dst_len)
 {
 	ulint		len = 0;
-	ulint		compression_level = page_zip_level;
+	ulint		compression_level = compression.m_level > 0
+		? compression.m_level : page_zip_level;
 	ulint		page_type = mach_read_from_2(src + FIL_PAGE_TYPE);
 
 	/* The page size must be a multiple of the OS punch hole size. */
@@ -1383,11 +1384,15 @@ os_file_compress_page(
 
 	case Compression::LZ4:
 
-		len = LZ4_compress_default(
+		/* The level is the acceleration factor, a higher value
+		trades compression ratio for speed. */
+		len = LZ4_compress_fast(
 			reinterpret_cast<char*>(src) + FIL_PAGE_DATA,
 			reinterpret_cast<char*>(dst) + FIL_PAGE_DATA,
 			static_cast<int>(content_len),
-			static_cast<int>(out_len));
+			static_cast<int>(out_len),
+			compression.m_level > 0
+			? static_cast<int>(compression.m_level) : 1);
 
 		ut_a(len <= src_len - FIL_PAGE_DATA);
 
@@ -25,6 +25,7 @@ Created 2/16/1997 Heikki Tuuri
 
 #include "read0read.h"
 
+#include "row0vers.h"
 #include "srv0srv.h"
 #include "trx0sys.h"
 
@@ -325,7 +326,9 @@ ReadView::ReadView()
 	m_up_limit_id(),
 	m_creator_trx_id(),
 	m_ids(),
-	m_low_limit_no()
+	m_low_limit_no(),
+	m_vers_cache(),
+	m_vers_cache_stale()
 {
 	ut_d(::memset(&m_view_list, 0x0, sizeof(m_view_list)));
 }
@@ -334,7 +337,7 @@ ReadView::ReadView()
 ReadView destructor */
 ReadView::~ReadView()
 {
-	// Do nothing
+	row_vers_cache_free(m_vers_cache);
 }
 
 /** Constructor
@@ -448,6 +451,8 @@ ReadView::prepare(trx_id_t id)
 
 	m_creator_trx_id = id;
 
+	m_vers_cache_stale = true;
+
 	m_low_limit_no = m_low_limit_id = trx_sys->max_trx_id;
 
 	if (!trx_sys->rw_trx_ids.empty()) {
@@ -649,6 +654,8 @@ ReadView::copy_prepare(const ReadView& other)
 	m_low_limit_id = other.m_low_limit_id;
 
 	m_creator_trx_id = other.m_creator_trx_id;
+
+	m_vers_cache_stale = true;
 }
 
 /**
@@ -998,6 +998,7 @@ row_create_prebuilt(
 
 	prebuilt->m_no_prefetch = false;
 	prebuilt->m_read_virtual_key = false;
+	prebuilt->m_key_ordered = false;
 
 	DBUG_RETURN(prebuilt);
 }
@@ -1208,6 +1209,7 @@ row_update_statistics_if_needed(
 
 			dict_stats_recalc_pool_add(table);
 			table->stat_modified_counter = 0;
+			table->stat_generation++;
 		}
 		return;
 	}
@@ -57,6 +57,7 @@ Created 12/19/1997 Heikki Tuuri
 #include "row0mysql.h"
 #include "read0read.h"
 #include "buf0lru.h"
+#include "buf0rea.h"
 #include "ha_prototypes.h"
 #include "srv0mon.h"
 #include "ut0new.h"
@@ -4574,6 +4575,144 @@ row_sel_fill_vrow(
 	}
 }
 
+/** Positions a cursor for a search in key order on the leaf page of its
+stored position, without a search from the root of the index. This is
+possible when the page has not changed since the position was stored,
+and the search tuple is after the first and not after the last user
+record of the page: the search from the root would end on the page too.
+@param[in]	index	index
+@param[in]	tuple	search tuple
+@param[in]	mode	search mode
+@param[in,out]	pcur	persistent cursor
+@param[out]	next	if the search tuple is after the last record of
+the page, the number of the next page, else FIL_NULL
+@param[in,out]	mtr	mini-transaction
+@return true if the cursor was positioned, with the page S-latched */
+static
+bool
+row_sel_open_on_stored_leaf(
+	dict_index_t*		index,
+	const dtuple_t*		tuple,
+	page_cur_mode_t		mode,
+	btr_pcur_t*		pcur,
+	ulint*			next,
+	mtr_t*			mtr)
+{
+	*next = FIL_NULL;
+
+	if (mode != PAGE_CUR_GE
+	    || !pcur->old_stored
+	    || (pcur->rel_pos != BTR_PCUR_ON
+		&& pcur->rel_pos != BTR_PCUR_BEFORE
+		&& pcur->rel_pos != BTR_PCUR_AFTER)
+	    || btr_pcur_get_btr_cur(pcur)->index != index
+	    || buf_pool_is_obsolete(pcur->withdraw_clock)) {
+
+		return(false);
+	}
+
+	buf_block_t*	block = pcur->block_when_stored;
+	const ulint	savepoint = mtr_set_savepoint(mtr);
+
+	if (!buf_page_optimistic_get(RW_S_LATCH, block, pcur->modify_clock,
+				     __FILE__, __LINE__, mtr)) {
+		return(false);
+	}
+
+	const page_t*	page = buf_block_get_frame(block);
+	bool		on_page = false;
+
+	if (page_is_leaf(page)
+	    && btr_page_get_index_id(page) == index->id
+	    && !page_is_empty(page)) {
+
+		mem_heap_t*	heap = NULL;
+		ulint		offsets_[REC_OFFS_NORMAL_SIZE];
+		ulint*		offsets = offsets_;
+		rec_offs_init(offsets_);
+
+		const rec_t*	rec = page_rec_get_next_const(
+			page_get_infimum_rec(page));
+
+		offsets = rec_get_offsets(rec, index, offsets,
+					  ULINT_UNDEFINED, &heap);
+
+		if (cmp_dtuple_rec(tuple, rec, offsets) > 0) {
+			rec = page_rec_get_prev_const(
+				page_get_supremum_rec(page));
+
+			offsets = rec_get_offsets(rec, index, offsets,
+						  ULINT_UNDEFINED, &heap);
+
+			on_page = cmp_dtuple_rec(tuple, rec, offsets) <= 0;
+
+			if (!on_page) {
+				*next = btr_page_get_next(page, mtr);
+			}
+		}
+
+		if (heap != NULL) {
+			mem_heap_free(heap);
+		}
+	}
+
+	if (!on_page) {
+		mtr_release_block_at_savepoint(mtr, savepoint, block);
+		return(false);
+	}
+
+	btr_cur_t*	btr_cur = btr_pcur_get_btr_cur(pcur);
+	ulint		up_match = 0;
+	ulint		low_match = 0;
+
+	page_cur_search_with_match(block, index, tuple, mode,
+				   &up_match, &low_match,
+				   btr_pcur_get_page_cur(pcur), NULL);
+
+	btr_cur->up_match = up_match;
+	btr_cur->low_match = low_match;
+
+	pcur->latch_mode = BTR_SEARCH_LEAF;
+	pcur->search_mode = mode;
+	pcur->pos_state = BTR_PCUR_IS_POSITIONED;
+	pcur->old_stored = false;
+	pcur->trx_if_known = NULL;
+
+	MONITOR_INC(MONITOR_INDEX_LEAF_REUSE);
+
+	return(true);
+}
+
+/** Starts reading the next leaf page of a cursor into the buffer pool
+in the background, if it is not there yet.
+@param[in]	pcur	persistent cursor, positioned on a leaf page
+@param[in]	mtr	mini-transaction */
+static
+void
+row_sel_prefetch_next_leaf(
+	const btr_pcur_t*	pcur,
+	mtr_t*			mtr)
+{
+	const buf_block_t*	block = btr_pcur_get_block(pcur);
+	const ulint		next = btr_page_get_next(
+		buf_block_get_frame(block), mtr);
+
+	if (next == FIL_NULL) {
+		return;
+	}
+
+	const page_id_t	page_id(block->page.id.space(), next);
+
+	if (!buf_page_peek(page_id)) {
+		buf_read_page_background(
+			page_id, dict_table_page_size(
+				btr_pcur_get_btr_cur(pcur)->index->table),
+			false);
+
+		os_aio_simulated_wake_handler_threads();
+	}
+}
+
 /** Searches for rows in the database using cursor.
 Function is mainly used for tables that are shared accorss connection and
 so it employs technique that can help re-construct the rows that
@@ -4846,8 +4985,13 @@ row_search_mvcc(
 
 		mode = PAGE_CUR_GE;
 
+		/* A search in key order rather starts on the leaf
+		page of the previous search, see
+		row_sel_open_on_stored_leaf(). */
+
 		if (trx->mysql_n_tables_locked == 0
 		    && !prebuilt->ins_sel_stmt
+		    && !prebuilt->m_key_ordered
 		    && prebuilt->select_lock_type == LOCK_NONE
 		    && trx->isolation_level > TRX_ISO_READ_UNCOMMITTED
 		    && MVCC::is_view_active(trx->read_view)) {
@@ -5112,9 +5256,27 @@ wait_table_again:
 			}
 		}
 
-		btr_pcur_open_with_no_init(index, search_tuple, mode,
-					   BTR_SEARCH_LEAF,
-					   pcur, 0, &mtr);
+		ulint	next_leaf = FIL_NULL;
+
+		if (!prebuilt->m_key_ordered
+		    || dict_index_is_spatial(index)) {
+			btr_pcur_open_with_no_init(index, search_tuple, mode,
+						   BTR_SEARCH_LEAF,
+						   pcur, 0, &mtr);
+		} else if (!row_sel_open_on_stored_leaf(
+				   index, search_tuple, mode, pcur,
+				   &next_leaf, &mtr)) {
+			btr_pcur_open_with_no_init(index, search_tuple, mode,
+						   BTR_SEARCH_LEAF,
+						   pcur, 0, &mtr);
+
+			/* If the searches move on to the next leaf page,
+			read the one after it ahead. */
+			if (btr_pcur_get_block(pcur)->page.id.page_no()
+			    == next_leaf) {
+				row_sel_prefetch_next_leaf(pcur, &mtr);
+			}
+		}
 
 		pcur->trx_if_known = trx;
 
@@ -5993,9 +6155,13 @@ idx_cond_failed:
 	    || direction != 0
 	    || prebuilt->select_lock_type != LOCK_NONE
 	    || prebuilt->used_in_HANDLER
-	    || prebuilt->innodb_api) {
+	    || prebuilt->innodb_api
+	    || prebuilt->m_key_ordered) {
 
-		/* Inside an update always store the cursor position */
+		/* Inside an update always store the cursor position;
+		in a search in key order, the next search may start
+		from the stored position, see
+		row_sel_open_on_stored_leaf(). */
 
 		if (!spatial_search) {
 			btr_pcur_store_position(pcur, &mtr);
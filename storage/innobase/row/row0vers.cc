@@ -49,6 +49,8 @@ Created 2/6/1997 Heikki Tuuri
 #include "lock0lock.h"
 #include "row0mysql.h"
 
+#include <map>
+
 /** Check whether all non-virtual columns in a virtual index match that of in
 the cluster index
 @param[in]	index		the secondary index
@@ -1096,6 +1098,326 @@ row_vers_old_has_index_entry(
 	}
 }
 
+/** Cache of old versions of clustered index records built for a
+consistent read view. The version that a view sees depends on the newest
+version of the record, which is identified by its roll pointer together
+with the record it belongs to: the undo log records that the view needs
+cannot be purged while the view is open, but the undo log space of a
+rolled back statement or transaction is reused, and with it the roll
+pointers. The key is therefore the index id, the roll pointer and
+DB_TRX_ID of the newest version, and the entry keeps its primary key. */
+struct row_vers_cache_t {
+	/** Old version of a record */
+	struct entry_t {
+		/** Primary key of the newest version: for each field,
+		its length in 4 bytes followed by its data */
+		const byte*	pk;
+		/** Size of the primary key in bytes */
+		ulint		pk_size;
+		/** Copy of the record including its header, or NULL if
+		the record did not exist in the view */
+		const byte*	buf;
+		/** Size of the record header in bytes */
+		ulint		extra_size;
+		/** Size of the record in bytes */
+		ulint		size;
+	};
+
+	/** Clustered index id, roll pointer and transaction id of the
+	newest version */
+	struct key_t {
+		index_id_t	index_id;
+		roll_ptr_t	roll_ptr;
+		trx_id_t	trx_id;
+
+		key_t(index_id_t id, roll_ptr_t ptr, trx_id_t trx)
+			: index_id(id), roll_ptr(ptr), trx_id(trx) {}
+
+		bool operator<(const key_t& other) const
+		{
+			if (index_id != other.index_id) {
+				return(index_id < other.index_id);
+			}
+			if (roll_ptr != other.roll_ptr) {
+				return(roll_ptr < other.roll_ptr);
+			}
+			return(trx_id < other.trx_id);
+		}
+	};
+
+	typedef std::map<
+		key_t,
+		entry_t,
+		std::less<key_t>,
+		ut_allocator<std::pair<const key_t, entry_t> > >
+		map_t;
+
+	/** Approximate size of a map node in bytes */
+	static const ulint	NODE_SIZE = sizeof(map_t::value_type)
+		+ 4 * sizeof(void*);
+
+	/** Cached versions */
+	map_t		map;
+
+	/** Memory for the copies of the records */
+	mem_heap_t*	heap;
+};
+
+/** Empty a cache of old record versions.
+@param[in,out]	cache	cache to empty */
+static
+void
+row_vers_cache_clear(
+	row_vers_cache_t*	cache)
+{
+	cache->map.clear();
+	mem_heap_empty(cache->heap);
+}
+
+/** Free a cache of old record versions built for a read view.
+@param[in,out]	cache	cache to free, or NULL */
+void
+row_vers_cache_free(
+	row_vers_cache_t*	cache)
+{
+	if (cache != NULL) {
+		mem_heap_free(cache->heap);
+		UT_DELETE(cache);
+	}
+}
+
+/** Get the cache of old record versions of a read view.
+@param[in,out]	view	consistent read view
+@return cache, or NULL if caching is disabled */
+static
+row_vers_cache_t*
+row_vers_cache_get(
+	ReadView*	view)
+{
+	row_vers_cache_t*&	cache = view->vers_cache();
+	bool			stale = view->vers_cache_reset();
+
+	if (srv_vers_cache_size == 0) {
+		row_vers_cache_free(cache);
+		cache = NULL;
+	} else if (cache == NULL) {
+		cache = UT_NEW_NOKEY(row_vers_cache_t());
+		cache->heap = mem_heap_create(1024);
+	} else if (stale) {
+		row_vers_cache_clear(cache);
+	}
+
+	return(cache);
+}
+
+/** Copy the primary key of a clustered index record in the form that
+row_vers_cache_t::entry_t keeps it.
+@param[in]	rec	clustered index record
+@param[in]	index	clustered index
+@param[in]	offsets	rec_get_offsets(rec, index), at least for the
+primary key fields
+@param[out]	buf	buffer for the primary key, or NULL to only
+compute its size
+@return size of the primary key in bytes */
+static
+ulint
+row_vers_cache_pk_copy(
+	const rec_t*		rec,
+	const dict_index_t*	index,
+	const ulint*		offsets,
+	byte*			buf)
+{
+	ulint	size = 0;
+
+	for (ulint i = 0; i < dict_index_get_n_unique(index); i++) {
+		ulint		len;
+		const byte*	field = rec_get_nth_field(
+			rec, offsets, i, &len);
+
+		ut_ad(len != UNIV_SQL_NULL);
+
+		if (buf != NULL) {
+			mach_write_to_4(buf + size, len);
+			memcpy(buf + size + 4, field, len);
+		}
+
+		size += 4 + len;
+	}
+
+	return(size);
+}
+
+/** Check whether a cache entry was built for a record.
+@param[in]	entry	cache entry
+@param[in]	rec	newest version of a clustered index record
+@param[in]	index	clustered index
+@param[in]	offsets	rec_get_offsets(rec, index)
+@return true if the primary key of rec is that of the entry */
+static
+bool
+row_vers_cache_pk_eq(
+	const row_vers_cache_t::entry_t&	entry,
+	const rec_t*				rec,
+	const dict_index_t*			index,
+	const ulint*				offsets)
+{
+	const byte*	pk = entry.pk;
+	const byte*	end = entry.pk + entry.pk_size;
+
+	for (ulint i = 0; i < dict_index_get_n_unique(index); i++) {
+		ulint		len;
+		const byte*	field = rec_get_nth_field(
+			rec, offsets, i, &len);
+
+		if (pk + 4 + len > end
+		    || mach_read_from_4(pk) != len
+		    || memcmp(pk + 4, field, len) != 0) {
+			return(false);
+		}
+
+		pk += 4 + len;
+	}
+
+	return(pk == end);
+}
+
+/** Look up the version of a clustered index record that a read view sees.
+@param[in]	cache		cache of the read view
+@param[in]	rec		newest version of the record
+@param[in]	index		clustered index
+@param[in]	roll_ptr	roll pointer of the newest version
+@param[in]	trx_id		DB_TRX_ID of the newest version
+@param[in,out]	offsets		rec_get_offsets(rec, index) on entry,
+offsets of the old version on return if it was found
+@param[in,out]	offset_heap	memory heap for offsets
+@param[in,out]	in_heap		memory heap for the old version
+@param[out]	old_vers	old version, or NULL if the record did
+not exist in the view
+@return true if the version was found in the cache */
+static
+bool
+row_vers_cache_lookup(
+	const row_vers_cache_t*	cache,
+	const rec_t*		rec,
+	const dict_index_t*	index,
+	roll_ptr_t		roll_ptr,
+	trx_id_t		trx_id,
+	ulint**			offsets,
+	mem_heap_t**		offset_heap,
+	mem_heap_t*		in_heap,
+	rec_t**			old_vers)
+{
+	row_vers_cache_t::map_t::const_iterator	it = cache->map.find(
+		row_vers_cache_t::key_t(index->id, roll_ptr, trx_id));
+
+	if (it == cache->map.end()) {
+		return(false);
+	}
+
+	const row_vers_cache_t::entry_t&	entry = it->second;
+
+	if (!row_vers_cache_pk_eq(entry, rec, index, *offsets)) {
+		return(false);
+	}
+
+	if (entry.buf == NULL) {
+		*old_vers = NULL;
+		return(true);
+	}
+
+	byte*	buf = static_cast<byte*>(mem_heap_alloc(in_heap, entry.size));
+
+	memcpy(buf, entry.buf, entry.size);
+
+	*old_vers = buf + entry.extra_size;
+
+	*offsets = rec_get_offsets(
+		*old_vers, index, *offsets, ULINT_UNDEFINED, offset_heap);
+
+	return(true);
+}
+
+/** Add the version of a clustered index record that a read view sees
+to the cache of the view. If the cache is full, it is emptied first.
+@param[in,out]	cache		cache of the read view
+@param[in]	rec		newest version of the record
+@param[in]	index		clustered index
+@param[in]	roll_ptr	roll pointer of the newest version
+@param[in]	trx_id		DB_TRX_ID of the newest version
+@param[in]	old_vers	old version, or NULL if the record did
+not exist in the view
+@param[in]	offsets		rec_get_offsets(old_vers, index) */
+static
+void
+row_vers_cache_insert(
+	row_vers_cache_t*	cache,
+	const rec_t*		rec,
+	const dict_index_t*	index,
+	roll_ptr_t		roll_ptr,
+	trx_id_t		trx_id,
+	const rec_t*		old_vers,
+	const ulint*		offsets)
+{
+	row_vers_cache_t::entry_t	entry;
+	mem_heap_t*			heap = NULL;
+	ulint				rec_offsets_[REC_OFFS_NORMAL_SIZE];
+
+	rec_offs_init(rec_offsets_);
+
+	const ulint*	rec_offsets = rec_get_offsets(
+		rec, index, rec_offsets_, dict_index_get_n_unique(index),
+		&heap);
+
+	entry.pk = NULL;
+	entry.pk_size = row_vers_cache_pk_copy(rec, index, rec_offsets, NULL);
+	entry.buf = NULL;
+	entry.extra_size = 0;
+	entry.size = 0;
+
+	if (old_vers != NULL) {
+		entry.extra_size = rec_offs_extra_size(offsets);
+		entry.size = rec_offs_size(offsets);
+	}
+
+	ulint	needed = entry.pk_size + entry.size
+		+ row_vers_cache_t::NODE_SIZE;
+
+	if (needed > srv_vers_cache_size) {
+		if (heap != NULL) {
+			mem_heap_free(heap);
+		}
+		return;
+	}
+
+	if (mem_heap_get_size(cache->heap)
+	    + cache->map.size() * row_vers_cache_t::NODE_SIZE + needed
+	    > srv_vers_cache_size) {
+
+		row_vers_cache_clear(cache);
+	}
+
+	byte*	pk = static_cast<byte*>(
+		mem_heap_alloc(cache->heap, entry.pk_size));
+
+	row_vers_cache_pk_copy(rec, index, rec_offsets, pk);
+	entry.pk = pk;
+
+	if (heap != NULL) {
+		mem_heap_free(heap);
+	}
+
+	if (old_vers != NULL) {
+		entry.buf = static_cast<const byte*>(
+			mem_heap_dup(cache->heap,
+				     old_vers - entry.extra_size,
+				     entry.size));
+	}
+
+	/* An entry for the same key and another record is replaced */
+	cache->map[row_vers_cache_t::key_t(index->id, roll_ptr, trx_id)]
+		= entry;
+}
+
 /*****************************************************************//**
 Constructs the version of a clustered index record which a consistent
 read should see. We assume that the trx id stored in rec is such that
@@ -1145,6 +1467,22 @@ row_vers_build_for_consistent_read(
 
 	ut_ad(!vrow || !(*vrow));
 
+	/* Virtual columns are not cached */
+	row_vers_cache_t*	cache = (vrow == NULL)
+		? row_vers_cache_get(view) : NULL;
+	roll_ptr_t		roll_ptr = 0;
+	const trx_id_t		rec_trx_id = trx_id;
+
+	if (cache != NULL) {
+		roll_ptr = row_get_rec_roll_ptr(rec, index, *offsets);
+
+		if (row_vers_cache_lookup(cache, rec, index, roll_ptr,
+					  rec_trx_id, offsets, offset_heap,
+					  in_heap, old_vers)) {
+			return(DB_SUCCESS);
+		}
+	}
+
 	version = rec;
 
 	for (;;) {
@@ -1210,6 +1548,11 @@ row_vers_build_for_consistent_read(
 
 	mem_heap_free(heap);
 
+	if (cache != NULL && err == DB_SUCCESS) {
+		row_vers_cache_insert(cache, rec, index, roll_ptr,
+				      rec_trx_id, *old_vers, *offsets);
+	}
+
 	return(err);
 }
 
@@ -67,6 +67,10 @@ we could get a deadlock. Value of 0 will disable the concurrency check. */
 
 ulong	srv_thread_concurrency	= 0;
 
+/** If TRUE, threads that cannot enter InnoDB because of
+srv_thread_concurrency wait in a queue instead of sleeping and retrying. */
+my_bool	srv_thread_concurrency_queue = FALSE;
+
 /** Variables tracking the active and waiting threads. */
 struct srv_conc_t {
 	char		pad[64  - (sizeof(ulint) + sizeof(lint))];
@@ -86,6 +90,62 @@ struct srv_conc_t {
 /* Control variables for tracking concurrency. */
 static srv_conc_t	srv_conc;
 
+/** Admission priority classes. Waiting threads are admitted from the
+highest class first, and in FIFO order within a class. */
+enum srv_conc_prio_t {
+	SRV_CONC_PRIO_HIGH = 0,		/*!< replication applier threads
+					and transactions holding locks */
+	SRV_CONC_PRIO_NORMAL,		/*!< all other threads */
+	SRV_CONC_PRIO_COUNT
+};
+
+/** State of a thread waiting in the admission queue */
+enum srv_conc_wait_state_t {
+	SRV_CONC_WAITING,		/*!< waiting for a seat */
+	SRV_CONC_ADMITTED,		/*!< a seat was reserved in
+					srv_conc.n_active for the thread */
+	SRV_CONC_RELEASED		/*!< the concurrency check was
+					disabled, enter without a seat */
+};
+
+/** Slot of a thread waiting in the admission queue */
+struct srv_conc_slot_t {
+	/** Event the thread waits on */
+	os_event_t			event;
+
+	/** Wait state, protected by srv_conc_queue.mutex */
+	srv_conc_wait_state_t		state;
+
+	/** List node in a queue or in the free list */
+	UT_LIST_NODE_T(srv_conc_slot_t)	queue;
+};
+
+typedef UT_LIST_BASE_NODE_T(srv_conc_slot_t)	srv_conc_slot_list_t;
+
+/** Threads waiting in the admission queue */
+struct srv_conc_queue_t {
+	/** Number of threads in the queues or about to be queued. This
+	is read without holding the mutex, to keep the uncontended paths
+	free of it. */
+	volatile lint		n_queued;
+
+	/** Mutex protecting the lists */
+	ib_mutex_t		mutex;
+
+	/** Waiting threads, one FIFO per priority class */
+	srv_conc_slot_list_t	queues[SRV_CONC_PRIO_COUNT];
+
+	/** Slots not in use */
+	srv_conc_slot_list_t	free;
+};
+
+/** The admission queue used when srv_thread_concurrency_queue is set */
+static srv_conc_queue_t	srv_conc_queue;
+
+/** Time in microseconds after which a waiting thread checks whether
+it missed a wakeup or srv_thread_concurrency was changed */
+static const ulint	SRV_CONC_WAIT_TIMEOUT = 1000000;
+
 /*********************************************************************//**
 Note that a user thread is entering InnoDB. */
 static
@@ -222,6 +282,226 @@ srv_conc_enter_innodb_with_atomics(
 	}
 }
 
+/** Try to reserve a seat inside InnoDB.
+@return true if a seat was reserved */
+static
+bool
+srv_conc_reserve_seat()
+{
+	lint	n_active = os_atomic_increment_lint(&srv_conc.n_active, 1);
+
+	if (n_active <= (lint) srv_thread_concurrency) {
+		return(true);
+	}
+
+	/* Since there were no free seats, we relinquish the overbooked
+	ticket. The overbooking may have made a concurrent
+	srv_conc_dispatch() fail, so the caller must dispatch after this,
+	or already hold srv_conc_queue.mutex. */
+
+	(void) os_atomic_decrement_lint(&srv_conc.n_active, 1);
+
+	return(false);
+}
+
+/** Hand the free seats to the threads waiting in the admission queue,
+highest priority class first and in FIFO order within a class. If the
+concurrency check was disabled, release all the waiting threads. */
+static
+void
+srv_conc_dispatch()
+{
+	ut_ad(mutex_own(&srv_conc_queue.mutex));
+
+	for (ulint i = 0; i < SRV_CONC_PRIO_COUNT; ++i) {
+		srv_conc_slot_list_t&	queue = srv_conc_queue.queues[i];
+
+		while (UT_LIST_GET_LEN(queue) > 0) {
+			srv_conc_slot_t*	slot = UT_LIST_GET_FIRST(queue);
+
+			if (srv_thread_concurrency == 0) {
+				slot->state = SRV_CONC_RELEASED;
+			} else if (srv_conc_reserve_seat()) {
+				slot->state = SRV_CONC_ADMITTED;
+			} else {
+				return;
+			}
+
+			UT_LIST_REMOVE(queue, slot);
+
+			(void) os_atomic_decrement_lint(
+				&srv_conc_queue.n_queued, 1);
+
+			os_event_set(slot->event);
+		}
+	}
+}
+
+/** Release a seat inside InnoDB, and hand it to the first thread in the
+admission queue if there is one. */
+static
+void
+srv_conc_release_seat()
+{
+	(void) os_atomic_decrement_lint(&srv_conc.n_active, 1);
+
+	/* Both n_active and n_queued are updated with full memory
+	barriers, and a thread increments n_queued before it tries to
+	reserve a seat. Either that thread gets our seat, or we see it
+	in the queue. */
+
+	if (srv_conc_queue.n_queued > 0) {
+		mutex_enter(&srv_conc_queue.mutex);
+		srv_conc_dispatch();
+		mutex_exit(&srv_conc_queue.mutex);
+	}
+}
+
+/** Determine the admission priority class of a transaction.
+@param[in]	trx	transaction that wants to enter InnoDB
+@return priority class */
+static
+srv_conc_prio_t
+srv_conc_get_prio(
+	const trx_t*	trx)
+{
+	/* Let the replication applier and transactions that already
+	hold locks in first, so that they can release their locks
+	sooner. We read the length of the lock list without holding
+	lock_sys->mutex, which is good enough for a heuristic. */
+
+	if ((trx->mysql_thd != NULL
+	     && thd_is_replication_slave_thread(trx->mysql_thd))
+	    || UT_LIST_GET_LEN(trx->lock.trx_locks) > 0) {
+
+		return(SRV_CONC_PRIO_HIGH);
+	}
+
+	return(SRV_CONC_PRIO_NORMAL);
+}
+
+/** Handle the scheduling of a user thread that wants to enter InnoDB
+when srv_thread_concurrency_queue is set. The thread takes a free seat
+without acquiring any mutex if nobody is waiting. Otherwise it waits in
+the queue of its priority class until a thread leaving InnoDB hands its
+seat over, so that waiting threads neither spin nor sleep for a
+guessed time.
+@param[in,out]	trx	transaction that wants to enter InnoDB */
+static
+void
+srv_conc_enter_innodb_with_queue(
+	trx_t*	trx)
+{
+	ut_a(!trx->declared_to_be_inside_innodb);
+
+	if (srv_conc_queue.n_queued == 0 && srv_conc_reserve_seat()) {
+
+		srv_enter_innodb_with_tickets(trx);
+
+		return;
+	}
+
+	srv_conc_prio_t	prio = srv_conc_get_prio(trx);
+
+	mutex_enter(&srv_conc_queue.mutex);
+
+	(void) os_atomic_increment_lint(&srv_conc_queue.n_queued, 1);
+
+	/* Admit the threads ahead of us first, in case our failed
+	attempt above overbooked the last free seat. */
+	srv_conc_dispatch();
+
+	bool	queue_empty = true;
+
+	for (ulint i = 0; i < SRV_CONC_PRIO_COUNT; ++i) {
+		if (UT_LIST_GET_LEN(srv_conc_queue.queues[i]) > 0) {
+			queue_empty = false;
+			break;
+		}
+	}
+
+	if (srv_thread_concurrency == 0
+	    || (queue_empty && srv_conc_reserve_seat())) {
+
+		(void) os_atomic_decrement_lint(&srv_conc_queue.n_queued, 1);
+
+		mutex_exit(&srv_conc_queue.mutex);
+
+		if (srv_thread_concurrency > 0) {
+			srv_enter_innodb_with_tickets(trx);
+		}
+
+		return;
+	}
+
+	srv_conc_slot_t*	slot = UT_LIST_GET_FIRST(srv_conc_queue.free);
+
+	if (slot != NULL) {
+		UT_LIST_REMOVE(srv_conc_queue.free, slot);
+	} else {
+		slot = UT_NEW_NOKEY(srv_conc_slot_t());
+		slot->event = os_event_create(0);
+	}
+
+	slot->state = SRV_CONC_WAITING;
+
+	int64_t	sig_count = os_event_reset(slot->event);
+
+	UT_LIST_ADD_LAST(srv_conc_queue.queues[prio], slot);
+
+	mutex_exit(&srv_conc_queue.mutex);
+
+	(void) os_atomic_increment_lint(&srv_conc.n_waiting, 1);
+
+	/* Release possible search system latch this thread has */
+	if (trx->has_search_latch) {
+		trx_search_latch_release_if_reserved(trx);
+	}
+
+	thd_wait_begin(trx->mysql_thd, THD_WAIT_USER_LOCK);
+
+	DEBUG_SYNC_C("user_thread_waiting");
+	trx->op_info = "waiting in InnoDB queue";
+
+	for (;;) {
+		os_event_wait_time_low(
+			slot->event, SRV_CONC_WAIT_TIMEOUT, sig_count);
+
+		mutex_enter(&srv_conc_queue.mutex);
+
+		if (slot->state == SRV_CONC_WAITING) {
+			/* Admit the threads ahead of us in case a
+			wakeup was missed or srv_thread_concurrency was
+			changed. */
+			srv_conc_dispatch();
+		}
+
+		if (slot->state != SRV_CONC_WAITING) {
+			break;
+		}
+
+		sig_count = os_event_reset(slot->event);
+
+		mutex_exit(&srv_conc_queue.mutex);
+	}
+
+	srv_conc_wait_state_t	state = slot->state;
+
+	UT_LIST_ADD_FIRST(srv_conc_queue.free, slot);
+
+	mutex_exit(&srv_conc_queue.mutex);
+
+	trx->op_info = "";
+
+	(void) os_atomic_decrement_lint(&srv_conc.n_waiting, 1);
+
+	thd_wait_end(trx->mysql_thd);
+
+	if (state == SRV_CONC_ADMITTED) {
+		srv_enter_innodb_with_tickets(trx);
+	}
+}
+
 /*********************************************************************//**
 Note that a user thread is leaving InnoDB code. */
 static
@@ -233,7 +513,43 @@ srv_conc_exit_innodb_with_atomics(
 	trx->n_tickets_to_enter_innodb = 0;
 	trx->declared_to_be_inside_innodb = FALSE;
 
-	(void) os_atomic_decrement_lint(&srv_conc.n_active, 1);
+	srv_conc_release_seat();
+}
+
+/** Create the admission queue. */
+void
+srv_conc_init()
+{
+	srv_conc_queue.n_queued = 0;
+
+	mutex_create(LATCH_ID_SRV_CONC, &srv_conc_queue.mutex);
+
+	for (ulint i = 0; i < SRV_CONC_PRIO_COUNT; ++i) {
+		UT_LIST_INIT(srv_conc_queue.queues[i], &srv_conc_slot_t::queue);
+	}
+
+	UT_LIST_INIT(srv_conc_queue.free, &srv_conc_slot_t::queue);
+}
+
+/** Free the admission queue. */
+void
+srv_conc_free()
+{
+	for (ulint i = 0; i < SRV_CONC_PRIO_COUNT; ++i) {
+		ut_a(UT_LIST_GET_LEN(srv_conc_queue.queues[i]) == 0);
+	}
+
+	while (srv_conc_slot_t* slot = UT_LIST_GET_FIRST(
+		       srv_conc_queue.free)) {
+
+		UT_LIST_REMOVE(srv_conc_queue.free, slot);
+
+		os_event_destroy(slot->event);
+
+		UT_DELETE(slot);
+	}
+
+	mutex_free(&srv_conc_queue.mutex);
 }
 
 /*********************************************************************//**
@@ -254,7 +570,11 @@ srv_conc_enter_innodb(
 	}
 #endif /* UNIV_DEBUG */
 
-	srv_conc_enter_innodb_with_atomics(trx);
+	if (srv_thread_concurrency_queue) {
+		srv_conc_enter_innodb_with_queue(trx);
+	} else {
+		srv_conc_enter_innodb_with_atomics(trx);
+	}
 }
 
 /*********************************************************************//**
@@ -296,9 +616,9 @@ srv_conc_force_exit_innodb(
 	trx_t*	trx)	/*!< in: transaction object associated with the
 			thread */
 {
-	if ((trx->mysql_thd != NULL
-	     && thd_is_replication_slave_thread(trx->mysql_thd))
-	    || trx->declared_to_be_inside_innodb == FALSE) {
+	/* The replication thread does not declare itself to be inside
+	InnoDB unless it entered through the admission queue. */
+	if (trx->declared_to_be_inside_innodb == FALSE) {
 
 		return;
 	}
@@ -988,6 +988,12 @@ static monitor_info_t	innodb_counter_info[] =
 	 MONITOR_NONE,
 	 MONITOR_DEFAULT_START, MONITOR_INDEX_DISCARD},
 
+	{"index_leaf_reuses", "index",
+	 "Number of searches in key order started on the leaf page"
+	 " of the previous search",
+	 MONITOR_NONE,
+	 MONITOR_DEFAULT_START, MONITOR_INDEX_LEAF_REUSE},
+
 	/* ========== Counters for Adaptive Hash Index ========== */
 	{"module_adaptive_hash", "adaptive_hash_index", "Adpative Hash Index",
 	 MONITOR_MODULE,
@@ -91,6 +91,9 @@ ibool	srv_buf_dump_thread_active = FALSE;
 
 bool	srv_buf_resize_thread_active = false;
 
+/** Number of change buffer merge threads that are running */
+ulint	srv_n_ibuf_merge_threads_active = 0;
+
 ibool	srv_dict_stats_thread_active = FALSE;
 
 const char*	srv_main_thread_op_info = "";
@@ -288,6 +291,10 @@ ulong	srv_read_ahead_threshold	= 56;
 of the buffer pool. */
 uint	srv_change_buffer_max_size = CHANGE_BUFFER_DEFAULT_SIZE;
 
+/** Number of change buffer merge threads. If 0, the master thread
+merges the change buffer itself. */
+ulong	srv_n_ibuf_merge_threads = 0;
+
 /* This parameter is used to throttle the number of insert buffers that are
 merged in a batch. By increasing this parameter on a faster disk you can
 possibly reduce the number of I/O operations performed to complete the
@@ -335,6 +342,10 @@ ulong	srv_n_purge_threads = 4;
 /* the number of pages to purge in one batch */
 ulong	srv_purge_batch_size = 20;
 
+/** Maximum size in bytes of the old record versions cached for one
+read view, 0 disables the cache */
+ulong	srv_vers_cache_size = 0;
+
 /* Internal setting for "innodb_stats_method". Decides how InnoDB treats
 NULL value when collecting statistics. By default, it is set to
 SRV_STATS_NULLS_EQUAL(0), ie. all NULL value are treated equal */
@@ -604,6 +615,9 @@ os_event_t	srv_buf_dump_event;
 /** Event to signal the buffer pool resize thread */
 os_event_t	srv_buf_resize_event;
 
+/** Event to signal the change buffer merge threads */
+os_event_t	srv_ibuf_merge_event;
+
 /** The buffer pool dump/load file name */
 char*	srv_buf_dump_filename;
 
@@ -1007,6 +1021,8 @@ srv_init(void)
 
 		buf_flush_event = os_event_create("buf_flush_event");
 
+		srv_ibuf_merge_event = os_event_create(0);
+
 		UT_LIST_INIT(srv_sys->tasks, &que_thr_t::queue);
 	}
 
@@ -1024,6 +1040,8 @@ srv_init(void)
 	mutex_create(LATCH_ID_PAGE_ZIP_STAT_PER_INDEX,
 		     &page_zip_stat_per_index_mutex);
 
+	srv_conc_init();
+
 	/* Create dummy indexes for infimum and supremum records */
 
 	dict_ind_init();
@@ -1045,6 +1063,8 @@ srv_free(void)
 	mutex_free(&srv_innodb_monitor_mutex);
 	mutex_free(&page_zip_stat_per_index_mutex);
 
+	srv_conc_free();
+
 	{
 		mutex_free(&srv_sys->mutex);
 		mutex_free(&srv_sys->tasks_mutex);
@@ -1059,6 +1079,7 @@ srv_free(void)
 		os_event_destroy(srv_monitor_event);
 		os_event_destroy(srv_buf_dump_event);
 		os_event_destroy(buf_flush_event);
+		os_event_destroy(srv_ibuf_merge_event);
 	}
 
 	os_event_destroy(srv_buf_resize_event);
@@ -1840,6 +1861,8 @@ srv_any_background_threads_are_active(void)
 		thread_active = "buf_resize_thread";
 	} else if (srv_dict_stats_thread_active) {
 		thread_active = "dict_stats_thread";
+	} else if (srv_n_ibuf_merge_threads_active) {
+		thread_active = "ibuf_merge_thread";
 	}
 
 	os_event_set(srv_error_event);
@@ -1848,6 +1871,7 @@ srv_any_background_threads_are_active(void)
 	os_event_set(lock_sys->timeout_event);
 	os_event_set(dict_stats_event);
 	os_event_set(srv_buf_resize_event);
+	os_event_set(srv_ibuf_merge_event);
 
 	return(thread_active);
 }
@@ -2126,12 +2150,14 @@ srv_master_do_active_tasks(void)
 	srv_main_thread_op_info = "checking free log space";
 	log_free_check();
 
-	/* Do an ibuf merge */
-	srv_main_thread_op_info = "doing insert buffer merge";
-	counter_time = ut_time_us(NULL);
-	ibuf_merge_in_background(false);
-	MONITOR_INC_TIME_IN_MICRO_SECS(
-		MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	/* Do an ibuf merge, unless the merge threads do it */
+	if (srv_n_ibuf_merge_threads == 0) {
+		srv_main_thread_op_info = "doing insert buffer merge";
+		counter_time = ut_time_us(NULL);
+		ibuf_merge_in_background(false);
+		MONITOR_INC_TIME_IN_MICRO_SECS(
+			MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	}
 
 	/* Flush logs if needed */
 	srv_main_thread_op_info = "flushing log";
@@ -2215,12 +2241,14 @@ srv_master_do_idle_tasks(void)
 	srv_main_thread_op_info = "checking free log space";
 	log_free_check();
 
-	/* Do an ibuf merge */
-	counter_time = ut_time_us(NULL);
-	srv_main_thread_op_info = "doing insert buffer merge";
-	ibuf_merge_in_background(true);
-	MONITOR_INC_TIME_IN_MICRO_SECS(
-		MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	/* Do an ibuf merge, unless the merge threads do it */
+	if (srv_n_ibuf_merge_threads == 0) {
+		counter_time = ut_time_us(NULL);
+		srv_main_thread_op_info = "doing insert buffer merge";
+		ibuf_merge_in_background(true);
+		MONITOR_INC_TIME_IN_MICRO_SECS(
+			MONITOR_SRV_IBUF_MERGE_MICROSECOND, counter_time);
+	}
 
 	if (srv_shutdown_state > 0) {
 		return;
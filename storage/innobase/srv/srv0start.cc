@@ -1649,6 +1649,7 @@ innobase_start_or_create_for_mysql(void)
 			    + srv_n_write_io_threads
 			    + srv_n_purge_threads
 			    + srv_n_page_cleaners
+			    + srv_n_ibuf_merge_threads
 			    /* FTS Parallel Sort */
 			    + fts_sort_pll_degree * FTS_NUM_AUX_INDEX
 			      * max_connections;
@@ -2663,6 +2664,11 @@ files_checked:
 		/* Create the dict stats gathering thread */
 		os_thread_create(dict_stats_thread, NULL, NULL);
 
+		/* Create the change buffer merge threads */
+		for (ulong i = 0; i < srv_n_ibuf_merge_threads; ++i) {
+			os_thread_create(ibuf_merge_thread, NULL, NULL);
+		}
+
 		/* Create the thread that will optimize the FTS sub-system. */
 		fts_optimize_init();
 
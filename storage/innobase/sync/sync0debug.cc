@@ -1393,6 +1393,9 @@ sync_latch_meta_init()
 	LATCH_ADD_MUTEX(IBUF_PESSIMISTIC_INSERT, SYNC_IBUF_PESS_INSERT_MUTEX,
 			ibuf_pessimistic_insert_mutex_key);
 
+	LATCH_ADD_MUTEX(IBUF_STAT_PER_INDEX, SYNC_ANY_LATCH,
+			ibuf_stat_per_index_mutex_key);
+
 	LATCH_ADD_MUTEX(LOG_SYS, SYNC_LOG, log_sys_mutex_key);
 
 	LATCH_ADD_MUTEX(LOG_WRITE, SYNC_LOG_WRITE, log_sys_write_mutex_key);
@@ -1483,6 +1486,8 @@ sync_latch_meta_init()
 
 	LATCH_ADD_MUTEX(SRV_SYS_TASKS, SYNC_ANY_LATCH, srv_threads_mutex_key);
 
+	LATCH_ADD_MUTEX(SRV_CONC, SYNC_ANY_LATCH, srv_conc_mutex_key);
+
 	LATCH_ADD_MUTEX(PAGE_ZIP_STAT_PER_INDEX, SYNC_ANY_LATCH,
 			page_zip_stat_per_index_mutex_key);
 
@@ -96,6 +96,14 @@ ut_crc32_func_t	ut_crc32_legacy_big_endian;
 but very slow). */
 ut_crc32_func_t	ut_crc32_byte_by_byte;
 
+/** Pointer to a function that copies a buffer and calculates its CRC32 in
+the same pass. */
+ut_crc32_copy_func_t	ut_crc32_copy;
+
+/** The CRC-32C polynomial 0x1EDC6F41 in the bit-reversed form used by the
+SSE4.2 crc32 instruction. */
+static const uint32_t	ut_crc32_poly = 0x82f63b78;
+
 /** Swap the byte order of an 8 byte integer.
 @param[in]	i	8-byte integer
 @return 8-byte integer */
@@ -119,6 +127,9 @@ ut_crc32_swap_byteorder(
 /* Flag that tells whether the CPU supports CRC32 or not */
 bool	ut_crc32_sse2_enabled = false;
 
+/* Flag that tells whether the CPU supports PCLMULQDQ or not */
+bool	ut_crc32_pclmul_enabled = false;
+
 #if defined(__GNUC__) && defined(__x86_64__)
 /********************************************************************//**
 Fetches CPU info */
@@ -257,12 +268,204 @@ ut_crc32_64_legacy_big_endian_hw(
 	*len -= 8;
 }
 
-/** Calculates CRC32 using hardware/CPU instructions.
+/** Number of bytes in each of the three streams of the long and short
+interleaved loops of ut_crc32_hw_low(). A 16KiB page body is consumed by one
+long and ten short rounds, a 512 byte log block by one short round. */
+static const ulint	UT_CRC32_LONG = 4096;
+static const ulint	UT_CRC32_SHORT = 128;
+
+/** Operator that advances a CRC32 register over a fixed number of zero
+bytes. It is used to combine the checksums of streams that were calculated
+independently of each other. */
+struct ut_crc32_shift_t {
+	/** x^(8 * len - 33) modulo the polynomial, for use with PCLMULQDQ */
+	uint32_t	clmul_k;
+
+	/** Lookup tables for the four bytes of the register, used when
+	PCLMULQDQ is not available */
+	uint32_t	table[4][256];
+};
+
+/** Shift operator over UT_CRC32_LONG bytes */
+static ut_crc32_shift_t	ut_crc32_shift_long;
+
+/** Shift operator over UT_CRC32_SHORT bytes */
+static ut_crc32_shift_t	ut_crc32_shift_short;
+
+/** Multiply two polynomials modulo the CRC-32C polynomial. Both operands and
+the result are in the bit-reversed form, bit 31 being the coefficient of x^0.
+@param[in]	a	first factor
+@param[in]	b	second factor
+@return a * b mod P */
+static
+uint32_t
+ut_crc32_multmodp(
+	uint32_t	a,
+	uint32_t	b)
+{
+	uint32_t	p = 0;
+
+	for (uint32_t m = 1U << 31; m != 0; m >>= 1) {
+		if (a & m) {
+			p ^= b;
+		}
+
+		b = (b & 1) ? (b >> 1) ^ ut_crc32_poly : b >> 1;
+	}
+
+	return(p);
+}
+
+/** Calculate x^n modulo the CRC-32C polynomial, in bit-reversed form.
+@param[in]	n	exponent
+@return x^n mod P */
+static
+uint32_t
+ut_crc32_xpow(
+	ulint	n)
+{
+	uint32_t	p = 1U << 31;
+
+	while (n-- > 0) {
+		p = (p & 1) ? (p >> 1) ^ ut_crc32_poly : p >> 1;
+	}
+
+	return(p);
+}
+
+/** Initialize a shift operator.
+@param[out]	shift	operator to initialize
+@param[in]	len	number of zero bytes the operator advances over */
+static
+void
+ut_crc32_shift_init(
+	ut_crc32_shift_t*	shift,
+	ulint			len)
+{
+	const uint32_t	xpow = ut_crc32_xpow(8 * len);
+
+	shift->clmul_k = ut_crc32_xpow(8 * len - 33);
+
+	for (ulint k = 0; k < 4; k++) {
+		for (uint32_t b = 0; b < 256; b++) {
+			shift->table[k][b] = ut_crc32_multmodp(
+				b << (8 * k), xpow);
+		}
+	}
+}
+
+/** Advance a CRC32 register over a fixed number of zero bytes.
+The carry-less product of the register and x^(8 * len - 33) is reduced to
+32 bits with one crc32 instruction, which multiplies by the remaining x^33.
+@param[in]	shift	shift operator
+@param[in]	crc	crc32 register (not inverted)
+@return crc * x^(8 * len) mod P */
+inline
+uint32_t
+ut_crc32_shift_hw(
+	const ut_crc32_shift_t*	shift,
+	uint32_t		crc)
+{
+	if (ut_crc32_pclmul_enabled) {
+		uint64_t	product;
+
+		asm("movq %1, %%xmm0\n\t"
+		    "movq %2, %%xmm1\n\t"
+		    "pclmulqdq $0x00, %%xmm1, %%xmm0\n\t"
+		    "movq %%xmm0, %0"
+		    /* output operands */
+		    : "=r" (product)
+		    /* input operands */
+		    : "r" (static_cast<uint64_t>(crc)),
+		      "r" (static_cast<uint64_t>(shift->clmul_k))
+		    /* clobbered registers */
+		    : "xmm0", "xmm1");
+
+		return(ut_crc32_64_low_hw(0, product));
+	}
+
+	return(shift->table[0][crc & 0xFF]
+	       ^ shift->table[1][(crc >> 8) & 0xFF]
+	       ^ shift->table[2][(crc >> 16) & 0xFF]
+	       ^ shift->table[3][crc >> 24]);
+}
+
+/** Calculate CRC32 over three adjacent streams of block_len bytes each in
+parallel, as long as there is enough input. The crc32 instruction has a
+latency of 3 cycles but a throughput of 1 per cycle, so three independent
+dependency chains keep the unit busy. The three partial results are then
+combined with ut_crc32_shift_hw().
+@tparam		copy		whether to also copy the data to *dst
+@param[in,out]	crc		crc32 register (not inverted)
+@param[in,out]	dst		copy destination, advanced when copying
+@param[in,out]	data		data to be checksummed, will be advanced
+@param[in,out]	len		remaining bytes, will be decremented
+@param[in]	block_len	length of each stream, multiple of 8
+@param[in]	shift		shift operator over block_len bytes */
+template <bool copy>
+inline
+void
+ut_crc32_3way_hw(
+	uint32_t*		crc,
+	byte**			dst,
+	const byte**		data,
+	ulint*			len,
+	ulint			block_len,
+	const ut_crc32_shift_t*	shift)
+{
+	while (*len >= 3 * block_len) {
+		const byte*	p = *data;
+		uint32_t	crc0 = *crc;
+		uint32_t	crc1 = 0;
+		uint32_t	crc2 = 0;
+
+		for (ulint i = 0; i < block_len; i += 8) {
+			const uint64_t	d0 = *reinterpret_cast<const uint64_t*>(
+				p + i);
+			const uint64_t	d1 = *reinterpret_cast<const uint64_t*>(
+				p + block_len + i);
+			const uint64_t	d2 = *reinterpret_cast<const uint64_t*>(
+				p + 2 * block_len + i);
+
+			crc0 = ut_crc32_64_low_hw(crc0, d0);
+			crc1 = ut_crc32_64_low_hw(crc1, d1);
+			crc2 = ut_crc32_64_low_hw(crc2, d2);
+
+			if (copy) {
+				byte*	q = *dst;
+
+				*reinterpret_cast<uint64_t*>(q + i) = d0;
+				*reinterpret_cast<uint64_t*>(
+					q + block_len + i) = d1;
+				*reinterpret_cast<uint64_t*>(
+					q + 2 * block_len + i) = d2;
+			}
+		}
+
+		*crc = ut_crc32_shift_hw(
+			shift, ut_crc32_shift_hw(shift, crc0) ^ crc1) ^ crc2;
+
+		*data += 3 * block_len;
+		*len -= 3 * block_len;
+
+		if (copy) {
+			*dst += 3 * block_len;
+		}
+	}
+}
+
+/** Calculates CRC32 using hardware/CPU instructions, optionally copying
+the data in the same pass.
+@tparam		copy	whether to copy buf to dst
+@param[out]	dst	copy destination, or NULL if !copy
 @param[in]	buf	data over which to calculate CRC32
 @param[in]	len	data length
 @return CRC-32C (polynomial 0x11EDC6F41) */
+template <bool copy>
+inline
 uint32_t
-ut_crc32_hw(
+ut_crc32_hw_low(
+	byte*		dst,
 	const byte*	buf,
 	ulint		len)
 {
@@ -273,79 +476,65 @@ ut_crc32_hw(
 	/* Calculate byte-by-byte up to an 8-byte aligned address. After
 	this consume the input 8-bytes at a time. */
 	while (len > 0 && (reinterpret_cast<uintptr_t>(buf) & 7) != 0) {
+		if (copy) {
+			*dst++ = *buf;
+		}
 		ut_crc32_8_hw(&crc, &buf, &len);
 	}
 
-	/* Perf testing
-	./unittest/gunit/innodb/merge_innodb_tests-t --gtest_filter=ut0crc32.perf
-	on CPU "Intel(R) Core(TM) i7-4770 CPU @ 3.40GHz"
-	with different N in "while (len >= N) {" shows:
-	N=16
-	2.867254 sec
-	2.866860 sec
-	2.867973 sec
-
-	N=32
-	2.715725 sec
-	2.713008 sec
-	2.712520 sec
-	(5.36% speedup over N=16)
-
-	N=64
-	2.634140 sec
-	2.636558 sec
-	2.636488 sec
-	(2.88% speedup over N=32)
-
-	N=128
-	2.599534 sec
-	2.599919 sec
-	2.598035 sec
-	(1.39% speedup over N=64)
-
-	N=256
-	2.576993 sec
-	2.576748 sec
-	2.575700 sec
-	(0.87% speedup over N=128)
-
-	N=512
-	2.693928 sec
-	2.691663 sec
-	2.692142 sec
-	(4.51% slowdown over N=256)
-	*/
-	while (len >= 128) {
-		/* This call is repeated 16 times. 16 * 8 = 128. */
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-		ut_crc32_64_hw(&crc, &buf, &len);
-	}
+	/* Most of a page is consumed in the long loop. The short loop
+	takes care of log blocks and of the remainder of a page. */
+	ut_crc32_3way_hw<copy>(&crc, &dst, &buf, &len,
+			       UT_CRC32_LONG, &ut_crc32_shift_long);
+
+	ut_crc32_3way_hw<copy>(&crc, &dst, &buf, &len,
+			       UT_CRC32_SHORT, &ut_crc32_shift_short);
 
 	while (len >= 8) {
+		if (copy) {
+			memcpy(dst, buf, 8);
+			dst += 8;
+		}
 		ut_crc32_64_hw(&crc, &buf, &len);
 	}
 
 	while (len > 0) {
+		if (copy) {
+			*dst++ = *buf;
+		}
 		ut_crc32_8_hw(&crc, &buf, &len);
 	}
 
 	return(~crc);
 }
 
+/** Calculates CRC32 using hardware/CPU instructions.
+@param[in]	buf	data over which to calculate CRC32
+@param[in]	len	data length
+@return CRC-32C (polynomial 0x11EDC6F41) */
+uint32_t
+ut_crc32_hw(
+	const byte*	buf,
+	ulint		len)
+{
+	return(ut_crc32_hw_low<false>(NULL, buf, len));
+}
+
+/** Copies a buffer and calculates its CRC32 using hardware/CPU
+instructions, reading the source only once.
+@param[out]	dst	copy destination, must not overlap buf
+@param[in]	buf	data over which to calculate CRC32
+@param[in]	len	data length
+@return CRC-32C (polynomial 0x11EDC6F41) */
+uint32_t
+ut_crc32_copy_hw(
+	byte*		dst,
+	const byte*	buf,
+	ulint		len)
+{
+	return(ut_crc32_hw_low<true>(dst, buf, len));
+}
+
 /** Calculates CRC32 using hardware/CPU instructions.
 This function uses big endian byte ordering when converting byte sequence to
 integers.
@@ -437,7 +626,7 @@ ut_crc32_slice8_table_init()
 /*========================*/
 {
 	/* bit-reversed poly 0x1EDC6F41 (from SSE42 crc32 instruction) */
-	static const uint32_t	poly = 0x82f63b78;
+	const uint32_t		poly = ut_crc32_poly;
 	uint32_t		n;
 	uint32_t		k;
 	uint32_t		c;
@@ -607,6 +796,22 @@ ut_crc32_sw(
 	return(~crc);
 }
 
+/** Copies a buffer and calculates its CRC32 in software.
+@param[out]	dst	copy destination, must not overlap buf
+@param[in]	buf	data over which to calculate CRC32
+@param[in]	len	data length
+@return CRC-32C (polynomial 0x11EDC6F41) */
+uint32_t
+ut_crc32_copy_sw(
+	byte*		dst,
+	const byte*	buf,
+	ulint		len)
+{
+	memcpy(dst, buf, len);
+
+	return(ut_crc32_sw(dst, len));
+}
+
 /** Calculates CRC32 in software, without using CPU instructions.
 This function uses big endian byte ordering when converting byte sequence to
 integers.
@@ -717,12 +922,17 @@ ut_crc32_init()
 	*/
 #ifndef UNIV_DEBUG_VALGRIND
 	ut_crc32_sse2_enabled = (features_ecx >> 20) & 1;
+	ut_crc32_pclmul_enabled = (features_ecx >> 1) & 1;
 #endif /* UNIV_DEBUG_VALGRIND */
 
 	if (ut_crc32_sse2_enabled) {
+		ut_crc32_shift_init(&ut_crc32_shift_long, UT_CRC32_LONG);
+		ut_crc32_shift_init(&ut_crc32_shift_short, UT_CRC32_SHORT);
+
 		ut_crc32 = ut_crc32_hw;
 		ut_crc32_legacy_big_endian = ut_crc32_legacy_big_endian_hw;
 		ut_crc32_byte_by_byte = ut_crc32_byte_by_byte_hw;
+		ut_crc32_copy = ut_crc32_copy_hw;
 	}
 
 #endif /* defined(__GNUC__) && defined(__x86_64__) */
@@ -732,5 +942,6 @@ ut_crc32_init()
 		ut_crc32 = ut_crc32_sw;
 		ut_crc32_legacy_big_endian = ut_crc32_legacy_big_endian_sw;
 		ut_crc32_byte_by_byte = ut_crc32_byte_by_byte_sw;
+		ut_crc32_copy = ut_crc32_copy_sw;
 	}
 }
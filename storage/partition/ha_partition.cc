@@ -4417,6 +4417,8 @@ void ha_partition::get_dynamic_partition_info(ha_statistics *stat_info,
   HA_EXTRA_EXPORT:
     Prepare table for export
     (e.g. quiesce the table and write table metadata).
+  HA_EXTRA_KEY_ORDERED_READS:
+    The following lookups are made in key order, by DS-MRR.
 
   11) Operations only used by partitioning
   ------------------------------
@@ -4564,6 +4566,7 @@ int ha_partition::extra(enum ha_extra_function operation)
     DBUG_RETURN(ER_UNSUPORTED_LOG_ENGINE);
     /* Category 10), used by InnoDB handlers */
   case HA_EXTRA_EXPORT:
+  case HA_EXTRA_KEY_ORDERED_READS:
     DBUG_RETURN(loop_extra(operation));
     /* Category 11) Operations only used by partitioning. */
   case HA_EXTRA_SECONDARY_SORT_ROWID:
@@ -19,6 +19,8 @@
 #include <utility>
 
 #include "filesort_utils.h"
+#include "myisampack.h"
+#include "sql_sort.h"
 #include "table.h"
 
 
@@ -123,4 +125,49 @@ TEST_F(FileSortBufferTest, AssignmentOperator)
 }
 
 
+/*
+  Fill a buffer with keys of 24 bytes, where every tenth key is equal,
+  followed by the number of the record.
+*/
+static void fill_keys(Filesort_buffer *buffer, uint count)
+{
+  buffer->alloc_sort_buffer(count, 28);
+  buffer->init_record_pointers();
+  for (uint ix= 0; ix < count; ++ix)
+  {
+    uchar *record= buffer->get_sort_keys()[ix];
+    memset(record, 'k', 24);
+    mi_int4store(record, (ix * 7919) % (count / 10));
+    mi_int4store(record + 24, ix);
+  }
+}
+
+
+TEST_F(FileSortBufferTest, SortInParallel)
+{
+  const uint count= 100000;
+  Sort_param param;
+  param.sort_length= 24;
+
+  Filesort_buffer serial;
+  fill_keys(&serial, count);
+  param.sort_threads= 1;
+  serial.sort_buffer(&param, count);
+
+  fill_keys(&fs_info, count);
+  param.sort_threads= 5;
+  fs_info.sort_buffer(&param, count);
+
+  for (uint ix= 0; ix < count; ++ix)
+  {
+    const uchar *expected= serial.get_sort_keys()[ix];
+    const uchar *actual= fs_info.get_sort_keys()[ix];
+    ASSERT_EQ(0, memcmp(expected, actual, 28)) << "index:" << ix;
+    if (ix > 0)
+      ASSERT_GE(memcmp(actual, fs_info.get_sort_keys()[ix - 1], 24), 0);
+  }
+  serial.free_sort_buffer();
+}
+
+
 }  // namespace
@@ -38,6 +38,9 @@ namespace filesort_compare_unittest {
                      typically implemented with introsort/insertion sort
   std::stable_sort - requires extra memory: array of n pointers,
                      typically implemented with mergesort
+  msd_radix_sort -   requires extra memory: array of n pointers,
+                     looks only at the bytes needed to tell keys apart,
+                     used for keys that radixsort cannot handle
 
   The record format for filesort is constructed in such a way that we can
   compare records byte-by-byte, without knowing the data types.
@@ -203,6 +206,19 @@ public:
 };
 
 
+class Mem_compare_sort_keys :
+  public std::binary_function<const uchar*, const uchar*, bool>
+{
+public:
+  Mem_compare_sort_keys(size_t n) : m_size(n) {}
+  bool operator()(const uchar *s1, const uchar *s2)
+  {
+    return cmp_sort_keys(s1, s2, m_size) < 0;
+  }
+  size_t m_size;
+};
+
+
 class Mem_compare_0 :
   public std::binary_function<const uchar*, const uchar*, bool>
 {
@@ -394,6 +410,88 @@ TEST_F(FileSortCompareTest, StdStableSortmemcmp)
   }
 }
 
+TEST_F(FileSortCompareTest, StdStableSortCmpSortKeys)
+{
+  for (int ix= 0; ix < num_iterations; ++ix)
+  {
+    std::vector<uchar*> keys(sort_keys, sort_keys + num_records);
+    std::stable_sort(keys.begin(), keys.end(),
+                     Mem_compare_sort_keys(record_size));
+  }
+}
+
+TEST_F(FileSortCompareTest, MsdRadixSort)
+{
+  std::vector<uchar*> buffer(num_records);
+  for (int ix= 0; ix < num_iterations; ++ix)
+  {
+    std::vector<uchar*> keys(sort_keys, sort_keys + num_records);
+    msd_radix_sort(&keys[0], num_records, record_size, &buffer[0]);
+  }
+}
+
+// The radix sort must give the same, stable, order as std::stable_sort.
+TEST_F(FileSortCompareTest, MsdRadixSortIsStable)
+{
+  std::vector<uchar*> expected(sort_keys, sort_keys + num_records);
+  std::stable_sort(expected.begin(), expected.end(),
+                   Mem_compare_memcmp(sizeof(int)));
+
+  std::vector<uchar*> keys(sort_keys, sort_keys + num_records);
+  std::vector<uchar*> buffer(num_records);
+  msd_radix_sort(&keys[0], num_records, sizeof(int), &buffer[0]);
+  for (int ix= 0; ix < num_records; ++ix)
+    EXPECT_EQ(expected[ix], keys[ix]) << "index:" << ix;
+}
+
+// Keys 'b', 'ab', 'aab', ... are split at every byte, which must not
+// take stack space for each byte of the key.
+TEST(MsdRadixSortTest, LongCommonPrefixes)
+{
+  const size_t num_keys= 5000;
+  const size_t key_length= num_keys + 1;
+  std::vector<uchar> data(num_keys * key_length, 0);
+  std::vector<uchar*> keys(num_keys);
+  for (size_t ix= 0; ix < num_keys; ++ix)
+  {
+    uchar *const key= &data[ix * key_length];
+    memset(key, 'a', ix);
+    key[ix]= 'b';
+    keys[ix]= key;
+  }
+  std::vector<uchar*> buffer(num_keys);
+  msd_radix_sort(&keys[0], num_keys, key_length, &buffer[0]);
+  for (size_t ix= 0; ix < num_keys; ++ix)
+    EXPECT_EQ(&data[(num_keys - 1 - ix) * key_length], keys[ix])
+      << "index:" << ix;
+}
+
+TEST(CmpSortKeysTest, SameSignAsMemcmp)
+{
+  const uchar keys[][12]=
+  {
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 },
+    { 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0 },
+    { 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { 0x80, 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff }
+  };
+  for (int ix= 0; ix < array_size(keys); ++ix)
+  {
+    for (int iy= 0; iy < array_size(keys); ++iy)
+    {
+      for (size_t len= 0; len <= sizeof(keys[0]); ++len)
+      {
+        const int expected= memcmp(keys[ix], keys[iy], len);
+        const int actual= cmp_sort_keys(keys[ix], keys[iy], len);
+        EXPECT_EQ(expected < 0, actual < 0);
+        EXPECT_EQ(expected == 0, actual == 0);
+      }
+    }
+  }
+}
+
 TEST_F(FileSortCompareTest, StdSortCompare0)
 {
   for (int ix= 0; ix < num_iterations; ++ix)
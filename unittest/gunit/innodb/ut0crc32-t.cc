@@ -24,6 +24,7 @@
 
 #include "univ.i"
 
+#include "my_rdtsc.h"
 #include "ut0crc32.h"
 #include "ut0dbg.h"
 
@@ -2087,10 +2088,11 @@ init()
 {
 	ut_crc32_init();
 
-	fprintf(stderr, "Using %s, CPU is %s-endian\n",
+	fprintf(stderr, "Using %s%s, CPU is %s-endian\n",
 		ut_crc32_sse2_enabled
 		? "hardware CPU crc32 instructions"
 		: "software crc32 implementation",
+		ut_crc32_pclmul_enabled ? " with pclmulqdq" : "",
 #ifdef WORDS_BIGENDIAN
 		"big"
 #else /* WORDS_BIGENDIAN */
@@ -2163,6 +2165,55 @@ TEST(ut0crc32, basic)
 	delete[] buf;
 }
 
+/* test ut_crc32_copy() and the interleaved streams of ut_crc32() against
+the byte by byte implementation, for lengths around the stream sizes */
+TEST(ut0crc32, copy)
+{
+	init();
+
+	byte*	buf = new byte[page_size + 7];
+	byte*	dst = new byte[page_size + 7];
+
+	for (int i = 0; i < 8; i++) {
+
+		byte*	p = buf + i;
+
+		memcpy(p, page, page_size);
+		memset(dst, 0, page_size + 7);
+
+		EXPECT_EQ(2400278014U, ut_crc32_copy(dst + 7 - i, p, page_size));
+		EXPECT_EQ(0, memcmp(dst + 7 - i, page, page_size));
+
+		for (size_t len = 0; len < page_size; len += 1 + len / 64) {
+			const uint32_t	crc = ut_crc32_byte_by_byte(p, len);
+
+			ASSERT_EQ(crc, ut_crc32(p, len));
+			ASSERT_EQ(crc, ut_crc32_copy(dst, p, len));
+			ASSERT_EQ(0, memcmp(dst, p, len));
+		}
+	}
+
+	delete[] dst;
+	delete[] buf;
+}
+
+/** Report the throughput of a checksum calculation.
+@param[in]	name	name of the calculation
+@param[in]	n_bytes	number of bytes processed
+@param[in]	cycles	number of CPU cycles spent */
+static
+void
+report_bytes_per_cycle(
+	const char*	name,
+	size_t		n_bytes,
+	ulonglong	cycles)
+{
+	if (cycles > 0) {
+		fprintf(stderr, "%s: %.2f bytes/cycle\n", name,
+			static_cast<double>(n_bytes) / cycles);
+	}
+}
+
 TEST(ut0crc32, perf)
 {
 	init();
@@ -2184,12 +2235,20 @@ TEST(ut0crc32, perf)
 	static const size_t	page_size = 16 * 1024;
 	static const size_t	n_pages = n_bytes / page_size;
 
+	static const size_t	n_bytes_processed = 128 * n_pages * page_size;
+
+	unsigned char*		dst = new unsigned char[page_size];
+
+	ulonglong		start;
+
 #ifdef HAVE_UT_CHRONO_T
 	ut_chrono_t*	chrono;
 
 	chrono = new ut_chrono_t("    normal CRC32");
 #endif /* HAVE_UT_CHRONO_T */
 
+	start = my_timer_cycles();
+
 	for (size_t n = 0; n < 128; n++) {
 		for (size_t i = 0; i < n_pages; i++) {
 
@@ -2198,12 +2257,37 @@ TEST(ut0crc32, perf)
 		}
 	}
 
+	report_bytes_per_cycle("    normal CRC32", n_bytes_processed,
+			       my_timer_cycles() - start);
+
+#ifdef HAVE_UT_CHRONO_T
+	delete chrono; /* shows the timings */
+
+	chrono = new ut_chrono_t("  copying CRC32");
+#endif /* HAVE_UT_CHRONO_T */
+
+	start = my_timer_cycles();
+
+	for (size_t n = 0; n < 128; n++) {
+		for (size_t i = 0; i < n_pages; i++) {
+
+			ASSERT_EQ(3911978414U,
+				  ut_crc32_copy(dst, p + i * page_size,
+						page_size));
+		}
+	}
+
+	report_bytes_per_cycle("  copying CRC32", n_bytes_processed,
+			       my_timer_cycles() - start);
+
 #ifdef HAVE_UT_CHRONO_T
 	delete chrono; /* shows the timings */
 
 	chrono = new ut_chrono_t("big endian CRC32");
 #endif /* HAVE_UT_CHRONO_T */
 
+	start = my_timer_cycles();
+
 	for (size_t n = 0; n < 128; n++) {
 		for (size_t i = 0; i < n_pages; i++) {
 
@@ -2213,10 +2297,14 @@ TEST(ut0crc32, perf)
 		}
 	}
 
+	report_bytes_per_cycle("big endian CRC32", n_bytes_processed,
+			       my_timer_cycles() - start);
+
 #ifdef HAVE_UT_CHRONO_T
 	delete chrono; /* shows the timings */
 #endif /* HAVE_UT_CHRONO_T */
 
+	delete[] dst;
 	delete[] p;
 }
 
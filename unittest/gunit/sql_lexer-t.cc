@@ -0,0 +1,256 @@
+/* Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include "test_utils.h"
+
+#include "sql_class.h"
+#include "sql_lex.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace sql_lexer_unittest {
+
+using my_testing::Server_initializer;
+
+/*
+  Statements like those that applications send, for the performance
+  test below.
+*/
+const char *corpus[]=
+{
+  "SELECT c FROM sbtest1 WHERE id=4711",
+  "SELECT c FROM sbtest1 WHERE id BETWEEN 100 AND 199",
+  "SELECT SUM(k) FROM sbtest1 WHERE id BETWEEN 5000 AND 5099",
+  "SELECT DISTINCT c FROM sbtest1 WHERE id BETWEEN 10 AND 109 ORDER BY c",
+  "UPDATE sbtest1 SET k=k+1 WHERE id=2302",
+  "UPDATE sbtest1 SET c='60736409165-99486148466-47346939291-61227418566"
+  "-34357405215' WHERE id=49985",
+  "DELETE FROM sbtest1 WHERE id=35108",
+  "INSERT INTO sbtest1 (id, k, c, pad) VALUES (35108, 50249, "
+  "'08566691963-88624912351-16662227201-46648573979-64646226163', "
+  "'63188288836-92351140030-06390587585-66802097351-49282961843')",
+  "SELECT `o`.`order_id`, `o`.`created_at`, `c`.`customer_name` "
+  "FROM `orders` `o` JOIN `customers` `c` ON `o`.`customer_id` = "
+  "`c`.`customer_id` WHERE `o`.`status` = 'shipped' AND "
+  "`o`.`created_at` >= '2017-11-01 00:00:00' LIMIT 50",
+  "SELECT t.name, COUNT(*) AS cnt FROM products t WHERE t.price > 12.50 "
+  "AND t.category IN (3, 7, 11, 19) GROUP BY t.name HAVING cnt > 1",
+  "SELECT @@session.autocommit, @@session.tx_isolation",
+  "SET NAMES utf8mb4"
+};
+
+
+class LexerTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    initializer.SetUp();
+    m_charset= thd()->variables.character_set_client;
+  }
+  virtual void TearDown()
+  {
+    thd()->variables.character_set_client= m_charset;
+    thd()->m_parser_state= NULL;
+    initializer.TearDown();
+  }
+
+  THD *thd() { return initializer.thd(); }
+
+  /**
+    Scan a statement into tokens, as the parser does.
+
+    @param query   Statement
+    @param tokens  If not NULL, the text of each token is added to it, or
+                   the value for identifiers and strings
+
+    @return The number of tokens, including the end of input
+  */
+  size_t scan(const char *query, std::vector<std::string> *tokens)
+  {
+    Parser_state state;
+    EXPECT_FALSE(state.init(thd(), query, strlen(query)));
+    thd()->m_parser_state= &state;
+
+    const char *const end= query + strlen(query);
+    size_t count= 0;
+    YYSTYPE yylval;
+    YYLTYPE yylloc;
+    int token;
+    while ((token= MYSQLlex(&yylval, &yylloc, thd())) != 0)
+    {
+      count++;
+      if (tokens == NULL || yylloc.raw.start >= end)
+        continue;
+      const char quote= *yylloc.raw.start;
+      if (quote == '\'' || quote == '`')
+        tokens->push_back(std::string(yylval.lex_str.str,
+                                      yylval.lex_str.length));
+      else
+        tokens->push_back(std::string(yylloc.raw.start,
+                                      yylloc.raw.end - yylloc.raw.start));
+    }
+    thd()->m_parser_state= NULL;
+    return count;
+  }
+
+  Server_initializer initializer;
+  const CHARSET_INFO *m_charset;
+};
+
+
+void check_tokens(const std::vector<std::string> &tokens,
+                  const char **expected, size_t expected_count)
+{
+  ASSERT_EQ(expected_count, tokens.size());
+  for (size_t i= 0; i < expected_count; i++)
+    EXPECT_EQ(std::string(expected[i]), tokens[i]) << "token " << i;
+}
+
+
+TEST_F(LexerTest, Identifiers)
+{
+  const char *expected[]=
+  {
+    "SELECT", "a_1", ",", "t1", ".", "$b", ",", "quoted ident",
+    ",", "back`quote", "FROM", "t1"
+  };
+  const CHARSET_INFO *charsets[]=
+  { &my_charset_latin1, &my_charset_utf8_general_ci };
+  for (size_t i= 0; i < array_elements(charsets); i++)
+  {
+    thd()->variables.character_set_client= charsets[i];
+    std::vector<std::string> tokens;
+    scan("SELECT a_1, t1.$b, `quoted ident`, `back``quote` FROM t1",
+         &tokens);
+    check_tokens(tokens, expected, array_elements(expected));
+  }
+}
+
+
+TEST_F(LexerTest, MultiByteIdentifiers)
+{
+  thd()->variables.character_set_client= &my_charset_utf8_general_ci;
+  const char *expected[]=
+  {
+    "SELECT", "gr\xC3\xB6\xC3\x9F" "e", ",", "\xC3\xA9t\xC3\xA9",
+    "FROM", "t\xE2\x82\xAC" "1", "WHERE", "x\xC3\xA5y", "=", "1"
+  };
+  std::vector<std::string> tokens;
+  scan("SELECT gr\xC3\xB6\xC3\x9F" "e, `\xC3\xA9t\xC3\xA9` "
+       "FROM t\xE2\x82\xAC" "1 WHERE x\xC3\xA5y = 1", &tokens);
+  check_tokens(tokens, expected, array_elements(expected));
+}
+
+
+TEST_F(LexerTest, Strings)
+{
+  const char *expected[]=
+  {
+    "SELECT", "plain", ",", "it's", ",", "tab\there", ",",
+    "caf\xC3\xA9 \xE2\x82\xAC", ",", "", ",", "12.5e3"
+  };
+  const CHARSET_INFO *charsets[]=
+  { &my_charset_latin1, &my_charset_utf8_general_ci };
+  for (size_t i= 0; i < array_elements(charsets); i++)
+  {
+    thd()->variables.character_set_client= charsets[i];
+    std::vector<std::string> tokens;
+    scan("SELECT 'plain', 'it''s', 'tab\\there', "
+         "'caf\xC3\xA9 \xE2\x82\xAC', '', 12.5e3", &tokens);
+    check_tokens(tokens, expected, array_elements(expected));
+  }
+}
+
+
+/*
+  In sjis and gbk the second byte of a character can be a backslash or a
+  backquote, which neither escapes nor ends a string or an identifier.
+*/
+TEST_F(LexerTest, DoubleByteTrailBytes)
+{
+  // 0x955C and 0x8360 in sjis
+  {
+    thd()->variables.character_set_client= &my_charset_sjis_japanese_ci;
+    const char *expected[]=
+    {
+      "SELECT", "x\x95\x5Cy", ",", "\x95\x5C", ",", "a\x83\x60",
+      ",", "\x95\x5C", "FROM", "\x83\x60"
+    };
+    std::vector<std::string> tokens;
+    scan("SELECT 'x\x95\x5Cy', '\x95\x5C', `a\x83\x60`, `\x95\x5C` "
+         "FROM `\x83\x60`", &tokens);
+    check_tokens(tokens, expected, array_elements(expected));
+  }
+  // 0xD55C and 0x8160 in gbk
+  {
+    thd()->variables.character_set_client= &my_charset_gbk_chinese_ci;
+    const char *expected[]=
+    {
+      "SELECT", "x\xD5\x5Cy", ",", "\xD5\x5C", ",", "a\x81\x60",
+      ",", "\xD5\x5C", "FROM", "\x81\x60"
+    };
+    std::vector<std::string> tokens;
+    scan("SELECT 'x\xD5\x5Cy', '\xD5\x5C', `a\x81\x60`, `\xD5\x5C` "
+         "FROM `\x81\x60`", &tokens);
+    check_tokens(tokens, expected, array_elements(expected));
+  }
+}
+
+
+// Increase number when doing performance comparisons.
+// Run with ./unittest/gunit/merge_large_tests-t --disable-tap-output
+//   --gtest_filter="LexerTest.Perf*" to get the number of tokens per second.
+const int num_iterations= 1; // 100000;
+
+TEST_F(LexerTest, PerfTokensPerSecond)
+{
+  thd()->variables.character_set_client= &my_charset_utf8_general_ci;
+
+  // The tokens are allocated on a MEM_ROOT of their own, freed after each
+  // statement
+  MEM_ROOT root;
+  init_sql_alloc(PSI_NOT_INSTRUMENTED, &root, 8192, 0);
+  MEM_ROOT *const saved_root= thd()->mem_root;
+  thd()->mem_root= &root;
+
+  size_t tokens= 0;
+  const ulonglong start= my_micro_time();
+  for (int ix= 0; ix < num_iterations; ++ix)
+  {
+    for (size_t i= 0; i < array_elements(corpus); i++)
+    {
+      tokens+= scan(corpus[i], NULL);
+      free_root(&root, MYF(MY_KEEP_PREALLOC));
+    }
+  }
+  const ulonglong elapsed= std::max(my_micro_time() - start, 1ULL);
+
+  thd()->mem_root= saved_root;
+  free_root(&root, MYF(0));
+  EXPECT_GT(tokens, 0U);
+  std::cout << tokens << " tokens in " << elapsed << " us, "
+            << tokens * 1000000ULL / elapsed << " tokens per second"
+            << std::endl;
+}
+
+}